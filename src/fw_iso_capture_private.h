@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#ifndef __ORG_KERNEL_HINOKO_FW_ISO_CAPTURE_PRIVATE_H__
+#define __ORG_KERNEL_HINOKO_FW_ISO_CAPTURE_PRIVATE_H__
+
+#include "fw_iso_ctx_private.h"
+
+// The layout of capture file. Every field is in little endian.
+//
+// The file begins with the file header, followed by the records. Each record consists of the
+// fixed-size fields and the payload. The payload is padded to 8 bytes so that the next record is
+// aligned to 8 bytes. The records are grouped into chunks; each chunk begins with the record of
+// chunk type whose payload has the absolute isochronous cycle of the first packet in the chunk.
+//
+// The index of chunks and the trailer follow the last record. The index has an entry per chunk,
+// sorted by the absolute isochronous cycle. When the trailer is missing, for example due to abort
+// of the writer, the index is rebuilt by scanning the records.
+#define FW_ISO_CAPTURE_MAGIC		"HNKCAPT"
+#define FW_ISO_CAPTURE_VERSION		2
+
+struct fw_iso_capture_file_header {
+	char magic[8];
+	guint32 version;
+	guint32 reserved;
+};
+G_STATIC_ASSERT(sizeof(struct fw_iso_capture_file_header) == 16);
+
+enum fw_iso_capture_record_type {
+	FW_ISO_CAPTURE_RECORD_TYPE_PACKET = 0,
+	FW_ISO_CAPTURE_RECORD_TYPE_CHUNK,
+};
+
+// The isochronous cycle is not available when the context header has no timestamp.
+#define FW_ISO_CAPTURE_CYCLES_UNKNOWN	0xffff
+
+struct fw_iso_capture_record {
+	guint32 length;		// The number of bytes in payload, excluding the padding.
+	guint32 iso_header;	// The isochronous packet header.
+	gint64 timestamp;	// The system time of CLOCK_MONOTONIC in nanoseconds, or zero.
+	guint16 cycles;		// The isochronous cycle in the lower three bits of second.
+	guint8 channel;
+	guint8 type;
+	guint8 reserved[4];
+};
+G_STATIC_ASSERT(sizeof(struct fw_iso_capture_record) == 24);
+
+#define FW_ISO_CAPTURE_RECORD_ALIGN(size)	(((size) + 7) & ~((gsize)7))
+
+struct fw_iso_capture_chunk {
+	guint64 cycle;		// The absolute isochronous cycle of the first packet.
+};
+
+struct fw_iso_capture_index_entry {
+	guint64 cycle;		// The absolute isochronous cycle of the first packet.
+	guint64 offset;		// The offset of the chunk record in the file.
+	guint64 channels;	// The bitmap of channels for packets in the chunk.
+};
+G_STATIC_ASSERT(sizeof(struct fw_iso_capture_index_entry) == 24);
+
+#define FW_ISO_CAPTURE_INDEX_MAGIC	"HNKI"
+
+struct fw_iso_capture_trailer {
+	guint64 index_offset;
+	guint32 index_count;
+	char magic[4];
+};
+G_STATIC_ASSERT(sizeof(struct fw_iso_capture_trailer) == 16);
+
+// The timestamp of packet has the lower three bits of second, thus the absolute isochronous cycle
+// is unwrapped against the previous one. The packets for several channels can be slightly out of
+// order, thus the distance is handled as signed value.
+static inline guint64 fw_iso_capture_unwrap_cycle(guint64 base, guint cycles)
+{
+	gint distance = (gint)cycles - (gint)(base % OHCI1394_ISOC_DESC_tstamp_CYCLES_PER_ROUND);
+
+	if (distance < -(gint)OHCI1394_ISOC_DESC_tstamp_CYCLES_PER_ROUND / 2)
+		distance += OHCI1394_ISOC_DESC_tstamp_CYCLES_PER_ROUND;
+	else if (distance >= (gint)OHCI1394_ISOC_DESC_tstamp_CYCLES_PER_ROUND / 2)
+		distance -= OHCI1394_ISOC_DESC_tstamp_CYCLES_PER_ROUND;
+
+	if (distance < 0 && base < (guint64)-distance)
+		return 0;
+
+	return base + distance;
+}
+
+#endif
@@ -0,0 +1,564 @@
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#include "fw_iso_capture_private.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+/**
+ * HinokoFwIsoCaptureReader:
+ * A reader of file written by [class@FwIsoCaptureWriter].
+ *
+ * [class@FwIsoCaptureReader] maps the whole file to the process address space, then iterates the
+ * records of packet. The payload of packet is retrieved without copy from the mapped file.
+ *
+ * The reader seeks to the given absolute isochronous cycle by binary search of the index of
+ * chunks, then scans the records in the chunk. The chunks including no packet for the channels
+ * of interest are skipped by the bitmap of channels in the index. When the file has no index,
+ * for example due to abort of the writer, the index is rebuilt by scanning the records once when
+ * opening the file.
+ */
+typedef struct {
+	guint8 *map;
+	gsize size;
+	gsize records_end;
+
+	const struct fw_iso_capture_index_entry *entries;
+	guint entry_count;
+	GArray *scanned;
+
+	gsize offset;
+	guint entry_pos;
+	guint64 cycle;
+	guint64 target;
+	guint64 channels;
+	guint64 last_cycle;
+} HinokoFwIsoCaptureReaderPrivate;
+
+G_DEFINE_TYPE_WITH_PRIVATE(HinokoFwIsoCaptureReader, hinoko_fw_iso_capture_reader, G_TYPE_OBJECT)
+
+#define generate_file_error(error, code, format, arg)		\
+	g_set_error(error, G_FILE_ERROR, code, format, arg)
+
+enum fw_iso_capture_reader_prop_type {
+	FW_ISO_CAPTURE_READER_PROP_TYPE_CHUNK_COUNT = 1,
+	FW_ISO_CAPTURE_READER_PROP_TYPE_FIRST_CYCLE,
+	FW_ISO_CAPTURE_READER_PROP_TYPE_LAST_CYCLE,
+	FW_ISO_CAPTURE_READER_PROP_TYPE_COUNT,
+};
+
+static inline guint64 entry_cycle(const HinokoFwIsoCaptureReaderPrivate *priv, guint pos)
+{
+	return GUINT64_FROM_LE(priv->entries[pos].cycle);
+}
+
+static inline gsize entry_offset(const HinokoFwIsoCaptureReaderPrivate *priv, guint pos)
+{
+	return GUINT64_FROM_LE(priv->entries[pos].offset);
+}
+
+static inline guint64 entry_channels(const HinokoFwIsoCaptureReaderPrivate *priv, guint pos)
+{
+	return GUINT64_FROM_LE(priv->entries[pos].channels);
+}
+
+static void fw_iso_capture_reader_get_property(GObject *obj, guint id, GValue *val,
+					       GParamSpec *spec)
+{
+	HinokoFwIsoCaptureReader *self = HINOKO_FW_ISO_CAPTURE_READER(obj);
+	HinokoFwIsoCaptureReaderPrivate *priv =
+		hinoko_fw_iso_capture_reader_get_instance_private(self);
+
+	switch (id) {
+	case FW_ISO_CAPTURE_READER_PROP_TYPE_CHUNK_COUNT:
+		g_value_set_uint(val, priv->entry_count);
+		break;
+	case FW_ISO_CAPTURE_READER_PROP_TYPE_FIRST_CYCLE:
+		g_value_set_uint64(val, priv->entry_count > 0 ? entry_cycle(priv, 0) : 0);
+		break;
+	case FW_ISO_CAPTURE_READER_PROP_TYPE_LAST_CYCLE:
+		g_value_set_uint64(val, priv->last_cycle);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, id, spec);
+		break;
+	}
+}
+
+static void release_map(HinokoFwIsoCaptureReaderPrivate *priv)
+{
+	if (priv->map != NULL) {
+		munmap(priv->map, priv->size);
+		priv->map = NULL;
+		priv->size = 0;
+	}
+
+	if (priv->scanned != NULL) {
+		g_array_unref(priv->scanned);
+		priv->scanned = NULL;
+	}
+
+	priv->entries = NULL;
+	priv->entry_count = 0;
+	priv->records_end = 0;
+	priv->last_cycle = 0;
+}
+
+static void fw_iso_capture_reader_finalize(GObject *obj)
+{
+	HinokoFwIsoCaptureReader *self = HINOKO_FW_ISO_CAPTURE_READER(obj);
+	HinokoFwIsoCaptureReaderPrivate *priv =
+		hinoko_fw_iso_capture_reader_get_instance_private(self);
+
+	release_map(priv);
+
+	G_OBJECT_CLASS(hinoko_fw_iso_capture_reader_parent_class)->finalize(obj);
+}
+
+static void hinoko_fw_iso_capture_reader_class_init(HinokoFwIsoCaptureReaderClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+
+	gobject_class->get_property = fw_iso_capture_reader_get_property;
+	gobject_class->finalize = fw_iso_capture_reader_finalize;
+
+	/**
+	 * HinokoFwIsoCaptureReader:chunk-count:
+	 *
+	 * The number of chunks in the file.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_CAPTURE_READER_PROP_TYPE_CHUNK_COUNT,
+		g_param_spec_uint("chunk-count", "chunk-count",
+				  "The number of chunks in the file",
+				  0, G_MAXUINT, 0,
+				  G_PARAM_READABLE));
+
+	/**
+	 * HinokoFwIsoCaptureReader:first-cycle:
+	 *
+	 * The absolute isochronous cycle of the first packet in the file.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_CAPTURE_READER_PROP_TYPE_FIRST_CYCLE,
+		g_param_spec_uint64("first-cycle", "first-cycle",
+				    "The absolute isochronous cycle of the first packet",
+				    0, G_MAXUINT64, 0,
+				    G_PARAM_READABLE));
+
+	/**
+	 * HinokoFwIsoCaptureReader:last-cycle:
+	 *
+	 * The absolute isochronous cycle of the last packet in the file.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_CAPTURE_READER_PROP_TYPE_LAST_CYCLE,
+		g_param_spec_uint64("last-cycle", "last-cycle",
+				    "The absolute isochronous cycle of the last packet",
+				    0, G_MAXUINT64, 0,
+				    G_PARAM_READABLE));
+}
+
+static void hinoko_fw_iso_capture_reader_init(HinokoFwIsoCaptureReader *self)
+{
+	return;
+}
+
+/**
+ * hinoko_fw_iso_capture_reader_new:
+ *
+ * Instantiate [class@FwIsoCaptureReader] object and return the instance.
+ *
+ * Returns: an instance of [class@FwIsoCaptureReader].
+ *
+ * Since: 1.1
+ */
+HinokoFwIsoCaptureReader *hinoko_fw_iso_capture_reader_new(void)
+{
+	return g_object_new(HINOKO_TYPE_FW_ISO_CAPTURE_READER, NULL);
+}
+
+// Return the size of record including the padding, or zero if the record is truncated.
+static gsize read_record(const HinokoFwIsoCaptureReaderPrivate *priv, gsize offset,
+			 const struct fw_iso_capture_record **record)
+{
+	gsize size;
+
+	if (offset + sizeof(**record) > priv->records_end)
+		return 0;
+
+	*record = (const struct fw_iso_capture_record *)(priv->map + offset);
+	size = sizeof(**record) + FW_ISO_CAPTURE_RECORD_ALIGN(GUINT32_FROM_LE((*record)->length));
+	if (offset + size > priv->records_end)
+		return 0;
+
+	return size;
+}
+
+// The record of chunk should have enough length for the cycle.
+static gboolean validate_record(const struct fw_iso_capture_record *record)
+{
+	return record->type != FW_ISO_CAPTURE_RECORD_TYPE_CHUNK ||
+	       GUINT32_FROM_LE(record->length) >= sizeof(struct fw_iso_capture_chunk);
+}
+
+static guint64 read_chunk_cycle(const struct fw_iso_capture_record *record)
+{
+	const struct fw_iso_capture_chunk *chunk;
+
+	chunk = (const struct fw_iso_capture_chunk *)(record + 1);
+
+	return GUINT64_FROM_LE(chunk->cycle);
+}
+
+static guint64 next_cycle(guint64 cycle, const struct fw_iso_capture_record *record)
+{
+	guint cycles = GUINT16_FROM_LE(record->cycles);
+
+	if (cycles == FW_ISO_CAPTURE_CYCLES_UNKNOWN)
+		return cycle;
+
+	return fw_iso_capture_unwrap_cycle(cycle, cycles);
+}
+
+static gboolean load_index(HinokoFwIsoCaptureReaderPrivate *priv)
+{
+	const struct fw_iso_capture_trailer *trailer;
+	guint64 index_offset;
+	guint32 index_count;
+
+	if (priv->size < sizeof(struct fw_iso_capture_file_header) + sizeof(*trailer))
+		return FALSE;
+
+	trailer = (const void *)(priv->map + priv->size - sizeof(*trailer));
+	if (memcmp(trailer->magic, FW_ISO_CAPTURE_INDEX_MAGIC, sizeof(trailer->magic)))
+		return FALSE;
+
+	index_offset = GUINT64_FROM_LE(trailer->index_offset);
+	index_count = GUINT32_FROM_LE(trailer->index_count);
+	if (index_offset < sizeof(struct fw_iso_capture_file_header) ||
+	    index_offset + (guint64)index_count * sizeof(*priv->entries) + sizeof(*trailer) !=
+	    priv->size)
+		return FALSE;
+
+	priv->entries = (const struct fw_iso_capture_index_entry *)(priv->map + index_offset);
+	priv->entry_count = index_count;
+	priv->records_end = index_offset;
+
+	return TRUE;
+}
+
+// Each entry of index should point to the record of chunk for the same cycle. The entries should
+// be in ascending order of the cycle and the offset, since they are looked up by binary search.
+static gboolean validate_index(const HinokoFwIsoCaptureReaderPrivate *priv)
+{
+	guint i;
+
+	for (i = 0; i < priv->entry_count; ++i) {
+		const struct fw_iso_capture_record *record;
+		gsize offset = entry_offset(priv, i);
+
+		if (offset < sizeof(struct fw_iso_capture_file_header) ||
+		    read_record(priv, offset, &record) == 0 ||
+		    record->type != FW_ISO_CAPTURE_RECORD_TYPE_CHUNK || !validate_record(record) ||
+		    read_chunk_cycle(record) != entry_cycle(priv, i))
+			return FALSE;
+
+		if (i > 0 && (offset <= entry_offset(priv, i - 1) ||
+			      entry_cycle(priv, i) < entry_cycle(priv, i - 1)))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean scan_index(HinokoFwIsoCaptureReaderPrivate *priv)
+{
+	struct fw_iso_capture_index_entry *entry = NULL;
+	gsize offset = sizeof(struct fw_iso_capture_file_header);
+
+	priv->records_end = priv->size;
+	priv->scanned = g_array_new(FALSE, TRUE, sizeof(struct fw_iso_capture_index_entry));
+
+	while (TRUE) {
+		const struct fw_iso_capture_record *record;
+		gsize size = read_record(priv, offset, &record);
+
+		if (size == 0)
+			break;
+		if (!validate_record(record))
+			return FALSE;
+
+		if (record->type == FW_ISO_CAPTURE_RECORD_TYPE_CHUNK) {
+			struct fw_iso_capture_index_entry new_entry = {0};
+
+			// The chunks are looked up by binary search as well as the loaded index.
+			if (entry != NULL &&
+			    read_chunk_cycle(record) < GUINT64_FROM_LE(entry->cycle))
+				return FALSE;
+
+			new_entry.cycle = GUINT64_TO_LE(read_chunk_cycle(record));
+			new_entry.offset = GUINT64_TO_LE(offset);
+			g_array_append_val(priv->scanned, new_entry);
+			entry = &g_array_index(priv->scanned, struct fw_iso_capture_index_entry,
+					       priv->scanned->len - 1);
+		} else if (entry != NULL) {
+			entry->channels |= GUINT64_TO_LE(G_GUINT64_CONSTANT(1) <<
+							  (record->channel & IEEE1394_MAX_CHANNEL));
+		}
+
+		offset += size;
+	}
+
+	// Drop the truncated record at the end.
+	priv->records_end = offset;
+	priv->entries = (const struct fw_iso_capture_index_entry *)priv->scanned->data;
+	priv->entry_count = priv->scanned->len;
+
+	return TRUE;
+}
+
+// Scan the last chunk to find the cycle of the last packet.
+static void find_last_cycle(HinokoFwIsoCaptureReaderPrivate *priv)
+{
+	gsize offset;
+	guint64 cycle;
+
+	if (priv->entry_count == 0)
+		return;
+
+	offset = entry_offset(priv, priv->entry_count - 1);
+	cycle = entry_cycle(priv, priv->entry_count - 1);
+
+	while (TRUE) {
+		const struct fw_iso_capture_record *record;
+		gsize size = read_record(priv, offset, &record);
+
+		if (size == 0)
+			break;
+		if (record->type == FW_ISO_CAPTURE_RECORD_TYPE_PACKET)
+			cycle = next_cycle(cycle, record);
+		offset += size;
+	}
+
+	priv->last_cycle = cycle;
+}
+
+/**
+ * hinoko_fw_iso_capture_reader_open:
+ * @self: A [class@FwIsoCaptureReader].
+ * @path: A path of file written by [class@FwIsoCaptureWriter].
+ * @error: A [struct@GLib.Error].
+ *
+ * Map the file and load the index of chunks. The cursor is at the beginning of file.
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_capture_reader_open(HinokoFwIsoCaptureReader *self, const char *path,
+					   GError **error)
+{
+	HinokoFwIsoCaptureReaderPrivate *priv;
+	const struct fw_iso_capture_file_header *header;
+	struct stat st;
+	void *map;
+	int fd;
+
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_CAPTURE_READER(self), FALSE);
+	g_return_val_if_fail(path != NULL && strlen(path) > 0, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	priv = hinoko_fw_iso_capture_reader_get_instance_private(self);
+	release_map(priv);
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		GFileError code = g_file_error_from_errno(errno);
+		if (code != G_FILE_ERROR_FAILED)
+			generate_file_error(error, code, "open(%s)", path);
+		else
+			generate_syscall_error(error, errno, "open(%s)", path);
+		return FALSE;
+	}
+
+	if (fstat(fd, &st) < 0) {
+		generate_syscall_error(error, errno, "fstat(%s)", path);
+		close(fd);
+		return FALSE;
+	}
+
+	if (st.st_size < (off_t)sizeof(*header)) {
+		generate_file_error(error, G_FILE_ERROR_INVAL, "Invalid capture file: %s", path);
+		close(fd);
+		return FALSE;
+	}
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		generate_syscall_error(error, errno, "mmap(%s)", path);
+		return FALSE;
+	}
+	priv->map = map;
+	priv->size = st.st_size;
+
+	header = (const struct fw_iso_capture_file_header *)priv->map;
+	if (memcmp(header->magic, FW_ISO_CAPTURE_MAGIC, sizeof(header->magic)) ||
+	    GUINT32_FROM_LE(header->version) != FW_ISO_CAPTURE_VERSION) {
+		generate_file_error(error, G_FILE_ERROR_INVAL, "Invalid capture file: %s", path);
+		release_map(priv);
+		return FALSE;
+	}
+
+	if (load_index(priv) ? !validate_index(priv) : !scan_index(priv)) {
+		generate_file_error(error, G_FILE_ERROR_INVAL, "Invalid capture file: %s", path);
+		release_map(priv);
+		return FALSE;
+	}
+	find_last_cycle(priv);
+
+	hinoko_fw_iso_capture_reader_seek(self, 0, G_MAXUINT64);
+
+	return TRUE;
+}
+
+/**
+ * hinoko_fw_iso_capture_reader_seek:
+ * @self: A [class@FwIsoCaptureReader].
+ * @cycle: The absolute isochronous cycle to seek.
+ * @channels: The bitmap of channels to retrieve, G_MAXUINT64 for all of channels.
+ *
+ * Move the cursor to the first packet at or after the absolute isochronous cycle, in the given
+ * channels. The chunk is looked up by binary search of index, thus the cost does not depend on
+ * the size of file.
+ *
+ * Since: 1.1
+ */
+void hinoko_fw_iso_capture_reader_seek(HinokoFwIsoCaptureReader *self, guint64 cycle,
+				       guint64 channels)
+{
+	HinokoFwIsoCaptureReaderPrivate *priv;
+	guint low;
+	guint high;
+
+	g_return_if_fail(HINOKO_IS_FW_ISO_CAPTURE_READER(self));
+
+	priv = hinoko_fw_iso_capture_reader_get_instance_private(self);
+	g_return_if_fail(priv->map != NULL);
+
+	priv->target = cycle;
+	priv->channels = channels;
+
+	if (priv->entry_count == 0) {
+		priv->offset = priv->records_end;
+		priv->entry_pos = 0;
+		return;
+	}
+
+	// Find the last chunk which begins at or before the cycle.
+	low = 0;
+	high = priv->entry_count;
+	while (high - low > 1) {
+		guint mid = low + (high - low) / 2;
+
+		if (entry_cycle(priv, mid) <= cycle)
+			low = mid;
+		else
+			high = mid;
+	}
+
+	priv->entry_pos = low;
+	priv->offset = entry_offset(priv, low);
+	priv->cycle = entry_cycle(priv, low);
+}
+
+/**
+ * hinoko_fw_iso_capture_reader_next:
+ * @self: A [class@FwIsoCaptureReader].
+ * @cycle: (out): The absolute isochronous cycle of packet.
+ * @channel: (out): The isochronous channel of packet.
+ * @iso_header: (out): The isochronous packet header.
+ * @timestamp: (out): The system time of CLOCK_MONOTONIC in nanoseconds when the packet is
+ *	       received, or zero if unavailable.
+ * @payload: (array length=length) (out) (transfer none): The payload of packet in the mapped file.
+ * @length: (out): The number of bytes in the above @payload.
+ *
+ * Retrieve the packet at the cursor, then move the cursor to the next packet.
+ *
+ * Returns: TRUE if the packet is retrieved, otherwise FALSE at the end of file.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_capture_reader_next(HinokoFwIsoCaptureReader *self, guint64 *cycle,
+					   guint *channel, guint32 *iso_header, gint64 *timestamp,
+					   const guint8 **payload, guint *length)
+{
+	HinokoFwIsoCaptureReaderPrivate *priv;
+
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_CAPTURE_READER(self), FALSE);
+	g_return_val_if_fail(cycle != NULL, FALSE);
+	g_return_val_if_fail(channel != NULL, FALSE);
+	g_return_val_if_fail(iso_header != NULL, FALSE);
+	g_return_val_if_fail(timestamp != NULL, FALSE);
+	g_return_val_if_fail(payload != NULL, FALSE);
+	g_return_val_if_fail(length != NULL, FALSE);
+
+	priv = hinoko_fw_iso_capture_reader_get_instance_private(self);
+	g_return_val_if_fail(priv->map != NULL, FALSE);
+
+	while (TRUE) {
+		const struct fw_iso_capture_record *record;
+		gsize size = read_record(priv, priv->offset, &record);
+		guint ch;
+
+		// The record of chunk out of index is not validated when opening the file.
+		if (size == 0 || !validate_record(record))
+			return FALSE;
+
+		if (record->type == FW_ISO_CAPTURE_RECORD_TYPE_CHUNK) {
+			while (priv->entry_pos < priv->entry_count &&
+			       entry_offset(priv, priv->entry_pos) < priv->offset)
+				++priv->entry_pos;
+
+			// Skip the chunk without packets for the channels of interest.
+			if (priv->entry_pos + 1 < priv->entry_count &&
+			    entry_offset(priv, priv->entry_pos) == priv->offset &&
+			    !(entry_channels(priv, priv->entry_pos) & priv->channels)) {
+				++priv->entry_pos;
+				priv->offset = entry_offset(priv, priv->entry_pos);
+				continue;
+			}
+
+			priv->cycle = read_chunk_cycle(record);
+			priv->offset += size;
+			continue;
+		}
+
+		priv->offset += size;
+
+		if (record->type != FW_ISO_CAPTURE_RECORD_TYPE_PACKET)
+			continue;
+
+		priv->cycle = next_cycle(priv->cycle, record);
+		if (priv->cycle < priv->target)
+			continue;
+
+		ch = record->channel & IEEE1394_MAX_CHANNEL;
+		if (!(priv->channels & (G_GUINT64_CONSTANT(1) << ch)))
+			continue;
+
+		*cycle = priv->cycle;
+		*channel = ch;
+		*iso_header = GUINT32_FROM_LE(record->iso_header);
+		*timestamp = GINT64_FROM_LE(record->timestamp);
+		*payload = (const guint8 *)(record + 1);
+		*length = GUINT32_FROM_LE(record->length);
+
+		return TRUE;
+	}
+}
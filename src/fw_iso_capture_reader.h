@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#ifndef __ORG_KERNEL_HINOKO_FW_ISO_CAPTURE_READER_H__
+#define __ORG_KERNEL_HINOKO_FW_ISO_CAPTURE_READER_H__
+
+#include <hinoko.h>
+
+G_BEGIN_DECLS
+
+#define HINOKO_TYPE_FW_ISO_CAPTURE_READER	(hinoko_fw_iso_capture_reader_get_type())
+
+G_DECLARE_DERIVABLE_TYPE(HinokoFwIsoCaptureReader, hinoko_fw_iso_capture_reader, HINOKO,
+			 FW_ISO_CAPTURE_READER, GObject);
+
+struct _HinokoFwIsoCaptureReaderClass {
+	GObjectClass parent_class;
+};
+
+HinokoFwIsoCaptureReader *hinoko_fw_iso_capture_reader_new(void);
+
+gboolean hinoko_fw_iso_capture_reader_open(HinokoFwIsoCaptureReader *self, const char *path,
+					   GError **error);
+
+void hinoko_fw_iso_capture_reader_seek(HinokoFwIsoCaptureReader *self, guint64 cycle,
+				       guint64 channels);
+
+gboolean hinoko_fw_iso_capture_reader_next(HinokoFwIsoCaptureReader *self, guint64 *cycle,
+					   guint *channel, guint32 *iso_header, gint64 *timestamp,
+					   const guint8 **payload, guint *length);
+
+G_END_DECLS
+
+#endif
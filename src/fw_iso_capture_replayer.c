@@ -0,0 +1,606 @@
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#include "fw_iso_capture_private.h"
+
+/**
+ * HinokoFwIsoCaptureReplayer:
+ * A source to transmit isochronous packets in file written by [class@FwIsoCaptureWriter].
+ *
+ * [class@FwIsoCaptureReplayer] reads the packets for single channel from the file by
+ * [class@FwIsoCaptureReader], then registers them to [class@FwIsoIt] so that the distance of
+ * isochronous cycle between packets is kept as recorded. The isochronous cycles without packet are
+ * filled by skip descriptor. Both the header and the payload of packet come from the file; the
+ * leading bytes of payload are used for the context header of IT context, and the rest is used for
+ * the context payload.
+ *
+ * The replayer keeps [property@FwIsoCaptureReplayer:lead-cycles] isochronous cycles registered
+ * ahead in the handler of [signal@FwIsoIt::interrupted], thus the registered packets are queued
+ * to hardware in batch at the interrupt event. The content of packet is copied from the mapped
+ * file into the buffer of context without any system call.
+ */
+typedef struct {
+	guint lead_cycles;
+	guint cycles_per_irq;
+	gboolean loop;
+
+	guint64 replayed_packets;
+	guint64 skipped_cycles;
+	guint64 dropped_packets;
+
+	HinokoFwIsoCaptureReader *reader;
+	guint channel;
+	guint64 first_cycle;
+	guint64 span;
+
+	HinokoFwIsoIt *ctx;
+	gulong handler_id;
+	guint header_size;
+	guint bytes_per_chunk;
+	guint8 *header;
+
+	// The position is the number of isochronous cycles since the first packet in the file,
+	// accumulated over the loops.
+	guint64 position;
+	guint64 loop_offset;
+	guint queued_cycles;
+	guint accumulated_cycles;
+
+	// The packet read from the file and not registered yet.
+	gboolean pending;
+	guint64 pending_position;
+	guint32 pending_iso_header;
+	const guint8 *pending_payload;
+	guint pending_length;
+
+	gboolean finished;
+	GError *error;
+} HinokoFwIsoCaptureReplayerPrivate;
+
+G_DEFINE_TYPE_WITH_PRIVATE(HinokoFwIsoCaptureReplayer, hinoko_fw_iso_capture_replayer,
+			   G_TYPE_OBJECT)
+
+#define DEFAULT_LEAD_CYCLES		64
+#define DEFAULT_CYCLES_PER_IRQ		16
+
+enum fw_iso_capture_replayer_prop_type {
+	FW_ISO_CAPTURE_REPLAYER_PROP_TYPE_LEAD_CYCLES = 1,
+	FW_ISO_CAPTURE_REPLAYER_PROP_TYPE_CYCLES_PER_IRQ,
+	FW_ISO_CAPTURE_REPLAYER_PROP_TYPE_LOOP,
+	FW_ISO_CAPTURE_REPLAYER_PROP_TYPE_REPLAYED_PACKETS,
+	FW_ISO_CAPTURE_REPLAYER_PROP_TYPE_SKIPPED_CYCLES,
+	FW_ISO_CAPTURE_REPLAYER_PROP_TYPE_DROPPED_PACKETS,
+	FW_ISO_CAPTURE_REPLAYER_PROP_TYPE_COUNT,
+};
+
+enum fw_iso_capture_replayer_sig_type {
+	FW_ISO_CAPTURE_REPLAYER_SIG_TYPE_FINISHED = 1,
+	FW_ISO_CAPTURE_REPLAYER_SIG_TYPE_COUNT,
+};
+
+static guint fw_iso_capture_replayer_sigs[FW_ISO_CAPTURE_REPLAYER_SIG_TYPE_COUNT] = { 0 };
+
+static void fw_iso_capture_replayer_get_property(GObject *obj, guint id, GValue *val,
+						 GParamSpec *spec)
+{
+	HinokoFwIsoCaptureReplayer *self = HINOKO_FW_ISO_CAPTURE_REPLAYER(obj);
+	HinokoFwIsoCaptureReplayerPrivate *priv =
+		hinoko_fw_iso_capture_replayer_get_instance_private(self);
+
+	switch (id) {
+	case FW_ISO_CAPTURE_REPLAYER_PROP_TYPE_LEAD_CYCLES:
+		g_value_set_uint(val, priv->lead_cycles);
+		break;
+	case FW_ISO_CAPTURE_REPLAYER_PROP_TYPE_CYCLES_PER_IRQ:
+		g_value_set_uint(val, priv->cycles_per_irq);
+		break;
+	case FW_ISO_CAPTURE_REPLAYER_PROP_TYPE_LOOP:
+		g_value_set_boolean(val, priv->loop);
+		break;
+	case FW_ISO_CAPTURE_REPLAYER_PROP_TYPE_REPLAYED_PACKETS:
+		g_value_set_uint64(val, priv->replayed_packets);
+		break;
+	case FW_ISO_CAPTURE_REPLAYER_PROP_TYPE_SKIPPED_CYCLES:
+		g_value_set_uint64(val, priv->skipped_cycles);
+		break;
+	case FW_ISO_CAPTURE_REPLAYER_PROP_TYPE_DROPPED_PACKETS:
+		g_value_set_uint64(val, priv->dropped_packets);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, id, spec);
+		break;
+	}
+}
+
+static void fw_iso_capture_replayer_set_property(GObject *obj, guint id, const GValue *val,
+						 GParamSpec *spec)
+{
+	HinokoFwIsoCaptureReplayer *self = HINOKO_FW_ISO_CAPTURE_REPLAYER(obj);
+	HinokoFwIsoCaptureReplayerPrivate *priv =
+		hinoko_fw_iso_capture_replayer_get_instance_private(self);
+
+	// The parameters are fixed while replaying.
+	if (priv->ctx != NULL) {
+		g_warning("The parameter is not changed while replaying");
+		return;
+	}
+
+	switch (id) {
+	case FW_ISO_CAPTURE_REPLAYER_PROP_TYPE_LEAD_CYCLES:
+		priv->lead_cycles = g_value_get_uint(val);
+		break;
+	case FW_ISO_CAPTURE_REPLAYER_PROP_TYPE_CYCLES_PER_IRQ:
+		priv->cycles_per_irq = g_value_get_uint(val);
+		break;
+	case FW_ISO_CAPTURE_REPLAYER_PROP_TYPE_LOOP:
+		priv->loop = g_value_get_boolean(val);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, id, spec);
+		break;
+	}
+}
+
+static void fw_iso_capture_replayer_finalize(GObject *obj)
+{
+	HinokoFwIsoCaptureReplayer *self = HINOKO_FW_ISO_CAPTURE_REPLAYER(obj);
+	HinokoFwIsoCaptureReplayerPrivate *priv =
+		hinoko_fw_iso_capture_replayer_get_instance_private(self);
+
+	hinoko_fw_iso_capture_replayer_stop(self, NULL);
+
+	g_clear_object(&priv->reader);
+
+	G_OBJECT_CLASS(hinoko_fw_iso_capture_replayer_parent_class)->finalize(obj);
+}
+
+static void hinoko_fw_iso_capture_replayer_class_init(HinokoFwIsoCaptureReplayerClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+
+	gobject_class->get_property = fw_iso_capture_replayer_get_property;
+	gobject_class->set_property = fw_iso_capture_replayer_set_property;
+	gobject_class->finalize = fw_iso_capture_replayer_finalize;
+
+	/**
+	 * HinokoFwIsoCaptureReplayer:lead-cycles:
+	 *
+	 * The number of isochronous cycles to keep registered ahead, up to the value of
+	 * [property@FwIsoCtx:chunks-per-buffer] of the context. The larger value tolerates the
+	 * larger latency to process interrupt event.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class,
+					FW_ISO_CAPTURE_REPLAYER_PROP_TYPE_LEAD_CYCLES,
+		g_param_spec_uint("lead-cycles", "lead-cycles",
+				  "The number of isochronous cycles registered ahead",
+				  1, G_MAXUINT, DEFAULT_LEAD_CYCLES,
+				  G_PARAM_READWRITE));
+
+	/**
+	 * HinokoFwIsoCaptureReplayer:cycles-per-irq:
+	 *
+	 * The number of isochronous cycles per hardware interrupt, up to the value of
+	 * [property@FwIsoCaptureReplayer:lead-cycles].
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class,
+					FW_ISO_CAPTURE_REPLAYER_PROP_TYPE_CYCLES_PER_IRQ,
+		g_param_spec_uint("cycles-per-irq", "cycles-per-irq",
+				  "The number of isochronous cycles per hardware interrupt",
+				  1, G_MAXUINT, DEFAULT_CYCLES_PER_IRQ,
+				  G_PARAM_READWRITE));
+
+	/**
+	 * HinokoFwIsoCaptureReplayer:loop:
+	 *
+	 * Whether to replay the packets from the beginning of file again after the last packet. The
+	 * next loop starts at the isochronous cycle after the one of the last packet in the file.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_CAPTURE_REPLAYER_PROP_TYPE_LOOP,
+		g_param_spec_boolean("loop", "loop",
+				     "Whether to replay the packets repeatedly",
+				     FALSE,
+				     G_PARAM_READWRITE));
+
+	/**
+	 * HinokoFwIsoCaptureReplayer:replayed-packets:
+	 *
+	 * The number of packets registered to the context since started.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class,
+					FW_ISO_CAPTURE_REPLAYER_PROP_TYPE_REPLAYED_PACKETS,
+		g_param_spec_uint64("replayed-packets", "replayed-packets",
+				    "The number of registered packets",
+				    0, G_MAXUINT64, 0,
+				    G_PARAM_READABLE));
+
+	/**
+	 * HinokoFwIsoCaptureReplayer:skipped-cycles:
+	 *
+	 * The number of isochronous cycles filled by skip descriptor since started.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class,
+					FW_ISO_CAPTURE_REPLAYER_PROP_TYPE_SKIPPED_CYCLES,
+		g_param_spec_uint64("skipped-cycles", "skipped-cycles",
+				    "The number of isochronous cycles without packet",
+				    0, G_MAXUINT64, 0,
+				    G_PARAM_READABLE));
+
+	/**
+	 * HinokoFwIsoCaptureReplayer:dropped-packets:
+	 *
+	 * The number of packets not replayed since started, due to the isochronous cycle occupied
+	 * by the former packet, the payload larger than [property@FwIsoCtx:bytes-per-chunk], or
+	 * the tag field with value 3 reserved in IEEE 1394.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class,
+					FW_ISO_CAPTURE_REPLAYER_PROP_TYPE_DROPPED_PACKETS,
+		g_param_spec_uint64("dropped-packets", "dropped-packets",
+				    "The number of packets not replayed",
+				    0, G_MAXUINT64, 0,
+				    G_PARAM_READABLE));
+
+	/**
+	 * HinokoFwIsoCaptureReplayer::finished:
+	 * @self: A [class@FwIsoCaptureReplayer].
+	 *
+	 * Emitted once when the last packet in the file is registered to the context without
+	 * [property@FwIsoCaptureReplayer:loop], or when the file has no packet for the channel. The
+	 * subsequent isochronous cycles are filled by skip descriptor until
+	 * [method@FwIsoCaptureReplayer.stop] is called.
+	 *
+	 * Since: 1.1
+	 */
+	fw_iso_capture_replayer_sigs[FW_ISO_CAPTURE_REPLAYER_SIG_TYPE_FINISHED] =
+		g_signal_new("finished",
+			G_OBJECT_CLASS_TYPE(klass),
+			G_SIGNAL_RUN_LAST,
+			G_STRUCT_OFFSET(HinokoFwIsoCaptureReplayerClass, finished),
+			NULL, NULL,
+			g_cclosure_marshal_VOID__VOID,
+			G_TYPE_NONE, 0);
+}
+
+static void hinoko_fw_iso_capture_replayer_init(HinokoFwIsoCaptureReplayer *self)
+{
+	HinokoFwIsoCaptureReplayerPrivate *priv =
+		hinoko_fw_iso_capture_replayer_get_instance_private(self);
+
+	priv->lead_cycles = DEFAULT_LEAD_CYCLES;
+	priv->cycles_per_irq = DEFAULT_CYCLES_PER_IRQ;
+}
+
+/**
+ * hinoko_fw_iso_capture_replayer_new:
+ *
+ * Instantiate [class@FwIsoCaptureReplayer] object and return the instance.
+ *
+ * Returns: an instance of [class@FwIsoCaptureReplayer].
+ *
+ * Since: 1.1
+ */
+HinokoFwIsoCaptureReplayer *hinoko_fw_iso_capture_replayer_new(void)
+{
+	return g_object_new(HINOKO_TYPE_FW_ISO_CAPTURE_REPLAYER, NULL);
+}
+
+// Read the next packet for the channel. In loop mode, the cursor moves back to the first packet at
+// the end of file, and the position advances by the span of file.
+static void fetch_packet(HinokoFwIsoCaptureReplayerPrivate *priv)
+{
+	guint64 cycle;
+	guint channel;
+	gint64 timestamp;
+
+	priv->pending = hinoko_fw_iso_capture_reader_next(priv->reader, &cycle, &channel,
+							  &priv->pending_iso_header, &timestamp,
+							  &priv->pending_payload,
+							  &priv->pending_length);
+	if (!priv->pending && priv->loop) {
+		priv->loop_offset += priv->span;
+		hinoko_fw_iso_capture_reader_seek(priv->reader, priv->first_cycle,
+						  G_GUINT64_CONSTANT(1) << priv->channel);
+		priv->pending = hinoko_fw_iso_capture_reader_next(priv->reader, &cycle, &channel,
+								  &priv->pending_iso_header,
+								  &timestamp,
+								  &priv->pending_payload,
+								  &priv->pending_length);
+	}
+
+	if (priv->pending)
+		priv->pending_position = cycle - priv->first_cycle + priv->loop_offset;
+}
+
+/**
+ * hinoko_fw_iso_capture_replayer_open:
+ * @self: A [class@FwIsoCaptureReplayer].
+ * @path: The path to the file written by [class@FwIsoCaptureWriter].
+ * @channel: The channel of packets to replay, up to 63.
+ * @error: A [struct@GLib.Error].
+ *
+ * Map the file and look up the first packet for the channel. The isochronous cycles before the
+ * first packet are not replayed.
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_capture_replayer_open(HinokoFwIsoCaptureReplayer *self, const char *path,
+					     guint channel, GError **error)
+{
+	HinokoFwIsoCaptureReplayerPrivate *priv;
+	guint64 last_cycle;
+
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_CAPTURE_REPLAYER(self), FALSE);
+	g_return_val_if_fail(path != NULL && strlen(path) > 0, FALSE);
+	g_return_val_if_fail(channel <= IEEE1394_MAX_CHANNEL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	priv = hinoko_fw_iso_capture_replayer_get_instance_private(self);
+	g_return_val_if_fail(priv->ctx == NULL, FALSE);
+
+	if (priv->reader == NULL)
+		priv->reader = hinoko_fw_iso_capture_reader_new();
+
+	if (!hinoko_fw_iso_capture_reader_open(priv->reader, path, error))
+		return FALSE;
+
+	priv->channel = channel;
+	priv->first_cycle = 0;
+	priv->loop_offset = 0;
+
+	hinoko_fw_iso_capture_reader_seek(priv->reader, 0, G_GUINT64_CONSTANT(1) << channel);
+	fetch_packet(priv);
+
+	// The position is relative to the first packet for the channel.
+	if (priv->pending) {
+		priv->first_cycle = priv->pending_position;
+		priv->pending_position = 0;
+	}
+
+	g_object_get(priv->reader, "last-cycle", &last_cycle, NULL);
+	priv->span = last_cycle >= priv->first_cycle ? last_cycle - priv->first_cycle + 1 : 1;
+
+	return TRUE;
+}
+
+static void fill_cycles(HinokoFwIsoCaptureReplayer *self,
+			HinokoFwIsoCaptureReplayerPrivate *priv)
+{
+	while (priv->error == NULL && priv->queued_cycles < priv->lead_cycles) {
+		const guint8 *header = NULL;
+		guint header_length = 0;
+		const guint8 *payload = NULL;
+		guint payload_length = 0;
+		HinokoFwIsoCtxMatchFlag tags = 0;
+		guint sync_code = 0;
+		gboolean schedule_interrupt;
+
+		// The packet in the isochronous cycle already registered is not replayed.
+		if (priv->pending && priv->pending_position < priv->position) {
+			++priv->dropped_packets;
+			fetch_packet(priv);
+			continue;
+		}
+
+		if (priv->pending && priv->pending_position == priv->position) {
+			guint32 iso_header = priv->pending_iso_header;
+			guint length = priv->pending_length;
+
+			if (length >= priv->header_size) {
+				header_length = priv->header_size;
+				header = header_length > 0 ? priv->pending_payload : NULL;
+				payload_length = length - header_length;
+				payload = payload_length > 0 ?
+					  priv->pending_payload + header_length : NULL;
+			} else {
+				// The short packet is padded by zero for the context header.
+				memcpy(priv->header, priv->pending_payload, length);
+				memset(priv->header + length, 0, priv->header_size - length);
+				header = priv->header;
+				header_length = priv->header_size;
+			}
+
+			// The value of tag field is passed to the descriptor as is, while the
+			// packet with 3 is not replayed since the value is reserved in IEEE 1394.
+			tags = ieee1394_iso_header_to_tag(iso_header);
+			sync_code = ieee1394_iso_header_to_sync_code(iso_header);
+
+			if (tags > 2 || payload_length > priv->bytes_per_chunk) {
+				++priv->dropped_packets;
+				header = NULL;
+				header_length = 0;
+				payload = NULL;
+				payload_length = 0;
+			}
+
+			fetch_packet(priv);
+		}
+
+		if (header_length == 0 && payload_length == 0) {
+			tags = 0;
+			sync_code = 0;
+			++priv->skipped_cycles;
+		} else {
+			++priv->replayed_packets;
+		}
+
+		schedule_interrupt = ++priv->accumulated_cycles % priv->cycles_per_irq == 0;
+		if (priv->accumulated_cycles >= G_MAXINT)
+			priv->accumulated_cycles %= priv->cycles_per_irq;
+
+		if (!hinoko_fw_iso_it_register_packet(priv->ctx, tags, sync_code, header,
+						      header_length, payload, payload_length,
+						      schedule_interrupt, &priv->error))
+			break;
+
+		++priv->position;
+		++priv->queued_cycles;
+	}
+
+	if (priv->error == NULL && !priv->pending && !priv->finished) {
+		priv->finished = TRUE;
+		g_signal_emit(self,
+			fw_iso_capture_replayer_sigs[FW_ISO_CAPTURE_REPLAYER_SIG_TYPE_FINISHED], 0);
+	}
+}
+
+static void handle_interrupted(HinokoFwIsoIt *ctx, guint sec, guint cycle, const guint8 *tstamp,
+			       guint tstamp_length, guint count, gpointer user_data)
+{
+	HinokoFwIsoCaptureReplayer *self = HINOKO_FW_ISO_CAPTURE_REPLAYER(user_data);
+	HinokoFwIsoCaptureReplayerPrivate *priv =
+		hinoko_fw_iso_capture_replayer_get_instance_private(self);
+
+	priv->queued_cycles -= MIN(count, priv->queued_cycles);
+
+	// The registered packets are queued to hardware in batch after the signal emission.
+	fill_cycles(self, priv);
+}
+
+/**
+ * hinoko_fw_iso_capture_replayer_start:
+ * @self: A [class@FwIsoCaptureReplayer].
+ * @ctx: A [class@FwIsoIt] which is allocated and mapped, and has no registered packet.
+ * @cycle_match: (array fixed-size=2) (element-type guint16) (in) (nullable): The isochronous
+ *		 cycle to start packet processing, as the same as [method@FwIsoIt.start].
+ * @error: A [struct@GLib.Error].
+ *
+ * Register the packets for [property@FwIsoCaptureReplayer:lead-cycles] isochronous cycles, then
+ * start the context. The signal of context should be emitted in the same thread as the call of
+ * the method. [property@FwIsoIt:underrun-margin] of the context should be zero or less than the
+ * lead time so that the context does not inject skip packets out of the timeline of file.
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_capture_replayer_start(HinokoFwIsoCaptureReplayer *self,
+					      HinokoFwIsoIt *ctx, const guint16 *cycle_match,
+					      GError **error)
+{
+	HinokoFwIsoCaptureReplayerPrivate *priv;
+	const struct fw_iso_ctx_state *state;
+
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_CAPTURE_REPLAYER(self), FALSE);
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_IT(ctx), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	priv = hinoko_fw_iso_capture_replayer_get_instance_private(self);
+	g_return_val_if_fail(priv->reader != NULL, FALSE);
+	g_return_val_if_fail(priv->ctx == NULL, FALSE);
+	g_return_val_if_fail(priv->cycles_per_irq <= priv->lead_cycles, FALSE);
+
+	state = fw_iso_it_get_state(ctx);
+
+	if (state->fd < 0) {
+		generate_fw_iso_ctx_error_coded(error, HINOKO_FW_ISO_CTX_ERROR_NOT_ALLOCATED);
+		return FALSE;
+	}
+
+	if (state->addr == NULL) {
+		generate_fw_iso_ctx_error_coded(error, HINOKO_FW_ISO_CTX_ERROR_NOT_MAPPED);
+		return FALSE;
+	}
+
+	g_return_val_if_fail(!state->running, FALSE);
+	g_return_val_if_fail(state->registered_chunk_count == 0, FALSE);
+	g_return_val_if_fail(priv->lead_cycles <= state->chunks_per_buffer, FALSE);
+
+	priv->header_size = state->header_size;
+	priv->bytes_per_chunk = state->bytes_per_chunk;
+	priv->header = g_malloc0(MAX(priv->header_size, 1));
+
+	// Rewind to the first packet.
+	hinoko_fw_iso_capture_reader_seek(priv->reader, priv->first_cycle,
+					  G_GUINT64_CONSTANT(1) << priv->channel);
+	priv->loop_offset = 0;
+	fetch_packet(priv);
+
+	priv->position = 0;
+	priv->queued_cycles = 0;
+	priv->accumulated_cycles = 0;
+	priv->replayed_packets = 0;
+	priv->skipped_cycles = 0;
+	priv->dropped_packets = 0;
+	priv->finished = FALSE;
+	g_clear_error(&priv->error);
+
+	priv->ctx = g_object_ref(ctx);
+
+	fill_cycles(self, priv);
+	if (priv->error != NULL) {
+		g_propagate_error(error, priv->error);
+		priv->error = NULL;
+		goto error;
+	}
+
+	priv->handler_id = g_signal_connect(ctx, "interrupted", G_CALLBACK(handle_interrupted),
+					    self);
+
+	if (!hinoko_fw_iso_it_start(ctx, cycle_match, error)) {
+		g_signal_handler_disconnect(ctx, priv->handler_id);
+		priv->handler_id = 0;
+		goto error;
+	}
+
+	return TRUE;
+error:
+	// Discard the registered packets so that the context can be started again.
+	fw_iso_it_recycle(ctx);
+	g_object_unref(priv->ctx);
+	priv->ctx = NULL;
+	g_free(priv->header);
+	priv->header = NULL;
+	return FALSE;
+}
+
+/**
+ * hinoko_fw_iso_capture_replayer_stop:
+ * @self: A [class@FwIsoCaptureReplayer].
+ * @error: A [struct@GLib.Error].
+ *
+ * Stop the context and replaying. The error to register packet in the handler of
+ * [signal@FwIsoIt::interrupted] is reported.
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_capture_replayer_stop(HinokoFwIsoCaptureReplayer *self, GError **error)
+{
+	HinokoFwIsoCaptureReplayerPrivate *priv;
+
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_CAPTURE_REPLAYER(self), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	priv = hinoko_fw_iso_capture_replayer_get_instance_private(self);
+
+	if (priv->ctx != NULL) {
+		g_signal_handler_disconnect(priv->ctx, priv->handler_id);
+		hinoko_fw_iso_ctx_stop(HINOKO_FW_ISO_CTX(priv->ctx));
+		g_object_unref(priv->ctx);
+		priv->ctx = NULL;
+		priv->handler_id = 0;
+	}
+
+	g_free(priv->header);
+	priv->header = NULL;
+
+	if (priv->error != NULL) {
+		g_propagate_error(error, priv->error);
+		priv->error = NULL;
+		return FALSE;
+	}
+
+	return TRUE;
+}
@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#ifndef __ORG_KERNEL_HINOKO_FW_ISO_CAPTURE_REPLAYER_H__
+#define __ORG_KERNEL_HINOKO_FW_ISO_CAPTURE_REPLAYER_H__
+
+#include <hinoko.h>
+
+G_BEGIN_DECLS
+
+#define HINOKO_TYPE_FW_ISO_CAPTURE_REPLAYER	(hinoko_fw_iso_capture_replayer_get_type())
+
+G_DECLARE_DERIVABLE_TYPE(HinokoFwIsoCaptureReplayer, hinoko_fw_iso_capture_replayer, HINOKO,
+			 FW_ISO_CAPTURE_REPLAYER, GObject);
+
+struct _HinokoFwIsoCaptureReplayerClass {
+	GObjectClass parent_class;
+
+	/**
+	 * HinokoFwIsoCaptureReplayerClass::finished:
+	 * @self: A [class@FwIsoCaptureReplayer].
+	 *
+	 * Class closure for the [signal@FwIsoCaptureReplayer::finished] signal.
+	 *
+	 * Since: 1.1
+	 */
+	void (*finished)(HinokoFwIsoCaptureReplayer *self);
+};
+
+HinokoFwIsoCaptureReplayer *hinoko_fw_iso_capture_replayer_new(void);
+
+gboolean hinoko_fw_iso_capture_replayer_open(HinokoFwIsoCaptureReplayer *self, const char *path,
+					     guint channel, GError **error);
+
+gboolean hinoko_fw_iso_capture_replayer_start(HinokoFwIsoCaptureReplayer *self,
+					      HinokoFwIsoIt *ctx, const guint16 *cycle_match,
+					      GError **error);
+
+gboolean hinoko_fw_iso_capture_replayer_stop(HinokoFwIsoCaptureReplayer *self, GError **error);
+
+G_END_DECLS
+
+#endif
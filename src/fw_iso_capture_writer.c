@@ -0,0 +1,948 @@
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#define _GNU_SOURCE
+#include "fw_iso_capture_private.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <stdlib.h>
+
+/**
+ * HinokoFwIsoCaptureWriter:
+ * A sink to write isochronous packets received by IR context into files.
+ *
+ * [class@FwIsoCaptureWriter] listens to [signal@FwIsoIrSingle::interrupted] or
+ * [signal@FwIsoIrMultiple::interrupted] of the attached context, and serializes each received
+ * packet into record with isochronous packet header, timestamp, channel, and payload. The records
+ * are copied from the mapped buffer of context into the batches of fixed size allocated in
+ * advance, then the dedicated thread writes the filled batches to the file. No system call is
+ * executed in the handler of signal, and the memory allocation is limited to the rare growth of
+ * index. When every batch is in flight, the records are dropped and counted by
+ * [property@FwIsoCaptureWriter:dropped-packets]. The room for the index of file is reserved in the
+ * batches before accepting each record, thus the index is written at the rotation of file even
+ * under the heavy load.
+ *
+ * The records are grouped into chunks by [property@FwIsoCaptureWriter:chunk-cycles], and the
+ * index of chunks keyed by the absolute isochronous cycle is appended to the end of file so that
+ * [class@FwIsoCaptureReader] seeks without scanning the whole file. The isochronous cycle is
+ * available when the context header includes timestamp for [class@FwIsoIrSingle].
+ *
+ * The system time of packet is recorded when [property@FwIsoIrSingle:timestamp-packets] or
+ * [property@FwIsoIrMultiple:timestamp-packets] is enabled. The file is rotated when either the
+ * size of file or the elapsed time reaches the threshold.
+ */
+struct capture_batch {
+	guint8 *data;
+	gsize length;
+};
+
+typedef struct {
+	gsize batch_size;
+	guint batch_count;
+	gboolean direct_io;
+	guint64 rotate_bytes;
+	guint rotate_interval;
+	guint chunk_cycles;
+
+	guint64 captured_packets;
+	guint64 dropped_packets;
+
+	// Accessed in the thread of caller.
+	HinokoFwIsoCtx *ctx;
+	gulong handler_id;
+	struct capture_batch *batches;
+	struct capture_batch *batch;
+	guint64 file_bytes;
+	gint64 file_begin;
+	GArray *index;
+	guint64 cycle;
+	gboolean cycle_known;
+	guint64 chunk_cycle;
+
+	// Shared with the writer thread.
+	GAsyncQueue *free_batches;
+	GAsyncQueue *filled_batches;
+	GThread *thread;
+	gint failed;
+	GError *error;
+
+	// Accessed in the writer thread.
+	gchar *path;
+	gboolean rotatable;
+	guint file_index;
+	int fd;
+	guint64 file_offset;
+} HinokoFwIsoCaptureWriterPrivate;
+
+G_DEFINE_TYPE_WITH_PRIVATE(HinokoFwIsoCaptureWriter, hinoko_fw_iso_capture_writer, G_TYPE_OBJECT)
+
+#define generate_file_error(error, code, format, arg)		\
+	g_set_error(error, G_FILE_ERROR, code, format, arg)
+
+// The alignment of buffer and length for the write with O_DIRECT.
+#define DIRECT_IO_ALIGN			4096
+#define DIRECT_IO_ALIGN_SIZE(size)	\
+	(((size) + DIRECT_IO_ALIGN - 1) & ~((gsize)DIRECT_IO_ALIGN - 1))
+
+#define DEFAULT_BATCH_SIZE		(1024 * 1024)
+#define DEFAULT_BATCH_COUNT		64
+#define DEFAULT_CHUNK_CYCLES		1000
+#define DEFAULT_INDEX_SIZE		4096
+
+// The markers queued to the writer thread to close the file.
+static struct capture_batch rotate_marker;
+static struct capture_batch quit_marker;
+
+enum fw_iso_capture_writer_prop_type {
+	FW_ISO_CAPTURE_WRITER_PROP_TYPE_BATCH_SIZE = 1,
+	FW_ISO_CAPTURE_WRITER_PROP_TYPE_BATCH_COUNT,
+	FW_ISO_CAPTURE_WRITER_PROP_TYPE_DIRECT_IO,
+	FW_ISO_CAPTURE_WRITER_PROP_TYPE_ROTATE_BYTES,
+	FW_ISO_CAPTURE_WRITER_PROP_TYPE_ROTATE_INTERVAL,
+	FW_ISO_CAPTURE_WRITER_PROP_TYPE_CHUNK_CYCLES,
+	FW_ISO_CAPTURE_WRITER_PROP_TYPE_CAPTURED_PACKETS,
+	FW_ISO_CAPTURE_WRITER_PROP_TYPE_DROPPED_PACKETS,
+	FW_ISO_CAPTURE_WRITER_PROP_TYPE_COUNT,
+};
+
+static void fw_iso_capture_writer_get_property(GObject *obj, guint id, GValue *val,
+					       GParamSpec *spec)
+{
+	HinokoFwIsoCaptureWriter *self = HINOKO_FW_ISO_CAPTURE_WRITER(obj);
+	HinokoFwIsoCaptureWriterPrivate *priv =
+		hinoko_fw_iso_capture_writer_get_instance_private(self);
+
+	switch (id) {
+	case FW_ISO_CAPTURE_WRITER_PROP_TYPE_BATCH_SIZE:
+		g_value_set_uint(val, (guint)priv->batch_size);
+		break;
+	case FW_ISO_CAPTURE_WRITER_PROP_TYPE_BATCH_COUNT:
+		g_value_set_uint(val, priv->batch_count);
+		break;
+	case FW_ISO_CAPTURE_WRITER_PROP_TYPE_DIRECT_IO:
+		g_value_set_boolean(val, priv->direct_io);
+		break;
+	case FW_ISO_CAPTURE_WRITER_PROP_TYPE_ROTATE_BYTES:
+		g_value_set_uint64(val, priv->rotate_bytes);
+		break;
+	case FW_ISO_CAPTURE_WRITER_PROP_TYPE_ROTATE_INTERVAL:
+		g_value_set_uint(val, priv->rotate_interval);
+		break;
+	case FW_ISO_CAPTURE_WRITER_PROP_TYPE_CHUNK_CYCLES:
+		g_value_set_uint(val, priv->chunk_cycles);
+		break;
+	case FW_ISO_CAPTURE_WRITER_PROP_TYPE_CAPTURED_PACKETS:
+		g_value_set_uint64(val, priv->captured_packets);
+		break;
+	case FW_ISO_CAPTURE_WRITER_PROP_TYPE_DROPPED_PACKETS:
+		g_value_set_uint64(val, priv->dropped_packets);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, id, spec);
+		break;
+	}
+}
+
+static void fw_iso_capture_writer_set_property(GObject *obj, guint id, const GValue *val,
+					       GParamSpec *spec)
+{
+	HinokoFwIsoCaptureWriter *self = HINOKO_FW_ISO_CAPTURE_WRITER(obj);
+	HinokoFwIsoCaptureWriterPrivate *priv =
+		hinoko_fw_iso_capture_writer_get_instance_private(self);
+
+	// The parameters are fixed while the file is opened.
+	if (priv->thread != NULL) {
+		g_warning("The parameter is not changed while the file is opened");
+		return;
+	}
+
+	switch (id) {
+	case FW_ISO_CAPTURE_WRITER_PROP_TYPE_BATCH_SIZE:
+		priv->batch_size = g_value_get_uint(val);
+		break;
+	case FW_ISO_CAPTURE_WRITER_PROP_TYPE_BATCH_COUNT:
+		priv->batch_count = g_value_get_uint(val);
+		break;
+	case FW_ISO_CAPTURE_WRITER_PROP_TYPE_DIRECT_IO:
+		priv->direct_io = g_value_get_boolean(val);
+		break;
+	case FW_ISO_CAPTURE_WRITER_PROP_TYPE_ROTATE_BYTES:
+		priv->rotate_bytes = g_value_get_uint64(val);
+		break;
+	case FW_ISO_CAPTURE_WRITER_PROP_TYPE_ROTATE_INTERVAL:
+		priv->rotate_interval = g_value_get_uint(val);
+		break;
+	case FW_ISO_CAPTURE_WRITER_PROP_TYPE_CHUNK_CYCLES:
+		priv->chunk_cycles = g_value_get_uint(val);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, id, spec);
+		break;
+	}
+}
+
+static void fw_iso_capture_writer_finalize(GObject *obj)
+{
+	HinokoFwIsoCaptureWriter *self = HINOKO_FW_ISO_CAPTURE_WRITER(obj);
+
+	hinoko_fw_iso_capture_writer_close(self, NULL);
+
+	G_OBJECT_CLASS(hinoko_fw_iso_capture_writer_parent_class)->finalize(obj);
+}
+
+static void hinoko_fw_iso_capture_writer_class_init(HinokoFwIsoCaptureWriterClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+
+	gobject_class->get_property = fw_iso_capture_writer_get_property;
+	gobject_class->set_property = fw_iso_capture_writer_set_property;
+	gobject_class->finalize = fw_iso_capture_writer_finalize;
+
+	/**
+	 * HinokoFwIsoCaptureWriter:batch-size:
+	 *
+	 * The number of bytes in each batch written to the file at once. It is rounded up to the
+	 * size of block for direct I/O when opening the file.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_CAPTURE_WRITER_PROP_TYPE_BATCH_SIZE,
+		g_param_spec_uint("batch-size", "batch-size",
+				  "The number of bytes in each batch",
+				  DIRECT_IO_ALIGN, G_MAXINT, DEFAULT_BATCH_SIZE,
+				  G_PARAM_READWRITE));
+
+	/**
+	 * HinokoFwIsoCaptureWriter:batch-count:
+	 *
+	 * The number of batches allocated when opening the file. The product of the size and the
+	 * count of batch is the room to absorb the latency of storage.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_CAPTURE_WRITER_PROP_TYPE_BATCH_COUNT,
+		g_param_spec_uint("batch-count", "batch-count",
+				  "The number of batches",
+				  2, G_MAXUINT16, DEFAULT_BATCH_COUNT,
+				  G_PARAM_READWRITE));
+
+	/**
+	 * HinokoFwIsoCaptureWriter:direct-io:
+	 *
+	 * Whether to open the file with O_DIRECT to bypass page cache. The file system should
+	 * support it.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_CAPTURE_WRITER_PROP_TYPE_DIRECT_IO,
+		g_param_spec_boolean("direct-io", "direct-io",
+				     "Whether to open the file with O_DIRECT",
+				     FALSE,
+				     G_PARAM_READWRITE));
+
+	/**
+	 * HinokoFwIsoCaptureWriter:rotate-bytes:
+	 *
+	 * The maximum number of bytes in each file. The subsequent records are written to the next
+	 * file when the size exceeds it. Zero means no rotation by size.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_CAPTURE_WRITER_PROP_TYPE_ROTATE_BYTES,
+		g_param_spec_uint64("rotate-bytes", "rotate-bytes",
+				    "The maximum number of bytes in each file",
+				    0, G_MAXUINT64, 0,
+				    G_PARAM_READWRITE));
+
+	/**
+	 * HinokoFwIsoCaptureWriter:rotate-interval:
+	 *
+	 * The interval in seconds to write the subsequent records to the next file. Zero means no
+	 * rotation by time.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class,
+					FW_ISO_CAPTURE_WRITER_PROP_TYPE_ROTATE_INTERVAL,
+		g_param_spec_uint("rotate-interval", "rotate-interval",
+				  "The interval in seconds to rotate the file",
+				  0, G_MAXUINT, 0,
+				  G_PARAM_READWRITE));
+
+	/**
+	 * HinokoFwIsoCaptureWriter:chunk-cycles:
+	 *
+	 * The number of isochronous cycles covered by each chunk of records. The index of file has
+	 * an entry per chunk, thus the smaller value results in the finer granularity to seek and
+	 * the larger index.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_CAPTURE_WRITER_PROP_TYPE_CHUNK_CYCLES,
+		g_param_spec_uint("chunk-cycles", "chunk-cycles",
+				  "The number of isochronous cycles covered by each chunk",
+				  1, G_MAXUINT, DEFAULT_CHUNK_CYCLES,
+				  G_PARAM_READWRITE));
+
+	/**
+	 * HinokoFwIsoCaptureWriter:captured-packets:
+	 *
+	 * The number of packets recorded since the file is opened.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class,
+					FW_ISO_CAPTURE_WRITER_PROP_TYPE_CAPTURED_PACKETS,
+		g_param_spec_uint64("captured-packets", "captured-packets",
+				    "The number of recorded packets",
+				    0, G_MAXUINT64, 0,
+				    G_PARAM_READABLE));
+
+	/**
+	 * HinokoFwIsoCaptureWriter:dropped-packets:
+	 *
+	 * The number of packets dropped since the file is opened, due to the shortage of batch, the
+	 * failure to write, or the frame of [class@FwIsoIrMultiple] too short to include
+	 * isochronous header and timestamp.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class,
+					FW_ISO_CAPTURE_WRITER_PROP_TYPE_DROPPED_PACKETS,
+		g_param_spec_uint64("dropped-packets", "dropped-packets",
+				    "The number of dropped packets",
+				    0, G_MAXUINT64, 0,
+				    G_PARAM_READABLE));
+}
+
+static void hinoko_fw_iso_capture_writer_init(HinokoFwIsoCaptureWriter *self)
+{
+	HinokoFwIsoCaptureWriterPrivate *priv =
+		hinoko_fw_iso_capture_writer_get_instance_private(self);
+
+	priv->batch_size = DEFAULT_BATCH_SIZE;
+	priv->batch_count = DEFAULT_BATCH_COUNT;
+	priv->chunk_cycles = DEFAULT_CHUNK_CYCLES;
+	priv->fd = -1;
+}
+
+/**
+ * hinoko_fw_iso_capture_writer_new:
+ *
+ * Instantiate [class@FwIsoCaptureWriter] object and return the instance.
+ *
+ * Returns: an instance of [class@FwIsoCaptureWriter].
+ *
+ * Since: 1.1
+ */
+HinokoFwIsoCaptureWriter *hinoko_fw_iso_capture_writer_new(void)
+{
+	return g_object_new(HINOKO_TYPE_FW_ISO_CAPTURE_WRITER, NULL);
+}
+
+static gboolean open_file(HinokoFwIsoCaptureWriterPrivate *priv, GError **error)
+{
+	int flags = O_WRONLY | O_CREAT | O_TRUNC;
+	gchar *path;
+
+	if (priv->direct_io)
+		flags |= O_DIRECT;
+
+	// The index is appended to the name of file when the rotation is enabled.
+	if (priv->rotatable)
+		path = g_strdup_printf("%s.%06u", priv->path, priv->file_index);
+	else
+		path = g_strdup(priv->path);
+
+	priv->fd = open(path, flags, 0644);
+	if (priv->fd < 0) {
+		GFileError code = g_file_error_from_errno(errno);
+		if (code != G_FILE_ERROR_FAILED)
+			generate_file_error(error, code, "open(%s)", path);
+		else
+			generate_syscall_error(error, errno, "open(%s)", path);
+		g_free(path);
+		return FALSE;
+	}
+	g_free(path);
+
+	++priv->file_index;
+	priv->file_offset = 0;
+
+	return TRUE;
+}
+
+static gboolean close_file(HinokoFwIsoCaptureWriterPrivate *priv, GError **error)
+{
+	gboolean result = TRUE;
+
+	if (priv->fd < 0)
+		return TRUE;
+
+	// The last batch is written with padding for O_DIRECT, thus truncate it.
+	if (priv->direct_io && ftruncate(priv->fd, priv->file_offset) < 0) {
+		generate_syscall_error(error, errno, "ftruncate(%" G_GUINT64_FORMAT ")",
+				       priv->file_offset);
+		result = FALSE;
+	}
+
+	close(priv->fd);
+	priv->fd = -1;
+
+	return result;
+}
+
+static gboolean write_batch(HinokoFwIsoCaptureWriterPrivate *priv, struct capture_batch *batch,
+			    GError **error)
+{
+	gsize length = batch->length;
+	gsize done = 0;
+
+	if (priv->direct_io) {
+		length = DIRECT_IO_ALIGN_SIZE(length);
+		memset(batch->data + batch->length, 0, length - batch->length);
+	}
+
+	while (done < length) {
+		ssize_t len = write(priv->fd, batch->data + done, length - done);
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+			generate_syscall_error(error, errno, "write(%zu)", length - done);
+			return FALSE;
+		}
+		done += len;
+	}
+
+	priv->file_offset += batch->length;
+
+	return TRUE;
+}
+
+static gpointer write_batches(gpointer data)
+{
+	HinokoFwIsoCaptureWriterPrivate *priv = data;
+	GError *error = NULL;
+
+	while (TRUE) {
+		struct capture_batch *batch = g_async_queue_pop(priv->filled_batches);
+
+		if (batch == &rotate_marker || batch == &quit_marker) {
+			if (!close_file(priv, error == NULL ? &error : NULL))
+				g_atomic_int_set(&priv->failed, TRUE);
+			if (batch == &quit_marker)
+				break;
+			continue;
+		}
+
+		if (!g_atomic_int_get(&priv->failed)) {
+			if ((priv->fd < 0 && !open_file(priv, &error)) ||
+			    !write_batch(priv, batch, &error))
+				g_atomic_int_set(&priv->failed, TRUE);
+		}
+
+		g_async_queue_push(priv->free_batches, batch);
+	}
+
+	priv->error = error;
+
+	return NULL;
+}
+
+static void release_batches(HinokoFwIsoCaptureWriterPrivate *priv)
+{
+	guint i;
+
+	for (i = 0; i < priv->batch_count; ++i)
+		free(priv->batches[i].data);
+	g_free(priv->batches);
+	priv->batches = NULL;
+	priv->batch = NULL;
+
+	g_async_queue_unref(priv->free_batches);
+	priv->free_batches = NULL;
+	g_async_queue_unref(priv->filled_batches);
+	priv->filled_batches = NULL;
+
+	if (priv->index != NULL) {
+		g_array_unref(priv->index);
+		priv->index = NULL;
+	}
+}
+
+/**
+ * hinoko_fw_iso_capture_writer_open:
+ * @self: A [class@FwIsoCaptureWriter].
+ * @path: A path of file to write records.
+ * @error: A [struct@GLib.Error].
+ *
+ * Open the file, allocate the batches, and launch the thread to write them. When either
+ * [property@FwIsoCaptureWriter:rotate-bytes] or [property@FwIsoCaptureWriter:rotate-interval] is
+ * not zero, the files are named with the index of rotation in six digits suffixed to @path, like
+ * `capture.000000`.
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_capture_writer_open(HinokoFwIsoCaptureWriter *self, const char *path,
+					   GError **error)
+{
+	HinokoFwIsoCaptureWriterPrivate *priv;
+	guint i;
+
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_CAPTURE_WRITER(self), FALSE);
+	g_return_val_if_fail(path != NULL && strlen(path) > 0, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	priv = hinoko_fw_iso_capture_writer_get_instance_private(self);
+	g_return_val_if_fail(priv->thread == NULL, FALSE);
+
+	priv->path = g_strdup(path);
+	priv->rotatable = priv->rotate_bytes > 0 || priv->rotate_interval > 0;
+	priv->file_index = 0;
+
+	// Open the first file in advance to report error immediately.
+	if (!open_file(priv, error)) {
+		g_free(priv->path);
+		priv->path = NULL;
+		return FALSE;
+	}
+
+	priv->batch_size = DIRECT_IO_ALIGN_SIZE(priv->batch_size);
+	priv->batches = g_new0(struct capture_batch, priv->batch_count);
+	priv->free_batches = g_async_queue_new();
+	priv->filled_batches = g_async_queue_new();
+
+	for (i = 0; i < priv->batch_count; ++i) {
+		struct capture_batch *batch = &priv->batches[i];
+		int err;
+
+		err = posix_memalign((void **)&batch->data, DIRECT_IO_ALIGN, priv->batch_size);
+		if (err != 0) {
+			generate_syscall_error(error, err, "posix_memalign(%zu)", priv->batch_size);
+			goto error;
+		}
+		g_async_queue_push(priv->free_batches, batch);
+	}
+
+	// The index grows by doubling, thus it is rarely reallocated in the handler of signal.
+	priv->index = g_array_sized_new(FALSE, TRUE, sizeof(struct fw_iso_capture_index_entry),
+					DEFAULT_INDEX_SIZE);
+	priv->cycle_known = FALSE;
+
+	priv->captured_packets = 0;
+	priv->dropped_packets = 0;
+	priv->file_bytes = 0;
+	priv->failed = FALSE;
+
+	priv->thread = g_thread_try_new("hinoko-capture", write_batches, priv, error);
+	if (priv->thread == NULL)
+		goto error;
+
+	return TRUE;
+error:
+	release_batches(priv);
+	close_file(priv, NULL);
+	g_free(priv->path);
+	priv->path = NULL;
+	return FALSE;
+}
+
+static void flush_batch(HinokoFwIsoCaptureWriterPrivate *priv)
+{
+	if (priv->batch != NULL) {
+		g_async_queue_push(priv->filled_batches, priv->batch);
+		priv->batch = NULL;
+	}
+}
+
+// The content is split at the boundary of batches so that every batch except for the last one in
+// the file is fully filled.
+static void append_bytes(HinokoFwIsoCaptureWriterPrivate *priv, const void *data, gsize length,
+			 gboolean wait)
+{
+	priv->file_bytes += length;
+
+	while (length > 0) {
+		struct capture_batch *batch;
+		gsize size;
+
+		if (priv->batch == NULL) {
+			if (wait)
+				priv->batch = g_async_queue_pop(priv->free_batches);
+			else
+				priv->batch = g_async_queue_try_pop(priv->free_batches);
+			priv->batch->length = 0;
+		}
+		batch = priv->batch;
+
+		size = MIN(length, priv->batch_size - batch->length);
+		if (data != NULL) {
+			memcpy(batch->data + batch->length, data, size);
+			data = (const guint8 *)data + size;
+		} else {
+			memset(batch->data + batch->length, 0, size);
+		}
+		batch->length += size;
+		length -= size;
+
+		if (batch->length == priv->batch_size)
+			flush_batch(priv);
+	}
+}
+
+// The writer thread just increases the number of free batches.
+static gboolean has_room(HinokoFwIsoCaptureWriterPrivate *priv, gsize size)
+{
+	gsize avail = (gsize)MAX(g_async_queue_length(priv->free_batches), 0) * priv->batch_size;
+
+	if (priv->batch != NULL)
+		avail += priv->batch_size - priv->batch->length;
+
+	return avail >= size;
+}
+
+// The room for the index and the trailer when the given number of entries are in the index.
+static gsize index_room(guint entry_count)
+{
+	if (entry_count == 0)
+		return 0;
+
+	return entry_count * sizeof(struct fw_iso_capture_index_entry) +
+	       sizeof(struct fw_iso_capture_trailer);
+}
+
+// In the handler of signal, the room for the index is reserved when accepting each record, thus
+// the batches are always available for the index.
+static void append_index(HinokoFwIsoCaptureWriterPrivate *priv, gboolean wait)
+{
+	struct fw_iso_capture_trailer trailer = {0};
+	gsize index_size = priv->index->len * sizeof(struct fw_iso_capture_index_entry);
+
+	if (priv->index->len == 0)
+		return;
+
+	trailer.index_offset = GUINT64_TO_LE(priv->file_bytes);
+	trailer.index_count = GUINT32_TO_LE(priv->index->len);
+	memcpy(trailer.magic, FW_ISO_CAPTURE_INDEX_MAGIC, sizeof(trailer.magic));
+
+	append_bytes(priv, priv->index->data, index_size, wait);
+	append_bytes(priv, &trailer, sizeof(trailer), wait);
+}
+
+static void finish_file(HinokoFwIsoCaptureWriterPrivate *priv, gboolean wait)
+{
+	append_index(priv, wait);
+	flush_batch(priv);
+
+	g_array_set_size(priv->index, 0);
+	priv->file_bytes = 0;
+}
+
+static void rotate_file(HinokoFwIsoCaptureWriterPrivate *priv)
+{
+	finish_file(priv, FALSE);
+	g_async_queue_push(priv->filled_batches, &rotate_marker);
+}
+
+static void begin_file(HinokoFwIsoCaptureWriterPrivate *priv)
+{
+	struct fw_iso_capture_file_header header = {0};
+
+	memcpy(header.magic, FW_ISO_CAPTURE_MAGIC, sizeof(header.magic));
+	header.version = GUINT32_TO_LE(FW_ISO_CAPTURE_VERSION);
+	append_bytes(priv, &header, sizeof(header), FALSE);
+
+	priv->file_begin = g_get_monotonic_time();
+}
+
+static void begin_chunk(HinokoFwIsoCaptureWriterPrivate *priv)
+{
+	struct fw_iso_capture_index_entry entry = {0};
+	struct fw_iso_capture_record record = {0};
+	struct fw_iso_capture_chunk chunk = {0};
+
+	// The entries are kept in little endian so that they are written as is.
+	entry.cycle = GUINT64_TO_LE(priv->cycle);
+	entry.offset = GUINT64_TO_LE(priv->file_bytes);
+	g_array_append_val(priv->index, entry);
+	priv->chunk_cycle = priv->cycle;
+
+	record.length = GUINT32_TO_LE(sizeof(chunk));
+	record.cycles = GUINT16_TO_LE(FW_ISO_CAPTURE_CYCLES_UNKNOWN);
+	record.type = FW_ISO_CAPTURE_RECORD_TYPE_CHUNK;
+	chunk.cycle = GUINT64_TO_LE(priv->cycle);
+
+	append_bytes(priv, &record, sizeof(record), FALSE);
+	append_bytes(priv, &chunk, sizeof(chunk), FALSE);
+}
+
+// The payload can be given in two parts, since the leading quadlets of payload can be in the
+// context header.
+static void write_record(HinokoFwIsoCaptureWriterPrivate *priv,
+			 struct fw_iso_capture_record *record, const guint8 *head,
+			 guint head_length, const guint8 *payload, guint payload_length)
+{
+	guint cycles = GUINT16_FROM_LE(record->cycles);
+	guint length = head_length + payload_length;
+	gsize padded = FW_ISO_CAPTURE_RECORD_ALIGN(length);
+	gsize size = sizeof(*record) + padded;
+	struct fw_iso_capture_index_entry *entry;
+	gboolean chunk_begins;
+
+	if (g_atomic_int_get(&priv->failed))
+		goto drop;
+
+	if (cycles != FW_ISO_CAPTURE_CYCLES_UNKNOWN) {
+		if (!priv->cycle_known) {
+			priv->cycle = cycles;
+			priv->cycle_known = TRUE;
+		} else {
+			priv->cycle = fw_iso_capture_unwrap_cycle(priv->cycle, cycles);
+		}
+	}
+
+	if (priv->rotate_bytes > 0 && priv->file_bytes > 0 &&
+	    priv->file_bytes + size > priv->rotate_bytes)
+		rotate_file(priv);
+
+	chunk_begins = priv->index->len == 0 ||
+		       priv->cycle >= priv->chunk_cycle + priv->chunk_cycles;
+	if (chunk_begins)
+		size += sizeof(*record) + sizeof(struct fw_iso_capture_chunk);
+	if (priv->file_bytes == 0)
+		size += sizeof(struct fw_iso_capture_file_header);
+	if (!has_room(priv, size + index_room(priv->index->len + (chunk_begins ? 1 : 0))))
+		goto drop;
+
+	if (priv->file_bytes == 0)
+		begin_file(priv);
+	if (chunk_begins)
+		begin_chunk(priv);
+
+	record->length = GUINT32_TO_LE(length);
+	record->type = FW_ISO_CAPTURE_RECORD_TYPE_PACKET;
+	append_bytes(priv, record, sizeof(*record), FALSE);
+	append_bytes(priv, head, head_length, FALSE);
+	append_bytes(priv, payload, payload_length, FALSE);
+	append_bytes(priv, NULL, padded - length, FALSE);
+
+	entry = &g_array_index(priv->index, struct fw_iso_capture_index_entry,
+			       priv->index->len - 1);
+	entry->channels |= GUINT64_TO_LE(G_GUINT64_CONSTANT(1) << record->channel);
+
+	++priv->captured_packets;
+	return;
+drop:
+	++priv->dropped_packets;
+}
+
+static void check_rotate_interval(HinokoFwIsoCaptureWriterPrivate *priv)
+{
+	if (priv->rotate_interval > 0 && priv->file_bytes > 0 &&
+	    g_get_monotonic_time() - priv->file_begin >=
+	    (gint64)priv->rotate_interval * G_USEC_PER_SEC)
+		rotate_file(priv);
+}
+
+static void handle_ir_single_interrupted(HinokoFwIsoIrSingle *ctx, guint sec, guint cycle,
+					 const guint8 *header, guint header_length, guint count,
+					 gpointer user_data)
+{
+	HinokoFwIsoCaptureWriter *self = HINOKO_FW_ISO_CAPTURE_WRITER(user_data);
+	HinokoFwIsoCaptureWriterPrivate *priv =
+		hinoko_fw_iso_capture_writer_get_instance_private(self);
+	const gint64 *timestamps;
+	guint timestamp_count;
+	guint header_size;
+	guint i;
+
+	if (count == 0)
+		return;
+
+	check_rotate_interval(priv);
+
+	header_size = header_length / count;
+	hinoko_fw_iso_ir_single_get_timestamps(ctx, &timestamps, &timestamp_count);
+
+	// The context header for each packet includes isochronous packet header in the first
+	// quadlet, timestamp in the second quadlet, and the leading quadlets of payload in the
+	// rest.
+	for (i = 0; i < count; ++i) {
+		const guint32 *quadlets = (const guint32 *)(header + i * header_size);
+		struct fw_iso_capture_record record = {0};
+		const guint8 *payload;
+		guint length;
+
+		hinoko_fw_iso_ir_single_get_payload(ctx, i, &payload, &length);
+
+		if (header_size >= 4) {
+			guint32 iso_header = GUINT32_FROM_BE(quadlets[0]);
+
+			record.iso_header = GUINT32_TO_LE(iso_header);
+			record.channel = ieee1394_iso_header_to_channel(iso_header);
+		}
+
+		if (header_size >= 8) {
+			guint32 tstamp = GUINT32_FROM_BE(quadlets[1]);
+
+			record.cycles = GUINT16_TO_LE(ohci1394_isoc_desc_tstamp_to_cycles(tstamp));
+		} else {
+			record.cycles = GUINT16_TO_LE(FW_ISO_CAPTURE_CYCLES_UNKNOWN);
+		}
+
+		if (i < timestamp_count)
+			record.timestamp = GINT64_TO_LE(timestamps[i]);
+
+		if (header_size > 8) {
+			write_record(priv, &record, header + i * header_size + 8, header_size - 8,
+				     payload, length);
+		} else {
+			write_record(priv, &record, NULL, 0, payload, length);
+		}
+	}
+}
+
+static void handle_ir_multiple_interrupted(HinokoFwIsoIrMultiple *ctx, guint count,
+					   gpointer user_data)
+{
+	HinokoFwIsoCaptureWriter *self = HINOKO_FW_ISO_CAPTURE_WRITER(user_data);
+	HinokoFwIsoCaptureWriterPrivate *priv =
+		hinoko_fw_iso_capture_writer_get_instance_private(self);
+	const gint64 *timestamps;
+	guint timestamp_count;
+	guint i;
+
+	if (count == 0)
+		return;
+
+	check_rotate_interval(priv);
+
+	hinoko_fw_iso_ir_multiple_get_timestamps(ctx, &timestamps, &timestamp_count);
+
+	// The payload is sandwitched by heading isochronous header and trailing timestamp.
+	for (i = 0; i < count; ++i) {
+		struct fw_iso_capture_record record = {0};
+		const guint8 *payload;
+		guint length;
+		guint32 iso_header;
+		guint32 tstamp;
+
+		hinoko_fw_iso_ir_multiple_get_payload(ctx, i, &payload, &length);
+		if (length < 8) {
+			++priv->dropped_packets;
+			continue;
+		}
+
+		iso_header = GUINT32_FROM_LE(*(const guint32 *)payload);
+		tstamp = GUINT32_FROM_LE(*(const guint32 *)(payload + length - 4));
+
+		record.iso_header = GUINT32_TO_LE(iso_header);
+		record.channel = ieee1394_iso_header_to_channel(iso_header);
+		record.cycles = GUINT16_TO_LE(ohci1394_isoc_desc_tstamp_to_cycles(tstamp));
+		if (i < timestamp_count)
+			record.timestamp = GINT64_TO_LE(timestamps[i]);
+
+		write_record(priv, &record, NULL, 0, payload + 4, length - 8);
+	}
+}
+
+/**
+ * hinoko_fw_iso_capture_writer_attach:
+ * @self: A [class@FwIsoCaptureWriter].
+ * @ctx: A [class@FwIsoIrSingle] or [class@FwIsoIrMultiple].
+ *
+ * Start recording packets received by the IR context. The file should be opened in advance. The
+ * signal of context should be emitted in the same thread as the call of the method.
+ *
+ * Since: 1.1
+ */
+void hinoko_fw_iso_capture_writer_attach(HinokoFwIsoCaptureWriter *self, HinokoFwIsoCtx *ctx)
+{
+	HinokoFwIsoCaptureWriterPrivate *priv;
+
+	g_return_if_fail(HINOKO_IS_FW_ISO_CAPTURE_WRITER(self));
+	g_return_if_fail(HINOKO_IS_FW_ISO_IR_SINGLE(ctx) || HINOKO_IS_FW_ISO_IR_MULTIPLE(ctx));
+
+	priv = hinoko_fw_iso_capture_writer_get_instance_private(self);
+	g_return_if_fail(priv->thread != NULL);
+	g_return_if_fail(priv->ctx == NULL);
+
+	if (HINOKO_IS_FW_ISO_IR_SINGLE(ctx)) {
+		priv->handler_id = g_signal_connect(ctx, "interrupted",
+						    G_CALLBACK(handle_ir_single_interrupted), self);
+	} else {
+		priv->handler_id = g_signal_connect(ctx, "interrupted",
+						    G_CALLBACK(handle_ir_multiple_interrupted),
+						    self);
+	}
+	priv->ctx = g_object_ref(ctx);
+}
+
+/**
+ * hinoko_fw_iso_capture_writer_detach:
+ * @self: A [class@FwIsoCaptureWriter].
+ *
+ * Stop recording packets received by the attached IR context.
+ *
+ * Since: 1.1
+ */
+void hinoko_fw_iso_capture_writer_detach(HinokoFwIsoCaptureWriter *self)
+{
+	HinokoFwIsoCaptureWriterPrivate *priv;
+
+	g_return_if_fail(HINOKO_IS_FW_ISO_CAPTURE_WRITER(self));
+	priv = hinoko_fw_iso_capture_writer_get_instance_private(self);
+
+	if (priv->ctx != NULL) {
+		g_signal_handler_disconnect(priv->ctx, priv->handler_id);
+		g_object_unref(priv->ctx);
+		priv->ctx = NULL;
+		priv->handler_id = 0;
+	}
+}
+
+/**
+ * hinoko_fw_iso_capture_writer_close:
+ * @self: A [class@FwIsoCaptureWriter].
+ * @error: A [struct@GLib.Error].
+ *
+ * Detach the IR context, write the rest of records, and close the file. The error at the thread
+ * to write batches is reported.
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_capture_writer_close(HinokoFwIsoCaptureWriter *self, GError **error)
+{
+	HinokoFwIsoCaptureWriterPrivate *priv;
+
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_CAPTURE_WRITER(self), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	priv = hinoko_fw_iso_capture_writer_get_instance_private(self);
+
+	hinoko_fw_iso_capture_writer_detach(self);
+
+	if (priv->thread == NULL)
+		return TRUE;
+
+	finish_file(priv, TRUE);
+	g_async_queue_push(priv->filled_batches, &quit_marker);
+	g_thread_join(priv->thread);
+	priv->thread = NULL;
+
+	release_batches(priv);
+	g_free(priv->path);
+	priv->path = NULL;
+
+	if (priv->error != NULL) {
+		g_propagate_error(error, priv->error);
+		priv->error = NULL;
+		return FALSE;
+	}
+
+	return TRUE;
+}
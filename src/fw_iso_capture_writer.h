@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#ifndef __ORG_KERNEL_HINOKO_FW_ISO_CAPTURE_WRITER_H__
+#define __ORG_KERNEL_HINOKO_FW_ISO_CAPTURE_WRITER_H__
+
+#include <hinoko.h>
+
+G_BEGIN_DECLS
+
+#define HINOKO_TYPE_FW_ISO_CAPTURE_WRITER	(hinoko_fw_iso_capture_writer_get_type())
+
+G_DECLARE_DERIVABLE_TYPE(HinokoFwIsoCaptureWriter, hinoko_fw_iso_capture_writer, HINOKO,
+			 FW_ISO_CAPTURE_WRITER, GObject);
+
+struct _HinokoFwIsoCaptureWriterClass {
+	GObjectClass parent_class;
+};
+
+HinokoFwIsoCaptureWriter *hinoko_fw_iso_capture_writer_new(void);
+
+gboolean hinoko_fw_iso_capture_writer_open(HinokoFwIsoCaptureWriter *self, const char *path,
+					   GError **error);
+
+void hinoko_fw_iso_capture_writer_attach(HinokoFwIsoCaptureWriter *self, HinokoFwIsoCtx *ctx);
+
+void hinoko_fw_iso_capture_writer_detach(HinokoFwIsoCaptureWriter *self);
+
+gboolean hinoko_fw_iso_capture_writer_close(HinokoFwIsoCaptureWriter *self, GError **error);
+
+G_END_DECLS
+
+#endif
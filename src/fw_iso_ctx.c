@@ -31,7 +31,7 @@ G_DEFINE_QUARK(hinoko-fw-iso-ctx-error-quark, hinoko_fw_iso_ctx_error)
  */
 void hinoko_fw_iso_ctx_error_to_label(HinokoFwIsoCtxError code, const char **label)
 {
-	const char *const labels[7] = {
+	const char *const labels[12] = {
 		[HINOKO_FW_ISO_CTX_ERROR_FAILED] = "The system call fails",
 		[HINOKO_FW_ISO_CTX_ERROR_ALLOCATED] =
 			"The instance is already associated to any firewire character device",
@@ -43,6 +43,15 @@ void hinoko_fw_iso_ctx_error_to_label(HinokoFwIsoCtxError code, const char **lab
 			"The intermediate buffer is not mapped to the process",
 		[HINOKO_FW_ISO_CTX_ERROR_CHUNK_UNREGISTERED] = "No chunk registered before starting",
 		[HINOKO_FW_ISO_CTX_ERROR_NO_ISOC_CHANNEL] = "No isochronous channel available",
+		[HINOKO_FW_ISO_CTX_ERROR_PACKET_LATE] =
+			"The packet is scheduled to isochronous cycle already processed",
+		[HINOKO_FW_ISO_CTX_ERROR_PACKET_EARLY] =
+			"The packet is scheduled to isochronous cycle beyond scheduler window",
+		[HINOKO_FW_ISO_CTX_ERROR_UNDERRUN] = "No packet is queued to transmit",
+		[HINOKO_FW_ISO_CTX_ERROR_OUT_OF_WINDOW] =
+			"The deadline to start is out of the window for cycle match",
+		[HINOKO_FW_ISO_CTX_ERROR_INVALID_GEOMETRY] =
+			"The geometry of buffer is not available for the mode of context",
 	};
 
 	switch (code) {
@@ -53,6 +62,11 @@ void hinoko_fw_iso_ctx_error_to_label(HinokoFwIsoCtxError code, const char **lab
 	case HINOKO_FW_ISO_CTX_ERROR_NOT_MAPPED:
 	case HINOKO_FW_ISO_CTX_ERROR_CHUNK_UNREGISTERED:
 	case HINOKO_FW_ISO_CTX_ERROR_NO_ISOC_CHANNEL:
+	case HINOKO_FW_ISO_CTX_ERROR_PACKET_LATE:
+	case HINOKO_FW_ISO_CTX_ERROR_PACKET_EARLY:
+	case HINOKO_FW_ISO_CTX_ERROR_UNDERRUN:
+	case HINOKO_FW_ISO_CTX_ERROR_OUT_OF_WINDOW:
+	case HINOKO_FW_ISO_CTX_ERROR_INVALID_GEOMETRY:
 		break;
 	default:
 		code = HINOKO_FW_ISO_CTX_ERROR_FAILED;
@@ -64,6 +78,8 @@ void hinoko_fw_iso_ctx_error_to_label(HinokoFwIsoCtxError code, const char **lab
 
 static void hinoko_fw_iso_ctx_default_init(HinokoFwIsoCtxInterface *iface)
 {
+	guint signal_id;
+
 	/**
 	 * HinokoFwIsoCtx:bytes-per-chunk:
 	 *
@@ -90,6 +106,123 @@ static void hinoko_fw_iso_ctx_default_init(HinokoFwIsoCtxInterface *iface)
 				  0, G_MAXUINT, 0,
 				  G_PARAM_READABLE));
 
+	/**
+	 * HinokoFwIsoCtx:map-flags:
+	 *
+	 * The set of flags applied when mapping intermediate buffer and allocating the arrays used
+	 * to operate isochronous context. The change of value takes effect at next mapping.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_interface_install_property(iface,
+		g_param_spec_flags(MAP_FLAGS_PROP_NAME, "map-flags",
+				   "The set of flags applied when mapping buffer.",
+				   HINOKO_TYPE_FW_ISO_CTX_MAP_FLAG, 0,
+				   G_PARAM_READWRITE));
+
+	/**
+	 * HinokoFwIsoCtx:resident-bytes:
+	 *
+	 * The number of bytes resident in physical memory for intermediate buffer and the arrays
+	 * used to operate isochronous context.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_interface_install_property(iface,
+		g_param_spec_uint64(RESIDENT_BYTES_PROP_NAME, "resident-bytes",
+				    "The number of bytes resident in physical memory.",
+				    0, G_MAXUINT64, 0,
+				    G_PARAM_READABLE));
+
+	/**
+	 * HinokoFwIsoCtx:queue-policy:
+	 *
+	 * The policy to queue registered chunks to hardware while the context is running, one of
+	 * [enum@FwIsoCtxQueuePolicy]. Any chunk registered before starting is queued at starting
+	 * regardless of the policy.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_interface_install_property(iface,
+		g_param_spec_enum(QUEUE_POLICY_PROP_NAME, "queue-policy",
+				  "The policy to queue registered chunks to hardware.",
+				  HINOKO_TYPE_FW_ISO_CTX_QUEUE_POLICY,
+				  HINOKO_FW_ISO_CTX_QUEUE_POLICY_INTERRUPT,
+				  G_PARAM_READWRITE));
+
+	/**
+	 * HinokoFwIsoCtx:queue-threshold-chunks:
+	 *
+	 * The number of pending chunks to queue them when the value of
+	 * [property@FwIsoCtx:queue-policy] is [enum@FwIsoCtxQueuePolicy.THRESHOLD]. Zero disables
+	 * the threshold.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_interface_install_property(iface,
+		g_param_spec_uint(QUEUE_THRESHOLD_CHUNKS_PROP_NAME, "queue-threshold-chunks",
+				  "The number of pending chunks to queue them.",
+				  0, G_MAXUINT, 0,
+				  G_PARAM_READWRITE));
+
+	/**
+	 * HinokoFwIsoCtx:queue-threshold-bytes:
+	 *
+	 * The number of bytes for payload of pending chunks to queue them when the value of
+	 * [property@FwIsoCtx:queue-policy] is [enum@FwIsoCtxQueuePolicy.THRESHOLD]. Zero disables
+	 * the threshold.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_interface_install_property(iface,
+		g_param_spec_uint(QUEUE_THRESHOLD_BYTES_PROP_NAME, "queue-threshold-bytes",
+				  "The number of bytes for payload of pending chunks to queue them.",
+				  0, G_MAXUINT, 0,
+				  G_PARAM_READWRITE));
+
+	/**
+	 * HinokoFwIsoCtx:headroom:
+	 *
+	 * The number of chunks queued to hardware and not completed yet, updated at every interrupt
+	 * event before [signal@FwIsoCtx::low-headroom] is emitted. For IT context, it is the
+	 * number of isochronous cycles for which packets are already queued. For IR context, it is
+	 * the number of chunks still available to store received packets.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_interface_install_property(iface,
+		g_param_spec_uint(HEADROOM_PROP_NAME, "headroom",
+				  "The number of chunks queued to hardware and not completed yet.",
+				  0, G_MAXUINT, 0,
+				  G_PARAM_READABLE));
+
+	/**
+	 * HinokoFwIsoCtx:minimum-headroom:
+	 *
+	 * The minimum value of [property@FwIsoCtx:headroom] since the context is started.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_interface_install_property(iface,
+		g_param_spec_uint(MINIMUM_HEADROOM_PROP_NAME, "minimum-headroom",
+				  "The minimum value of headroom since starting.",
+				  0, G_MAXUINT, 0,
+				  G_PARAM_READABLE));
+
+	/**
+	 * HinokoFwIsoCtx:headroom-threshold:
+	 *
+	 * The value of [property@FwIsoCtx:headroom] under which [signal@FwIsoCtx::low-headroom] is
+	 * emitted. Zero disables the signal.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_interface_install_property(iface,
+		g_param_spec_uint(HEADROOM_THRESHOLD_PROP_NAME, "headroom-threshold",
+				  "The value of headroom under which the signal is emitted.",
+				  0, G_MAXUINT, 0,
+				  G_PARAM_READWRITE));
+
 	/**
 	 * HinokoFwIsoCtx::stopped:
 	 * @self: A [iface@FwIsoCtx].
@@ -106,6 +239,30 @@ static void hinoko_fw_iso_ctx_default_init(HinokoFwIsoCtxInterface *iface)
 		NULL, NULL,
 		g_cclosure_marshal_VOID__BOXED,
 		G_TYPE_NONE, 1, G_TYPE_ERROR);
+
+	/**
+	 * HinokoFwIsoCtx::low-headroom:
+	 * @self: A [iface@FwIsoCtx].
+	 * @headroom: The value of [property@FwIsoCtx:headroom].
+	 *
+	 * Emitted in the path of interrupt event when the number of chunks queued to hardware and
+	 * not completed yet is less than [property@FwIsoCtx:headroom-threshold], before the signal
+	 * specific to the context is emitted. It is a sign of imminent underrun in IT context and
+	 * overrun in IR context.
+	 *
+	 * Since: 1.1
+	 */
+	signal_id = g_signal_new(LOW_HEADROOM_SIGNAL_NAME,
+		G_TYPE_FROM_INTERFACE(iface),
+		G_SIGNAL_RUN_LAST,
+		G_STRUCT_OFFSET(HinokoFwIsoCtxInterface, low_headroom),
+		NULL, NULL,
+		g_cclosure_marshal_VOID__UINT,
+		G_TYPE_NONE, 1, G_TYPE_UINT);
+
+	// Collect arguments of the signal without GValue in the path of interrupt event.
+	g_signal_set_va_marshaller(signal_id, G_TYPE_FROM_INTERFACE(iface),
+				   g_cclosure_marshal_VOID__UINTv);
 }
 
 /**
@@ -222,3 +379,265 @@ gboolean hinoko_fw_iso_ctx_flush_completions(HinokoFwIsoCtx *self, GError **erro
 
 	return HINOKO_FW_ISO_CTX_GET_IFACE(self)->flush_completions(self, error);
 }
+
+// Linux FireWire subsystem stores one quadlet of timestamp per packet as the header of IT context.
+#define IT_HEADER_SIZE		4
+
+// In buffer-fill mode, payload is sandwiched by heading isochronous header and trailing timestamp.
+#define IR_MULTIPLE_FRAME_OVERHEAD	8
+
+#define generate_geometry_error(error, format, arg)				\
+	g_set_error(error, HINOKO_FW_ISO_CTX_ERROR,				\
+		    HINOKO_FW_ISO_CTX_ERROR_INVALID_GEOMETRY, format, arg)
+
+static gboolean check_header_size(HinokoFwIsoCtxMode mode, guint header_size, GError **error)
+{
+	long page_size = sysconf(_SC_PAGESIZE);
+
+	if (header_size % 4 > 0) {
+		generate_geometry_error(error, "The header size %u is not aligned to quadlet",
+					header_size);
+		return FALSE;
+	}
+
+	if (mode == HINOKO_FW_ISO_CTX_MODE_IR_SINGLE &&
+	    (header_size < 4 || header_size > page_size)) {
+		generate_geometry_error(error, "The header size %u is out of range for IR context",
+					header_size);
+		return FALSE;
+	}
+
+	if (mode == HINOKO_FW_ISO_CTX_MODE_IR_MULTIPLE && header_size > 0) {
+		generate_geometry_error(error,
+			"The header size %u is not available in buffer-fill mode", header_size);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+// The number of chunks after which Linux FireWire subsystem queues the interrupt event since the
+// header for the packets fills one page, or 0 for the mode without the header.
+static guint header_flush_chunks(HinokoFwIsoCtxMode mode, guint header_size)
+{
+	long page_size = sysconf(_SC_PAGESIZE);
+
+	switch (mode) {
+	case HINOKO_FW_ISO_CTX_MODE_IT:
+		return page_size / IT_HEADER_SIZE;
+	case HINOKO_FW_ISO_CTX_MODE_IR_SINGLE:
+		return page_size / header_size;
+	case HINOKO_FW_ISO_CTX_MODE_IR_MULTIPLE:
+	default:
+		return 0;
+	}
+}
+
+/**
+ * hinoko_fw_iso_ctx_validate_geometry:
+ * @mode: The mode of context, one of [enum@FwIsoCtxMode].
+ * @header_size: The number of bytes for header of isochronous context, given to allocate method.
+ * @bytes_per_chunk: The number of bytes per chunk, given to map_buffer method.
+ * @chunks_per_buffer: The number of chunks in buffer, given to map_buffer method.
+ * @chunks_per_irq: The number of chunks per interval of interrupt. When 0 is given, no chunk is
+ *		    marked to generate hardware interrupt.
+ * @chunks_per_event: (out): The maximum number of chunks handled by one interrupt event.
+ * @error: A [struct@GLib.Error]. Error is generated with domain of Hinoko.FwIsoCtxError.
+ *
+ * Validate the geometry of buffer before mapping it. Linux FireWire subsystem queues interrupt
+ * event independently of hardware interrupt when the header for packets fills one page, thus the
+ * interval of event for IT and IR single contexts is clamped by the number of packets; 1,024 for
+ * IT context, and the size of page divided by @header_size for IR single context. The buffer
+ * should have room to queue chunks while the event is handled. The number of chunks in buffer
+ * should be a multiple of @chunks_per_irq so that chunks marked to generate interrupt are at the
+ * same position after the buffer wraps around. The chunk of IR contexts should be
+ * aligned to quadlet since the payload of isochronous packet is padded to quadlet.
+ *
+ * Returns: TRUE if the geometry is valid, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_ctx_validate_geometry(HinokoFwIsoCtxMode mode, guint header_size,
+					     guint bytes_per_chunk, guint chunks_per_buffer,
+					     guint chunks_per_irq, guint *chunks_per_event,
+					     GError **error)
+{
+	guint flush_chunks;
+	guint event_chunks;
+
+	g_return_val_if_fail(mode == HINOKO_FW_ISO_CTX_MODE_IT ||
+			     mode == HINOKO_FW_ISO_CTX_MODE_IR_SINGLE ||
+			     mode == HINOKO_FW_ISO_CTX_MODE_IR_MULTIPLE, FALSE);
+	g_return_val_if_fail(chunks_per_event != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (!check_header_size(mode, header_size, error))
+		return FALSE;
+
+	if (bytes_per_chunk == 0 || chunks_per_buffer == 0 ||
+	    (guint64)bytes_per_chunk * chunks_per_buffer > G_MAXINT) {
+		generate_geometry_error(error, "The size of buffer is out of range: %u chunks",
+					chunks_per_buffer);
+		return FALSE;
+	}
+
+	if (mode != HINOKO_FW_ISO_CTX_MODE_IT && bytes_per_chunk % 4 > 0) {
+		generate_geometry_error(error, "The size of chunk %u is not aligned to quadlet",
+					bytes_per_chunk);
+		return FALSE;
+	}
+
+	if (chunks_per_irq > 0 && chunks_per_buffer % chunks_per_irq > 0) {
+		g_set_error(error, HINOKO_FW_ISO_CTX_ERROR,
+			    HINOKO_FW_ISO_CTX_ERROR_INVALID_GEOMETRY,
+			    "The size of buffer %u is not a multiple of the interval of %u chunks",
+			    chunks_per_buffer, chunks_per_irq);
+		return FALSE;
+	}
+
+	flush_chunks = header_flush_chunks(mode, header_size);
+	if (flush_chunks == 0)
+		event_chunks = chunks_per_irq;
+	else if (chunks_per_irq == 0)
+		event_chunks = flush_chunks;
+	else
+		event_chunks = MIN(chunks_per_irq, flush_chunks);
+
+	if (event_chunks >= chunks_per_buffer) {
+		generate_geometry_error(error,
+			"No room to queue chunks while the event for %u chunks is handled",
+			event_chunks);
+		return FALSE;
+	}
+
+	*chunks_per_event = event_chunks;
+
+	return TRUE;
+}
+
+/**
+ * hinoko_fw_iso_ctx_solve_geometry:
+ * @mode: The mode of context, one of [enum@FwIsoCtxMode].
+ * @bytes_per_payload: The maximum number of bytes for payload of isochronous packet.
+ * @packets_per_cycle: The number of packets handled per isochronous cycle. For IR multiple
+ *		       context, it is the total number of packets in all of the channels.
+ * @header_size: The number of bytes for header of isochronous context, given to allocate method.
+ * @latency_cycles: The budget of latency in isochronous cycle. For IT context, it is the time from
+ *		    registration of packet to its transmission. For IR contexts, it is the time
+ *		    from reception of packet to the interrupt event.
+ * @wakeups_per_second: The budget of interrupt events per second.
+ * @bytes_per_chunk: (out): The number of bytes per chunk to map buffer.
+ * @chunks_per_buffer: (out): The number of chunks in buffer to map buffer.
+ * @chunks_per_irq: (out): The number of chunks per interval of interrupt.
+ * @error: A [struct@GLib.Error]. Error is generated with domain of Hinoko.FwIsoCtxError.
+ *
+ * Calculate the geometry of buffer within the budgets of latency and wakeups. The shortest interval
+ * of interrupt within @wakeups_per_second is chosen, and it should not exceed the number of chunks
+ * at which Linux FireWire subsystem queues event by filling one page with header. The buffer is
+ * deep as much as @latency_cycles for IT context, and has room for two intervals at least. The
+ * number of chunks in buffer is a multiple of the interval so that chunks marked to generate
+ * interrupt are at the same position after the buffer wraps around. For IR multiple context, one
+ * chunk has the size of packets for one isochronous cycle, including the isochronous header and
+ * timestamp with quadlet alignment, so that a packet over the end of buffer is concatenated in two
+ * chunks. The result is validated by [func@FwIsoCtx.validate_geometry].
+ *
+ * Returns: TRUE if the geometry is found within the budgets, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_ctx_solve_geometry(HinokoFwIsoCtxMode mode, guint bytes_per_payload,
+					  guint packets_per_cycle, guint header_size,
+					  guint latency_cycles, guint wakeups_per_second,
+					  guint *bytes_per_chunk, guint *chunks_per_buffer,
+					  guint *chunks_per_irq, GError **error)
+{
+	guint64 chunk_size;
+	guint chunks_per_cycle;
+	guint64 latency_chunks;
+	guint64 interval;
+	guint64 buffer_chunks;
+	guint flush_chunks;
+	guint chunks_per_event;
+
+	g_return_val_if_fail(mode == HINOKO_FW_ISO_CTX_MODE_IT ||
+			     mode == HINOKO_FW_ISO_CTX_MODE_IR_SINGLE ||
+			     mode == HINOKO_FW_ISO_CTX_MODE_IR_MULTIPLE, FALSE);
+	g_return_val_if_fail(packets_per_cycle > 0, FALSE);
+	g_return_val_if_fail(latency_cycles > 0, FALSE);
+	g_return_val_if_fail(wakeups_per_second > 0, FALSE);
+	g_return_val_if_fail(bytes_per_chunk != NULL, FALSE);
+	g_return_val_if_fail(chunks_per_buffer != NULL, FALSE);
+	g_return_val_if_fail(chunks_per_irq != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (!check_header_size(mode, header_size, error))
+		return FALSE;
+
+	switch (mode) {
+	case HINOKO_FW_ISO_CTX_MODE_IT:
+		chunk_size = MAX(bytes_per_payload, 1);
+		chunks_per_cycle = packets_per_cycle;
+		break;
+	case HINOKO_FW_ISO_CTX_MODE_IR_SINGLE:
+		chunk_size = MAX((bytes_per_payload + 3) / 4 * 4, 4);
+		chunks_per_cycle = packets_per_cycle;
+		break;
+	case HINOKO_FW_ISO_CTX_MODE_IR_MULTIPLE:
+	default:
+		chunk_size = (bytes_per_payload + 3) / 4 * 4 + IR_MULTIPLE_FRAME_OVERHEAD;
+		chunk_size *= packets_per_cycle;
+		chunks_per_cycle = 1;
+		break;
+	}
+
+	interval = ((guint64)IEEE1394_CYCLES_PER_SEC * chunks_per_cycle + wakeups_per_second - 1) /
+		   wakeups_per_second;
+	latency_chunks = (guint64)latency_cycles * chunks_per_cycle;
+
+	flush_chunks = header_flush_chunks(mode, header_size);
+	if (flush_chunks > 0 && interval > flush_chunks) {
+		generate_geometry_error(error,
+			"The budget of wakeups is less than the events per %u chunks of header",
+			flush_chunks);
+		return FALSE;
+	}
+
+	if (mode == HINOKO_FW_ISO_CTX_MODE_IT) {
+		// The queued chunks are transmitted before the registered one.
+		if (latency_chunks < 2 * interval) {
+			generate_geometry_error(error,
+				"The budget of latency is less than two intervals of %u chunks",
+				(guint)interval);
+			return FALSE;
+		}
+		buffer_chunks = latency_chunks / interval * interval;
+	} else {
+		// The received chunks wait for the interrupt event.
+		if (latency_chunks < interval) {
+			generate_geometry_error(error,
+				"The budget of latency is less than the interval of %u chunks",
+				(guint)interval);
+			return FALSE;
+		}
+		buffer_chunks = MAX(latency_chunks, 2 * interval);
+		buffer_chunks = (buffer_chunks + interval - 1) / interval * interval;
+	}
+
+	if (chunk_size > G_MAXUINT || buffer_chunks > G_MAXUINT) {
+		generate_geometry_error(error,
+			"The geometry for %u packets per cycle exceeds the range of value",
+			packets_per_cycle);
+		return FALSE;
+	}
+
+	if (!hinoko_fw_iso_ctx_validate_geometry(mode, header_size, (guint)chunk_size,
+						 (guint)buffer_chunks, (guint)interval,
+						 &chunks_per_event, error))
+		return FALSE;
+
+	*bytes_per_chunk = (guint)chunk_size;
+	*chunks_per_buffer = (guint)buffer_chunks;
+	*chunks_per_irq = (guint)interval;
+
+	return TRUE;
+}
@@ -105,6 +105,17 @@ struct _HinokoFwIsoCtxInterface {
 	 * Closure for the [signal@FwIsoCtx::stopped] signal.
 	 */
 	void (*stopped)(HinokoFwIsoCtx *self, const GError *error);
+
+	/**
+	 * HinokoFwIsoCtxInterface::low_headroom:
+	 * @self: A [iface@FwIsoCtx].
+	 * @headroom: The value of [property@FwIsoCtx:headroom].
+	 *
+	 * Closure for the [signal@FwIsoCtx::low-headroom] signal.
+	 *
+	 * Since: 1.1
+	 */
+	void (*low_headroom)(HinokoFwIsoCtx *self, guint headroom);
 };
 
 void hinoko_fw_iso_ctx_stop(HinokoFwIsoCtx *self);
@@ -120,6 +131,17 @@ gboolean hinoko_fw_iso_ctx_create_source(HinokoFwIsoCtx *self, GSource **source,
 
 gboolean hinoko_fw_iso_ctx_flush_completions(HinokoFwIsoCtx *self, GError **error);
 
+gboolean hinoko_fw_iso_ctx_validate_geometry(HinokoFwIsoCtxMode mode, guint header_size,
+					     guint bytes_per_chunk, guint chunks_per_buffer,
+					     guint chunks_per_irq, guint *chunks_per_event,
+					     GError **error);
+
+gboolean hinoko_fw_iso_ctx_solve_geometry(HinokoFwIsoCtxMode mode, guint bytes_per_payload,
+					  guint packets_per_cycle, guint header_size,
+					  guint latency_cycles, guint wakeups_per_second,
+					  guint *bytes_per_chunk, guint *chunks_per_buffer,
+					  guint *chunks_per_irq, GError **error);
+
 G_END_DECLS
 
 #endif
@@ -0,0 +1,331 @@
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#include "fw_iso_ctx_private.h"
+
+#include <time.h>
+
+/**
+ * HinokoFwIsoCtxGroup:
+ * A group of isochronous contexts started at the same isochronous cycle.
+ *
+ * [class@FwIsoCtxGroup] starts several isochronous contexts at the same isochronous cycle, for
+ * example the pair of IT and IR contexts for duplex streams. The chunks registered to each member
+ * are queued to hardware in advance, then one future isochronous cycle is computed from a single
+ * sample of cycle time, and the request to start is issued to every member back to back.
+ *
+ * The group holds the reference to each member. The members are expected to be allocated,
+ * mapped, and registered with chunks for IT and IR contexts in packet-per-buffer mode before
+ * calling [method@FwIsoCtxGroup.start].
+ */
+typedef struct {
+	GArray *members;
+} HinokoFwIsoCtxGroupPrivate;
+
+G_DEFINE_TYPE_WITH_PRIVATE(HinokoFwIsoCtxGroup, hinoko_fw_iso_ctx_group, G_TYPE_OBJECT)
+
+struct fw_iso_ctx_group_member {
+	HinokoFwIsoCtx *ctx;
+	guint32 sync_code;
+	HinokoFwIsoCtxMatchFlag tags;
+	guint chunks_per_irq;
+	struct fw_iso_ctx_state *state;
+};
+
+static void clear_member(gpointer data)
+{
+	struct fw_iso_ctx_group_member *member = data;
+
+	g_object_unref(member->ctx);
+}
+
+static void fw_iso_ctx_group_finalize(GObject *obj)
+{
+	HinokoFwIsoCtxGroup *self = HINOKO_FW_ISO_CTX_GROUP(obj);
+	HinokoFwIsoCtxGroupPrivate *priv = hinoko_fw_iso_ctx_group_get_instance_private(self);
+
+	g_array_unref(priv->members);
+
+	G_OBJECT_CLASS(hinoko_fw_iso_ctx_group_parent_class)->finalize(obj);
+}
+
+static void hinoko_fw_iso_ctx_group_class_init(HinokoFwIsoCtxGroupClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+
+	gobject_class->finalize = fw_iso_ctx_group_finalize;
+}
+
+static void hinoko_fw_iso_ctx_group_init(HinokoFwIsoCtxGroup *self)
+{
+	HinokoFwIsoCtxGroupPrivate *priv = hinoko_fw_iso_ctx_group_get_instance_private(self);
+
+	priv->members = g_array_new(FALSE, TRUE, sizeof(struct fw_iso_ctx_group_member));
+	g_array_set_clear_func(priv->members, clear_member);
+}
+
+/**
+ * hinoko_fw_iso_ctx_group_new:
+ *
+ * Instantiate [class@FwIsoCtxGroup] object and return the instance.
+ *
+ * Returns: an instance of [class@FwIsoCtxGroup].
+ *
+ * Since: 1.1
+ */
+HinokoFwIsoCtxGroup *hinoko_fw_iso_ctx_group_new(void)
+{
+	return g_object_new(HINOKO_TYPE_FW_ISO_CTX_GROUP, NULL);
+}
+
+static gboolean has_member(HinokoFwIsoCtxGroupPrivate *priv, HinokoFwIsoCtx *ctx)
+{
+	guint i;
+
+	for (i = 0; i < priv->members->len; ++i) {
+		const struct fw_iso_ctx_group_member *member =
+			&g_array_index(priv->members, struct fw_iso_ctx_group_member, i);
+
+		if (member->ctx == ctx)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+static void add_member(HinokoFwIsoCtxGroup *self, HinokoFwIsoCtx *ctx, guint32 sync_code,
+		       HinokoFwIsoCtxMatchFlag tags, guint chunks_per_irq)
+{
+	HinokoFwIsoCtxGroupPrivate *priv = hinoko_fw_iso_ctx_group_get_instance_private(self);
+	struct fw_iso_ctx_group_member member = {0};
+
+	g_return_if_fail(!has_member(priv, ctx));
+
+	member.ctx = g_object_ref(ctx);
+	member.sync_code = sync_code;
+	member.tags = tags;
+	member.chunks_per_irq = chunks_per_irq;
+	g_array_append_val(priv->members, member);
+}
+
+/**
+ * hinoko_fw_iso_ctx_group_add_it:
+ * @self: A [class@FwIsoCtxGroup].
+ * @ctx: A [class@FwIsoIt].
+ *
+ * Add the IT context to the group.
+ *
+ * Since: 1.1
+ */
+void hinoko_fw_iso_ctx_group_add_it(HinokoFwIsoCtxGroup *self, HinokoFwIsoIt *ctx)
+{
+	g_return_if_fail(HINOKO_IS_FW_ISO_CTX_GROUP(self));
+	g_return_if_fail(HINOKO_IS_FW_ISO_IT(ctx));
+
+	add_member(self, HINOKO_FW_ISO_CTX(ctx), 0, 0, 0);
+}
+
+/**
+ * hinoko_fw_iso_ctx_group_add_ir_single:
+ * @self: A [class@FwIsoCtxGroup].
+ * @ctx: A [class@FwIsoIrSingle].
+ * @sync_code: The value of sy field in isochronous packet header for packet processing, up to 15.
+ * @tags: The value of tag field in isochronous header for packet processing.
+ *
+ * Add the IR context for packet-per-buffer mode to the group, with the parameters to start it.
+ *
+ * Since: 1.1
+ */
+void hinoko_fw_iso_ctx_group_add_ir_single(HinokoFwIsoCtxGroup *self, HinokoFwIsoIrSingle *ctx,
+					   guint32 sync_code, HinokoFwIsoCtxMatchFlag tags)
+{
+	g_return_if_fail(HINOKO_IS_FW_ISO_CTX_GROUP(self));
+	g_return_if_fail(HINOKO_IS_FW_ISO_IR_SINGLE(ctx));
+	g_return_if_fail(sync_code <= IEEE1394_MAX_SYNC_CODE);
+
+	add_member(self, HINOKO_FW_ISO_CTX(ctx), sync_code, tags, 0);
+}
+
+/**
+ * hinoko_fw_iso_ctx_group_add_ir_multiple:
+ * @self: A [class@FwIsoCtxGroup].
+ * @ctx: A [class@FwIsoIrMultiple].
+ * @sync_code: The value of sy field in isochronous packet header for packet processing, up to 15.
+ * @tags: The value of tag field in isochronous header for packet processing.
+ * @chunks_per_irq: The number of chunks per interval of interrupt.
+ *
+ * Add the IR context for buffer-fill mode to the group, with the parameters to start it. The
+ * chunks are registered at [method@FwIsoCtxGroup.start] as [method@FwIsoIrMultiple.start] does.
+ *
+ * Since: 1.1
+ */
+void hinoko_fw_iso_ctx_group_add_ir_multiple(HinokoFwIsoCtxGroup *self,
+					     HinokoFwIsoIrMultiple *ctx, guint32 sync_code,
+					     HinokoFwIsoCtxMatchFlag tags, guint chunks_per_irq)
+{
+	g_return_if_fail(HINOKO_IS_FW_ISO_CTX_GROUP(self));
+	g_return_if_fail(HINOKO_IS_FW_ISO_IR_MULTIPLE(ctx));
+	g_return_if_fail(sync_code <= IEEE1394_MAX_SYNC_CODE);
+
+	add_member(self, HINOKO_FW_ISO_CTX(ctx), sync_code, tags, chunks_per_irq);
+}
+
+/**
+ * hinoko_fw_iso_ctx_group_remove:
+ * @self: A [class@FwIsoCtxGroup].
+ * @ctx: A [iface@FwIsoCtx] added to the group.
+ *
+ * Remove the isochronous context from the group. The context is not stopped.
+ *
+ * Since: 1.1
+ */
+void hinoko_fw_iso_ctx_group_remove(HinokoFwIsoCtxGroup *self, HinokoFwIsoCtx *ctx)
+{
+	HinokoFwIsoCtxGroupPrivate *priv;
+	guint i;
+
+	g_return_if_fail(HINOKO_IS_FW_ISO_CTX_GROUP(self));
+	g_return_if_fail(HINOKO_IS_FW_ISO_CTX(ctx));
+	priv = hinoko_fw_iso_ctx_group_get_instance_private(self);
+
+	for (i = 0; i < priv->members->len; ++i) {
+		const struct fw_iso_ctx_group_member *member =
+			&g_array_index(priv->members, struct fw_iso_ctx_group_member, i);
+
+		if (member->ctx == ctx) {
+			g_array_remove_index(priv->members, i);
+			return;
+		}
+	}
+}
+
+static struct fw_iso_ctx_state *prepare_member(struct fw_iso_ctx_group_member *member,
+					       GError **error)
+{
+	if (HINOKO_IS_FW_ISO_IT(member->ctx))
+		return fw_iso_it_prepare_start(HINOKO_FW_ISO_IT(member->ctx));
+	else if (HINOKO_IS_FW_ISO_IR_SINGLE(member->ctx))
+		return fw_iso_ir_single_prepare_start(HINOKO_FW_ISO_IR_SINGLE(member->ctx));
+	else
+		return fw_iso_ir_multiple_prepare_start(HINOKO_FW_ISO_IR_MULTIPLE(member->ctx),
+							member->chunks_per_irq, error);
+}
+
+// Drop the chunks queued to the members which are not started yet so that they are available
+// for retry.
+static void recycle_members(struct fw_iso_ctx_group_member *members, guint begin, guint end)
+{
+	guint i;
+
+	for (i = begin; i < end; ++i) {
+		if (HINOKO_IS_FW_ISO_IT(members[i].ctx))
+			fw_iso_it_recycle(HINOKO_FW_ISO_IT(members[i].ctx));
+		else if (HINOKO_IS_FW_ISO_IR_SINGLE(members[i].ctx))
+			fw_iso_ir_single_recycle(HINOKO_FW_ISO_IR_SINGLE(members[i].ctx));
+		else
+			fw_iso_ctx_state_recycle(members[i].state);
+	}
+}
+
+static gboolean read_cycles(struct fw_iso_ctx_state *state, guint *cycles, GError **error)
+{
+	HinawaCycleTime cycle_time = {0};
+	HinawaCycleTime *ptr = &cycle_time;
+	guint16 fields[3];
+
+	if (!fw_iso_ctx_state_read_cycle_time(state, CLOCK_MONOTONIC_RAW, &ptr, error))
+		return FALSE;
+
+	hinawa_cycle_time_get_fields(&cycle_time, fields);
+	*cycles = fields[0] * IEEE1394_CYCLES_PER_SEC + fields[1];
+
+	return TRUE;
+}
+
+/**
+ * hinoko_fw_iso_ctx_group_start:
+ * @self: A [class@FwIsoCtxGroup].
+ * @delay_cycles: The number of isochronous cycles from current one to start, between 1 and 31999.
+ * @cycle_match: (array fixed-size=2) (out caller-allocates): The isochronous cycle to start packet
+ *		 processing. The first element is the second part of isochronous cycle, up to 3.
+ *		 The second element is the cycle part of isochronous cycle, up to 7999.
+ * @aligned: (out): Whether every member is started before the isochronous cycle.
+ * @error: A [struct@GLib.Error].
+ *
+ * Start all members of the group at the same isochronous cycle. The chunks registered to each
+ * member are queued to hardware at first. Then the isochronous cycle to start is computed by adding
+ * @delay_cycles to the value of cycle time register sampled once, and the request to start is
+ * issued to each member back to back. The cycle time register is sampled again after the last
+ * request so that @aligned is FALSE when the isochronous cycle already passed at the time, in the
+ * case that some members may start at the same isochronous cycle in the next 4 seconds. When any
+ * request fails, the members started already are stopped, and the chunks queued to the other
+ * members are dropped.
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_ctx_group_start(HinokoFwIsoCtxGroup *self, guint delay_cycles,
+				       guint16 cycle_match[2], gboolean *aligned,
+				       GError **error)
+{
+	HinokoFwIsoCtxGroupPrivate *priv;
+	struct fw_iso_ctx_group_member *members;
+	guint begin_cycles;
+	guint end_cycles;
+	guint target_cycles;
+	guint i;
+
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_CTX_GROUP(self), FALSE);
+	g_return_val_if_fail(delay_cycles > 0, FALSE);
+	g_return_val_if_fail(delay_cycles < OHCI1394_cycleMatch_CYCLES_PER_WINDOW, FALSE);
+	g_return_val_if_fail(cycle_match != NULL, FALSE);
+	g_return_val_if_fail(aligned != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+	priv = hinoko_fw_iso_ctx_group_get_instance_private(self);
+
+	g_return_val_if_fail(priv->members->len > 0, FALSE);
+	members = (struct fw_iso_ctx_group_member *)priv->members->data;
+
+	for (i = 0; i < priv->members->len; ++i) {
+		members[i].state = prepare_member(&members[i], error);
+		if (members[i].state == NULL) {
+			recycle_members(members, 0, i);
+			return FALSE;
+		}
+
+		if (!fw_iso_ctx_state_prefill(members[i].state, error)) {
+			recycle_members(members, 0, i + 1);
+			return FALSE;
+		}
+	}
+
+	if (!read_cycles(members[0].state, &begin_cycles, error)) {
+		recycle_members(members, 0, priv->members->len);
+		return FALSE;
+	}
+
+	target_cycles = (begin_cycles + delay_cycles) % IEEE1394_CYCLES_PER_ROUND;
+	ohci1394_cycle_match_from_cycles(target_cycles, cycle_match);
+
+	for (i = 0; i < priv->members->len; ++i) {
+		if (!fw_iso_ctx_state_start_prefilled(members[i].state, cycle_match,
+						      members[i].sync_code, members[i].tags,
+						      error)) {
+			recycle_members(members, i, priv->members->len);
+			while (i > 0)
+				hinoko_fw_iso_ctx_stop(members[--i].ctx);
+			return FALSE;
+		}
+	}
+
+	// The members are started at the cycle as long as every request is issued before it.
+	if (read_cycles(members[0].state, &end_cycles, NULL)) {
+		guint elapsed = (end_cycles + IEEE1394_CYCLES_PER_ROUND - begin_cycles) %
+				IEEE1394_CYCLES_PER_ROUND;
+
+		*aligned = elapsed < delay_cycles;
+	} else {
+		*aligned = FALSE;
+	}
+
+	return TRUE;
+}
@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#ifndef __ORG_KERNEL_HINOKO_FW_ISO_CTX_GROUP_H__
+#define __ORG_KERNEL_HINOKO_FW_ISO_CTX_GROUP_H__
+
+#include <hinoko.h>
+
+G_BEGIN_DECLS
+
+#define HINOKO_TYPE_FW_ISO_CTX_GROUP	(hinoko_fw_iso_ctx_group_get_type())
+
+G_DECLARE_DERIVABLE_TYPE(HinokoFwIsoCtxGroup, hinoko_fw_iso_ctx_group, HINOKO, FW_ISO_CTX_GROUP,
+			 GObject);
+
+struct _HinokoFwIsoCtxGroupClass {
+	GObjectClass parent_class;
+};
+
+HinokoFwIsoCtxGroup *hinoko_fw_iso_ctx_group_new(void);
+
+void hinoko_fw_iso_ctx_group_add_it(HinokoFwIsoCtxGroup *self, HinokoFwIsoIt *ctx);
+
+void hinoko_fw_iso_ctx_group_add_ir_single(HinokoFwIsoCtxGroup *self, HinokoFwIsoIrSingle *ctx,
+					   guint32 sync_code, HinokoFwIsoCtxMatchFlag tags);
+
+void hinoko_fw_iso_ctx_group_add_ir_multiple(HinokoFwIsoCtxGroup *self,
+					     HinokoFwIsoIrMultiple *ctx, guint32 sync_code,
+					     HinokoFwIsoCtxMatchFlag tags, guint chunks_per_irq);
+
+void hinoko_fw_iso_ctx_group_remove(HinokoFwIsoCtxGroup *self, HinokoFwIsoCtx *ctx);
+
+gboolean hinoko_fw_iso_ctx_group_start(HinokoFwIsoCtxGroup *self, guint delay_cycles,
+				       guint16 cycle_match[2], gboolean *aligned,
+				       GError **error);
+
+G_END_DECLS
+
+#endif
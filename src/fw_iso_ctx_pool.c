@@ -0,0 +1,443 @@
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#include "fw_iso_ctx_private.h"
+
+/**
+ * HinokoFwIsoCtxPool:
+ * A pool of isochronous contexts allocated and mapped in advance.
+ *
+ * [class@FwIsoCtxPool] keeps a set of isochronous contexts for the same geometry of buffer. Each
+ * context is already allocated to 1394 OHCI hardware and its intermediate buffer is already mapped
+ * and populated, thus the context handed out by [method@FwIsoCtxPool.acquire] is available to
+ * register packets and start immediately. The context is recycled by
+ * [method@FwIsoCtxPool.release].
+ *
+ * The IT context and the IR context for packet-per-buffer mode are supported. Linux FireWire
+ * subsystem allows one IR context per isochronous channel, thus the pool for IR context holds one
+ * context at most.
+ */
+typedef struct {
+	GMutex mutex;
+	GQueue idle;
+	GHashTable *leased;
+
+	gchar *path;
+	HinokoFwIsoCtxMode mode;
+	HinokoFwScode scode;
+	guint channel;
+	guint header_size;
+	guint bytes_per_chunk;
+	guint chunks_per_buffer;
+	HinokoFwIsoCtxMapFlag map_flags;
+	gboolean prepared;
+} HinokoFwIsoCtxPoolPrivate;
+
+G_DEFINE_TYPE_WITH_PRIVATE(HinokoFwIsoCtxPool, hinoko_fw_iso_ctx_pool, G_TYPE_OBJECT)
+
+static void clear_ctxs(GQueue *ctxs)
+{
+	HinokoFwIsoCtx *ctx;
+
+	while ((ctx = g_queue_pop_head(ctxs)) != NULL)
+		g_object_unref(ctx);
+}
+
+enum fw_iso_ctx_pool_prop_type {
+	FW_ISO_CTX_POOL_PROP_TYPE_MODE = 1,
+	FW_ISO_CTX_POOL_PROP_TYPE_BYTES_PER_CHUNK,
+	FW_ISO_CTX_POOL_PROP_TYPE_CHUNKS_PER_BUFFER,
+	FW_ISO_CTX_POOL_PROP_TYPE_MAP_FLAGS,
+	FW_ISO_CTX_POOL_PROP_TYPE_AVAILABLE,
+	FW_ISO_CTX_POOL_PROP_TYPE_COUNT,
+};
+
+static void fw_iso_ctx_pool_get_property(GObject *obj, guint id, GValue *val, GParamSpec *spec)
+{
+	HinokoFwIsoCtxPool *self = HINOKO_FW_ISO_CTX_POOL(obj);
+	HinokoFwIsoCtxPoolPrivate *priv = hinoko_fw_iso_ctx_pool_get_instance_private(self);
+
+	switch (id) {
+	case FW_ISO_CTX_POOL_PROP_TYPE_MODE:
+		g_value_set_enum(val, priv->mode);
+		break;
+	case FW_ISO_CTX_POOL_PROP_TYPE_BYTES_PER_CHUNK:
+		g_value_set_uint(val, priv->bytes_per_chunk);
+		break;
+	case FW_ISO_CTX_POOL_PROP_TYPE_CHUNKS_PER_BUFFER:
+		g_value_set_uint(val, priv->chunks_per_buffer);
+		break;
+	case FW_ISO_CTX_POOL_PROP_TYPE_MAP_FLAGS:
+		g_value_set_flags(val, priv->map_flags);
+		break;
+	case FW_ISO_CTX_POOL_PROP_TYPE_AVAILABLE:
+		g_mutex_lock(&priv->mutex);
+		g_value_set_uint(val, priv->idle.length);
+		g_mutex_unlock(&priv->mutex);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, id, spec);
+		break;
+	}
+}
+
+static void fw_iso_ctx_pool_set_property(GObject *obj, guint id, const GValue *val,
+					 GParamSpec *spec)
+{
+	HinokoFwIsoCtxPool *self = HINOKO_FW_ISO_CTX_POOL(obj);
+	HinokoFwIsoCtxPoolPrivate *priv = hinoko_fw_iso_ctx_pool_get_instance_private(self);
+
+	switch (id) {
+	case FW_ISO_CTX_POOL_PROP_TYPE_MAP_FLAGS:
+		g_mutex_lock(&priv->mutex);
+		priv->map_flags = g_value_get_flags(val);
+		g_mutex_unlock(&priv->mutex);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, id, spec);
+		break;
+	}
+}
+
+static void fw_iso_ctx_pool_finalize(GObject *obj)
+{
+	HinokoFwIsoCtxPool *self = HINOKO_FW_ISO_CTX_POOL(obj);
+	HinokoFwIsoCtxPoolPrivate *priv = hinoko_fw_iso_ctx_pool_get_instance_private(self);
+
+	clear_ctxs(&priv->idle);
+	g_hash_table_destroy(priv->leased);
+	g_free(priv->path);
+	g_mutex_clear(&priv->mutex);
+
+	G_OBJECT_CLASS(hinoko_fw_iso_ctx_pool_parent_class)->finalize(obj);
+}
+
+static void hinoko_fw_iso_ctx_pool_class_init(HinokoFwIsoCtxPoolClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+
+	gobject_class->get_property = fw_iso_ctx_pool_get_property;
+	gobject_class->set_property = fw_iso_ctx_pool_set_property;
+	gobject_class->finalize = fw_iso_ctx_pool_finalize;
+
+	/**
+	 * HinokoFwIsoCtxPool:mode:
+	 *
+	 * The mode of isochronous contexts in the pool.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_CTX_POOL_PROP_TYPE_MODE,
+		g_param_spec_enum("mode", "mode",
+				  "The mode of isochronous contexts in the pool.",
+				  HINOKO_TYPE_FW_ISO_CTX_MODE, HINOKO_FW_ISO_CTX_MODE_IT,
+				  G_PARAM_READABLE));
+
+	/**
+	 * HinokoFwIsoCtxPool:bytes-per-chunk:
+	 *
+	 * The number of bytes per chunk in buffer of each isochronous context.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_CTX_POOL_PROP_TYPE_BYTES_PER_CHUNK,
+		g_param_spec_uint(BYTES_PER_CHUNK_PROP_NAME, "bytes-per-chunk",
+				  "The number of bytes for chunk in buffer.",
+				  0, G_MAXUINT, 0,
+				  G_PARAM_READABLE));
+
+	/**
+	 * HinokoFwIsoCtxPool:chunks-per-buffer:
+	 *
+	 * The number of chunks per buffer of each isochronous context.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_CTX_POOL_PROP_TYPE_CHUNKS_PER_BUFFER,
+		g_param_spec_uint(CHUNKS_PER_BUFFER_PROP_NAME, "chunks-per-buffer",
+				  "The number of chunks in buffer.",
+				  0, G_MAXUINT, 0,
+				  G_PARAM_READABLE));
+
+	/**
+	 * HinokoFwIsoCtxPool:map-flags:
+	 *
+	 * The set of flags applied to isochronous contexts created after the change of value. The
+	 * pages are always populated in advance.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_CTX_POOL_PROP_TYPE_MAP_FLAGS,
+		g_param_spec_flags(MAP_FLAGS_PROP_NAME, "map-flags",
+				   "The set of flags applied when mapping buffer.",
+				   HINOKO_TYPE_FW_ISO_CTX_MAP_FLAG,
+				   HINOKO_FW_ISO_CTX_MAP_FLAG_POPULATE,
+				   G_PARAM_READWRITE));
+
+	/**
+	 * HinokoFwIsoCtxPool:available:
+	 *
+	 * The number of isochronous contexts which are ready to be acquired.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_CTX_POOL_PROP_TYPE_AVAILABLE,
+		g_param_spec_uint("available", "available",
+				  "The number of isochronous contexts ready to be acquired.",
+				  0, G_MAXUINT, 0,
+				  G_PARAM_READABLE));
+}
+
+static void hinoko_fw_iso_ctx_pool_init(HinokoFwIsoCtxPool *self)
+{
+	HinokoFwIsoCtxPoolPrivate *priv = hinoko_fw_iso_ctx_pool_get_instance_private(self);
+
+	g_mutex_init(&priv->mutex);
+	g_queue_init(&priv->idle);
+	priv->leased = g_hash_table_new(g_direct_hash, g_direct_equal);
+	priv->mode = HINOKO_FW_ISO_CTX_MODE_IT;
+	priv->map_flags = HINOKO_FW_ISO_CTX_MAP_FLAG_POPULATE;
+}
+
+/**
+ * hinoko_fw_iso_ctx_pool_new:
+ *
+ * Instantiate [class@FwIsoCtxPool] object and return the instance.
+ *
+ * Returns: an instance of [class@FwIsoCtxPool].
+ *
+ * Since: 1.1
+ */
+HinokoFwIsoCtxPool *hinoko_fw_iso_ctx_pool_new(void)
+{
+	return g_object_new(HINOKO_TYPE_FW_ISO_CTX_POOL, NULL);
+}
+
+// The parameters of context are not changed after the preparation, thus the call is available
+// without holding the lock.
+static HinokoFwIsoCtx *create_ctx(const HinokoFwIsoCtxPoolPrivate *priv,
+				  HinokoFwIsoCtxMapFlag map_flags, GError **error)
+{
+	HinokoFwIsoCtx *ctx;
+
+	map_flags |= HINOKO_FW_ISO_CTX_MAP_FLAG_POPULATE;
+
+	switch (priv->mode) {
+	case HINOKO_FW_ISO_CTX_MODE_IT:
+	{
+		HinokoFwIsoIt *it = hinoko_fw_iso_it_new();
+
+		ctx = HINOKO_FW_ISO_CTX(it);
+		g_object_set(it, MAP_FLAGS_PROP_NAME, map_flags, NULL);
+
+		if (!hinoko_fw_iso_it_allocate(it, priv->path, priv->scode, priv->channel,
+					       priv->header_size, error))
+			break;
+
+		if (!hinoko_fw_iso_it_map_buffer(it, priv->bytes_per_chunk,
+						 priv->chunks_per_buffer, error))
+			break;
+
+		return ctx;
+	}
+	case HINOKO_FW_ISO_CTX_MODE_IR_SINGLE:
+	{
+		HinokoFwIsoIrSingle *ir = hinoko_fw_iso_ir_single_new();
+
+		ctx = HINOKO_FW_ISO_CTX(ir);
+		g_object_set(ir, MAP_FLAGS_PROP_NAME, map_flags, NULL);
+
+		if (!hinoko_fw_iso_ir_single_allocate(ir, priv->path, priv->channel,
+						      priv->header_size, error))
+			break;
+
+		if (!hinoko_fw_iso_ir_single_map_buffer(ir, priv->bytes_per_chunk,
+							priv->chunks_per_buffer, error))
+			break;
+
+		return ctx;
+	}
+	default:
+		g_return_val_if_reached(NULL);
+	}
+
+	g_object_unref(ctx);
+	return NULL;
+}
+
+/**
+ * hinoko_fw_iso_ctx_pool_prepare:
+ * @self: A [class@FwIsoCtxPool].
+ * @path: A path to any Linux FireWire character device.
+ * @mode: The mode of isochronous contexts, either [enum@Hinoko.FwIsoCtxMode].IT or
+ *	  [enum@Hinoko.FwIsoCtxMode].IR_SINGLE.
+ * @scode: A [enum@FwScode] to indicate speed of isochronous communication, only for IT context.
+ * @channel: An isochronous channel to transfer or listen, up to 63.
+ * @header_size: The number of bytes for header of isochronous context.
+ * @bytes_per_chunk: The number of bytes per chunk in buffer.
+ * @chunks_per_buffer: The number of chunks in buffer.
+ * @count: The number of isochronous contexts to prepare in advance, up to 1 for IR context.
+ * @error: A [struct@GLib.Error].
+ *
+ * Allocate the given number of isochronous contexts to 1394 OHCI hardware, map intermediate
+ * buffer for each of them with the flags in [property@FwIsoCtxPool:map-flags], and populate the
+ * pages so that no page fault occurs when the context starts. The parameters are kept to create
+ * context on demand when the pool is empty at [method@FwIsoCtxPool.acquire].
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_ctx_pool_prepare(HinokoFwIsoCtxPool *self, const char *path,
+					HinokoFwIsoCtxMode mode, HinokoFwScode scode,
+					guint channel, guint header_size, guint bytes_per_chunk,
+					guint chunks_per_buffer, guint count, GError **error)
+{
+	HinokoFwIsoCtxPoolPrivate *priv;
+	GQueue ctxs = G_QUEUE_INIT;
+	guint i;
+
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_CTX_POOL(self), FALSE);
+	g_return_val_if_fail(path != NULL, FALSE);
+	g_return_val_if_fail(mode == HINOKO_FW_ISO_CTX_MODE_IT ||
+			     mode == HINOKO_FW_ISO_CTX_MODE_IR_SINGLE, FALSE);
+	g_return_val_if_fail(channel <= IEEE1394_MAX_CHANNEL, FALSE);
+	g_return_val_if_fail(bytes_per_chunk > 0, FALSE);
+	g_return_val_if_fail(chunks_per_buffer > 0, FALSE);
+	g_return_val_if_fail(mode != HINOKO_FW_ISO_CTX_MODE_IR_SINGLE || count <= 1, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+	priv = hinoko_fw_iso_ctx_pool_get_instance_private(self);
+
+	g_mutex_lock(&priv->mutex);
+
+	if (priv->prepared) {
+		g_mutex_unlock(&priv->mutex);
+		generate_fw_iso_ctx_error_coded(error, HINOKO_FW_ISO_CTX_ERROR_ALLOCATED);
+		return FALSE;
+	}
+
+	priv->path = g_strdup(path);
+	priv->mode = mode;
+	priv->scode = scode;
+	priv->channel = channel;
+	priv->header_size = header_size;
+	priv->bytes_per_chunk = bytes_per_chunk;
+	priv->chunks_per_buffer = chunks_per_buffer;
+
+	for (i = 0; i < count; ++i) {
+		HinokoFwIsoCtx *ctx = create_ctx(priv, priv->map_flags, error);
+
+		if (ctx == NULL) {
+			clear_ctxs(&ctxs);
+			g_clear_pointer(&priv->path, g_free);
+			g_mutex_unlock(&priv->mutex);
+			return FALSE;
+		}
+
+		g_queue_push_tail(&ctxs, ctx);
+	}
+
+	priv->idle = ctxs;
+	priv->prepared = TRUE;
+
+	g_mutex_unlock(&priv->mutex);
+
+	return TRUE;
+}
+
+/**
+ * hinoko_fw_iso_ctx_pool_acquire:
+ * @self: A [class@FwIsoCtxPool].
+ * @error: A [struct@GLib.Error].
+ *
+ * Hand out an isochronous context kept in the pool. When the pool is empty, a new context is
+ * allocated and mapped with the parameters given to [method@FwIsoCtxPool.prepare]. The context
+ * should be given back by [method@FwIsoCtxPool.release].
+ *
+ * Returns: (transfer full) (nullable): An instance of [iface@FwIsoCtx], either [class@FwIsoIt]
+ *	    or [class@FwIsoIrSingle].
+ *
+ * Since: 1.1
+ */
+HinokoFwIsoCtx *hinoko_fw_iso_ctx_pool_acquire(HinokoFwIsoCtxPool *self, GError **error)
+{
+	HinokoFwIsoCtxPoolPrivate *priv;
+	HinokoFwIsoCtxMapFlag map_flags;
+	HinokoFwIsoCtx *ctx;
+
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_CTX_POOL(self), NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+	priv = hinoko_fw_iso_ctx_pool_get_instance_private(self);
+
+	g_mutex_lock(&priv->mutex);
+
+	if (!priv->prepared) {
+		g_mutex_unlock(&priv->mutex);
+		generate_fw_iso_ctx_error_coded(error, HINOKO_FW_ISO_CTX_ERROR_NOT_ALLOCATED);
+		return NULL;
+	}
+
+	ctx = g_queue_pop_head(&priv->idle);
+	map_flags = priv->map_flags;
+
+	// The allocation and the mapping are done without holding the lock, since they take time.
+	if (ctx == NULL) {
+		g_mutex_unlock(&priv->mutex);
+		ctx = create_ctx(priv, map_flags, error);
+		if (ctx == NULL)
+			return NULL;
+		g_mutex_lock(&priv->mutex);
+	}
+
+	g_hash_table_add(priv->leased, ctx);
+
+	g_mutex_unlock(&priv->mutex);
+
+	return ctx;
+}
+
+/**
+ * hinoko_fw_iso_ctx_pool_release:
+ * @self: A [class@FwIsoCtxPool].
+ * @ctx: (transfer full): An instance of [iface@FwIsoCtx] handed out by
+ *	 [method@FwIsoCtxPool.acquire].
+ *
+ * Give back the isochronous context to the pool. The context is stopped if running, and the chunks
+ * registered but not queued yet are dropped. The allocation to 1394 OHCI hardware and the mapping
+ * of intermediate buffer are kept, thus the context is handed out again by
+ * [method@FwIsoCtxPool.acquire]. When the context is already released or unmapped, it is just
+ * destroyed. The caller should remove [struct@GLib.Source] created for the context and disconnect
+ * signal handlers in advance.
+ *
+ * Since: 1.1
+ */
+void hinoko_fw_iso_ctx_pool_release(HinokoFwIsoCtxPool *self, HinokoFwIsoCtx *ctx)
+{
+	HinokoFwIsoCtxPoolPrivate *priv;
+	gboolean reusable;
+
+	g_return_if_fail(HINOKO_IS_FW_ISO_CTX_POOL(self));
+	g_return_if_fail(HINOKO_IS_FW_ISO_CTX(ctx));
+	priv = hinoko_fw_iso_ctx_pool_get_instance_private(self);
+
+	g_mutex_lock(&priv->mutex);
+	if (!g_hash_table_remove(priv->leased, ctx)) {
+		g_mutex_unlock(&priv->mutex);
+		g_return_if_reached();
+	}
+	g_mutex_unlock(&priv->mutex);
+
+	hinoko_fw_iso_ctx_stop(ctx);
+
+	if (HINOKO_IS_FW_ISO_IT(ctx))
+		reusable = fw_iso_it_recycle(HINOKO_FW_ISO_IT(ctx));
+	else
+		reusable = fw_iso_ir_single_recycle(HINOKO_FW_ISO_IR_SINGLE(ctx));
+
+	if (!reusable) {
+		g_object_unref(ctx);
+		return;
+	}
+
+	g_mutex_lock(&priv->mutex);
+	g_queue_push_tail(&priv->idle, ctx);
+	g_mutex_unlock(&priv->mutex);
+}
@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#ifndef __ORG_KERNEL_HINOKO_FW_ISO_CTX_POOL_H__
+#define __ORG_KERNEL_HINOKO_FW_ISO_CTX_POOL_H__
+
+#include <hinoko.h>
+
+G_BEGIN_DECLS
+
+#define HINOKO_TYPE_FW_ISO_CTX_POOL	(hinoko_fw_iso_ctx_pool_get_type())
+
+G_DECLARE_DERIVABLE_TYPE(HinokoFwIsoCtxPool, hinoko_fw_iso_ctx_pool, HINOKO, FW_ISO_CTX_POOL,
+			 GObject);
+
+struct _HinokoFwIsoCtxPoolClass {
+	GObjectClass parent_class;
+};
+
+HinokoFwIsoCtxPool *hinoko_fw_iso_ctx_pool_new(void);
+
+gboolean hinoko_fw_iso_ctx_pool_prepare(HinokoFwIsoCtxPool *self, const char *path,
+					HinokoFwIsoCtxMode mode, HinokoFwScode scode,
+					guint channel, guint header_size, guint bytes_per_chunk,
+					guint chunks_per_buffer, guint count, GError **error);
+
+HinokoFwIsoCtx *hinoko_fw_iso_ctx_pool_acquire(HinokoFwIsoCtxPool *self, GError **error);
+
+void hinoko_fw_iso_ctx_pool_release(HinokoFwIsoCtxPool *self, HinokoFwIsoCtx *ctx);
+
+G_END_DECLS
+
+#endif
@@ -5,6 +5,9 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <stdlib.h>
+#include <time.h>
 
 #define generate_file_error(error, code, format, arg)		\
 	g_set_error(error, G_FILE_ERROR, code, format, arg)
@@ -12,6 +15,7 @@
 typedef struct {
 	GSource src;
 	gpointer tag;
+	struct fw_iso_ctx_state *state;
 	unsigned int len;
 	void *buf;
 	HinokoFwIsoCtx *self;
@@ -20,6 +24,17 @@ typedef struct {
 				 GError **error);
 } FwIsoCtxSource;
 
+// Evaluated at each call so that g_log_set_debug_enabled() and G_MESSAGES_DEBUG changed at
+// runtime take effect.
+gboolean fw_iso_ctx_debug_enabled(void)
+{
+#if GLIB_CHECK_VERSION(2, 68, 0)
+	return !g_log_writer_default_would_drop(G_LOG_LEVEL_DEBUG, G_LOG_DOMAIN);
+#else
+	return g_getenv("G_MESSAGES_DEBUG") != NULL;
+#endif
+}
+
 void fw_iso_ctx_class_override_properties(GObjectClass *gobject_class)
 {
 	g_object_class_override_property(gobject_class, FW_ISO_CTX_PROP_TYPE_BYTES_PER_CHUNK,
@@ -27,6 +42,43 @@ void fw_iso_ctx_class_override_properties(GObjectClass *gobject_class)
 
 	g_object_class_override_property(gobject_class, FW_ISO_CTX_PROP_TYPE_CHUNKS_PER_BUFFER,
 					 CHUNKS_PER_BUFFER_PROP_NAME);
+
+	g_object_class_override_property(gobject_class, FW_ISO_CTX_PROP_TYPE_MAP_FLAGS,
+					 MAP_FLAGS_PROP_NAME);
+
+	g_object_class_override_property(gobject_class, FW_ISO_CTX_PROP_TYPE_RESIDENT_BYTES,
+					 RESIDENT_BYTES_PROP_NAME);
+
+	g_object_class_override_property(gobject_class, FW_ISO_CTX_PROP_TYPE_QUEUE_POLICY,
+					 QUEUE_POLICY_PROP_NAME);
+
+	g_object_class_override_property(gobject_class, FW_ISO_CTX_PROP_TYPE_QUEUE_THRESHOLD_CHUNKS,
+					 QUEUE_THRESHOLD_CHUNKS_PROP_NAME);
+
+	g_object_class_override_property(gobject_class, FW_ISO_CTX_PROP_TYPE_QUEUE_THRESHOLD_BYTES,
+					 QUEUE_THRESHOLD_BYTES_PROP_NAME);
+
+	g_object_class_override_property(gobject_class, FW_ISO_CTX_PROP_TYPE_HEADROOM,
+					 HEADROOM_PROP_NAME);
+
+	g_object_class_override_property(gobject_class, FW_ISO_CTX_PROP_TYPE_MINIMUM_HEADROOM,
+					 MINIMUM_HEADROOM_PROP_NAME);
+
+	g_object_class_override_property(gobject_class, FW_ISO_CTX_PROP_TYPE_HEADROOM_THRESHOLD,
+					 HEADROOM_THRESHOLD_PROP_NAME);
+}
+
+// The signal is defined by the interface, thus the interface is initialized in advance to look it
+// up at class initialization of the implementation. The identifier is used to emit the signal in
+// the path of interrupt event without the look up by name.
+guint fw_iso_ctx_class_lookup_low_headroom(void)
+{
+	gpointer iface = g_type_default_interface_ref(HINOKO_TYPE_FW_ISO_CTX);
+	guint signal_id = g_signal_lookup(LOW_HEADROOM_SIGNAL_NAME, HINOKO_TYPE_FW_ISO_CTX);
+
+	g_type_default_interface_unref(iface);
+
+	return signal_id;
 }
 
 void fw_iso_ctx_state_get_property(const struct fw_iso_ctx_state *state, GObject *obj, guint id,
@@ -39,12 +91,223 @@ void fw_iso_ctx_state_get_property(const struct fw_iso_ctx_state *state, GObject
 	case FW_ISO_CTX_PROP_TYPE_CHUNKS_PER_BUFFER:
 		g_value_set_uint(val, state->chunks_per_buffer);
 		break;
+	case FW_ISO_CTX_PROP_TYPE_MAP_FLAGS:
+		g_value_set_flags(val, state->map_flags);
+		break;
+	case FW_ISO_CTX_PROP_TYPE_RESIDENT_BYTES:
+		g_value_set_uint64(val, fw_iso_ctx_state_resident_bytes(state));
+		break;
+	case FW_ISO_CTX_PROP_TYPE_QUEUE_POLICY:
+		g_value_set_enum(val, state->queue_policy);
+		break;
+	case FW_ISO_CTX_PROP_TYPE_QUEUE_THRESHOLD_CHUNKS:
+		g_value_set_uint(val, state->queue_threshold_chunks);
+		break;
+	case FW_ISO_CTX_PROP_TYPE_QUEUE_THRESHOLD_BYTES:
+		g_value_set_uint(val, state->queue_threshold_bytes);
+		break;
+	case FW_ISO_CTX_PROP_TYPE_HEADROOM:
+		g_value_set_uint(val, state->headroom);
+		break;
+	case FW_ISO_CTX_PROP_TYPE_MINIMUM_HEADROOM:
+		g_value_set_uint(val, state->minimum_headroom);
+		break;
+	case FW_ISO_CTX_PROP_TYPE_HEADROOM_THRESHOLD:
+		g_value_set_uint(val, state->headroom_threshold);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, id, spec);
+		break;
+	}
+}
+
+void fw_iso_ctx_state_set_property(struct fw_iso_ctx_state *state, GObject *obj, guint id,
+				   const GValue *val, GParamSpec *spec)
+{
+	switch (id) {
+	case FW_ISO_CTX_PROP_TYPE_MAP_FLAGS:
+		state->map_flags = g_value_get_flags(val);
+		break;
+	case FW_ISO_CTX_PROP_TYPE_QUEUE_POLICY:
+		state->queue_policy = g_value_get_enum(val);
+		break;
+	case FW_ISO_CTX_PROP_TYPE_QUEUE_THRESHOLD_CHUNKS:
+		state->queue_threshold_chunks = g_value_get_uint(val);
+		break;
+	case FW_ISO_CTX_PROP_TYPE_QUEUE_THRESHOLD_BYTES:
+		state->queue_threshold_bytes = g_value_get_uint(val);
+		break;
+	case FW_ISO_CTX_PROP_TYPE_HEADROOM_THRESHOLD:
+		state->headroom_threshold = g_value_get_uint(val);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, id, spec);
 		break;
 	}
 }
 
+// The default size of huge page in the system, or zero when it is not available.
+static gsize read_huge_page_size(void)
+{
+	static const char label[] = "Hugepagesize:";
+	gchar *content;
+	const gchar *pos;
+	gsize size = 0;
+
+	if (!g_file_get_contents("/proc/meminfo", &content, NULL, NULL))
+		return 0;
+
+	// The value is in kilobytes.
+	pos = strstr(content, label);
+	if (pos != NULL)
+		size = (gsize)g_ascii_strtoull(pos + sizeof(label) - 1, NULL, 10) * 1024;
+	g_free(content);
+
+	return size;
+}
+
+static guint64 count_resident_bytes(const void *ptr, gsize size)
+{
+	long page_size = sysconf(_SC_PAGESIZE);
+	guintptr head;
+	gsize length;
+	gsize page_count;
+	unsigned char *vec;
+	guint64 bytes;
+	gsize i;
+
+	if (ptr == NULL || size == 0)
+		return 0;
+
+	// The address should be aligned to page for mincore(2).
+	head = (guintptr)ptr & ~((guintptr)page_size - 1);
+	length = (guintptr)ptr + size - head;
+	page_count = (length + page_size - 1) / page_size;
+
+	vec = g_malloc(page_count);
+	if (mincore((void *)head, length, vec) < 0) {
+		g_free(vec);
+		return 0;
+	}
+
+	bytes = 0;
+	for (i = 0; i < page_count; ++i) {
+		if (vec[i] & 0x01)
+			bytes += page_size;
+	}
+	g_free(vec);
+
+	return bytes;
+}
+
+static void arena_free(struct fw_iso_ctx_arena *arena);
+
+static gboolean arena_alloc(struct fw_iso_ctx_arena *arena, gsize size,
+			    HinokoFwIsoCtxMapFlag flags, GError **error)
+{
+	void *ptr;
+
+	g_return_val_if_fail(arena->ptr == NULL, FALSE);
+	g_return_val_if_fail(size > 0, FALSE);
+
+	if (flags & HINOKO_FW_ISO_CTX_MAP_FLAG_HUGE_PAGES) {
+		long page_size = sysconf(_SC_PAGESIZE);
+		gsize huge_page_size = read_huge_page_size();
+
+		ptr = MAP_FAILED;
+		if (huge_page_size > 0) {
+			arena->size = (size + huge_page_size - 1) / huge_page_size * huge_page_size;
+			ptr = mmap(NULL, arena->size, PROT_READ | PROT_WRITE,
+				   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		}
+		if (ptr == MAP_FAILED) {
+			// Fallback to transparent huge page when no huge page is reserved.
+			g_debug("No huge page of %zu bytes is available for %zu bytes, fallback to "
+				"transparent huge page", huge_page_size, size);
+			arena->size = (size + page_size - 1) / page_size * page_size;
+			ptr = mmap(NULL, arena->size, PROT_READ | PROT_WRITE,
+				   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (ptr == MAP_FAILED) {
+				generate_syscall_error(error, errno, "mmap(%zu)", arena->size);
+				arena->size = 0;
+				return FALSE;
+			}
+			madvise(ptr, arena->size, MADV_HUGEPAGE);
+		}
+		arena->anonymous_map = TRUE;
+
+		// The pages are filled with zero by the kernel at page fault, thus touched just to
+		// populate them.
+		if (flags & HINOKO_FW_ISO_CTX_MAP_FLAG_POPULATE)
+			memset(ptr, 0, arena->size);
+	} else {
+		int err = posix_memalign(&ptr, CACHELINE_SIZE, size);
+		if (err != 0) {
+			generate_syscall_error(error, err, "posix_memalign(%zu)", size);
+			return FALSE;
+		}
+		arena->size = size;
+		arena->anonymous_map = FALSE;
+
+		// The pages are populated at the same time.
+		memset(ptr, 0, size);
+	}
+
+	arena->ptr = ptr;
+
+	if (flags & HINOKO_FW_ISO_CTX_MAP_FLAG_LOCK) {
+		if (mlock(arena->ptr, arena->size) < 0) {
+			generate_syscall_error(error, errno, "mlock(%zu)", arena->size);
+			arena_free(arena);
+			return FALSE;
+		}
+		arena->locked = TRUE;
+	}
+
+	return TRUE;
+}
+
+static void arena_free(struct fw_iso_ctx_arena *arena)
+{
+	if (arena->ptr == NULL)
+		return;
+
+	if (arena->locked)
+		munlock(arena->ptr, arena->size);
+
+	if (arena->anonymous_map)
+		munmap(arena->ptr, arena->size);
+	else
+		free(arena->ptr);
+
+	arena->ptr = NULL;
+	arena->size = 0;
+	arena->anonymous_map = FALSE;
+	arena->locked = FALSE;
+}
+
+/**
+ * fw_iso_ctx_state_resident_bytes:
+ * @state: A [struct@FwIsoCtxState].
+ *
+ * Count the number of bytes resident in physical memory for intermediate buffer and the arena of
+ * the context.
+ *
+ * Returns: The number of bytes.
+ */
+guint64 fw_iso_ctx_state_resident_bytes(const struct fw_iso_ctx_state *state)
+{
+	guint64 bytes = 0;
+
+	if (state->addr != NULL)
+		bytes += count_resident_bytes(state->addr,
+					      state->bytes_per_chunk * state->chunks_per_buffer);
+
+	bytes += count_resident_bytes(state->arena.ptr, state->arena.size);
+
+	return bytes;
+}
+
 /**
  * fw_iso_ctx_state_init:
  * @state: A [struct@FwIsoCtxState].
@@ -113,6 +376,20 @@ gboolean fw_iso_ctx_state_allocate(struct fw_iso_ctx_state *state, const char *p
 		return FALSE;
 	}
 
+	if (state->offline) {
+		state->fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+		if (state->fd < 0) {
+			generate_syscall_error(error, errno, "eventfd(%s)", path);
+			return FALSE;
+		}
+
+		state->handle = 0;
+		state->mode = mode;
+		state->header_size = header_size;
+
+		return TRUE;
+	}
+
 	state->fd = open(path, O_RDWR);
 	if  (state->fd < 0) {
 		GFileError code = g_file_error_from_errno(errno);
@@ -161,22 +438,61 @@ void fw_iso_ctx_state_release(struct fw_iso_ctx_state *state)
 		close(state->fd);
 
 	state->fd = -1;
+	state->offline = FALSE;
+}
+
+static unsigned int event_buf_length(HinokoFwIsoCtxMode mode)
+{
+	if (mode != HINOKO_FW_ISO_CTX_MODE_IR_MULTIPLE) {
+		// MEMO: Linux FireWire subsystem queues isochronous event
+		// independently of interrupt flag when the same number of
+		// bytes as one page is stored in the buffer of header. To
+		// avoid truncated read, keep enough size.
+		return sizeof(struct fw_cdev_event_iso_interrupt) + sysconf(_SC_PAGESIZE);
+	} else {
+		return sizeof(struct fw_cdev_event_iso_interrupt_mc);
+	}
+}
+
+static void prefault_buffer(struct fw_iso_ctx_state *state)
+{
+	unsigned int bytes_per_buffer = state->bytes_per_chunk * state->chunks_per_buffer;
+	long page_size = sysconf(_SC_PAGESIZE);
+	unsigned int i;
+
+	// The buffer for IR context is not writable.
+	for (i = 0; i < bytes_per_buffer; i += page_size) {
+		if (state->mode == HINOKO_FW_ISO_CTX_MODE_IT)
+			state->addr[i] = 0;
+		else
+			(void)*(volatile guchar *)(state->addr + i);
+	}
 }
 
+static gboolean queue_chunks_it(struct fw_iso_ctx_state *state, GError **error);
+static gboolean queue_chunks_ir_single(struct fw_iso_ctx_state *state, GError **error);
+static gboolean queue_chunks_ir_multiple(struct fw_iso_ctx_state *state, GError **error);
+
 /**
  * fw_iso_ctx_state_map_buffer:
  * @state: A [struct@FwIsoCtxState].
  * @bytes_per_chunk: The number of bytes per chunk in buffer going to be allocated.
  * @chunks_per_buffer: The number of chunks in buffer going to be allocated.
+ * @private_size: The number of bytes for private area of the class in the arena.
  * @error: A [struct@GLib.Error].
  *
- * Map intermediate buffer to share payload of isochronous context with 1394 OHCI hardware.
+ * Map intermediate buffer to share payload of isochronous context with 1394 OHCI hardware, and
+ * allocate the arena of context. The value of map_flags member is applied to both of them.
  */
 gboolean fw_iso_ctx_state_map_buffer(struct fw_iso_ctx_state *state, guint bytes_per_chunk,
-				     guint chunks_per_buffer, GError **error)
+				     guint chunks_per_buffer, gsize private_size, GError **error)
 {
+	unsigned int bytes_per_buffer;
 	unsigned int datum_size;
+	gsize data_offset;
+	gsize private_offset;
 	int prot;
+	int flags;
 
 	g_return_val_if_fail(bytes_per_chunk > 0, FALSE);
 	g_return_val_if_fail(chunks_per_buffer > 0, FALSE);
@@ -192,52 +508,193 @@ gboolean fw_iso_ctx_state_map_buffer(struct fw_iso_ctx_state *state, guint bytes
 		return FALSE;
 	}
 
+	state->event_buf_length = event_buf_length(state->mode);
+
 	datum_size = sizeof(struct fw_cdev_iso_packet);
 	if (state->mode == HINOKO_FW_ISO_CTX_MODE_IT)
 		datum_size += state->header_size;
+	state->alloc_data_length = chunks_per_buffer * datum_size;
 
-	state->data = g_malloc_n(chunks_per_buffer, datum_size);
+	data_offset = CACHELINE_ALIGN(state->event_buf_length);
+	private_offset = CACHELINE_ALIGN(data_offset + state->alloc_data_length);
 
-	state->alloc_data_length = chunks_per_buffer * datum_size;
+	if (!arena_alloc(&state->arena, private_offset + private_size, state->map_flags, error))
+		return FALSE;
+	state->event_buf = state->arena.ptr;
+	state->data = state->arena.ptr + data_offset;
+	state->private_area = private_size > 0 ? state->arena.ptr + private_offset : NULL;
 
 	prot = PROT_READ;
 	if (state->mode == HINOKO_FW_ISO_CTX_MODE_IT)
 		prot |= PROT_WRITE;
 
+	flags = MAP_SHARED;
+	if (state->map_flags & HINOKO_FW_ISO_CTX_MAP_FLAG_POPULATE)
+		flags |= MAP_POPULATE;
+
 	// Align to size of page.
-	state->addr = mmap(NULL, bytes_per_chunk * chunks_per_buffer, prot,
-			  MAP_SHARED, state->fd, 0);
+	bytes_per_buffer = bytes_per_chunk * chunks_per_buffer;
+	if (!state->offline) {
+		state->addr = mmap(NULL, bytes_per_buffer, prot, flags, state->fd, 0);
+	} else {
+		// The content of buffer is written by the driver of offline context.
+		flags = (flags & ~MAP_SHARED) | MAP_PRIVATE | MAP_ANONYMOUS;
+		state->addr = mmap(NULL, bytes_per_buffer, PROT_READ | PROT_WRITE, flags, -1, 0);
+	}
 	if (state->addr == MAP_FAILED) {
-		generate_syscall_error(error, errno,
-				       "mmap(%d)", bytes_per_chunk * chunks_per_buffer);
-		return FALSE;
+		generate_syscall_error(error, errno, "mmap(%d)", bytes_per_buffer);
+		state->addr = NULL;
+		goto err_arena;
+	}
+
+	if (state->map_flags & HINOKO_FW_ISO_CTX_MAP_FLAG_LOCK) {
+		if (mlock(state->addr, bytes_per_buffer) < 0) {
+			generate_syscall_error(error, errno, "mlock(%d)", bytes_per_buffer);
+			munmap(state->addr, bytes_per_buffer);
+			state->addr = NULL;
+			goto err_arena;
+		}
 	}
 
 	state->bytes_per_chunk = bytes_per_chunk;
 	state->chunks_per_buffer = chunks_per_buffer;
+	state->applied_map_flags = state->map_flags;
+
+	switch (state->mode) {
+	case HINOKO_FW_ISO_CTX_MODE_IT:
+		state->queue_chunks = queue_chunks_it;
+		break;
+	case HINOKO_FW_ISO_CTX_MODE_IR_SINGLE:
+		state->queue_chunks = queue_chunks_ir_single;
+		break;
+	case HINOKO_FW_ISO_CTX_MODE_IR_MULTIPLE:
+	default:
+		state->queue_chunks = queue_chunks_ir_multiple;
+		break;
+	}
+
+	if (state->map_flags & HINOKO_FW_ISO_CTX_MAP_FLAG_POPULATE)
+		prefault_buffer(state);
 
 	return TRUE;
+err_arena:
+	arena_free(&state->arena);
+	state->event_buf = NULL;
+	state->data = NULL;
+	state->private_area = NULL;
+	return FALSE;
 }
 
 /**
  * hinoko_fw_iso_ctx_unmap_buffer:
  * @state: A [struct@FwIsoCtxState].
  *
- * Unmap intermediate buffer shard with 1394 OHCI hardware for payload of isochronous context.
+ * Unmap intermediate buffer shard with 1394 OHCI hardware for payload of isochronous context, and
+ * free the arena of context.
  */
 void fw_iso_ctx_state_unmap_buffer(struct fw_iso_ctx_state *state)
 {
 	if (state->addr != NULL) {
-		munmap(state->addr, state->bytes_per_chunk * state->chunks_per_buffer);
+		unsigned int bytes_per_buffer = state->bytes_per_chunk * state->chunks_per_buffer;
+
+		if (state->applied_map_flags & HINOKO_FW_ISO_CTX_MAP_FLAG_LOCK)
+			munlock(state->addr, bytes_per_buffer);
+		munmap(state->addr, bytes_per_buffer);
 	}
 
-	if (state->data != NULL)
-		free(state->data);
+	arena_free(&state->arena);
 
 	state->addr = NULL;
+	state->event_buf = NULL;
 	state->data = NULL;
+	state->private_area = NULL;
+	state->applied_map_flags = 0;
+	state->queue_chunks = NULL;
+}
+
+/**
+ * fw_iso_ctx_state_recycle:
+ * @state: A [struct@FwIsoCtxState].
+ *
+ * Stop isochronous context and drop chunks registered but not queued yet, so that the context
+ * is available again with the same allocation and mapping.
+ *
+ * Returns: TRUE if the context is still allocated and the buffer is still mapped, otherwise FALSE.
+ */
+gboolean fw_iso_ctx_state_recycle(struct fw_iso_ctx_state *state)
+{
+	fw_iso_ctx_state_stop(state);
+
+	state->registered_chunk_count = 0;
+	state->pending_bytes = 0;
+	state->registered_total = 0;
+	state->completed_total = 0;
+	state->data_length = 0;
+	state->curr_offset = 0;
+
+	return state->fd >= 0 && state->addr != NULL;
+}
+
+// The mode and geometry of context are fixed after mapping buffer, thus the functions below are
+// specialized for each mode to skip the validation of arguments and the branches for mode in the
+// path of packet processing. The caller should validate arguments in advance.
+static inline void register_chunk_unchecked(struct fw_iso_ctx_state *state,
+					    HinokoFwIsoCtxMode mode, gboolean skip,
+					    HinokoFwIsoCtxMatchFlag tags, guint sync_code,
+					    const guint8 *header, guint header_length,
+					    guint payload_length, gboolean schedule_interrupt)
+{
+	struct fw_cdev_iso_packet *datum;
+
+	datum = (struct fw_cdev_iso_packet *)(state->data + state->data_length);
+	state->data_length += sizeof(*datum) + header_length;
+	++state->registered_chunk_count;
+	++state->registered_total;
+
+	if (mode == HINOKO_FW_ISO_CTX_MODE_IT) {
+		if (!skip)
+			memcpy(datum->header, header, header_length);
+	} else {
+		payload_length = state->bytes_per_chunk;
+
+		if (mode == HINOKO_FW_ISO_CTX_MODE_IR_SINGLE)
+			header_length = state->header_size;
+	}
+
+	state->pending_bytes += payload_length;
+
+	datum->control =
+		FW_CDEV_ISO_PAYLOAD_LENGTH(payload_length) |
+		FW_CDEV_ISO_TAG(tags) |
+		FW_CDEV_ISO_SY(sync_code) |
+		FW_CDEV_ISO_HEADER_LENGTH(header_length);
+
+	if (skip)
+		datum->control |= FW_CDEV_ISO_SKIP;
+
+	if (schedule_interrupt)
+		datum->control |= FW_CDEV_ISO_INTERRUPT;
 }
 
+void fw_iso_ctx_state_register_chunk_it(struct fw_iso_ctx_state *state, gboolean skip,
+					HinokoFwIsoCtxMatchFlag tags, guint sync_code,
+					const guint8 *header, guint header_length,
+					guint payload_length, gboolean schedule_interrupt)
+{
+	register_chunk_unchecked(state, HINOKO_FW_ISO_CTX_MODE_IT, skip, tags, sync_code, header,
+				 header_length, payload_length, schedule_interrupt);
+}
+
+#define DEFINE_REGISTER_CHUNK_IR(name, mode)							\
+void fw_iso_ctx_state_register_chunk_##name(struct fw_iso_ctx_state *state,			\
+					    gboolean schedule_interrupt)			\
+{												\
+	register_chunk_unchecked(state, mode, FALSE, 0, 0, NULL, 0, 0, schedule_interrupt);	\
+}
+
+DEFINE_REGISTER_CHUNK_IR(ir_single, HINOKO_FW_ISO_CTX_MODE_IR_SINGLE)
+DEFINE_REGISTER_CHUNK_IR(ir_multiple, HINOKO_FW_ISO_CTX_MODE_IR_MULTIPLE)
+
 /**
  * fw_iso_ctx_state_register_chunk:
  * @state: A [struct@FwIsoCtxState].
@@ -304,58 +761,27 @@ gboolean fw_iso_ctx_state_register_chunk(struct fw_iso_ctx_state *state, gboolea
 		return FALSE;
 	}
 
-	datum = (struct fw_cdev_iso_packet *)(state->data + state->data_length);
-	state->data_length += sizeof(*datum) + header_length;
-	++state->registered_chunk_count;
-
-	if (state->mode == HINOKO_FW_ISO_CTX_MODE_IT) {
-		if (!skip)
-			memcpy(datum->header, header, header_length);
-	} else {
-		payload_length = state->bytes_per_chunk;
-
-		if (state->mode == HINOKO_FW_ISO_CTX_MODE_IR_SINGLE)
-			header_length = state->header_size;
+	switch (state->mode) {
+	case HINOKO_FW_ISO_CTX_MODE_IT:
+		fw_iso_ctx_state_register_chunk_it(state, skip, tags, sync_code, header,
+						   header_length, payload_length,
+						   schedule_interrupt);
+		break;
+	case HINOKO_FW_ISO_CTX_MODE_IR_SINGLE:
+		fw_iso_ctx_state_register_chunk_ir_single(state, schedule_interrupt);
+		break;
+	case HINOKO_FW_ISO_CTX_MODE_IR_MULTIPLE:
+		fw_iso_ctx_state_register_chunk_ir_multiple(state, schedule_interrupt);
+		break;
+	default:
+		g_return_val_if_reached(FALSE);
 	}
 
-	datum->control =
-		FW_CDEV_ISO_PAYLOAD_LENGTH(payload_length) |
-		FW_CDEV_ISO_TAG(tags) |
-		FW_CDEV_ISO_SY(sync_code) |
-		FW_CDEV_ISO_HEADER_LENGTH(header_length);
-
-	if (skip)
-		datum->control |= FW_CDEV_ISO_SKIP;
-
-	if (schedule_interrupt)
-		datum->control |= FW_CDEV_ISO_INTERRUPT;
-
 	return TRUE;
 }
 
-#define FW_CDEV_ISO_PACKET_CONTROL_HEADER_LENGTH_MASK	0xff000000
-#define FW_CDEV_ISO_PACKET_CONTROL_HEADER_LENGTH_SHIFT	24
-#define FW_CDEV_ISO_PACKET_CONTROL_PAYLOAD_MASK		0x0000ffff
-
-static guint fw_cdev_iso_packet_control_to_header_length(guint control)
-{
-	return (control & FW_CDEV_ISO_PACKET_CONTROL_HEADER_LENGTH_MASK) >>
-		FW_CDEV_ISO_PACKET_CONTROL_HEADER_LENGTH_SHIFT;
-}
-
-static guint fw_cdev_iso_packet_control_to_payload_length(guint control)
-{
-	return (control & FW_CDEV_ISO_PACKET_CONTROL_PAYLOAD_MASK);
-}
-
-/**
- * fw_iso_ctx_state_queue_chunks:
- * @state: A [struct@FwIsoCtxState].
- * @error: A [struct@GLib.Error].
- *
- * Queue registered chunks to 1394 OHCI hardware.
- */
-gboolean fw_iso_ctx_state_queue_chunks(struct fw_iso_ctx_state *state, GError **error)
+static inline gboolean queue_chunks_unchecked(struct fw_iso_ctx_state *state,
+					      HinokoFwIsoCtxMode mode, GError **error)
 {
 	guint data_offset = 0;
 	int chunk_count = 0;
@@ -389,10 +815,10 @@ gboolean fw_iso_ctx_state_queue_chunks(struct fw_iso_ctx_state *state, GError **
 			}
 
 			datum_length = sizeof(*datum);
-			if (state->mode == HINOKO_FW_ISO_CTX_MODE_IT)
+			if (mode == HINOKO_FW_ISO_CTX_MODE_IT)
 				datum_length += header_length;
 
-			g_debug("%3d: %3d-%3d/%3d: %6d-%6d/%6d: %d",
+			fw_iso_ctx_debug("%3d: %3d-%3d/%3d: %6d-%6d/%6d: %d",
 				chunk_count,
 				data_offset + data_length,
 				data_offset + data_length + datum_length,
@@ -411,12 +837,16 @@ gboolean fw_iso_ctx_state_queue_chunks(struct fw_iso_ctx_state *state, GError **
 		arg.size = data_length;
 		arg.data = (__u64)(state->addr + buf_offset);
 		arg.handle = state->handle;
-		if (ioctl(state->fd, FW_CDEV_IOC_QUEUE_ISO, &arg) < 0) {
+		if (state->offline) {
+			if (state->queue_offline != NULL)
+				state->queue_offline(state, state->data + data_offset, data_length,
+						     buf_offset, state->queue_offline_data);
+		} else if (ioctl(state->fd, FW_CDEV_IOC_QUEUE_ISO, &arg) < 0) {
 			generate_fw_iso_ctx_error_ioctl(error, errno, FW_CDEV_IOC_QUEUE_ISO);
 			return FALSE;
 		}
 
-		g_debug("%3d: %3d-%3d/%3d: %6d-%6d/%6d",
+		fw_iso_ctx_debug("%3d: %3d-%3d/%3d: %6d-%6d/%6d",
 			chunk_count,
 			data_offset, data_offset + data_length,
 			state->alloc_data_length,
@@ -435,10 +865,128 @@ gboolean fw_iso_ctx_state_queue_chunks(struct fw_iso_ctx_state *state, GError **
 
 	state->data_length = 0;
 	state->registered_chunk_count = 0;
+	state->pending_bytes = 0;
 
 	return TRUE;
 }
 
+#define DEFINE_QUEUE_CHUNKS(name, mode)							\
+static gboolean queue_chunks_##name(struct fw_iso_ctx_state *state, GError **error)	\
+{											\
+	return queue_chunks_unchecked(state, mode, error);				\
+}
+
+DEFINE_QUEUE_CHUNKS(it, HINOKO_FW_ISO_CTX_MODE_IT)
+DEFINE_QUEUE_CHUNKS(ir_single, HINOKO_FW_ISO_CTX_MODE_IR_SINGLE)
+DEFINE_QUEUE_CHUNKS(ir_multiple, HINOKO_FW_ISO_CTX_MODE_IR_MULTIPLE)
+
+/**
+ * fw_iso_ctx_state_queue_chunks:
+ * @state: A [struct@FwIsoCtxState].
+ * @error: A [struct@GLib.Error].
+ *
+ * Queue registered chunks to 1394 OHCI hardware.
+ */
+gboolean fw_iso_ctx_state_queue_chunks(struct fw_iso_ctx_state *state, GError **error)
+{
+	if (state->registered_chunk_count == 0)
+		return TRUE;
+
+	if (state->queue_chunks == NULL) {
+		generate_fw_iso_ctx_error_coded(error, HINOKO_FW_ISO_CTX_ERROR_NOT_MAPPED);
+		return FALSE;
+	}
+
+	return state->queue_chunks(state, error);
+}
+
+/**
+ * fw_iso_ctx_state_queue_chunks_by_policy:
+ * @state: A [struct@FwIsoCtxState].
+ * @at_interrupt: Whether to be called just after processing interrupt event.
+ * @error: A [struct@GLib.Error].
+ *
+ * Queue registered chunks to 1394 OHCI hardware according to the queue policy while the context
+ * is running. The chunks registered before starting are queued at starting.
+ */
+gboolean fw_iso_ctx_state_queue_chunks_by_policy(struct fw_iso_ctx_state *state,
+						 gboolean at_interrupt, GError **error)
+{
+	if (!state->running || state->registered_chunk_count == 0)
+		return TRUE;
+
+	switch (state->queue_policy) {
+	case HINOKO_FW_ISO_CTX_QUEUE_POLICY_IMMEDIATE:
+		break;
+	case HINOKO_FW_ISO_CTX_QUEUE_POLICY_THRESHOLD:
+	{
+		gboolean reached;
+
+		// When both thresholds are zero, the chunk is queued as soon as registered.
+		if (state->queue_threshold_chunks == 0 && state->queue_threshold_bytes == 0) {
+			reached = TRUE;
+		} else {
+			reached = (state->queue_threshold_chunks > 0 &&
+				   state->registered_chunk_count >= state->queue_threshold_chunks) ||
+				  (state->queue_threshold_bytes > 0 &&
+				   state->pending_bytes >= state->queue_threshold_bytes);
+		}
+
+		// No room to register any chunk further.
+		if (state->registered_chunk_count >= state->chunks_per_buffer)
+			reached = TRUE;
+
+		if (!reached)
+			return TRUE;
+		break;
+	}
+	case HINOKO_FW_ISO_CTX_QUEUE_POLICY_INTERRUPT:
+	default:
+		if (!at_interrupt)
+			return TRUE;
+		break;
+	}
+
+	return state->queue_chunks(state, error);
+}
+
+static guint count_headroom(const struct fw_iso_ctx_state *state)
+{
+	guint64 uncompleted = state->registered_total - state->completed_total;
+
+	// The chunks registered but not queued yet are not available for hardware.
+	if (uncompleted <= state->registered_chunk_count)
+		return 0;
+
+	return (guint)MIN(uncompleted - state->registered_chunk_count, state->chunks_per_buffer);
+}
+
+/**
+ * fw_iso_ctx_state_complete_chunks:
+ * @state: A [struct@FwIsoCtxState].
+ * @count: The number of chunks completed by hardware in the interrupt event.
+ *
+ * Account chunks completed by hardware, then update the headroom, the number of chunks queued to
+ * hardware and not completed yet. For IT context it is the number of isochronous cycles for which
+ * packets are already queued, and for IR context it is the number of chunks available to store
+ * packets. The call is expected in the path of interrupt event before the handler of signal
+ * registers chunks further.
+ *
+ * Returns: TRUE if the headroom is less than the threshold, otherwise FALSE.
+ */
+gboolean fw_iso_ctx_state_complete_chunks(struct fw_iso_ctx_state *state, guint count)
+{
+	guint64 uncompleted = state->registered_total - state->completed_total;
+
+	state->completed_total += MIN(count, uncompleted);
+
+	state->headroom = count_headroom(state);
+	if (state->headroom < state->minimum_headroom)
+		state->minimum_headroom = state->headroom;
+
+	return state->headroom < state->headroom_threshold;
+}
+
 #define FW_CDEV_CYCLE_MATCH_SEC_MASK				0x00007000
 #define FW_CDEV_CYCLE_MATCH_SEC_SHIFT				13
 #define FW_CDEV_CYCLE_MATCH_CYCLE_MASK				0x00001fff
@@ -449,6 +997,83 @@ static guint fw_cdev_cycle_match_from_fields(guint sec, guint cycle)
 	       (cycle & FW_CDEV_CYCLE_MATCH_CYCLE_MASK);
 }
 
+/**
+ * fw_iso_ctx_state_prefill:
+ * @state: A [struct@FwIsoCtxState].
+ * @error: A [struct@GLib.Error].
+ *
+ * Queue chunks registered before starting isochronous context to 1394 OHCI hardware.
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ */
+gboolean fw_iso_ctx_state_prefill(struct fw_iso_ctx_state *state, GError **error)
+{
+	if (state->fd < 0) {
+		generate_fw_iso_ctx_error_coded(error, HINOKO_FW_ISO_CTX_ERROR_NOT_ALLOCATED);
+		return FALSE;
+	}
+
+	if (state->addr == NULL) {
+		generate_fw_iso_ctx_error_coded(error, HINOKO_FW_ISO_CTX_ERROR_NOT_MAPPED);
+		return FALSE;
+	}
+
+	// Not prepared.
+	if (state->registered_total == 0) {
+		generate_fw_iso_ctx_error_coded(error, HINOKO_FW_ISO_CTX_ERROR_CHUNK_UNREGISTERED);
+		return FALSE;
+	}
+
+	return fw_iso_ctx_state_queue_chunks(state, error);
+}
+
+/**
+ * fw_iso_ctx_state_start_prefilled:
+ * @state: A [struct@FwIsoCtxState].
+ * @cycle_match: (array fixed-size=2) (element-type guint16) (in) (nullable): The isochronous cycle
+ *		 to start packet processing.
+ * @sync_code: The value of sy field in isochronous packet header for packet processing, up to 15.
+ * @tags: The value of tag field in isochronous header for packet processing.
+ * @error: A [struct@GLib.Error].
+ *
+ * Start isochronous context for which the chunks are already queued by
+ * fw_iso_ctx_state_prefill(). The call is just one system call so that several contexts can be
+ * started back to back.
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ */
+gboolean fw_iso_ctx_state_start_prefilled(struct fw_iso_ctx_state *state,
+					  const guint16 *cycle_match, guint32 sync_code,
+					  HinokoFwIsoCtxMatchFlag tags, GError **error)
+{
+	struct fw_cdev_start_iso arg = {0};
+
+	if (cycle_match == NULL)
+		arg.cycle = -1;
+	else
+		arg.cycle = fw_cdev_cycle_match_from_fields(cycle_match[0], cycle_match[1]);
+
+	arg.sync = sync_code;
+	arg.tags = tags;
+	arg.handle = state->handle;
+	if (!state->offline && ioctl(state->fd, FW_CDEV_IOC_START_ISO, &arg) < 0) {
+		generate_fw_iso_ctx_error_ioctl(error, errno, FW_CDEV_IOC_START_ISO);
+		return FALSE;
+	}
+
+	state->running = TRUE;
+	state->start_cycle = cycle_match == NULL ? -1 :
+			     cycle_match[0] * IEEE1394_CYCLES_PER_SEC + cycle_match[1];
+	state->start_sync_code = sync_code;
+	state->start_tags = tags;
+
+	// The minimum is measured since starting.
+	state->headroom = count_headroom(state);
+	state->minimum_headroom = state->headroom;
+
+	return TRUE;
+}
+
 /**
  * fw_iso_ctx_state_start:
  * @state: A [struct@FwIsoCtxState].
@@ -465,21 +1090,8 @@ static guint fw_cdev_cycle_match_from_fields(guint sec, guint cycle)
 gboolean fw_iso_ctx_state_start(struct fw_iso_ctx_state *state, const guint16 *cycle_match,
 				guint32 sync_code, HinokoFwIsoCtxMatchFlag tags, GError **error)
 {
-	struct fw_cdev_start_iso arg = {0};
-	gint cycle;
-
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
-	if (state->fd < 0) {
-		generate_fw_iso_ctx_error_coded(error, HINOKO_FW_ISO_CTX_ERROR_NOT_ALLOCATED);
-		return FALSE;
-	}
-
-	if (state->addr == NULL) {
-		generate_fw_iso_ctx_error_coded(error, HINOKO_FW_ISO_CTX_ERROR_NOT_MAPPED);
-		return FALSE;
-	}
-
 	if (state->mode == HINOKO_FW_ISO_CTX_MODE_IT) {
 		g_return_val_if_fail(cycle_match == NULL ||
 				cycle_match[0] <= OHCI1394_IT_contextControl_cycleMatch_MAX_SEC ||
@@ -499,31 +1111,45 @@ gboolean fw_iso_ctx_state_start(struct fw_iso_ctx_state *state, const guint16 *c
 					      HINOKO_FW_ISO_CTX_MATCH_FLAG_TAG3), FALSE);
 	}
 
-	if (cycle_match == NULL)
-		cycle = -1;
-	else
-		cycle = fw_cdev_cycle_match_from_fields(cycle_match[0], cycle_match[1]);
-
-	// Not prepared.
-	if (state->data_length == 0) {
-		generate_fw_iso_ctx_error_coded(error, HINOKO_FW_ISO_CTX_ERROR_CHUNK_UNREGISTERED);
+	if (!fw_iso_ctx_state_prefill(state, error))
 		return FALSE;
-	}
 
-	if (!fw_iso_ctx_state_queue_chunks(state, error))
+	return fw_iso_ctx_state_start_prefilled(state, cycle_match, sync_code, tags, error);
+}
+
+/**
+ * fw_iso_ctx_state_start_at:
+ * @state: A [struct@FwIsoCtxState].
+ * @clock_id: The numeric ID of clock source for the deadline, either CLOCK_MONOTONIC(1) or
+ *	      CLOCK_MONOTONIC_RAW(4).
+ * @deadline_ns: The time in nanoseconds of the clock source to start isochronous context.
+ * @sync_code: The value of sy field in isochronous packet header for packet processing, up to 15.
+ * @tags: The value of tag field in isochronous header for packet processing.
+ * @cycle_match: (array fixed-size=2) (out caller-allocates): The isochronous cycle chosen to start.
+ * @error: A [struct@GLib.Error].
+ *
+ * Start isochronous context at the isochronous cycle which begins at the deadline or just after
+ * it. The deadline is converted and validated before queueing the registered chunks, thus the
+ * registered chunks are kept for retry when the deadline is not available. Once the chunks are
+ * queued, the state is recycled at failure to start.
+ */
+gboolean fw_iso_ctx_state_start_at(struct fw_iso_ctx_state *state, gint clock_id,
+				   gint64 deadline_ns, guint32 sync_code,
+				   HinokoFwIsoCtxMatchFlag tags, guint16 cycle_match[2],
+				   GError **error)
+{
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (!fw_iso_ctx_state_cycle_match_from_deadline(state, clock_id, deadline_ns, cycle_match,
+							error))
 		return FALSE;
 
-	arg.sync = sync_code;
-	arg.cycle = cycle;
-	arg.tags = tags;
-	arg.handle = state->handle;
-	if (ioctl(state->fd, FW_CDEV_IOC_START_ISO, &arg) < 0) {
-		generate_fw_iso_ctx_error_ioctl(error, errno, FW_CDEV_IOC_START_ISO);
+	if (!fw_iso_ctx_state_prefill(state, error) ||
+	    !fw_iso_ctx_state_start_prefilled(state, cycle_match, sync_code, tags, error)) {
+		fw_iso_ctx_state_recycle(state);
 		return FALSE;
 	}
 
-	state->running = TRUE;
-
 	return TRUE;
 }
 
@@ -541,10 +1167,15 @@ void fw_iso_ctx_state_stop(struct fw_iso_ctx_state *state)
 		return;
 
 	arg.handle = state->handle;
-	ioctl(state->fd, FW_CDEV_IOC_STOP_ISO, &arg);
+	if (!state->offline)
+		ioctl(state->fd, FW_CDEV_IOC_STOP_ISO, &arg);
 
 	state->running = FALSE;
 	state->registered_chunk_count = 0;
+	state->pending_bytes = 0;
+	state->registered_total = 0;
+	state->completed_total = 0;
+	state->headroom = 0;
 	state->data_length = 0;
 	state->curr_offset = 0;
 }
@@ -597,7 +1228,7 @@ gboolean fw_iso_ctx_state_flush_completions(struct fw_iso_ctx_state *state, GErr
 		.handle = state->handle,
 	};
 
-	if (ioctl(state->fd, FW_CDEV_IOC_FLUSH_ISO, &arg) < 0) {
+	if (!state->offline && ioctl(state->fd, FW_CDEV_IOC_FLUSH_ISO, &arg) < 0) {
 		generate_fw_iso_ctx_error_ioctl(error, errno, FW_CDEV_IOC_FLUSH_ISO);
 		return FALSE;
 	}
@@ -605,6 +1236,47 @@ gboolean fw_iso_ctx_state_flush_completions(struct fw_iso_ctx_state *state, GErr
 	return TRUE;
 }
 
+// The offline context has no hardware, thus the cycle time is simulated so that the isochronous
+// cycle begins at every 125 microseconds of FW_ISO_CTX_OFFLINE_CLOCK_ID, as the simulated clock
+// of loopback. The given clock is just for the reference timestamp, like Linux FireWire subsystem.
+static gboolean read_offline_cycle_time(gint clock_id, HinawaCycleTime *cycle_time,
+					GError **error)
+{
+	struct fw_cdev_get_cycle_timer2 *arg = (struct fw_cdev_get_cycle_timer2 *)cycle_time;
+	struct timespec base;
+	struct timespec ts;
+	gint64 nsec;
+	guint64 cycles;
+	guint offset;
+
+	if (clock_gettime(FW_ISO_CTX_OFFLINE_CLOCK_ID, &base) < 0) {
+		generate_syscall_error(error, errno, "clock_gettime(%d)",
+				       FW_ISO_CTX_OFFLINE_CLOCK_ID);
+		return FALSE;
+	}
+
+	if (clock_id == FW_ISO_CTX_OFFLINE_CLOCK_ID) {
+		ts = base;
+	} else if (clock_gettime(clock_id, &ts) < 0) {
+		generate_syscall_error(error, errno, "clock_gettime(%d)", clock_id);
+		return FALSE;
+	}
+
+	nsec = base.tv_sec * G_GINT64_CONSTANT(1000000000) + base.tv_nsec;
+	cycles = (nsec / IEEE1394_NSEC_PER_CYCLE) % IEEE1394_CYCLES_PER_ROUND;
+	offset = (nsec % IEEE1394_NSEC_PER_CYCLE) * OHCI1394_CYCLE_TIME_TICKS_PER_CYCLE /
+		 IEEE1394_NSEC_PER_CYCLE;
+
+	// The layout of cycle time register: 7 bits for second, 13 bits for cycle, and 12 bits for
+	// offset.
+	arg->tv_sec = ts.tv_sec;
+	arg->tv_nsec = ts.tv_nsec;
+	arg->cycle_timer = ((cycles / IEEE1394_CYCLES_PER_SEC) << 25) |
+			   ((cycles % IEEE1394_CYCLES_PER_SEC) << 12) | offset;
+
+	return TRUE;
+}
+
 /**
  * fw_iso_ctx_state_read_cycle_time:
  * @state: A [struct@FwIsoCtxState].
@@ -630,6 +1302,9 @@ gboolean fw_iso_ctx_state_read_cycle_time(struct fw_iso_ctx_state *state, gint c
 	}
 
 	(*cycle_time)->clk_id = clock_id;
+	if (state->offline)
+		return read_offline_cycle_time(clock_id, *cycle_time, error);
+
 	if (ioctl(state->fd, FW_CDEV_IOC_GET_CYCLE_TIMER2, *cycle_time) < 0) {
 		generate_fw_iso_ctx_error_ioctl(error, errno, FW_CDEV_IOC_GET_CYCLE_TIMER2);
 		return FALSE;
@@ -638,6 +1313,69 @@ gboolean fw_iso_ctx_state_read_cycle_time(struct fw_iso_ctx_state *state, gint c
 	return TRUE;
 }
 
+/**
+ * fw_iso_ctx_state_cycle_match_from_deadline:
+ * @state: A [struct@FwIsoCtxState].
+ * @clock_id: The numeric ID of clock source for the deadline, either CLOCK_MONOTONIC(1) or
+ *	      CLOCK_MONOTONIC_RAW(4).
+ * @deadline_ns: The time in nanoseconds of the clock source to start isochronous context.
+ * @cycle_match: (array fixed-size=2) (out caller-allocates): The isochronous cycle which begins at
+ *		 the deadline or just after it.
+ * @error: A [struct@GLib.Error].
+ *
+ * Convert the deadline to the isochronous cycle by the pair of cycle time and system time sampled
+ * at once. The isochronous cycle should be within the window of cycle match from the current one.
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ */
+gboolean fw_iso_ctx_state_cycle_match_from_deadline(struct fw_iso_ctx_state *state, gint clock_id,
+						    gint64 deadline_ns, guint16 cycle_match[2],
+						    GError **error)
+{
+	HinawaCycleTime cycle_time = {0};
+	HinawaCycleTime *ptr = &cycle_time;
+	guint16 fields[3];
+	gint64 sec;
+	gint32 nsec;
+	gint64 now_ns;
+	gint64 distance_ns;
+	gint64 delay_cycles;
+	guint cycles;
+
+	g_return_val_if_fail(clock_id == CLOCK_MONOTONIC || clock_id == CLOCK_MONOTONIC_RAW, FALSE);
+
+	if (!fw_iso_ctx_state_read_cycle_time(state, clock_id, &ptr, error))
+		return FALSE;
+
+	hinawa_cycle_time_get_fields(&cycle_time, fields);
+	hinawa_cycle_time_get_system_time(&cycle_time, &sec, &nsec);
+	now_ns = sec * G_GINT64_CONSTANT(1000000000) + nsec;
+
+	if (deadline_ns <= now_ns) {
+		g_set_error(error, HINOKO_FW_ISO_CTX_ERROR, HINOKO_FW_ISO_CTX_ERROR_OUT_OF_WINDOW,
+			    "The deadline already passed by %" G_GINT64_FORMAT " nsec",
+			    now_ns - deadline_ns);
+		return FALSE;
+	}
+
+	// The distance from the beginning of current isochronous cycle to the deadline.
+	distance_ns = deadline_ns - now_ns +
+		      fields[2] * IEEE1394_NSEC_PER_CYCLE / OHCI1394_CYCLE_TIME_TICKS_PER_CYCLE;
+	delay_cycles = (distance_ns + IEEE1394_NSEC_PER_CYCLE - 1) / IEEE1394_NSEC_PER_CYCLE;
+
+	if (delay_cycles >= OHCI1394_cycleMatch_CYCLES_PER_WINDOW) {
+		g_set_error(error, HINOKO_FW_ISO_CTX_ERROR, HINOKO_FW_ISO_CTX_ERROR_OUT_OF_WINDOW,
+			    "The deadline is %" G_GINT64_FORMAT " cycles ahead, beyond the window "
+			    "of %d cycles", delay_cycles, OHCI1394_cycleMatch_CYCLES_PER_WINDOW);
+		return FALSE;
+	}
+
+	cycles = fields[0] * IEEE1394_CYCLES_PER_SEC + fields[1] + (guint)delay_cycles;
+	ohci1394_cycle_match_from_cycles(cycles % IEEE1394_CYCLES_PER_ROUND, cycle_match);
+
+	return TRUE;
+}
+
 static gboolean check_src(GSource *source)
 {
 	FwIsoCtxSource *src = (FwIsoCtxSource *)source;
@@ -654,6 +1392,8 @@ static gboolean dispatch_src(GSource *source, GSourceFunc cb, gpointer user_data
 	FwIsoCtxSource *src = (FwIsoCtxSource *)source;
 	GIOCondition condition;
 	GError *error = NULL;
+	void *buf;
+	unsigned int buf_length;
 	int len;
 	const union fw_cdev_event *event;
 
@@ -661,7 +1401,17 @@ static gboolean dispatch_src(GSource *source, GSourceFunc cb, gpointer user_data
 	if (condition & G_IO_ERR)
 		return G_SOURCE_REMOVE;
 
-	len = read(src->fd, src->buf, src->len);
+	// The buffer in the arena of context is used as long as the context is mapped.
+	buf = src->state->event_buf;
+	buf_length = src->state->event_buf_length;
+	if (buf == NULL) {
+		if (src->buf == NULL)
+			src->buf = g_malloc0(src->len);
+		buf = src->buf;
+		buf_length = src->len;
+	}
+
+	len = read(src->fd, buf, buf_length);
 	if (len < 0) {
 		if (errno != EAGAIN) {
 			generate_file_error(&error, g_file_error_from_errno(errno),
@@ -672,18 +1422,53 @@ static gboolean dispatch_src(GSource *source, GSourceFunc cb, gpointer user_data
 		return G_SOURCE_CONTINUE;
 	}
 
-	event = (const union fw_cdev_event *)src->buf;
-	if (!src->handle_event(src->self, event, &error))
-		goto error;
+	event = (const union fw_cdev_event *)buf;
+	if (!fw_iso_ctx_state_dispatch_event(src->state, src->self, src->handle_event, event, len))
+		return G_SOURCE_REMOVE;
 
 	// Just be sure to continue to process this source.
 	return G_SOURCE_CONTINUE;
 error:
+	// The error is delivered to the handler of stopped signal.
+	src->state->stop_error = error;
 	hinoko_fw_iso_ctx_stop(src->self);
+	src->state->stop_error = NULL;
 	g_clear_error(&error);
 	return G_SOURCE_REMOVE;
 }
 
+/**
+ * fw_iso_ctx_state_dispatch_event:
+ * @state: A [struct@FwIsoCtxState].
+ * @inst: The instance of context.
+ * @handle_event: The handler of event for the context.
+ * @event: The event to handle.
+ * @length: The number of bytes in @event.
+ *
+ * Pass the event to the hook for trace if any, then handle it. When the handler fails, the context
+ * is stopped and the error is delivered to the handler of stopped signal.
+ *
+ * Returns: TRUE if the event is handled successfully, otherwise FALSE.
+ */
+gboolean fw_iso_ctx_state_dispatch_event(struct fw_iso_ctx_state *state, HinokoFwIsoCtx *inst,
+					 fw_iso_ctx_handle_event_t handle_event,
+					 const union fw_cdev_event *event, guint length)
+{
+	GError *error = NULL;
+
+	if (state->trace_event != NULL)
+		state->trace_event(state, event, length, state->trace_data);
+
+	if (handle_event(inst, event, &error))
+		return TRUE;
+
+	state->stop_error = error;
+	hinoko_fw_iso_ctx_stop(inst);
+	state->stop_error = NULL;
+	g_clear_error(&error);
+	return FALSE;
+}
+
 static void finalize_src(GSource *source)
 {
 	FwIsoCtxSource *src = (FwIsoCtxSource *)source;
@@ -704,10 +1489,8 @@ static void finalize_src(GSource *source)
  * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
  */
 gboolean fw_iso_ctx_state_create_source(struct fw_iso_ctx_state *state, HinokoFwIsoCtx *inst,
-					gboolean (*handle_event)(HinokoFwIsoCtx *inst,
-								 const union fw_cdev_event *event,
-								 GError **error),
-					GSource **source, GError **error)
+					fw_iso_ctx_handle_event_t handle_event, GSource **source,
+					GError **error)
 {
 	static GSourceFuncs funcs = {
 		.check		= check_src,
@@ -731,22 +1514,192 @@ gboolean fw_iso_ctx_state_create_source(struct fw_iso_ctx_state *state, HinokoFw
 
 	src = (FwIsoCtxSource *)(*source);
 
-	if (state->mode != HINOKO_FW_ISO_CTX_MODE_IR_MULTIPLE) {
-		// MEMO: Linux FireWire subsystem queues isochronous event
-		// independently of interrupt flag when the same number of
-		// bytes as one page is stored in the buffer of header. To
-		// avoid truncated read, keep enough size.
-		src->len = sizeof(struct fw_cdev_event_iso_interrupt) +
-			   sysconf(_SC_PAGESIZE);
-	} else {
-		src->len = sizeof(struct fw_cdev_event_iso_interrupt_mc);
-	}
-	src->buf = g_malloc0(src->len);
+	src->len = event_buf_length(state->mode);
+	src->buf = NULL;
 
 	src->tag = g_source_add_unix_fd(*source, state->fd, G_IO_IN);
 	src->fd = state->fd;
+	src->state = state;
 	src->self = g_object_ref(inst);
 	src->handle_event = handle_event;
 
 	return TRUE;
 }
+
+struct fw_iso_ctx_state *fw_iso_ctx_get_state(HinokoFwIsoCtx *inst,
+					      fw_iso_ctx_handle_event_t *handle_event)
+{
+	if (HINOKO_IS_FW_ISO_IT(inst)) {
+		*handle_event = fw_iso_it_handle_event;
+		return fw_iso_it_get_state(HINOKO_FW_ISO_IT(inst));
+	} else if (HINOKO_IS_FW_ISO_IR_SINGLE(inst)) {
+		*handle_event = fw_iso_ir_single_handle_event;
+		return fw_iso_ir_single_get_state(HINOKO_FW_ISO_IR_SINGLE(inst));
+	} else {
+		*handle_event = fw_iso_ir_multiple_handle_event;
+		return fw_iso_ir_multiple_get_state(HINOKO_FW_ISO_IR_MULTIPLE(inst));
+	}
+}
+
+void fw_iso_ir_loss_detector_reset(struct fw_iso_ir_loss_detector *detector)
+{
+	int i;
+
+	memset(detector, 0, sizeof(*detector));
+	for (i = 0; i < G_N_ELEMENTS(detector->prev_cycles); ++i)
+		detector->prev_cycles[i] = -1;
+}
+
+static void classify_cycles(struct fw_iso_ir_loss_detector *detector, guint channel,
+			    const gint32 *cycles, guint count, fw_iso_ir_loss_report_t report,
+			    gpointer user_data)
+{
+	gint32 prev = detector->prev_cycles[channel];
+	guint i;
+
+	for (i = 0; i < count; ++i) {
+		gint32 cycle = cycles[i];
+
+		if (prev >= 0) {
+			gint32 distance = cycle - prev;
+
+			if (distance < 0)
+				distance += OHCI1394_ISOC_DESC_tstamp_CYCLES_PER_ROUND;
+
+			if (distance == 0) {
+				++detector->duplicated[channel];
+				continue;
+			} else if (distance >= OHCI1394_ISOC_DESC_tstamp_CYCLES_PER_ROUND / 2) {
+				// The packet arrives later than the one for newer cycle.
+				++detector->reordered[channel];
+				continue;
+			} else if (distance > 1) {
+				detector->lost[channel] += distance - 1;
+				report(user_data, channel, cycle, distance - 1);
+			}
+		}
+
+		prev = cycle;
+	}
+
+	detector->prev_cycles[channel] = prev;
+}
+
+/**
+ * fw_iso_ir_loss_detector_feed:
+ * @detector: A [struct@FwIsoIrLossDetector].
+ * @channel: The isochronous channel of packets.
+ * @cycles: (array length=count): The cycles of packets computed from timestamp.
+ * @count: The number of cycles, up to FW_ISO_IR_LOSS_DETECTOR_BLOCK.
+ * @report: The function called for each gap of cycles.
+ * @user_data: The data passed to @report.
+ *
+ * Detect gap, duplication, and reordering of cycles for packets in the channel. It is assumed
+ * that the channel conveys one packet per isochronous cycle.
+ */
+void fw_iso_ir_loss_detector_feed(struct fw_iso_ir_loss_detector *detector, guint channel,
+				  const gint32 *cycles, guint count, fw_iso_ir_loss_report_t report,
+				  gpointer user_data)
+{
+	gint32 prevs[FW_ISO_IR_LOSS_DETECTOR_BLOCK];
+	gboolean anomaly;
+	guint i;
+
+	g_return_if_fail(channel <= IEEE1394_MAX_CHANNEL);
+	g_return_if_fail(count <= FW_ISO_IR_LOSS_DETECTOR_BLOCK);
+
+	if (count == 0)
+		return;
+
+	if (detector->prev_cycles[channel] < 0) {
+		classify_cycles(detector, channel, cycles, count, report, user_data);
+		return;
+	}
+
+	prevs[0] = detector->prev_cycles[channel];
+	memcpy(prevs + 1, cycles, (count - 1) * sizeof(*cycles));
+
+	// The pass without branch so that compiler can vectorize it. The packets are classified
+	// one by one only when any distance is not one cycle.
+	anomaly = FALSE;
+	for (i = 0; i < count; ++i) {
+		gint32 distance = cycles[i] - prevs[i];
+
+		anomaly |= (distance != 1) &
+			   (distance != 1 - OHCI1394_ISOC_DESC_tstamp_CYCLES_PER_ROUND);
+	}
+
+	if (anomaly)
+		classify_cycles(detector, channel, cycles, count, report, user_data);
+	else
+		detector->prev_cycles[channel] = cycles[count - 1];
+}
+
+void fw_iso_ir_loss_detector_get_counters(const struct fw_iso_ir_loss_detector *detector,
+					  guint channel, guint *lost, guint *duplicated,
+					  guint *reordered)
+{
+	g_return_if_fail(channel <= IEEE1394_MAX_CHANNEL);
+
+	*lost = detector->lost[channel];
+	*duplicated = detector->duplicated[channel];
+	*reordered = detector->reordered[channel];
+}
+
+/**
+ * fw_iso_ir_clock_sample:
+ * @clock: A [struct@FwIsoIrClock].
+ * @state: A [struct@FwIsoCtxState].
+ * @error: A [struct@GLib.Error].
+ *
+ * Sample the pair of cycle time and system time in CLOCK_MONOTONIC at once as the reference to
+ * convert timestamps of isochronous descriptor.
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ */
+gboolean fw_iso_ir_clock_sample(struct fw_iso_ir_clock *clock, struct fw_iso_ctx_state *state,
+				GError **error)
+{
+	HinawaCycleTime cycle_time = {0};
+	HinawaCycleTime *ptr = &cycle_time;
+	guint16 fields[3];
+	gint64 sec;
+	gint32 nsec;
+
+	if (!fw_iso_ctx_state_read_cycle_time(state, CLOCK_MONOTONIC, &ptr, error))
+		return FALSE;
+
+	hinawa_cycle_time_get_fields(&cycle_time, fields);
+	hinawa_cycle_time_get_system_time(&cycle_time, &sec, &nsec);
+
+	// The timestamp of isochronous descriptor has the lower three bits of second field.
+	clock->cycles = (fields[0] % 8) * IEEE1394_CYCLES_PER_SEC + fields[1];
+	clock->nsec = sec * G_GINT64_CONSTANT(1000000000) + nsec -
+		      fields[2] * IEEE1394_NSEC_PER_CYCLE / OHCI1394_CYCLE_TIME_TICKS_PER_CYCLE;
+
+	return TRUE;
+}
+
+/**
+ * fw_iso_ir_clock_convert:
+ * @clock: A [struct@FwIsoIrClock].
+ * @cycles: (array length=count): The cycles converted from timestamps of isochronous descriptor.
+ * @nsec: (array length=count) (out caller-allocates): The system time in nanoseconds at the
+ *	  beginning of each isochronous cycle.
+ * @count: The number of elements in both arrays.
+ *
+ * Convert the cycles of received packets to system time in batch. Each packet is assumed to be
+ * received within 8 seconds before the reference is sampled.
+ */
+void fw_iso_ir_clock_convert(const struct fw_iso_ir_clock *clock, const gint32 *cycles,
+			     gint64 *nsec, guint count)
+{
+	guint i;
+
+	for (i = 0; i < count; ++i) {
+		gint32 distance = clock->cycles - cycles[i];
+
+		distance += OHCI1394_ISOC_DESC_tstamp_CYCLES_PER_ROUND & -(distance < 0);
+		nsec[i] = clock->nsec - distance * IEEE1394_NSEC_PER_CYCLE;
+	}
+}
@@ -28,17 +28,83 @@ static inline void generate_fw_iso_ctx_error_coded(GError **error, HinokoFwIsoCt
 	g_set_error(error, HINOKO_FW_ISO_CTX_ERROR, HINOKO_FW_ISO_CTX_ERROR_FAILED,	\
 		    "ioctl(" #request ") %d (%s)", errno, strerror(errno))
 
+gboolean fw_iso_ctx_debug_enabled(void);
+
+// GLib formats the message of g_debug() in heap even if it is dropped at last, thus check in
+// advance to avoid allocation in the path of interrupt event.
+#define fw_iso_ctx_debug(...)					\
+	G_STMT_START {						\
+		if (G_UNLIKELY(fw_iso_ctx_debug_enabled()))	\
+			g_debug(__VA_ARGS__);			\
+	} G_STMT_END
+
 #define IEEE1394_MAX_CHANNEL			63
 #define IEEE1394_MAX_SYNC_CODE			15
 #define IEEE1394_ISO_HEADER_DATA_LENGTH_MASK	0xffff0000
 #define IEEE1394_ISO_HEADER_DATA_LENGTH_SHIFT	16
 
+#define IEEE1394_ISO_HEADER_CHANNEL_MASK	0x00003f00
+#define IEEE1394_ISO_HEADER_CHANNEL_SHIFT	8
+
+#define IEEE1394_ISO_HEADER_TAG_MASK		0x0000c000
+#define IEEE1394_ISO_HEADER_TAG_SHIFT		14
+
+#define IEEE1394_ISO_HEADER_SY_MASK		0x0000000f
+#define IEEE1394_ISO_HEADER_SY_SHIFT		0
+
 static inline guint ieee1394_iso_header_to_data_length(guint iso_header)
 {
 	return (iso_header & IEEE1394_ISO_HEADER_DATA_LENGTH_MASK) >>
 		IEEE1394_ISO_HEADER_DATA_LENGTH_SHIFT;
 }
 
+static inline guint ieee1394_iso_header_to_channel(guint iso_header)
+{
+	return (iso_header & IEEE1394_ISO_HEADER_CHANNEL_MASK) >>
+		IEEE1394_ISO_HEADER_CHANNEL_SHIFT;
+}
+
+static inline guint ieee1394_iso_header_to_tag(guint iso_header)
+{
+	return (iso_header & IEEE1394_ISO_HEADER_TAG_MASK) >> IEEE1394_ISO_HEADER_TAG_SHIFT;
+}
+
+static inline guint ieee1394_iso_header_to_sync_code(guint iso_header)
+{
+	return (iso_header & IEEE1394_ISO_HEADER_SY_MASK) >> IEEE1394_ISO_HEADER_SY_SHIFT;
+}
+
+#define FW_CDEV_ISO_PACKET_CONTROL_HEADER_LENGTH_MASK	0xff000000
+#define FW_CDEV_ISO_PACKET_CONTROL_HEADER_LENGTH_SHIFT	24
+#define FW_CDEV_ISO_PACKET_CONTROL_SY_MASK		0x00f00000
+#define FW_CDEV_ISO_PACKET_CONTROL_SY_SHIFT		20
+#define FW_CDEV_ISO_PACKET_CONTROL_TAG_MASK		0x000c0000
+#define FW_CDEV_ISO_PACKET_CONTROL_TAG_SHIFT		18
+#define FW_CDEV_ISO_PACKET_CONTROL_PAYLOAD_MASK		0x0000ffff
+
+static inline guint fw_cdev_iso_packet_control_to_header_length(guint control)
+{
+	return (control & FW_CDEV_ISO_PACKET_CONTROL_HEADER_LENGTH_MASK) >>
+		FW_CDEV_ISO_PACKET_CONTROL_HEADER_LENGTH_SHIFT;
+}
+
+static inline guint fw_cdev_iso_packet_control_to_tag(guint control)
+{
+	return (control & FW_CDEV_ISO_PACKET_CONTROL_TAG_MASK) >>
+		FW_CDEV_ISO_PACKET_CONTROL_TAG_SHIFT;
+}
+
+static inline guint fw_cdev_iso_packet_control_to_sync_code(guint control)
+{
+	return (control & FW_CDEV_ISO_PACKET_CONTROL_SY_MASK) >>
+		FW_CDEV_ISO_PACKET_CONTROL_SY_SHIFT;
+}
+
+static inline guint fw_cdev_iso_packet_control_to_payload_length(guint control)
+{
+	return (control & FW_CDEV_ISO_PACKET_CONTROL_PAYLOAD_MASK);
+}
+
 #define OHCI1394_ISOC_DESC_timeStamp_SEC_MASK		0x0000e000
 #define OHCI1394_ISOC_DESC_timeStamp_SEC_SHIFT		13
 #define OHCI1394_ISOC_DESC_timeStmap_CYCLE_MASK		0x00001fff
@@ -60,41 +126,166 @@ static inline guint ohci1394_isoc_desc_tstamp_to_cycle(guint32 tstamp)
 #define OHCI1394_IT_contextControl_cycleMatch_MAX_SEC		3
 #define OHCI1394_IT_contextControl_cycleMatch_MAX_CYCLE		7999
 
+#define IEEE1394_CYCLE_TIME_MAX_SEC		127
+#define IEEE1394_CYCLES_PER_SEC			8000
+#define IEEE1394_CYCLES_PER_ROUND		\
+	((IEEE1394_CYCLE_TIME_MAX_SEC + 1) * IEEE1394_CYCLES_PER_SEC)
+
+// The cycle match of 1394 OHCI hardware has the lower two bits of second, thus any isochronous
+// cycle to start context should be within the window from current cycle.
+#define OHCI1394_cycleMatch_CYCLES_PER_WINDOW	\
+	((OHCI1394_IT_contextControl_cycleMatch_MAX_SEC + 1) * IEEE1394_CYCLES_PER_SEC)
+
+static inline void ohci1394_cycle_match_from_cycles(guint cycles, guint16 cycle_match[2])
+{
+	cycle_match[0] = (cycles / IEEE1394_CYCLES_PER_SEC) %
+			 (OHCI1394_IT_contextControl_cycleMatch_MAX_SEC + 1);
+	cycle_match[1] = cycles % IEEE1394_CYCLES_PER_SEC;
+}
+
+// The timestamp of isochronous descriptor has the lower three bits of second.
+#define OHCI1394_ISOC_DESC_tstamp_CYCLES_PER_ROUND	(8 * IEEE1394_CYCLES_PER_SEC)
+
+static inline gint32 ohci1394_isoc_desc_tstamp_to_cycles(guint32 tstamp)
+{
+	return ohci1394_isoc_desc_tstamp_to_sec(tstamp) * IEEE1394_CYCLES_PER_SEC +
+	       ohci1394_isoc_desc_tstamp_to_cycle(tstamp);
+}
+
+#define OHCI1394_CYCLE_TIME_TICKS_PER_CYCLE	3072
+#define IEEE1394_NSEC_PER_CYCLE			\
+	(G_GINT64_CONSTANT(1000000000) / IEEE1394_CYCLES_PER_SEC)
+
+#define CACHELINE_SIZE		64
+#define CACHELINE_ALIGN(size)	(((size) + CACHELINE_SIZE - 1) & ~((gsize)CACHELINE_SIZE - 1))
+
+// The single block of memory for every array accessed in hot path of isochronous context. It is
+// sized at mapping intermediate buffer and the content is laid out as below, each part aligned to
+// cacheline:
+//  - the buffer to read event from Linux FireWire subsystem.
+//  - the array of packet descriptors.
+//  - the private area for the class implementing the context.
+struct fw_iso_ctx_arena {
+	guint8 *ptr;
+	gsize size;
+	gboolean anonymous_map;
+	gboolean locked;
+};
+
+struct fw_iso_ctx_state;
+
+typedef void (*fw_iso_ctx_trace_event_t)(const struct fw_iso_ctx_state *state,
+					 const union fw_cdev_event *event, guint length,
+					 gpointer user_data);
+
+typedef void (*fw_iso_ctx_queue_offline_t)(struct fw_iso_ctx_state *state, const guint8 *packets,
+					   guint size, guint buf_offset, gpointer user_data);
+
+// The clock source to simulate the cycle time register of offline context.
+#define FW_ISO_CTX_OFFLINE_CLOCK_ID	CLOCK_MONOTONIC
+
 struct fw_iso_ctx_state {
 	int fd;
 	guint handle;
 
+	// The context is not backed by Linux FireWire subsystem. The file descriptor is for
+	// eventfd, the buffer is anonymous memory, and the requests to hardware are omitted.
+	gboolean offline;
+
 	HinokoFwIsoCtxMode mode;
 	guint header_size;
 	guchar *addr;
 	guint bytes_per_chunk;
 	guint chunks_per_buffer;
 
+	HinokoFwIsoCtxMapFlag map_flags;
+	HinokoFwIsoCtxMapFlag applied_map_flags;
+
+	struct fw_iso_ctx_arena arena;
+	guint8 *event_buf;
+	guint event_buf_length;
+	guint8 *private_area;
+
 	// The number of entries equals to the value of chunks_per_buffer.
 	guint8 *data;
 	guint data_length;
 	guint alloc_data_length;
 	guint registered_chunk_count;
+	guint pending_bytes;
+
+	// The total number of chunks registered and completed since the context is stopped.
+	guint64 registered_total;
+	guint64 completed_total;
+
+	// Specialized for the mode of context at mapping buffer.
+	gboolean (*queue_chunks)(struct fw_iso_ctx_state *state, GError **error);
+
+	HinokoFwIsoCtxQueuePolicy queue_policy;
+	guint queue_threshold_chunks;
+	guint queue_threshold_bytes;
+
+	// The number of chunks queued to hardware and not completed yet, updated at every event.
+	guint headroom;
+	guint minimum_headroom;
+	guint headroom_threshold;
 
 	guint curr_offset;
 	gboolean running;
+
+	// The cause of stopping the context in the path of interrupt event, if any.
+	const GError *stop_error;
+
+	// The hook to record the event read from Linux FireWire subsystem before handling it.
+	fw_iso_ctx_trace_event_t trace_event;
+	gpointer trace_data;
+
+	// The hook to receive the chunks queued to the offline context instead of hardware.
+	fw_iso_ctx_queue_offline_t queue_offline;
+	gpointer queue_offline_data;
+
+	// The conditions to start the context. The cycle is -1 when it is not given.
+	gint start_cycle;
+	guint32 start_sync_code;
+	HinokoFwIsoCtxMatchFlag start_tags;
 };
 
 enum fw_iso_ctx_prop_type {
 	FW_ISO_CTX_PROP_TYPE_BYTES_PER_CHUNK = 1,
 	FW_ISO_CTX_PROP_TYPE_CHUNKS_PER_BUFFER,
+	FW_ISO_CTX_PROP_TYPE_MAP_FLAGS,
+	FW_ISO_CTX_PROP_TYPE_RESIDENT_BYTES,
+	FW_ISO_CTX_PROP_TYPE_QUEUE_POLICY,
+	FW_ISO_CTX_PROP_TYPE_QUEUE_THRESHOLD_CHUNKS,
+	FW_ISO_CTX_PROP_TYPE_QUEUE_THRESHOLD_BYTES,
+	FW_ISO_CTX_PROP_TYPE_HEADROOM,
+	FW_ISO_CTX_PROP_TYPE_MINIMUM_HEADROOM,
+	FW_ISO_CTX_PROP_TYPE_HEADROOM_THRESHOLD,
 	FW_ISO_CTX_PROP_TYPE_COUNT,
 };
 
 #define BYTES_PER_CHUNK_PROP_NAME		"bytes-per-chunk"
 #define CHUNKS_PER_BUFFER_PROP_NAME		"chunks-per-buffer"
+#define MAP_FLAGS_PROP_NAME			"map-flags"
+#define RESIDENT_BYTES_PROP_NAME		"resident-bytes"
+#define QUEUE_POLICY_PROP_NAME			"queue-policy"
+#define QUEUE_THRESHOLD_CHUNKS_PROP_NAME	"queue-threshold-chunks"
+#define QUEUE_THRESHOLD_BYTES_PROP_NAME		"queue-threshold-bytes"
+#define HEADROOM_PROP_NAME			"headroom"
+#define MINIMUM_HEADROOM_PROP_NAME		"minimum-headroom"
+#define HEADROOM_THRESHOLD_PROP_NAME		"headroom-threshold"
 
 #define STOPPED_SIGNAL_NAME			"stopped"
+#define LOW_HEADROOM_SIGNAL_NAME		"low-headroom"
 
 void fw_iso_ctx_class_override_properties(GObjectClass *gobject_class);
 
+guint fw_iso_ctx_class_lookup_low_headroom(void);
+
 void fw_iso_ctx_state_get_property(const struct fw_iso_ctx_state *state, GObject *obj, guint id,
 				   GValue *val, GParamSpec *spec);
+void fw_iso_ctx_state_set_property(struct fw_iso_ctx_state *state, GObject *obj, guint id,
+				   const GValue *val, GParamSpec *spec);
+guint64 fw_iso_ctx_state_resident_bytes(const struct fw_iso_ctx_state *state);
 
 void fw_iso_ctx_state_init(struct fw_iso_ctx_state *state);
 
@@ -104,8 +295,9 @@ gboolean fw_iso_ctx_state_allocate(struct fw_iso_ctx_state *state, const char *p
 void fw_iso_ctx_state_release(struct fw_iso_ctx_state *state);
 
 gboolean fw_iso_ctx_state_map_buffer(struct fw_iso_ctx_state *state, guint bytes_per_chunk,
-				     guint chunks_per_buffer, GError **error);
+				     guint chunks_per_buffer, gsize private_size, GError **error);
 void fw_iso_ctx_state_unmap_buffer(struct fw_iso_ctx_state *state);
+gboolean fw_iso_ctx_state_recycle(struct fw_iso_ctx_state *state);
 
 gboolean fw_iso_ctx_state_register_chunk(struct fw_iso_ctx_state *state, gboolean skip,
 					 HinokoFwIsoCtxMatchFlag tags, guint sync_code,
@@ -114,8 +306,30 @@ gboolean fw_iso_ctx_state_register_chunk(struct fw_iso_ctx_state *state, gboolea
 					 GError **error);
 gboolean fw_iso_ctx_state_queue_chunks(struct fw_iso_ctx_state *state, GError **error);
 
+// Unchecked variants specialized for the mode of context. The caller should validate arguments and
+// the room for the chunk in advance.
+void fw_iso_ctx_state_register_chunk_it(struct fw_iso_ctx_state *state, gboolean skip,
+					HinokoFwIsoCtxMatchFlag tags, guint sync_code,
+					const guint8 *header, guint header_length,
+					guint payload_length, gboolean schedule_interrupt);
+void fw_iso_ctx_state_register_chunk_ir_single(struct fw_iso_ctx_state *state,
+					       gboolean schedule_interrupt);
+void fw_iso_ctx_state_register_chunk_ir_multiple(struct fw_iso_ctx_state *state,
+						 gboolean schedule_interrupt);
+gboolean fw_iso_ctx_state_queue_chunks_by_policy(struct fw_iso_ctx_state *state,
+						 gboolean at_interrupt, GError **error);
+gboolean fw_iso_ctx_state_complete_chunks(struct fw_iso_ctx_state *state, guint count);
+
 gboolean fw_iso_ctx_state_start(struct fw_iso_ctx_state *state, const guint16 *cycle_match,
 				guint32 sync_code, HinokoFwIsoCtxMatchFlag tags, GError **error);
+gboolean fw_iso_ctx_state_prefill(struct fw_iso_ctx_state *state, GError **error);
+gboolean fw_iso_ctx_state_start_prefilled(struct fw_iso_ctx_state *state,
+					  const guint16 *cycle_match, guint32 sync_code,
+					  HinokoFwIsoCtxMatchFlag tags, GError **error);
+gboolean fw_iso_ctx_state_start_at(struct fw_iso_ctx_state *state, gint clock_id,
+				   gint64 deadline_ns, guint32 sync_code,
+				   HinokoFwIsoCtxMatchFlag tags, guint16 cycle_match[2],
+				   GError **error);
 void fw_iso_ctx_state_stop(struct fw_iso_ctx_state *state);
 
 void fw_iso_ctx_state_read_frame(struct fw_iso_ctx_state *state, guint offset, guint length,
@@ -125,11 +339,78 @@ gboolean fw_iso_ctx_state_flush_completions(struct fw_iso_ctx_state *state, GErr
 
 gboolean fw_iso_ctx_state_read_cycle_time(struct fw_iso_ctx_state *state, gint clock_id,
 					  HinawaCycleTime **cycle_time, GError **error);
+gboolean fw_iso_ctx_state_cycle_match_from_deadline(struct fw_iso_ctx_state *state, gint clock_id,
+						    gint64 deadline_ns, guint16 cycle_match[2],
+						    GError **error);
+
+typedef gboolean (*fw_iso_ctx_handle_event_t)(HinokoFwIsoCtx *inst,
+					      const union fw_cdev_event *event, GError **error);
 
 gboolean fw_iso_ctx_state_create_source(struct fw_iso_ctx_state *state, HinokoFwIsoCtx *inst,
-					gboolean (*handle_event)(HinokoFwIsoCtx *inst,
-								 const union fw_cdev_event *event,
-								 GError **error),
-					GSource **source, GError **error);
+					fw_iso_ctx_handle_event_t handle_event, GSource **source,
+					GError **error);
+gboolean fw_iso_ctx_state_dispatch_event(struct fw_iso_ctx_state *state, HinokoFwIsoCtx *inst,
+					 fw_iso_ctx_handle_event_t handle_event,
+					 const union fw_cdev_event *event, guint length);
+
+// For detection of packet loss in IR contexts. The cycles are in the range of timestamp of
+// isochronous descriptor.
+#define FW_ISO_IR_LOSS_DETECTOR_BLOCK	64
+
+struct fw_iso_ir_loss_detector {
+	gint32 prev_cycles[IEEE1394_MAX_CHANNEL + 1];
+	guint lost[IEEE1394_MAX_CHANNEL + 1];
+	guint duplicated[IEEE1394_MAX_CHANNEL + 1];
+	guint reordered[IEEE1394_MAX_CHANNEL + 1];
+};
+
+typedef void (*fw_iso_ir_loss_report_t)(gpointer user_data, guint channel, guint cycles,
+					guint count);
+
+void fw_iso_ir_loss_detector_reset(struct fw_iso_ir_loss_detector *detector);
+void fw_iso_ir_loss_detector_feed(struct fw_iso_ir_loss_detector *detector, guint channel,
+				  const gint32 *cycles, guint count, fw_iso_ir_loss_report_t report,
+				  gpointer user_data);
+void fw_iso_ir_loss_detector_get_counters(const struct fw_iso_ir_loss_detector *detector,
+					  guint channel, guint *lost, guint *duplicated,
+					  guint *reordered);
+
+// For conversion of timestamp in isochronous descriptor to system time, with the pair of cycle time
+// and system time sampled once per interrupt event.
+struct fw_iso_ir_clock {
+	gint32 cycles;
+	gint64 nsec;
+};
+
+gboolean fw_iso_ir_clock_sample(struct fw_iso_ir_clock *clock, struct fw_iso_ctx_state *state,
+				GError **error);
+void fw_iso_ir_clock_convert(const struct fw_iso_ir_clock *clock, const gint32 *cycles,
+			     gint64 *nsec, guint count);
+
+// For HinokoFwIsoCtxPool.
+gboolean fw_iso_it_recycle(HinokoFwIsoIt *self);
+gboolean fw_iso_ir_single_recycle(HinokoFwIsoIrSingle *self);
+
+// For HinokoFwIsoCtxGroup.
+struct fw_iso_ctx_state *fw_iso_it_prepare_start(HinokoFwIsoIt *self);
+struct fw_iso_ctx_state *fw_iso_ir_single_prepare_start(HinokoFwIsoIrSingle *self);
+struct fw_iso_ctx_state *fw_iso_ir_multiple_prepare_start(HinokoFwIsoIrMultiple *self,
+							  guint chunks_per_irq, GError **error);
+
+// For HinokoFwIsoCaptureReplayer, HinokoFwIsoEventTrace, and HinokoFwIsoLoopback.
+struct fw_iso_ctx_state *fw_iso_it_get_state(HinokoFwIsoIt *self);
+struct fw_iso_ctx_state *fw_iso_ir_single_get_state(HinokoFwIsoIrSingle *self);
+struct fw_iso_ctx_state *fw_iso_ir_multiple_get_state(HinokoFwIsoIrMultiple *self);
+
+// For HinokoFwIsoEventTrace and HinokoFwIsoLoopback.
+struct fw_iso_ctx_state *fw_iso_ctx_get_state(HinokoFwIsoCtx *inst,
+					      fw_iso_ctx_handle_event_t *handle_event);
+
+gboolean fw_iso_it_handle_event(HinokoFwIsoCtx *inst, const union fw_cdev_event *event,
+				GError **error);
+gboolean fw_iso_ir_single_handle_event(HinokoFwIsoCtx *inst, const union fw_cdev_event *event,
+				       GError **error);
+gboolean fw_iso_ir_multiple_handle_event(HinokoFwIsoCtx *inst, const union fw_cdev_event *event,
+					 GError **error);
 
 #endif
@@ -0,0 +1,845 @@
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#include "fw_iso_ctx_private.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <time.h>
+
+/**
+ * HinokoFwIsoEventTrace:
+ * A recorder and replayer of events for isochronous context.
+ *
+ * [class@FwIsoEventTrace] records the events read from Linux FireWire subsystem for the attached
+ * context into a trace file, together with the snapshot of region in the intermediate buffer which
+ * the handler of event reads; the payload of packets received by [class@FwIsoIrSingle] and
+ * [class@FwIsoIrMultiple]. The events are recorded just before they are handled.
+ *
+ * The trace file is replayed to the context prepared by [method@FwIsoEventTrace.prepare] without
+ * hardware. The context is allocated and mapped offline with the same geometry as recorded, then
+ * the application can configure and start it as usual. [method@FwIsoEventTrace.replay] restores
+ * the snapshot of buffer and feeds each event to the same handler as the one for hardware, thus
+ * the signals of context are emitted as recorded. The events are fed as fast as possible, or at
+ * the same intervals as recorded.
+ *
+ * The trace file is not portable between machines, since the events are recorded in the layout
+ * of Linux FireWire subsystem for the running machine.
+ */
+typedef struct {
+	HinokoFwIsoCtxMode mode;
+	guint header_size;
+	guint bytes_per_chunk;
+	guint chunks_per_buffer;
+	guint64 event_count;
+
+	// For recording.
+	HinokoFwIsoCtx *ctx;
+	struct fw_iso_ctx_state *state;
+	gulong handler_id;
+	int fd;
+	guint8 *buf;
+	gsize buf_length;
+	struct fw_iso_event_trace_region *regions;
+	guint prev_offset;
+	GError *error;
+
+	// For replaying.
+	guint8 *map;
+	gsize size;
+} HinokoFwIsoEventTracePrivate;
+
+G_DEFINE_TYPE_WITH_PRIVATE(HinokoFwIsoEventTrace, hinoko_fw_iso_event_trace, G_TYPE_OBJECT)
+
+#define generate_file_error(error, code, format, arg)		\
+	g_set_error(error, G_FILE_ERROR, code, format, arg)
+
+// The layout of trace file in the byte order of running machine.
+//
+// The file begins with the file header, followed by the records of event. Each record consists of
+// the fixed-size fields, the content of event, and the regions of buffer. Each region consists of
+// the fixed-size fields and the content of buffer. The content is padded to 8 bytes.
+#define TRACE_MAGIC		"HNKTRACE"
+#define TRACE_VERSION		1
+
+struct fw_iso_event_trace_header {
+	char magic[8];
+	guint32 version;
+	guint32 mode;
+	guint32 header_size;
+	guint32 bytes_per_chunk;
+	guint32 chunks_per_buffer;
+	guint32 reserved;
+};
+G_STATIC_ASSERT(sizeof(struct fw_iso_event_trace_header) == 32);
+
+struct fw_iso_event_trace_record {
+	gint64 timestamp;	// The system time of CLOCK_MONOTONIC in nanoseconds.
+	guint32 length;		// The number of bytes in the content of event.
+	guint32 region_count;
+};
+G_STATIC_ASSERT(sizeof(struct fw_iso_event_trace_record) == 16);
+
+struct fw_iso_event_trace_region {
+	guint32 offset;		// The offset in the intermediate buffer.
+	guint32 length;
+};
+G_STATIC_ASSERT(sizeof(struct fw_iso_event_trace_region) == 8);
+
+#define TRACE_ALIGN(size)	(((size) + 7) & ~((gsize)7))
+
+// The records are accumulated in the buffer and written at once to reduce system calls.
+#define TRACE_BUFFER_SIZE	(1024 * 1024)
+
+enum fw_iso_event_trace_prop_type {
+	FW_ISO_EVENT_TRACE_PROP_TYPE_MODE = 1,
+	FW_ISO_EVENT_TRACE_PROP_TYPE_HEADER_SIZE,
+	FW_ISO_EVENT_TRACE_PROP_TYPE_BYTES_PER_CHUNK,
+	FW_ISO_EVENT_TRACE_PROP_TYPE_CHUNKS_PER_BUFFER,
+	FW_ISO_EVENT_TRACE_PROP_TYPE_EVENT_COUNT,
+	FW_ISO_EVENT_TRACE_PROP_TYPE_COUNT,
+};
+
+static void fw_iso_event_trace_get_property(GObject *obj, guint id, GValue *val,
+					    GParamSpec *spec)
+{
+	HinokoFwIsoEventTrace *self = HINOKO_FW_ISO_EVENT_TRACE(obj);
+	HinokoFwIsoEventTracePrivate *priv = hinoko_fw_iso_event_trace_get_instance_private(self);
+
+	switch (id) {
+	case FW_ISO_EVENT_TRACE_PROP_TYPE_MODE:
+		g_value_set_enum(val, priv->mode);
+		break;
+	case FW_ISO_EVENT_TRACE_PROP_TYPE_HEADER_SIZE:
+		g_value_set_uint(val, priv->header_size);
+		break;
+	case FW_ISO_EVENT_TRACE_PROP_TYPE_BYTES_PER_CHUNK:
+		g_value_set_uint(val, priv->bytes_per_chunk);
+		break;
+	case FW_ISO_EVENT_TRACE_PROP_TYPE_CHUNKS_PER_BUFFER:
+		g_value_set_uint(val, priv->chunks_per_buffer);
+		break;
+	case FW_ISO_EVENT_TRACE_PROP_TYPE_EVENT_COUNT:
+		g_value_set_uint64(val, priv->event_count);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, id, spec);
+		break;
+	}
+}
+
+static void release_map(HinokoFwIsoEventTracePrivate *priv)
+{
+	if (priv->map != NULL) {
+		munmap(priv->map, priv->size);
+		priv->map = NULL;
+		priv->size = 0;
+	}
+}
+
+static void fw_iso_event_trace_finalize(GObject *obj)
+{
+	HinokoFwIsoEventTrace *self = HINOKO_FW_ISO_EVENT_TRACE(obj);
+	HinokoFwIsoEventTracePrivate *priv = hinoko_fw_iso_event_trace_get_instance_private(self);
+
+	hinoko_fw_iso_event_trace_close(self, NULL);
+	release_map(priv);
+
+	G_OBJECT_CLASS(hinoko_fw_iso_event_trace_parent_class)->finalize(obj);
+}
+
+static void hinoko_fw_iso_event_trace_class_init(HinokoFwIsoEventTraceClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+
+	gobject_class->get_property = fw_iso_event_trace_get_property;
+	gobject_class->finalize = fw_iso_event_trace_finalize;
+
+	/**
+	 * HinokoFwIsoEventTrace:mode:
+	 *
+	 * The mode of context for the trace being recorded or opened.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_EVENT_TRACE_PROP_TYPE_MODE,
+		g_param_spec_enum("mode", "mode",
+				  "The mode of context for the trace",
+				  HINOKO_TYPE_FW_ISO_CTX_MODE, HINOKO_FW_ISO_CTX_MODE_IT,
+				  G_PARAM_READABLE));
+
+	/**
+	 * HinokoFwIsoEventTrace:header-size:
+	 *
+	 * The number of bytes for header of context for the trace being recorded or opened.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_EVENT_TRACE_PROP_TYPE_HEADER_SIZE,
+		g_param_spec_uint("header-size", "header-size",
+				  "The number of bytes for header of context",
+				  0, G_MAXUINT, 0,
+				  G_PARAM_READABLE));
+
+	/**
+	 * HinokoFwIsoEventTrace:bytes-per-chunk:
+	 *
+	 * The number of bytes per chunk in the buffer of context for the trace being recorded or
+	 * opened.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class,
+					FW_ISO_EVENT_TRACE_PROP_TYPE_BYTES_PER_CHUNK,
+		g_param_spec_uint("bytes-per-chunk", "bytes-per-chunk",
+				  "The number of bytes per chunk in the buffer of context",
+				  0, G_MAXUINT, 0,
+				  G_PARAM_READABLE));
+
+	/**
+	 * HinokoFwIsoEventTrace:chunks-per-buffer:
+	 *
+	 * The number of chunks in the buffer of context for the trace being recorded or opened.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class,
+					FW_ISO_EVENT_TRACE_PROP_TYPE_CHUNKS_PER_BUFFER,
+		g_param_spec_uint("chunks-per-buffer", "chunks-per-buffer",
+				  "The number of chunks in the buffer of context",
+				  0, G_MAXUINT, 0,
+				  G_PARAM_READABLE));
+
+	/**
+	 * HinokoFwIsoEventTrace:event-count:
+	 *
+	 * The number of events recorded since [method@FwIsoEventTrace.record], or included in the
+	 * trace file opened by [method@FwIsoEventTrace.open].
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_EVENT_TRACE_PROP_TYPE_EVENT_COUNT,
+		g_param_spec_uint64("event-count", "event-count",
+				    "The number of events in the trace",
+				    0, G_MAXUINT64, 0,
+				    G_PARAM_READABLE));
+}
+
+static void hinoko_fw_iso_event_trace_init(HinokoFwIsoEventTrace *self)
+{
+	HinokoFwIsoEventTracePrivate *priv = hinoko_fw_iso_event_trace_get_instance_private(self);
+
+	priv->fd = -1;
+}
+
+/**
+ * hinoko_fw_iso_event_trace_new:
+ *
+ * Instantiate [class@FwIsoEventTrace] object and return the instance.
+ *
+ * Returns: an instance of [class@FwIsoEventTrace].
+ *
+ * Since: 1.1
+ */
+HinokoFwIsoEventTrace *hinoko_fw_iso_event_trace_new(void)
+{
+	return g_object_new(HINOKO_TYPE_FW_ISO_EVENT_TRACE, NULL);
+}
+
+static gboolean write_all(int fd, const guint8 *data, gsize length, GError **error)
+{
+	while (length > 0) {
+		ssize_t len = write(fd, data, length);
+
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+
+			generate_file_error(error, g_file_error_from_errno(errno), "write %s",
+					    strerror(errno));
+			return FALSE;
+		}
+
+		data += len;
+		length -= len;
+	}
+
+	return TRUE;
+}
+
+static void flush_buffer(HinokoFwIsoEventTracePrivate *priv)
+{
+	if (priv->error == NULL && priv->buf_length > 0)
+		write_all(priv->fd, priv->buf, priv->buf_length, &priv->error);
+	priv->buf_length = 0;
+}
+
+// The content is padded to 8 bytes by zero.
+static void append_bytes(HinokoFwIsoEventTracePrivate *priv, const void *data, gsize length)
+{
+	gsize padded = TRACE_ALIGN(length);
+
+	if (priv->buf_length + padded > TRACE_BUFFER_SIZE)
+		flush_buffer(priv);
+
+	// The large content is written without the buffer.
+	if (padded > TRACE_BUFFER_SIZE) {
+		static const guint8 zeros[8] = { 0 };
+
+		if (priv->error == NULL && write_all(priv->fd, data, length, &priv->error))
+			write_all(priv->fd, zeros, padded - length, &priv->error);
+		return;
+	}
+
+	memcpy(priv->buf + priv->buf_length, data, length);
+	memset(priv->buf + priv->buf_length + length, 0, padded - length);
+	priv->buf_length += padded;
+}
+
+// The payload of each packet is in the chunk of buffer next to the one completed before. The
+// length is given by the isochronous packet header in context header.
+static guint collect_ir_single_regions(HinokoFwIsoEventTracePrivate *priv,
+				       const struct fw_iso_ctx_state *state,
+				       const struct fw_cdev_event_iso_interrupt *ev)
+{
+	guint quadlets_per_header = state->header_size / 4;
+	guint count = MIN(ev->header_length / state->header_size, state->chunks_per_buffer);
+	guint chunk = state->completed_total % state->chunks_per_buffer;
+	guint i;
+
+	for (i = 0; i < count; ++i) {
+		guint32 iso_header = GUINT32_FROM_BE(ev->header[i * quadlets_per_header]);
+
+		priv->regions[i].offset = chunk * state->bytes_per_chunk;
+		priv->regions[i].length = MIN(ieee1394_iso_header_to_data_length(iso_header),
+					      state->bytes_per_chunk);
+		chunk = (chunk + 1) % state->chunks_per_buffer;
+	}
+
+	return count;
+}
+
+// The content of buffer is filled up to the completed offset, from the one in the former event.
+static guint collect_ir_multiple_regions(HinokoFwIsoEventTracePrivate *priv,
+					 const struct fw_iso_ctx_state *state,
+					 const struct fw_cdev_event_iso_interrupt_mc *ev)
+{
+	guint bytes_per_buffer = state->bytes_per_chunk * state->chunks_per_buffer;
+	guint completed = ev->completed % bytes_per_buffer;
+	guint count = 0;
+
+	if (completed < priv->prev_offset) {
+		priv->regions[count].offset = priv->prev_offset;
+		priv->regions[count].length = bytes_per_buffer - priv->prev_offset;
+		++count;
+		priv->prev_offset = 0;
+	}
+
+	if (completed > priv->prev_offset) {
+		priv->regions[count].offset = priv->prev_offset;
+		priv->regions[count].length = completed - priv->prev_offset;
+		++count;
+	}
+
+	priv->prev_offset = completed;
+
+	return count;
+}
+
+static void record_event(const struct fw_iso_ctx_state *state, const union fw_cdev_event *event,
+			 guint length, gpointer user_data)
+{
+	HinokoFwIsoEventTracePrivate *priv = user_data;
+	struct fw_iso_event_trace_record record;
+	struct timespec ts;
+	guint count = 0;
+	guint i;
+
+	if (priv->error != NULL)
+		return;
+
+	if (state->mode == HINOKO_FW_ISO_CTX_MODE_IR_SINGLE)
+		count = collect_ir_single_regions(priv, state, &event->iso_interrupt);
+	else if (state->mode == HINOKO_FW_ISO_CTX_MODE_IR_MULTIPLE)
+		count = collect_ir_multiple_regions(priv, state, &event->iso_interrupt_mc);
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	record.timestamp = ts.tv_sec * G_GINT64_CONSTANT(1000000000) + ts.tv_nsec;
+	record.length = length;
+	record.region_count = count;
+
+	append_bytes(priv, &record, sizeof(record));
+	append_bytes(priv, event, length);
+
+	for (i = 0; i < count; ++i) {
+		append_bytes(priv, &priv->regions[i], sizeof(priv->regions[i]));
+		append_bytes(priv, state->addr + priv->regions[i].offset, priv->regions[i].length);
+	}
+
+	++priv->event_count;
+}
+
+// The context is restarted with empty buffer.
+static void handle_stopped(HinokoFwIsoCtx *ctx, const GError *error, gpointer user_data)
+{
+	HinokoFwIsoEventTracePrivate *priv = user_data;
+
+	priv->prev_offset = 0;
+}
+
+/**
+ * hinoko_fw_iso_event_trace_record:
+ * @self: A [class@FwIsoEventTrace].
+ * @ctx: A [class@FwIsoIt], [class@FwIsoIrSingle], or [class@FwIsoIrMultiple] which is allocated
+ *	 and mapped, and not started yet.
+ * @path: The path to the trace file to write.
+ * @error: A [struct@GLib.Error].
+ *
+ * Start recording the events for the context. The events are recorded in the thread to dispatch
+ * the source of context, and the records are accumulated in the buffer and written to the file
+ * at once when the buffer is full.
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_event_trace_record(HinokoFwIsoEventTrace *self, HinokoFwIsoCtx *ctx,
+					  const char *path, GError **error)
+{
+	HinokoFwIsoEventTracePrivate *priv;
+	struct fw_iso_event_trace_header header = {0};
+	fw_iso_ctx_handle_event_t handle_event;
+	struct fw_iso_ctx_state *state;
+
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_EVENT_TRACE(self), FALSE);
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_IT(ctx) || HINOKO_IS_FW_ISO_IR_SINGLE(ctx) ||
+			     HINOKO_IS_FW_ISO_IR_MULTIPLE(ctx), FALSE);
+	g_return_val_if_fail(path != NULL && strlen(path) > 0, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	priv = hinoko_fw_iso_event_trace_get_instance_private(self);
+	g_return_val_if_fail(priv->ctx == NULL, FALSE);
+
+	state = fw_iso_ctx_get_state(ctx, &handle_event);
+
+	if (state->fd < 0) {
+		generate_fw_iso_ctx_error_coded(error, HINOKO_FW_ISO_CTX_ERROR_NOT_ALLOCATED);
+		return FALSE;
+	}
+
+	if (state->addr == NULL) {
+		generate_fw_iso_ctx_error_coded(error, HINOKO_FW_ISO_CTX_ERROR_NOT_MAPPED);
+		return FALSE;
+	}
+
+	g_return_val_if_fail(!state->running, FALSE);
+	g_return_val_if_fail(state->trace_event == NULL, FALSE);
+
+	priv->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (priv->fd < 0) {
+		GFileError code = g_file_error_from_errno(errno);
+		if (code != G_FILE_ERROR_FAILED)
+			generate_file_error(error, code, "open(%s)", path);
+		else
+			generate_syscall_error(error, errno, "open(%s)", path);
+		return FALSE;
+	}
+
+	release_map(priv);
+	priv->mode = state->mode;
+	priv->header_size = state->header_size;
+	priv->bytes_per_chunk = state->bytes_per_chunk;
+	priv->chunks_per_buffer = state->chunks_per_buffer;
+	priv->event_count = 0;
+
+	// The region of buffer is up to two for IR context in buffer-fill mode.
+	priv->buf = g_malloc(TRACE_BUFFER_SIZE);
+	priv->buf_length = 0;
+	priv->regions = g_new(struct fw_iso_event_trace_region, MAX(priv->chunks_per_buffer, 2));
+	priv->prev_offset = 0;
+
+	memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+	header.version = TRACE_VERSION;
+	header.mode = priv->mode;
+	header.header_size = priv->header_size;
+	header.bytes_per_chunk = priv->bytes_per_chunk;
+	header.chunks_per_buffer = priv->chunks_per_buffer;
+	append_bytes(priv, &header, sizeof(header));
+
+	priv->handler_id = g_signal_connect(ctx, STOPPED_SIGNAL_NAME, G_CALLBACK(handle_stopped),
+					    priv);
+	priv->ctx = g_object_ref(ctx);
+	priv->state = state;
+	state->trace_data = priv;
+	state->trace_event = record_event;
+
+	return TRUE;
+}
+
+/**
+ * hinoko_fw_iso_event_trace_close:
+ * @self: A [class@FwIsoEventTrace].
+ * @error: A [struct@GLib.Error].
+ *
+ * Stop recording, write the rest of records, and close the trace file. The error to write the
+ * records during recording is reported.
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_event_trace_close(HinokoFwIsoEventTrace *self, GError **error)
+{
+	HinokoFwIsoEventTracePrivate *priv;
+
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_EVENT_TRACE(self), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	priv = hinoko_fw_iso_event_trace_get_instance_private(self);
+
+	if (priv->ctx == NULL)
+		return TRUE;
+
+	priv->state->trace_event = NULL;
+	priv->state->trace_data = NULL;
+	priv->state = NULL;
+	g_signal_handler_disconnect(priv->ctx, priv->handler_id);
+	priv->handler_id = 0;
+	g_object_unref(priv->ctx);
+	priv->ctx = NULL;
+
+	flush_buffer(priv);
+	if (close(priv->fd) < 0 && priv->error == NULL)
+		generate_syscall_error(&priv->error, errno, "close(%d)", priv->fd);
+	priv->fd = -1;
+
+	g_free(priv->buf);
+	priv->buf = NULL;
+	g_free(priv->regions);
+	priv->regions = NULL;
+
+	if (priv->error != NULL) {
+		g_propagate_error(error, priv->error);
+		priv->error = NULL;
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gsize read_record(const HinokoFwIsoEventTracePrivate *priv, gsize offset,
+			 const struct fw_iso_event_trace_record **record)
+{
+	guint bytes_per_buffer = priv->bytes_per_chunk * priv->chunks_per_buffer;
+	gsize pos = offset;
+	guint i;
+
+	if (pos + sizeof(**record) > priv->size)
+		return 0;
+	*record = (const struct fw_iso_event_trace_record *)(priv->map + pos);
+	pos += sizeof(**record) + TRACE_ALIGN((*record)->length);
+
+	for (i = 0; i < (*record)->region_count; ++i) {
+		const struct fw_iso_event_trace_region *region;
+
+		if (pos + sizeof(*region) > priv->size)
+			return 0;
+		region = (const struct fw_iso_event_trace_region *)(priv->map + pos);
+		if (region->offset > bytes_per_buffer ||
+		    region->length > bytes_per_buffer - region->offset)
+			return 0;
+		pos += sizeof(*region) + TRACE_ALIGN(region->length);
+	}
+
+	if (pos > priv->size)
+		return 0;
+
+	return pos - offset;
+}
+
+/**
+ * hinoko_fw_iso_event_trace_open:
+ * @self: A [class@FwIsoEventTrace].
+ * @path: The path to the trace file written by [method@FwIsoEventTrace.record].
+ * @error: A [struct@GLib.Error].
+ *
+ * Map the trace file to replay. The records truncated at the end of file, for example due to
+ * abort of recording, are ignored.
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_event_trace_open(HinokoFwIsoEventTrace *self, const char *path,
+					GError **error)
+{
+	HinokoFwIsoEventTracePrivate *priv;
+	const struct fw_iso_event_trace_header *header;
+	const struct fw_iso_event_trace_record *record;
+	struct stat st;
+	gsize offset;
+	gsize size;
+	void *map;
+	int fd;
+
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_EVENT_TRACE(self), FALSE);
+	g_return_val_if_fail(path != NULL && strlen(path) > 0, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	priv = hinoko_fw_iso_event_trace_get_instance_private(self);
+	g_return_val_if_fail(priv->ctx == NULL, FALSE);
+	release_map(priv);
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		GFileError code = g_file_error_from_errno(errno);
+		if (code != G_FILE_ERROR_FAILED)
+			generate_file_error(error, code, "open(%s)", path);
+		else
+			generate_syscall_error(error, errno, "open(%s)", path);
+		return FALSE;
+	}
+
+	if (fstat(fd, &st) < 0) {
+		generate_syscall_error(error, errno, "fstat(%s)", path);
+		close(fd);
+		return FALSE;
+	}
+
+	if (st.st_size < (off_t)sizeof(*header)) {
+		generate_file_error(error, G_FILE_ERROR_INVAL, "Invalid trace file: %s", path);
+		close(fd);
+		return FALSE;
+	}
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		generate_syscall_error(error, errno, "mmap(%s)", path);
+		return FALSE;
+	}
+	priv->map = map;
+	priv->size = st.st_size;
+
+	header = (const struct fw_iso_event_trace_header *)priv->map;
+	if (memcmp(header->magic, TRACE_MAGIC, sizeof(header->magic)) ||
+	    header->version != TRACE_VERSION ||
+	    (header->mode != HINOKO_FW_ISO_CTX_MODE_IT &&
+	     header->mode != HINOKO_FW_ISO_CTX_MODE_IR_SINGLE &&
+	     header->mode != HINOKO_FW_ISO_CTX_MODE_IR_MULTIPLE) ||
+	    header->bytes_per_chunk == 0 || header->chunks_per_buffer == 0) {
+		generate_file_error(error, G_FILE_ERROR_INVAL, "Invalid trace file: %s", path);
+		release_map(priv);
+		return FALSE;
+	}
+
+	priv->mode = header->mode;
+	priv->header_size = header->header_size;
+	priv->bytes_per_chunk = header->bytes_per_chunk;
+	priv->chunks_per_buffer = header->chunks_per_buffer;
+
+	priv->event_count = 0;
+	offset = sizeof(*header);
+	while ((size = read_record(priv, offset, &record)) > 0) {
+		offset += size;
+		++priv->event_count;
+	}
+
+	// Ignore the truncated record.
+	priv->size = offset;
+
+	return TRUE;
+}
+
+/**
+ * hinoko_fw_iso_event_trace_prepare:
+ * @self: A [class@FwIsoEventTrace].
+ * @ctx: A [class@FwIsoIt], [class@FwIsoIrSingle], or [class@FwIsoIrMultiple] which is not
+ *	 allocated yet, for the mode of context in the trace file.
+ * @error: A [struct@GLib.Error].
+ *
+ * Allocate the context offline and map the buffer with the same geometry as the trace file. The
+ * context is not backed by Linux FireWire subsystem, thus the requests to hardware are omitted
+ * and the cycle time is simulated by the system time. The application can configure and start
+ * the context as usual, then call [method@FwIsoEventTrace.replay]. The context should be released
+ * by [method@FwIsoCtx.release] when it is not used anymore.
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_event_trace_prepare(HinokoFwIsoEventTrace *self, HinokoFwIsoCtx *ctx,
+					   GError **error)
+{
+	static const guint8 channels[] = { 0 };
+	HinokoFwIsoEventTracePrivate *priv;
+	fw_iso_ctx_handle_event_t handle_event;
+	struct fw_iso_ctx_state *state;
+	gboolean result;
+
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_EVENT_TRACE(self), FALSE);
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_IT(ctx) || HINOKO_IS_FW_ISO_IR_SINGLE(ctx) ||
+			     HINOKO_IS_FW_ISO_IR_MULTIPLE(ctx), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	priv = hinoko_fw_iso_event_trace_get_instance_private(self);
+	g_return_val_if_fail(priv->map != NULL, FALSE);
+	g_return_val_if_fail((priv->mode == HINOKO_FW_ISO_CTX_MODE_IT &&
+			      HINOKO_IS_FW_ISO_IT(ctx)) ||
+			     (priv->mode == HINOKO_FW_ISO_CTX_MODE_IR_SINGLE &&
+			      HINOKO_IS_FW_ISO_IR_SINGLE(ctx)) ||
+			     (priv->mode == HINOKO_FW_ISO_CTX_MODE_IR_MULTIPLE &&
+			      HINOKO_IS_FW_ISO_IR_MULTIPLE(ctx)), FALSE);
+
+	state = fw_iso_ctx_get_state(ctx, &handle_event);
+
+	if (state->fd >= 0) {
+		generate_fw_iso_ctx_error_coded(error, HINOKO_FW_ISO_CTX_ERROR_ALLOCATED);
+		return FALSE;
+	}
+
+	// The path is not used for the offline context.
+	state->offline = TRUE;
+
+	switch (priv->mode) {
+	case HINOKO_FW_ISO_CTX_MODE_IT:
+		result = hinoko_fw_iso_it_allocate(HINOKO_FW_ISO_IT(ctx), "offline",
+						   HINOKO_FW_SCODE_S400, 0, priv->header_size,
+						   error) &&
+			 hinoko_fw_iso_it_map_buffer(HINOKO_FW_ISO_IT(ctx), priv->bytes_per_chunk,
+						     priv->chunks_per_buffer, error);
+		break;
+	case HINOKO_FW_ISO_CTX_MODE_IR_SINGLE:
+		result = hinoko_fw_iso_ir_single_allocate(HINOKO_FW_ISO_IR_SINGLE(ctx), "offline",
+							  0, priv->header_size, error) &&
+			 hinoko_fw_iso_ir_single_map_buffer(HINOKO_FW_ISO_IR_SINGLE(ctx),
+							    priv->bytes_per_chunk,
+							    priv->chunks_per_buffer, error);
+		break;
+	case HINOKO_FW_ISO_CTX_MODE_IR_MULTIPLE:
+	default:
+		result = hinoko_fw_iso_ir_multiple_allocate(HINOKO_FW_ISO_IR_MULTIPLE(ctx),
+							    "offline", channels,
+							    G_N_ELEMENTS(channels), error) &&
+			 hinoko_fw_iso_ir_multiple_map_buffer(HINOKO_FW_ISO_IR_MULTIPLE(ctx),
+							      priv->bytes_per_chunk,
+							      priv->chunks_per_buffer, error);
+		break;
+	}
+
+	if (!result) {
+		hinoko_fw_iso_ctx_release(ctx);
+		state->offline = FALSE;
+	}
+
+	return result;
+}
+
+static void wait_until(gint64 deadline_ns)
+{
+	struct timespec ts = {
+		.tv_sec = deadline_ns / G_GINT64_CONSTANT(1000000000),
+		.tv_nsec = deadline_ns % G_GINT64_CONSTANT(1000000000),
+	};
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+		;
+}
+
+/**
+ * hinoko_fw_iso_event_trace_replay:
+ * @self: A [class@FwIsoEventTrace].
+ * @ctx: The context prepared by [method@FwIsoEventTrace.prepare].
+ * @preserve_timing: Whether to feed the events at the same intervals as recorded, or as fast as
+ *		     possible.
+ * @error: A [struct@GLib.Error].
+ *
+ * Feed the events in the trace file to the handler of context in the thread of caller, after
+ * restoring the snapshot of buffer for each event. The signals of context are emitted in the
+ * handler as well as the events from hardware. When the handler fails, the context is stopped
+ * and the error is reported.
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_event_trace_replay(HinokoFwIsoEventTrace *self, HinokoFwIsoCtx *ctx,
+					  gboolean preserve_timing, GError **error)
+{
+	HinokoFwIsoEventTracePrivate *priv;
+	fw_iso_ctx_handle_event_t handle_event;
+	struct fw_iso_ctx_state *state;
+	const struct fw_iso_event_trace_record *record;
+	gint64 first_timestamp = 0;
+	gint64 base_ns = 0;
+	gsize offset;
+	gsize size;
+
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_EVENT_TRACE(self), FALSE);
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_IT(ctx) || HINOKO_IS_FW_ISO_IR_SINGLE(ctx) ||
+			     HINOKO_IS_FW_ISO_IR_MULTIPLE(ctx), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	priv = hinoko_fw_iso_event_trace_get_instance_private(self);
+	g_return_val_if_fail(priv->map != NULL, FALSE);
+
+	state = fw_iso_ctx_get_state(ctx, &handle_event);
+	g_return_val_if_fail(state->offline, FALSE);
+	g_return_val_if_fail(state->mode == priv->mode, FALSE);
+	g_return_val_if_fail(state->bytes_per_chunk == priv->bytes_per_chunk, FALSE);
+	g_return_val_if_fail(state->chunks_per_buffer == priv->chunks_per_buffer, FALSE);
+
+	if (preserve_timing) {
+		struct timespec ts;
+
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		base_ns = ts.tv_sec * G_GINT64_CONSTANT(1000000000) + ts.tv_nsec;
+	}
+
+	offset = sizeof(struct fw_iso_event_trace_header);
+	while ((size = read_record(priv, offset, &record)) > 0) {
+		GError *local_error = NULL;
+		const guint8 *pos;
+		guint i;
+
+		if (record->length > state->event_buf_length) {
+			generate_file_error(error, G_FILE_ERROR_INVAL,
+					    "The event is larger than the buffer: %u",
+					    record->length);
+			return FALSE;
+		}
+
+		if (preserve_timing) {
+			if (offset == sizeof(struct fw_iso_event_trace_header))
+				first_timestamp = record->timestamp;
+			wait_until(base_ns + record->timestamp - first_timestamp);
+		}
+
+		pos = (const guint8 *)(record + 1);
+		memcpy(state->event_buf, pos, record->length);
+		pos += TRACE_ALIGN(record->length);
+
+		for (i = 0; i < record->region_count; ++i) {
+			const struct fw_iso_event_trace_region *region =
+				(const struct fw_iso_event_trace_region *)pos;
+
+			pos += sizeof(*region);
+			memcpy(state->addr + region->offset, pos, region->length);
+			pos += TRACE_ALIGN(region->length);
+		}
+
+		offset += size;
+
+		if (!handle_event(ctx, (const union fw_cdev_event *)state->event_buf,
+				  &local_error)) {
+			// The error is delivered to the handler of stopped signal.
+			state->stop_error = local_error;
+			hinoko_fw_iso_ctx_stop(ctx);
+			state->stop_error = NULL;
+			g_propagate_error(error, local_error);
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#ifndef __ORG_KERNEL_HINOKO_FW_ISO_EVENT_TRACE_H__
+#define __ORG_KERNEL_HINOKO_FW_ISO_EVENT_TRACE_H__
+
+#include <hinoko.h>
+
+G_BEGIN_DECLS
+
+#define HINOKO_TYPE_FW_ISO_EVENT_TRACE	(hinoko_fw_iso_event_trace_get_type())
+
+G_DECLARE_DERIVABLE_TYPE(HinokoFwIsoEventTrace, hinoko_fw_iso_event_trace, HINOKO,
+			 FW_ISO_EVENT_TRACE, GObject);
+
+struct _HinokoFwIsoEventTraceClass {
+	GObjectClass parent_class;
+};
+
+HinokoFwIsoEventTrace *hinoko_fw_iso_event_trace_new(void);
+
+gboolean hinoko_fw_iso_event_trace_record(HinokoFwIsoEventTrace *self, HinokoFwIsoCtx *ctx,
+					  const char *path, GError **error);
+
+gboolean hinoko_fw_iso_event_trace_close(HinokoFwIsoEventTrace *self, GError **error);
+
+gboolean hinoko_fw_iso_event_trace_open(HinokoFwIsoEventTrace *self, const char *path,
+					GError **error);
+
+gboolean hinoko_fw_iso_event_trace_prepare(HinokoFwIsoEventTrace *self, HinokoFwIsoCtx *ctx,
+					   GError **error);
+
+gboolean hinoko_fw_iso_event_trace_replay(HinokoFwIsoEventTrace *self, HinokoFwIsoCtx *ctx,
+					  gboolean preserve_timing, GError **error);
+
+G_END_DECLS
+
+#endif
@@ -19,12 +19,24 @@ typedef struct {
 
 	guint prev_offset;
 
+	// In private area of the arena.
 	struct ctx_payload *ctx_payloads;
 	unsigned int ctx_payload_count;
+	gint32 *tstamp_cycles;
+	gint64 *timestamps;
 	guint8 *concat_frames;
+	gint32 *loss_cycles;
 
 	guint chunks_per_irq;
 	guint accumulated_chunk_count;
+
+	gboolean detect_loss;
+	struct fw_iso_ir_loss_detector loss;
+	guint loss_cycle_counts[IEEE1394_MAX_CHANNEL + 1];
+
+	gboolean timestamp_packets;
+	struct fw_iso_ir_clock clock;
+	guint timestamp_count;
 } HinokoFwIsoIrMultiplePrivate;
 
 static void fw_iso_ctx_iface_init(HinokoFwIsoCtxInterface *iface);
@@ -35,11 +47,15 @@ G_DEFINE_TYPE_WITH_CODE(HinokoFwIsoIrMultiple, hinoko_fw_iso_ir_multiple, G_TYPE
 
 enum fw_iso_ir_multiple_prop_type {
 	FW_ISO_IR_MULTIPLE_PROP_TYPE_CHANNELS = FW_ISO_CTX_PROP_TYPE_COUNT,
+	FW_ISO_IR_MULTIPLE_PROP_TYPE_DETECT_PACKET_LOSS,
+	FW_ISO_IR_MULTIPLE_PROP_TYPE_TIMESTAMP_PACKETS,
 	FW_ISO_IR_MULTIPLE_PROP_TYPE_COUNT,
 };
 
 enum fw_iso_ir_multiple_sig_type {
 	FW_ISO_IR_MULTIPLE_SIG_TYPE_IRQ = 1,
+	FW_ISO_IR_MULTIPLE_SIG_TYPE_PACKETS_LOST,
+	FW_ISO_IR_MULTIPLE_SIG_TYPE_LOW_HEADROOM,
 	FW_ISO_IR_MULTIPLE_SIG_TYPE_COUNT,
 };
 static guint fw_iso_ir_multiple_sigs[FW_ISO_IR_MULTIPLE_SIG_TYPE_COUNT] = { 0 };
@@ -54,12 +70,38 @@ static void fw_iso_ir_multiple_get_property(GObject *obj, guint id, GValue *val,
 	case FW_ISO_IR_MULTIPLE_PROP_TYPE_CHANNELS:
 		g_value_set_static_boxed(val, priv->channels);
 		break;
+	case FW_ISO_IR_MULTIPLE_PROP_TYPE_DETECT_PACKET_LOSS:
+		g_value_set_boolean(val, priv->detect_loss);
+		break;
+	case FW_ISO_IR_MULTIPLE_PROP_TYPE_TIMESTAMP_PACKETS:
+		g_value_set_boolean(val, priv->timestamp_packets);
+		break;
 	default:
 		fw_iso_ctx_state_get_property(&priv->state, obj, id, val, spec);
 		break;
 	}
 }
 
+static void fw_iso_ir_multiple_set_property(GObject *obj, guint id, const GValue *val,
+					    GParamSpec *spec)
+{
+	HinokoFwIsoIrMultiple *self = HINOKO_FW_ISO_IR_MULTIPLE(obj);
+	HinokoFwIsoIrMultiplePrivate *priv =
+			hinoko_fw_iso_ir_multiple_get_instance_private(self);
+
+	switch (id) {
+	case FW_ISO_IR_MULTIPLE_PROP_TYPE_DETECT_PACKET_LOSS:
+		priv->detect_loss = g_value_get_boolean(val);
+		break;
+	case FW_ISO_IR_MULTIPLE_PROP_TYPE_TIMESTAMP_PACKETS:
+		priv->timestamp_packets = g_value_get_boolean(val);
+		break;
+	default:
+		fw_iso_ctx_state_set_property(&priv->state, obj, id, val, spec);
+		break;
+	}
+}
+
 static void fw_iso_ir_multiple_finalize(GObject *obj)
 {
 	hinoko_fw_iso_ctx_release(HINOKO_FW_ISO_CTX(obj));
@@ -72,10 +114,14 @@ static void hinoko_fw_iso_ir_multiple_class_init(HinokoFwIsoIrMultipleClass *kla
 	GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
 
 	gobject_class->get_property = fw_iso_ir_multiple_get_property;
+	gobject_class->set_property = fw_iso_ir_multiple_set_property;
 	gobject_class->finalize = fw_iso_ir_multiple_finalize;
 
 	fw_iso_ctx_class_override_properties(gobject_class);
 
+	fw_iso_ir_multiple_sigs[FW_ISO_IR_MULTIPLE_SIG_TYPE_LOW_HEADROOM] =
+		fw_iso_ctx_class_lookup_low_headroom();
+
 	/**
 	 * HinokoFwIsoIrMultiple:channels:
 	 *
@@ -88,6 +134,45 @@ static void hinoko_fw_iso_ir_multiple_class_init(HinokoFwIsoIrMultipleClass *kla
 				   G_TYPE_BYTE_ARRAY,
 				   G_PARAM_READABLE));
 
+	/**
+	 * HinokoFwIsoIrMultiple:detect-packet-loss:
+	 *
+	 * Whether to detect gap, duplication, and reordering of isochronous cycles for received
+	 * packets in each channel by their timestamps. It is assumed that each channel conveys
+	 * one packet per isochronous cycle. The gap is notified by
+	 * [signal@FwIsoIrMultiple::packets-lost]. The counters are available by
+	 * [method@FwIsoIrMultiple.get_loss_counters]. The property should be enabled before
+	 * [method@FwIsoIrMultiple.map_buffer] since the storage for the detection is allocated
+	 * then, otherwise the detection is not done.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class,
+					FW_ISO_IR_MULTIPLE_PROP_TYPE_DETECT_PACKET_LOSS,
+		g_param_spec_boolean("detect-packet-loss", "detect-packet-loss",
+				     "Whether to detect loss of packets",
+				     FALSE,
+				     G_PARAM_READWRITE));
+
+	/**
+	 * HinokoFwIsoIrMultiple:timestamp-packets:
+	 *
+	 * Whether to convert timestamp of each received packet to system time in CLOCK_MONOTONIC.
+	 * The timestamp is read from the trailing quadlet of each packet. The pair of cycle time
+	 * and system time is sampled once per interrupt event, then the timestamps of all packets
+	 * in the event are converted in batch. The result is available by
+	 * [method@FwIsoIrMultiple.get_timestamps] in the handler of
+	 * [signal@FwIsoIrMultiple::interrupted].
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class,
+					FW_ISO_IR_MULTIPLE_PROP_TYPE_TIMESTAMP_PACKETS,
+		g_param_spec_boolean("timestamp-packets", "timestamp-packets",
+				     "Whether to convert timestamp of packets to system time",
+				     FALSE,
+				     G_PARAM_READWRITE));
+
 	/**
 	 * HinokoFwIsoIrMultiple::interrupted:
 	 * @self: A [class@FwIsoIrMultiple].
@@ -112,6 +197,39 @@ static void hinoko_fw_iso_ir_multiple_class_init(HinokoFwIsoIrMultipleClass *kla
 			g_cclosure_marshal_VOID__UINT,
 			G_TYPE_NONE,
 			1, G_TYPE_UINT);
+
+	// Collect arguments of the signal without GValue in the path of interrupt event.
+	g_signal_set_va_marshaller(fw_iso_ir_multiple_sigs[FW_ISO_IR_MULTIPLE_SIG_TYPE_IRQ],
+				   G_OBJECT_CLASS_TYPE(klass), g_cclosure_marshal_VOID__UINTv);
+
+	/**
+	 * HinokoFwIsoIrMultiple::packets-lost:
+	 * @self: A [class@FwIsoIrMultiple].
+	 * @channel: The isochronous channel in which packets are lost.
+	 * @sec: The sec part of isochronous cycle for the packet after the loss, up to 7.
+	 * @cycle: The cycle part of isochronous cycle for the packet after the loss, up to 7999.
+	 * @count: The number of lost packets.
+	 *
+	 * Emitted when the gap of isochronous cycles is detected in received packets, before
+	 * [signal@FwIsoIrMultiple::interrupted] in the same interrupt event. The signal is
+	 * available when [property@FwIsoIrMultiple:detect-packet-loss] is enabled.
+	 *
+	 * Since: 1.1
+	 */
+	fw_iso_ir_multiple_sigs[FW_ISO_IR_MULTIPLE_SIG_TYPE_PACKETS_LOST] =
+		g_signal_new("packets-lost",
+			G_OBJECT_CLASS_TYPE(klass),
+			G_SIGNAL_RUN_LAST,
+			G_STRUCT_OFFSET(HinokoFwIsoIrMultipleClass, packets_lost),
+			NULL, NULL,
+			hinoko_sigs_marshal_VOID__UINT_UINT_UINT_UINT,
+			G_TYPE_NONE,
+			4, G_TYPE_UINT, G_TYPE_UINT, G_TYPE_UINT, G_TYPE_UINT);
+
+	g_signal_set_va_marshaller(
+		fw_iso_ir_multiple_sigs[FW_ISO_IR_MULTIPLE_SIG_TYPE_PACKETS_LOST],
+		G_OBJECT_CLASS_TYPE(klass),
+		hinoko_sigs_marshal_VOID__UINT_UINT_UINT_UINTv);
 }
 
 static void hinoko_fw_iso_ir_multiple_init(HinokoFwIsoIrMultiple *self)
@@ -119,6 +237,7 @@ static void hinoko_fw_iso_ir_multiple_init(HinokoFwIsoIrMultiple *self)
 	HinokoFwIsoIrMultiplePrivate *priv = hinoko_fw_iso_ir_multiple_get_instance_private(self);
 
 	fw_iso_ctx_state_init(&priv->state);
+	fw_iso_ir_loss_detector_reset(&priv->loss);
 }
 
 static void fw_iso_ir_multiple_stop(HinokoFwIsoCtx *inst)
@@ -136,7 +255,8 @@ static void fw_iso_ir_multiple_stop(HinokoFwIsoCtx *inst)
 	fw_iso_ctx_state_stop(&priv->state);
 
 	if (priv->state.running != running)
-		g_signal_emit_by_name(G_OBJECT(inst), STOPPED_SIGNAL_NAME, NULL);
+		g_signal_emit_by_name(G_OBJECT(inst), STOPPED_SIGNAL_NAME,
+				      priv->state.stop_error);
 }
 
 static void fw_iso_ir_multiple_unmap_buffer(HinokoFwIsoCtx *inst)
@@ -150,10 +270,11 @@ static void fw_iso_ir_multiple_unmap_buffer(HinokoFwIsoCtx *inst)
 
 	fw_iso_ctx_state_unmap_buffer(&priv->state);
 
-	if (priv->concat_frames != NULL)
-		free(priv->concat_frames);
-
+	priv->ctx_payloads = NULL;
+	priv->tstamp_cycles = NULL;
+	priv->timestamps = NULL;
 	priv->concat_frames = NULL;
+	priv->loss_cycles = NULL;
 }
 
 static void fw_iso_ir_multiple_release(HinokoFwIsoCtx *inst)
@@ -198,9 +319,69 @@ static gboolean fw_iso_ir_multiple_flush_completions(HinokoFwIsoCtx *inst, GErro
 	return fw_iso_ctx_state_flush_completions(&priv->state, error);
 }
 
-static gboolean fw_iso_ir_multiple_register_chunk(HinokoFwIsoIrMultiple *self, GError **error)
+static void fw_iso_ir_multiple_report_loss(gpointer user_data, guint channel, guint cycles,
+					   guint count)
+{
+	g_signal_emit(user_data, fw_iso_ir_multiple_sigs[FW_ISO_IR_MULTIPLE_SIG_TYPE_PACKETS_LOST],
+		      0, channel, cycles / IEEE1394_CYCLES_PER_SEC,
+		      cycles % IEEE1394_CYCLES_PER_SEC, count);
+}
+
+static gint32 fw_iso_ir_multiple_read_tstamp(HinokoFwIsoIrMultiplePrivate *priv, guint offset,
+					     guint length)
+{
+	unsigned int bytes_per_buffer = priv->state.bytes_per_chunk * priv->state.chunks_per_buffer;
+	const guint8 *frames;
+	guint frame_size;
+	guint32 tstamp;
+
+	// The trailing quadlet is aligned to quadlet, thus not split at the end of buffer.
+	offset = (offset + length - 4) % bytes_per_buffer;
+	fw_iso_ctx_state_read_frame(&priv->state, offset, 4, &frames, &frame_size);
+	tstamp = GUINT32_FROM_LE(*(const guint32 *)frames);
+
+	return ohci1394_isoc_desc_tstamp_to_cycles(tstamp);
+}
+
+static void fw_iso_ir_multiple_feed_loss(HinokoFwIsoIrMultiple *self, guint channel)
+{
+	HinokoFwIsoIrMultiplePrivate *priv = hinoko_fw_iso_ir_multiple_get_instance_private(self);
+
+	fw_iso_ir_loss_detector_feed(&priv->loss, channel,
+				     priv->loss_cycles + channel * FW_ISO_IR_LOSS_DETECTOR_BLOCK,
+				     priv->loss_cycle_counts[channel],
+				     fw_iso_ir_multiple_report_loss, self);
+	priv->loss_cycle_counts[channel] = 0;
+}
+
+// The packets for several channels are interleaved in the buffer, thus the cycles are gathered
+// into the block for each channel, then fed to the detector when the block is full or at the end
+// of interrupt event.
+static void fw_iso_ir_multiple_detect_loss(HinokoFwIsoIrMultiple *self, guint32 iso_header,
+					   const gint32 *cycles)
 {
 	HinokoFwIsoIrMultiplePrivate *priv = hinoko_fw_iso_ir_multiple_get_instance_private(self);
+	guint channel = ieee1394_iso_header_to_channel(iso_header);
+	gint32 *block = priv->loss_cycles + channel * FW_ISO_IR_LOSS_DETECTOR_BLOCK;
+
+	block[priv->loss_cycle_counts[channel]++] = *cycles;
+	if (priv->loss_cycle_counts[channel] == FW_ISO_IR_LOSS_DETECTOR_BLOCK)
+		fw_iso_ir_multiple_feed_loss(self, channel);
+}
+
+static void fw_iso_ir_multiple_flush_loss(HinokoFwIsoIrMultiple *self)
+{
+	HinokoFwIsoIrMultiplePrivate *priv = hinoko_fw_iso_ir_multiple_get_instance_private(self);
+	guint channel;
+
+	for (channel = 0; channel <= IEEE1394_MAX_CHANNEL; ++channel) {
+		if (priv->loss_cycle_counts[channel] > 0)
+			fw_iso_ir_multiple_feed_loss(self, channel);
+	}
+}
+
+static gboolean fw_iso_ir_multiple_schedule_irq(HinokoFwIsoIrMultiplePrivate *priv)
+{
 	gboolean schedule_irq = FALSE;
 
 	if (priv->chunks_per_irq > 0) {
@@ -210,8 +391,15 @@ static gboolean fw_iso_ir_multiple_register_chunk(HinokoFwIsoIrMultiple *self, G
 			priv->accumulated_chunk_count %= priv->chunks_per_irq;
 	}
 
-	return fw_iso_ctx_state_register_chunk(&priv->state, FALSE, 0, 0, NULL, 0, 0, schedule_irq,
-					       error);
+	return schedule_irq;
+}
+
+static gboolean fw_iso_ir_multiple_register_chunk(HinokoFwIsoIrMultiple *self, GError **error)
+{
+	HinokoFwIsoIrMultiplePrivate *priv = hinoko_fw_iso_ir_multiple_get_instance_private(self);
+
+	return fw_iso_ctx_state_register_chunk(&priv->state, FALSE, 0, 0, NULL, 0, 0,
+					       fw_iso_ir_multiple_schedule_irq(priv), error);
 }
 
 gboolean fw_iso_ir_multiple_handle_event(HinokoFwIsoCtx *inst, const union fw_cdev_event *event,
@@ -229,6 +417,7 @@ gboolean fw_iso_ir_multiple_handle_event(HinokoFwIsoCtx *inst, const union fw_cd
 	unsigned int chunk_pos;
 	unsigned int chunk_end;
 	struct ctx_payload *ctx_payload;
+	gboolean detect_loss;
 
 	g_return_val_if_fail(HINOKO_IS_FW_ISO_IR_MULTIPLE(inst), FALSE);
 	g_return_val_if_fail(event->common.type == FW_CDEV_EVENT_ISO_INTERRUPT_MULTICHANNEL, FALSE);
@@ -236,6 +425,9 @@ gboolean fw_iso_ir_multiple_handle_event(HinokoFwIsoCtx *inst, const union fw_cd
 	self = HINOKO_FW_ISO_IR_MULTIPLE(inst);
 	priv = hinoko_fw_iso_ir_multiple_get_instance_private(self);
 
+	// The blocks of cycles are allocated only when the detection is enabled at mapping.
+	detect_loss = priv->detect_loss && priv->loss_cycles != NULL;
+
 	ev = &event->iso_interrupt_mc;
 
 	bytes_per_chunk = priv->state.bytes_per_chunk;
@@ -249,6 +441,14 @@ gboolean fw_iso_ir_multiple_handle_event(HinokoFwIsoCtx *inst, const union fw_cd
 	accum_length = 0;
 	ctx_payload = priv->ctx_payloads;
 	priv->ctx_payload_count = 0;
+	priv->timestamp_count = 0;
+
+	// Sample the clocks before any signal emission.
+	if (priv->timestamp_packets && accum_end - priv->prev_offset >= 4) {
+		if (!fw_iso_ir_clock_sample(&priv->clock, &priv->state, error))
+			return FALSE;
+	}
+
 	while (TRUE) {
 		unsigned int avail = accum_end - priv->prev_offset - accum_length;
 		guint offset;
@@ -275,10 +475,19 @@ gboolean fw_iso_ir_multiple_handle_event(HinokoFwIsoCtx *inst, const union fw_cd
 		if (avail < length)
 			break;
 
-		g_debug("%3d: %6d %4d %6d",
+		fw_iso_ctx_debug("%3d: %6d %4d %6d",
 			priv->ctx_payload_count, offset, length,
 			ev->completed);
 
+		if (detect_loss || priv->timestamp_packets) {
+			gint32 *cycles = priv->tstamp_cycles + priv->ctx_payload_count;
+
+			*cycles = fw_iso_ir_multiple_read_tstamp(priv, offset, length);
+
+			if (detect_loss)
+				fw_iso_ir_multiple_detect_loss(self, iso_header, cycles);
+		}
+
 		ctx_payload->offset = offset;
 		ctx_payload->length = length;
 		++ctx_payload;
@@ -288,21 +497,37 @@ gboolean fw_iso_ir_multiple_handle_event(HinokoFwIsoCtx *inst, const union fw_cd
 		accum_length += length;
 	}
 
+	if (detect_loss)
+		fw_iso_ir_multiple_flush_loss(self);
+
+	if (priv->timestamp_packets && priv->ctx_payload_count > 0) {
+		fw_iso_ir_clock_convert(&priv->clock, priv->tstamp_cycles, priv->timestamps,
+					priv->ctx_payload_count);
+		priv->timestamp_count = priv->ctx_payload_count;
+	}
+
+	chunk_pos = priv->prev_offset / bytes_per_chunk;
+	chunk_end = (priv->prev_offset + accum_length) / bytes_per_chunk;
+
+	if (fw_iso_ctx_state_complete_chunks(&priv->state, chunk_end - chunk_pos))
+		g_signal_emit(inst,
+			      fw_iso_ir_multiple_sigs[FW_ISO_IR_MULTIPLE_SIG_TYPE_LOW_HEADROOM], 0,
+			      priv->state.headroom);
+
 	g_signal_emit(self,
 		fw_iso_ir_multiple_sigs[FW_ISO_IR_MULTIPLE_SIG_TYPE_IRQ],
 		0, priv->ctx_payload_count);
 
-	chunk_pos = priv->prev_offset / bytes_per_chunk;
-	chunk_end = (priv->prev_offset + accum_length) / bytes_per_chunk;
+	// The chunks consumed by hardware are always within the room of registration.
 	for (; chunk_pos < chunk_end; ++chunk_pos) {
-		if (!fw_iso_ir_multiple_register_chunk(self, error))
-			return FALSE;
+		fw_iso_ctx_state_register_chunk_ir_multiple(&priv->state,
+							    fw_iso_ir_multiple_schedule_irq(priv));
 	}
 
 	priv->prev_offset += accum_length;
 	priv->prev_offset %= bytes_per_buffer;
 
-	return fw_iso_ctx_state_queue_chunks(&priv->state, error);
+	return fw_iso_ctx_state_queue_chunks_by_policy(&priv->state, TRUE, error);
 }
 
 gboolean fw_iso_ir_multiple_create_source(HinokoFwIsoCtx *inst, GSource **source, GError **error)
@@ -318,6 +543,42 @@ gboolean fw_iso_ir_multiple_create_source(HinokoFwIsoCtx *inst, GSource **source
 					      source, error);
 }
 
+// The chunks over the whole buffer are registered in advance since hardware fills them with
+// packets continuously in buffer-fill mode.
+struct fw_iso_ctx_state *fw_iso_ir_multiple_prepare_start(HinokoFwIsoIrMultiple *self,
+							  guint chunks_per_irq, GError **error)
+{
+	HinokoFwIsoIrMultiplePrivate *priv = hinoko_fw_iso_ir_multiple_get_instance_private(self);
+	guint chunks_per_buffer;
+	int i;
+
+	chunks_per_buffer = priv->state.chunks_per_buffer;
+	g_return_val_if_fail(chunks_per_irq < chunks_per_buffer, NULL);
+
+	priv->chunks_per_irq = chunks_per_irq;
+	priv->accumulated_chunk_count = 0;
+
+	for (i = 0; i < chunks_per_buffer; ++i) {
+		if (!fw_iso_ir_multiple_register_chunk(self, error)) {
+			fw_iso_ctx_state_recycle(&priv->state);
+			return NULL;
+		}
+	}
+
+	priv->prev_offset = 0;
+	fw_iso_ir_loss_detector_reset(&priv->loss);
+	memset(priv->loss_cycle_counts, 0, sizeof(priv->loss_cycle_counts));
+
+	return &priv->state;
+}
+
+struct fw_iso_ctx_state *fw_iso_ir_multiple_get_state(HinokoFwIsoIrMultiple *self)
+{
+	HinokoFwIsoIrMultiplePrivate *priv = hinoko_fw_iso_ir_multiple_get_instance_private(self);
+
+	return &priv->state;
+}
+
 static void fw_iso_ctx_iface_init(HinokoFwIsoCtxInterface *iface)
 {
 	iface->stop = fw_iso_ir_multiple_stop;
@@ -380,7 +641,7 @@ gboolean hinoko_fw_iso_ir_multiple_allocate(HinokoFwIsoIrMultiple *self, const c
 		return FALSE;
 
 	set.handle = priv->state.handle;
-	if (ioctl(priv->state.fd, FW_CDEV_IOC_SET_ISO_CHANNELS, &set) < 0) {
+	if (!priv->state.offline && ioctl(priv->state.fd, FW_CDEV_IOC_SET_ISO_CHANNELS, &set) < 0) {
 		generate_fw_iso_ctx_error_ioctl(error, errno, FW_CDEV_IOC_SET_ISO_CHANNELS);
 		hinoko_fw_iso_ctx_release(HINOKO_FW_ISO_CTX(self));
 		return FALSE;
@@ -413,6 +674,12 @@ gboolean hinoko_fw_iso_ir_multiple_map_buffer(HinokoFwIsoIrMultiple *self, guint
 					      guint chunks_per_buffer, GError **error)
 {
 	HinokoFwIsoIrMultiplePrivate *priv;
+	guint payload_count;
+	gsize payloads_size;
+	gsize cycles_size;
+	gsize timestamps_size;
+	gsize loss_size;
+	gsize frames_size;
 
 	g_return_val_if_fail(HINOKO_IS_FW_ISO_IR_MULTIPLE(self), FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
@@ -423,16 +690,34 @@ gboolean hinoko_fw_iso_ir_multiple_map_buffer(HinokoFwIsoIrMultiple *self, guint
 	bytes_per_chunk = (bytes_per_chunk + 3) / 4;
 	bytes_per_chunk *= 4;
 
-	priv->concat_frames = g_malloc_n(4, bytes_per_chunk);
+	// The arrays of payload index, cycles and system time for the timestamp of each packet, the
+	// blocks of cycles per channel for loss detection, and the area to concatenate frames.
+	payload_count = bytes_per_chunk * chunks_per_buffer / 8 / 2;
+	payloads_size = CACHELINE_ALIGN(payload_count * sizeof(*priv->ctx_payloads));
+	cycles_size = CACHELINE_ALIGN(payload_count * sizeof(*priv->tstamp_cycles));
+	timestamps_size = CACHELINE_ALIGN(payload_count * sizeof(*priv->timestamps));
+	loss_size = 0;
+	if (priv->detect_loss) {
+		loss_size = (IEEE1394_MAX_CHANNEL + 1) * FW_ISO_IR_LOSS_DETECTOR_BLOCK;
+		loss_size = CACHELINE_ALIGN(loss_size * sizeof(*priv->loss_cycles));
+	}
+	frames_size = 4 * bytes_per_chunk;
 
-	if (!fw_iso_ctx_state_map_buffer(&priv->state, bytes_per_chunk, chunks_per_buffer, error))
+	if (!fw_iso_ctx_state_map_buffer(&priv->state, bytes_per_chunk, chunks_per_buffer,
+					 payloads_size + cycles_size + timestamps_size + loss_size +
+					 frames_size, error))
 		return FALSE;
 
-	bytes_per_chunk = priv->state.bytes_per_chunk;
-	chunks_per_buffer = priv->state.chunks_per_buffer;
-
-	priv->ctx_payloads = g_malloc_n(bytes_per_chunk * chunks_per_buffer / 8 / 2,
-					sizeof(*priv->ctx_payloads));
+	priv->ctx_payloads = (struct ctx_payload *)priv->state.private_area;
+	priv->tstamp_cycles = (gint32 *)(priv->state.private_area + payloads_size);
+	priv->timestamps = (gint64 *)(priv->state.private_area + payloads_size + cycles_size);
+	priv->loss_cycles = NULL;
+	if (loss_size > 0) {
+		priv->loss_cycles = (gint32 *)(priv->state.private_area + payloads_size +
+					       cycles_size + timestamps_size);
+	}
+	priv->concat_frames = priv->state.private_area + payloads_size + cycles_size +
+			      timestamps_size + loss_size;
 
 	return TRUE;
 }
@@ -457,9 +742,7 @@ gboolean hinoko_fw_iso_ir_multiple_start(HinokoFwIsoIrMultiple *self, const guin
 					 guint32 sync_code, HinokoFwIsoCtxMatchFlag tags,
 					 guint chunks_per_irq, GError **error)
 {
-	HinokoFwIsoIrMultiplePrivate *priv;
-	guint chunks_per_buffer;
-	int i;
+	struct fw_iso_ctx_state *state;
 
 	g_return_val_if_fail(HINOKO_IS_FW_ISO_IR_MULTIPLE(self), FALSE);
 	g_return_val_if_fail(cycle_match == NULL ||
@@ -469,21 +752,69 @@ gboolean hinoko_fw_iso_ir_multiple_start(HinokoFwIsoIrMultiple *self, const guin
 	g_return_val_if_fail(sync_code <= IEEE1394_MAX_SYNC_CODE, FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
-	priv = hinoko_fw_iso_ir_multiple_get_instance_private(self);
+	state = fw_iso_ir_multiple_prepare_start(self, chunks_per_irq, error);
+	if (state == NULL)
+		return FALSE;
 
-	chunks_per_buffer = priv->state.chunks_per_buffer;
-	g_return_val_if_fail(chunks_per_irq < chunks_per_buffer, FALSE);
+	// The chunks registered over the whole buffer are dropped for retry.
+	if (!fw_iso_ctx_state_start(state, cycle_match, sync_code, tags, error)) {
+		fw_iso_ctx_state_recycle(state);
+		return FALSE;
+	}
 
-	priv->chunks_per_irq = chunks_per_irq;
-	priv->accumulated_chunk_count = 0;
+	return TRUE;
+}
 
-	for (i = 0; i < chunks_per_buffer; ++i) {
-		if (!fw_iso_ir_multiple_register_chunk(self, error))
-			return FALSE;
+/**
+ * hinoko_fw_iso_ir_multiple_start_at:
+ * @self: A [class@FwIsoIrMultiple].
+ * @clock_id: The numeric ID of clock source for the deadline. Either CLOCK_MONOTONIC(1) or
+ *	      CLOCK_MONOTONIC_RAW(4) is available.
+ * @deadline_ns: The time in nanoseconds of the clock source to start the context.
+ * @sync_code: The value of sy field in isochronous packet header for packet processing, up to 15.
+ * @tags: The value of tag field in isochronous header for packet processing.
+ * @chunks_per_irq: The number of chunks per interval of interrupt. When 0 is given, application
+ *		    should call [method@FwIsoCtx.flush_completions] voluntarily to generate
+ *		    [signal@FwIsoIrMultiple::interrupted] event.
+ * @cycle_match: (array fixed-size=2) (out caller-allocates): The isochronous cycle chosen to start
+ *		 packet processing. The first element is the second part of isochronous cycle, up
+ *		 to 3. The second element is the cycle part of isochronous cycle, up to 7999.
+ * @error: A [struct@GLib.Error].
+ *
+ * Start IR context at the deadline instead of the isochronous cycle. The deadline is converted to
+ * the isochronous cycle which begins at the deadline or just after it, by the pair of cycle time
+ * and system time sampled at once. The isochronous cycle should be within 4 seconds from the
+ * current one due to the two bits of second part for cycle match, otherwise
+ * [error@FwIsoCtxError.OUT_OF_WINDOW] is reported. The deadline in the past is reported as well.
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_ir_multiple_start_at(HinokoFwIsoIrMultiple *self, gint clock_id,
+					    gint64 deadline_ns, guint32 sync_code,
+					    HinokoFwIsoCtxMatchFlag tags, guint chunks_per_irq,
+					    guint16 cycle_match[2], GError **error)
+{
+	struct fw_iso_ctx_state *state;
+
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_IR_MULTIPLE(self), FALSE);
+	g_return_val_if_fail(sync_code <= IEEE1394_MAX_SYNC_CODE, FALSE);
+	g_return_val_if_fail(cycle_match != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	state = fw_iso_ir_multiple_prepare_start(self, chunks_per_irq, error);
+	if (state == NULL)
+		return FALSE;
+
+	// The chunks registered over the whole buffer are dropped for retry.
+	if (!fw_iso_ctx_state_start_at(state, clock_id, deadline_ns, sync_code, tags, cycle_match,
+				       error)) {
+		fw_iso_ctx_state_recycle(state);
+		return FALSE;
 	}
 
-	priv->prev_offset = 0;
-	return fw_iso_ctx_state_start(&priv->state, cycle_match, sync_code, tags, error);
+	return TRUE;
 }
 
 /**
@@ -530,3 +861,62 @@ void hinoko_fw_iso_ir_multiple_get_payload(HinokoFwIsoIrMultiple *self, guint in
 
 	*length = ctx_payload->length;
 }
+
+/**
+ * hinoko_fw_iso_ir_multiple_get_timestamps:
+ * @self: A [class@FwIsoIrMultiple].
+ * @timestamps: (array length=count) (out) (transfer none): The system time in nanoseconds of
+ *		CLOCK_MONOTONIC at the beginning of isochronous cycle for each handled packet, in
+ *		the same order as the index for [method@FwIsoIrMultiple.get_payload].
+ * @count: The number of elements in @timestamps.
+ *
+ * Retrieve system time of packets handled at the event of interrupt. The timestamps are available
+ * when [property@FwIsoIrMultiple:timestamp-packets] is enabled, otherwise @count is zero.
+ *
+ * Since: 1.1
+ */
+void hinoko_fw_iso_ir_multiple_get_timestamps(HinokoFwIsoIrMultiple *self,
+					      const gint64 **timestamps, guint *count)
+{
+	HinokoFwIsoIrMultiplePrivate *priv;
+
+	g_return_if_fail(HINOKO_IS_FW_ISO_IR_MULTIPLE(self));
+	g_return_if_fail(timestamps != NULL);
+	g_return_if_fail(count != NULL);
+
+	priv = hinoko_fw_iso_ir_multiple_get_instance_private(self);
+
+	*timestamps = priv->timestamps;
+	*count = priv->timestamp_count;
+}
+
+/**
+ * hinoko_fw_iso_ir_multiple_get_loss_counters:
+ * @self: A [class@FwIsoIrMultiple].
+ * @channel: The isochronous channel, up to 63.
+ * @lost: (out): The number of packets lost.
+ * @duplicated: (out): The number of packets received for the same isochronous cycle as the
+ *		previous packet.
+ * @reordered: (out): The number of packets received after the packet for newer isochronous
+ *	       cycle.
+ *
+ * Retrieve the counters of detection enabled by
+ * [property@FwIsoIrMultiple:detect-packet-loss] for the channel since the context starts.
+ *
+ * Since: 1.1
+ */
+void hinoko_fw_iso_ir_multiple_get_loss_counters(HinokoFwIsoIrMultiple *self, guint channel,
+						 guint *lost, guint *duplicated, guint *reordered)
+{
+	HinokoFwIsoIrMultiplePrivate *priv;
+
+	g_return_if_fail(HINOKO_IS_FW_ISO_IR_MULTIPLE(self));
+	g_return_if_fail(channel <= IEEE1394_MAX_CHANNEL);
+	g_return_if_fail(lost != NULL);
+	g_return_if_fail(duplicated != NULL);
+	g_return_if_fail(reordered != NULL);
+
+	priv = hinoko_fw_iso_ir_multiple_get_instance_private(self);
+
+	fw_iso_ir_loss_detector_get_counters(&priv->loss, channel, lost, duplicated, reordered);
+}
@@ -22,6 +22,21 @@ struct _HinokoFwIsoIrMultipleClass {
 	 * Class closure for the [signal@FwIsoIrMultiple::interrupted].
 	 */
 	void (*interrupted)(HinokoFwIsoIrMultiple *self, guint count);
+
+	/**
+	 * HinokoFwIsoIrMultipleClass::packets_lost:
+	 * @self: A [class@FwIsoIrMultiple].
+	 * @channel: The isochronous channel in which packets are lost.
+	 * @sec: The sec part of isochronous cycle for the packet after the loss, up to 7.
+	 * @cycle: The cycle part of isochronous cycle for the packet after the loss, up to 7999.
+	 * @count: The number of lost packets.
+	 *
+	 * Class closure for the [signal@FwIsoIrMultiple::packets-lost] signal.
+	 *
+	 * Since: 1.1
+	 */
+	void (*packets_lost)(HinokoFwIsoIrMultiple *self, guint channel, guint sec, guint cycle,
+			     guint count);
 };
 
 HinokoFwIsoIrMultiple *hinoko_fw_iso_ir_multiple_new(void);
@@ -37,9 +52,21 @@ gboolean hinoko_fw_iso_ir_multiple_start(HinokoFwIsoIrMultiple *self, const guin
 					 guint32 sync_code, HinokoFwIsoCtxMatchFlag tags,
 					 guint chunks_per_irq, GError **error);
 
+gboolean hinoko_fw_iso_ir_multiple_start_at(HinokoFwIsoIrMultiple *self, gint clock_id,
+					    gint64 deadline_ns, guint32 sync_code,
+					    HinokoFwIsoCtxMatchFlag tags, guint chunks_per_irq,
+					    guint16 cycle_match[2], GError **error);
+
 void hinoko_fw_iso_ir_multiple_get_payload(HinokoFwIsoIrMultiple *self, guint index,
 					   const guint8 **payload, guint *length);
 
+void hinoko_fw_iso_ir_multiple_get_timestamps(HinokoFwIsoIrMultiple *self,
+					      const gint64 **timestamps, guint *count);
+
+void hinoko_fw_iso_ir_multiple_get_loss_counters(HinokoFwIsoIrMultiple *self, guint channel,
+						 guint *lost, guint *duplicated,
+						 guint *reordered);
+
 G_END_DECLS
 
 #endif
@@ -17,6 +17,17 @@ typedef struct {
 	guint chunk_cursor;
 
 	const struct fw_cdev_event_iso_interrupt *ev;
+
+	gboolean detect_loss;
+	struct fw_iso_ir_loss_detector loss;
+
+	gboolean timestamp_packets;
+	struct fw_iso_ir_clock clock;
+	guint timestamp_count;
+
+	// In private area of the arena.
+	gint32 *tstamp_cycles;
+	gint64 *timestamps;
 } HinokoFwIsoIrSinglePrivate;
 
 static void fw_iso_ctx_iface_init(HinokoFwIsoCtxInterface *iface);
@@ -25,8 +36,16 @@ G_DEFINE_TYPE_WITH_CODE(HinokoFwIsoIrSingle, hinoko_fw_iso_ir_single, G_TYPE_OBJ
 			G_ADD_PRIVATE(HinokoFwIsoIrSingle)
 			G_IMPLEMENT_INTERFACE(HINOKO_TYPE_FW_ISO_CTX, fw_iso_ctx_iface_init))
 
+enum fw_iso_ir_single_prop_type {
+	FW_ISO_IR_SINGLE_PROP_TYPE_DETECT_PACKET_LOSS = FW_ISO_CTX_PROP_TYPE_COUNT,
+	FW_ISO_IR_SINGLE_PROP_TYPE_TIMESTAMP_PACKETS,
+	FW_ISO_IR_SINGLE_PROP_TYPE_COUNT,
+};
+
 enum fw_iso_ir_single_sig_type {
 	FW_ISO_IR_SINGLE_SIG_TYPE_IRQ = 1,
+	FW_ISO_IR_SINGLE_SIG_TYPE_PACKETS_LOST,
+	FW_ISO_IR_SINGLE_SIG_TYPE_LOW_HEADROOM,
 	FW_ISO_IR_SINGLE_SIG_TYPE_COUNT,
 };
 static guint fw_iso_ir_single_sigs[FW_ISO_IR_SINGLE_SIG_TYPE_COUNT] = { 0 };
@@ -36,7 +55,36 @@ static void fw_iso_ir_single_get_property(GObject *obj, guint id, GValue *val, G
 	HinokoFwIsoIrSingle *self = HINOKO_FW_ISO_IR_SINGLE(obj);
 	HinokoFwIsoIrSinglePrivate *priv = hinoko_fw_iso_ir_single_get_instance_private(self);
 
-	fw_iso_ctx_state_get_property(&priv->state, obj, id, val, spec);
+	switch (id) {
+	case FW_ISO_IR_SINGLE_PROP_TYPE_DETECT_PACKET_LOSS:
+		g_value_set_boolean(val, priv->detect_loss);
+		break;
+	case FW_ISO_IR_SINGLE_PROP_TYPE_TIMESTAMP_PACKETS:
+		g_value_set_boolean(val, priv->timestamp_packets);
+		break;
+	default:
+		fw_iso_ctx_state_get_property(&priv->state, obj, id, val, spec);
+		break;
+	}
+}
+
+static void fw_iso_ir_single_set_property(GObject *obj, guint id, const GValue *val,
+					  GParamSpec *spec)
+{
+	HinokoFwIsoIrSingle *self = HINOKO_FW_ISO_IR_SINGLE(obj);
+	HinokoFwIsoIrSinglePrivate *priv = hinoko_fw_iso_ir_single_get_instance_private(self);
+
+	switch (id) {
+	case FW_ISO_IR_SINGLE_PROP_TYPE_DETECT_PACKET_LOSS:
+		priv->detect_loss = g_value_get_boolean(val);
+		break;
+	case FW_ISO_IR_SINGLE_PROP_TYPE_TIMESTAMP_PACKETS:
+		priv->timestamp_packets = g_value_get_boolean(val);
+		break;
+	default:
+		fw_iso_ctx_state_set_property(&priv->state, obj, id, val, spec);
+		break;
+	}
 }
 
 static void fw_iso_ir_single_finalize(GObject *obj)
@@ -51,10 +99,51 @@ static void hinoko_fw_iso_ir_single_class_init(HinokoFwIsoIrSingleClass *klass)
 	GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
 
 	gobject_class->get_property = fw_iso_ir_single_get_property;
+	gobject_class->set_property = fw_iso_ir_single_set_property;
 	gobject_class->finalize = fw_iso_ir_single_finalize;
 
 	fw_iso_ctx_class_override_properties(gobject_class);
 
+	fw_iso_ir_single_sigs[FW_ISO_IR_SINGLE_SIG_TYPE_LOW_HEADROOM] =
+		fw_iso_ctx_class_lookup_low_headroom();
+
+	/**
+	 * HinokoFwIsoIrSingle:detect-packet-loss:
+	 *
+	 * Whether to detect gap, duplication, and reordering of isochronous cycles for received
+	 * packets in each channel by their timestamps. The detection requires context header at
+	 * least 8 bytes to include timestamp. It is assumed that each channel conveys one packet
+	 * per isochronous cycle. The gap is notified by [signal@FwIsoIrSingle::packets-lost]. The
+	 * counters are available by [method@FwIsoIrSingle.get_loss_counters].
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class,
+					FW_ISO_IR_SINGLE_PROP_TYPE_DETECT_PACKET_LOSS,
+		g_param_spec_boolean("detect-packet-loss", "detect-packet-loss",
+				     "Whether to detect loss of packets",
+				     FALSE,
+				     G_PARAM_READWRITE));
+
+	/**
+	 * HinokoFwIsoIrSingle:timestamp-packets:
+	 *
+	 * Whether to convert timestamp of each received packet to system time in CLOCK_MONOTONIC.
+	 * The conversion requires context header at least 8 bytes to include timestamp. The pair of
+	 * cycle time and system time is sampled once per interrupt event, then the timestamps of
+	 * all packets in the event are converted in batch. The result is available by
+	 * [method@FwIsoIrSingle.get_timestamps] in the handler of
+	 * [signal@FwIsoIrSingle::interrupted].
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class,
+					FW_ISO_IR_SINGLE_PROP_TYPE_TIMESTAMP_PACKETS,
+		g_param_spec_boolean("timestamp-packets", "timestamp-packets",
+				     "Whether to convert timestamp of packets to system time",
+				     FALSE,
+				     G_PARAM_READWRITE));
+
 	/**
 	 * HinokoFwIsoIrSingle::interrupted:
 	 * @self: A [class@FwIsoIrSingle]
@@ -88,6 +177,39 @@ static void hinoko_fw_iso_ir_single_class_init(HinokoFwIsoIrSingleClass *klass)
 			G_TYPE_NONE,
 			5, G_TYPE_UINT, G_TYPE_UINT, G_TYPE_POINTER,
 			G_TYPE_UINT, G_TYPE_UINT);
+
+	// Collect arguments of the signal without GValue in the path of interrupt event.
+	g_signal_set_va_marshaller(fw_iso_ir_single_sigs[FW_ISO_IR_SINGLE_SIG_TYPE_IRQ],
+				   G_OBJECT_CLASS_TYPE(klass),
+				   hinoko_sigs_marshal_VOID__UINT_UINT_POINTER_UINT_UINTv);
+
+	/**
+	 * HinokoFwIsoIrSingle::packets-lost:
+	 * @self: A [class@FwIsoIrSingle].
+	 * @channel: The isochronous channel in which packets are lost.
+	 * @sec: The sec part of isochronous cycle for the packet after the loss, up to 7.
+	 * @cycle: The cycle part of isochronous cycle for the packet after the loss, up to 7999.
+	 * @count: The number of lost packets.
+	 *
+	 * Emitted when the gap of isochronous cycles is detected in received packets, before
+	 * [signal@FwIsoIrSingle::interrupted] in the same interrupt event. The signal is
+	 * available when [property@FwIsoIrSingle:detect-packet-loss] is enabled.
+	 *
+	 * Since: 1.1
+	 */
+	fw_iso_ir_single_sigs[FW_ISO_IR_SINGLE_SIG_TYPE_PACKETS_LOST] =
+		g_signal_new("packets-lost",
+			G_OBJECT_CLASS_TYPE(klass),
+			G_SIGNAL_RUN_LAST,
+			G_STRUCT_OFFSET(HinokoFwIsoIrSingleClass, packets_lost),
+			NULL, NULL,
+			hinoko_sigs_marshal_VOID__UINT_UINT_UINT_UINT,
+			G_TYPE_NONE,
+			4, G_TYPE_UINT, G_TYPE_UINT, G_TYPE_UINT, G_TYPE_UINT);
+
+	g_signal_set_va_marshaller(fw_iso_ir_single_sigs[FW_ISO_IR_SINGLE_SIG_TYPE_PACKETS_LOST],
+				   G_OBJECT_CLASS_TYPE(klass),
+				   hinoko_sigs_marshal_VOID__UINT_UINT_UINT_UINTv);
 }
 
 static void hinoko_fw_iso_ir_single_init(HinokoFwIsoIrSingle *self)
@@ -95,6 +217,7 @@ static void hinoko_fw_iso_ir_single_init(HinokoFwIsoIrSingle *self)
 	HinokoFwIsoIrSinglePrivate *priv = hinoko_fw_iso_ir_single_get_instance_private(self);
 
 	fw_iso_ctx_state_init(&priv->state);
+	fw_iso_ir_loss_detector_reset(&priv->loss);
 }
 
 static void fw_iso_ir_single_stop(HinokoFwIsoCtx *inst)
@@ -112,7 +235,8 @@ static void fw_iso_ir_single_stop(HinokoFwIsoCtx *inst)
 	fw_iso_ctx_state_stop(&priv->state);
 
 	if (priv->state.running != running)
-		g_signal_emit_by_name(G_OBJECT(inst), STOPPED_SIGNAL_NAME, NULL);
+		g_signal_emit_by_name(G_OBJECT(inst), STOPPED_SIGNAL_NAME,
+				      priv->state.stop_error);
 }
 
 static void fw_iso_ir_single_unmap_buffer(HinokoFwIsoCtx *inst)
@@ -127,6 +251,35 @@ static void fw_iso_ir_single_unmap_buffer(HinokoFwIsoCtx *inst)
 	fw_iso_ctx_state_unmap_buffer(&priv->state);
 }
 
+gboolean fw_iso_ir_single_recycle(HinokoFwIsoIrSingle *self)
+{
+	HinokoFwIsoIrSinglePrivate *priv;
+
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_IR_SINGLE(self), FALSE);
+	priv = hinoko_fw_iso_ir_single_get_instance_private(self);
+
+	priv->chunk_cursor = 0;
+
+	return fw_iso_ctx_state_recycle(&priv->state);
+}
+
+struct fw_iso_ctx_state *fw_iso_ir_single_prepare_start(HinokoFwIsoIrSingle *self)
+{
+	HinokoFwIsoIrSinglePrivate *priv = hinoko_fw_iso_ir_single_get_instance_private(self);
+
+	priv->chunk_cursor = 0;
+	fw_iso_ir_loss_detector_reset(&priv->loss);
+
+	return &priv->state;
+}
+
+struct fw_iso_ctx_state *fw_iso_ir_single_get_state(HinokoFwIsoIrSingle *self)
+{
+	HinokoFwIsoIrSinglePrivate *priv = hinoko_fw_iso_ir_single_get_instance_private(self);
+
+	return &priv->state;
+}
+
 static void fw_iso_ir_single_release(HinokoFwIsoCtx *inst)
 {
 	HinokoFwIsoIrSingle *self;
@@ -165,6 +318,46 @@ static gboolean fw_iso_ir_single_flush_completions(HinokoFwIsoCtx *inst, GError
 	return fw_iso_ctx_state_flush_completions(&priv->state, error);
 }
 
+static void fw_iso_ir_single_report_loss(gpointer user_data, guint channel, guint cycles,
+					 guint count)
+{
+	g_signal_emit(user_data, fw_iso_ir_single_sigs[FW_ISO_IR_SINGLE_SIG_TYPE_PACKETS_LOST], 0,
+		      channel, cycles / IEEE1394_CYCLES_PER_SEC, cycles % IEEE1394_CYCLES_PER_SEC,
+		      count);
+}
+
+// The context header for each packet includes isochronous packet header in the first quadlet, and
+// timestamp in the second quadlet.
+static void fw_iso_ir_single_read_tstamps(HinokoFwIsoIrSinglePrivate *priv,
+					  const struct fw_cdev_event_iso_interrupt *ev, guint count)
+{
+	guint quadlets_per_header = priv->header_size / 4;
+	guint i;
+
+	for (i = 0; i < count; ++i) {
+		guint32 tstamp = GUINT32_FROM_BE(ev->header[i * quadlets_per_header + 1]);
+
+		priv->tstamp_cycles[i] = ohci1394_isoc_desc_tstamp_to_cycles(tstamp);
+	}
+}
+
+static void fw_iso_ir_single_detect_loss(HinokoFwIsoIrSingle *self,
+					 const struct fw_cdev_event_iso_interrupt *ev, guint count)
+{
+	HinokoFwIsoIrSinglePrivate *priv = hinoko_fw_iso_ir_single_get_instance_private(self);
+	guint channel;
+	guint i;
+
+	channel = ieee1394_iso_header_to_channel(GUINT32_FROM_BE(ev->header[0]));
+
+	for (i = 0; i < count; i += FW_ISO_IR_LOSS_DETECTOR_BLOCK) {
+		guint length = MIN(count - i, FW_ISO_IR_LOSS_DETECTOR_BLOCK);
+
+		fw_iso_ir_loss_detector_feed(&priv->loss, channel, priv->tstamp_cycles + i, length,
+					     fw_iso_ir_single_report_loss, self);
+	}
+}
+
 gboolean fw_iso_ir_single_handle_event(HinokoFwIsoCtx *inst, const union fw_cdev_event *event,
 				       GError **error)
 {
@@ -187,6 +380,31 @@ gboolean fw_iso_ir_single_handle_event(HinokoFwIsoCtx *inst, const union fw_cdev
 	cycle = ohci1394_isoc_desc_tstamp_to_cycle(ev->cycle);
 	count = ev->header_length / priv->header_size;
 
+	priv->timestamp_count = 0;
+
+	if ((priv->detect_loss || priv->timestamp_packets) && priv->header_size >= 8 && count > 0) {
+		guint length = MIN(count, priv->state.chunks_per_buffer);
+
+		fw_iso_ir_single_read_tstamps(priv, ev, length);
+
+		// Sample the clocks before any signal emission.
+		if (priv->timestamp_packets) {
+			if (!fw_iso_ir_clock_sample(&priv->clock, &priv->state, error))
+				return FALSE;
+			fw_iso_ir_clock_convert(&priv->clock, priv->tstamp_cycles, priv->timestamps,
+						length);
+			priv->timestamp_count = length;
+		}
+
+		if (priv->detect_loss)
+			fw_iso_ir_single_detect_loss(self, ev, length);
+	}
+
+	if (fw_iso_ctx_state_complete_chunks(&priv->state, count))
+		g_signal_emit(inst,
+			      fw_iso_ir_single_sigs[FW_ISO_IR_SINGLE_SIG_TYPE_LOW_HEADROOM], 0,
+			      priv->state.headroom);
+
 	// TODO; handling error?
 	priv->ev = ev;
 	g_signal_emit(self, fw_iso_ir_single_sigs[FW_ISO_IR_SINGLE_SIG_TYPE_IRQ], 0,
@@ -197,7 +415,7 @@ gboolean fw_iso_ir_single_handle_event(HinokoFwIsoCtx *inst, const union fw_cdev
 	if (priv->chunk_cursor >= G_MAXINT)
 		priv->chunk_cursor %= priv->state.chunks_per_buffer;
 
-	return fw_iso_ctx_state_queue_chunks(&priv->state, error);
+	return fw_iso_ctx_state_queue_chunks_by_policy(&priv->state, TRUE, error);
 }
 
 gboolean fw_iso_ir_single_create_source(HinokoFwIsoCtx *inst, GSource **source, GError **error)
@@ -296,14 +514,26 @@ gboolean hinoko_fw_iso_ir_single_map_buffer(HinokoFwIsoIrSingle *self,
 					    guint payloads_per_buffer, GError **error)
 {
 	HinokoFwIsoIrSinglePrivate *priv;
+	gsize cycles_size;
+	gsize timestamps_size;
 
 	g_return_val_if_fail(HINOKO_IS_FW_ISO_IR_SINGLE(self), FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
 	priv = hinoko_fw_iso_ir_single_get_instance_private(self);
 
-	return fw_iso_ctx_state_map_buffer(&priv->state, maximum_bytes_per_payload,
-					   payloads_per_buffer, error);
+	// The arrays of cycles and system time for the timestamp of each packet.
+	cycles_size = CACHELINE_ALIGN(payloads_per_buffer * sizeof(*priv->tstamp_cycles));
+	timestamps_size = payloads_per_buffer * sizeof(*priv->timestamps);
+
+	if (!fw_iso_ctx_state_map_buffer(&priv->state, maximum_bytes_per_payload,
+					 payloads_per_buffer, cycles_size + timestamps_size, error))
+		return FALSE;
+
+	priv->tstamp_cycles = (gint32 *)priv->state.private_area;
+	priv->timestamps = (gint64 *)(priv->state.private_area + cycles_size);
+
+	return TRUE;
 }
 
 /**
@@ -314,7 +544,8 @@ gboolean hinoko_fw_iso_ir_single_map_buffer(HinokoFwIsoIrSingle *self,
  *
  * Register chunk of buffer to process packet for future isochronous cycle. The caller can schedule
  * hardware interrupt to generate interrupt event. In detail, please refer to documentation about
- * [signal@FwIsoIrSingle::interrupted] signal.
+ * [signal@FwIsoIrSingle::interrupted] signal. While the context is running, the chunk is queued to
+ * hardware according to [property@FwIsoCtx:queue-policy].
  *
  * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
  *
@@ -328,8 +559,11 @@ gboolean hinoko_fw_iso_ir_single_register_packet(HinokoFwIsoIrSingle *self,
 	g_return_val_if_fail(HINOKO_IS_FW_ISO_IR_SINGLE(self), FALSE);
 	priv = hinoko_fw_iso_ir_single_get_instance_private(self);
 
-	return fw_iso_ctx_state_register_chunk(&priv->state, FALSE, 0, 0, NULL, 0, 0,
-					       schedule_interrupt, error);
+	if (!fw_iso_ctx_state_register_chunk(&priv->state, FALSE, 0, 0, NULL, 0, 0,
+					     schedule_interrupt, error))
+		return FALSE;
+
+	return fw_iso_ctx_state_queue_chunks_by_policy(&priv->state, FALSE, error);
 }
 
 /**
@@ -352,8 +586,6 @@ gboolean hinoko_fw_iso_ir_single_register_packet(HinokoFwIsoIrSingle *self,
 gboolean hinoko_fw_iso_ir_single_start(HinokoFwIsoIrSingle *self, const guint16 *cycle_match,
 				       guint32 sync_code, HinokoFwIsoCtxMatchFlag tags, GError **error)
 {
-	HinokoFwIsoIrSinglePrivate *priv;
-
 	g_return_val_if_fail(HINOKO_IS_FW_ISO_IR_SINGLE(self), FALSE);
 	g_return_val_if_fail(cycle_match == NULL ||
 			     cycle_match[0] <= OHCI1394_IR_contextMatch_cycleMatch_MAX_SEC ||
@@ -362,11 +594,45 @@ gboolean hinoko_fw_iso_ir_single_start(HinokoFwIsoIrSingle *self, const guint16
 	g_return_val_if_fail(sync_code <= IEEE1394_MAX_SYNC_CODE, FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
-	priv = hinoko_fw_iso_ir_single_get_instance_private(self);
+	return fw_iso_ctx_state_start(fw_iso_ir_single_prepare_start(self), cycle_match, sync_code,
+				      tags, error);
+}
 
-	priv->chunk_cursor = 0;
+/**
+ * hinoko_fw_iso_ir_single_start_at:
+ * @self: A [class@FwIsoIrSingle].
+ * @clock_id: The numeric ID of clock source for the deadline. Either CLOCK_MONOTONIC(1) or
+ *	      CLOCK_MONOTONIC_RAW(4) is available.
+ * @deadline_ns: The time in nanoseconds of the clock source to start the context.
+ * @sync_code: The value of sy field in isochronous packet header for packet processing, up to 15.
+ * @tags: The value of tag field in isochronous header for packet processing.
+ * @cycle_match: (array fixed-size=2) (out caller-allocates): The isochronous cycle chosen to start
+ *		 packet processing. The first element is the second part of isochronous cycle, up
+ *		 to 3. The second element is the cycle part of isochronous cycle, up to 7999.
+ * @error: A [struct@GLib.Error].
+ *
+ * Start IR context at the deadline instead of the isochronous cycle. The deadline is converted to
+ * the isochronous cycle which begins at the deadline or just after it, by the pair of cycle time
+ * and system time sampled at once. The isochronous cycle should be within 4 seconds from the
+ * current one due to the two bits of second part for cycle match, otherwise
+ * [error@FwIsoCtxError.OUT_OF_WINDOW] is reported. The deadline in the past is reported as well.
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_ir_single_start_at(HinokoFwIsoIrSingle *self, gint clock_id,
+					  gint64 deadline_ns, guint32 sync_code,
+					  HinokoFwIsoCtxMatchFlag tags, guint16 cycle_match[2],
+					  GError **error)
+{
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_IR_SINGLE(self), FALSE);
+	g_return_val_if_fail(sync_code <= IEEE1394_MAX_SYNC_CODE, FALSE);
+	g_return_val_if_fail(cycle_match != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
-	return fw_iso_ctx_state_start(&priv->state, cycle_match, sync_code, tags, error);
+	return fw_iso_ctx_state_start_at(fw_iso_ir_single_prepare_start(self), clock_id,
+					 deadline_ns, sync_code, tags, cycle_match, error);
 }
 
 /**
@@ -416,3 +682,64 @@ void hinoko_fw_iso_ir_single_get_payload(HinokoFwIsoIrSingle *self, guint index,
 	fw_iso_ctx_state_read_frame(&priv->state, offset, *length, payload, &frame_size);
 	g_return_if_fail(frame_size == *length);
 }
+
+/**
+ * hinoko_fw_iso_ir_single_get_timestamps:
+ * @self: A [class@FwIsoIrSingle].
+ * @timestamps: (array length=count) (out) (transfer none): The system time in nanoseconds of
+ *		CLOCK_MONOTONIC at the beginning of isochronous cycle for each handled packet, in
+ *		the same order as the index for [method@FwIsoIrSingle.get_payload].
+ * @count: The number of elements in @timestamps.
+ *
+ * Retrieve system time of packets handled at the event of interrupt. The timestamps are available
+ * when [property@FwIsoIrSingle:timestamp-packets] is enabled, otherwise @count is zero.
+ *
+ * Since: 1.1
+ */
+void hinoko_fw_iso_ir_single_get_timestamps(HinokoFwIsoIrSingle *self, const gint64 **timestamps,
+					    guint *count)
+{
+	HinokoFwIsoIrSinglePrivate *priv;
+
+	g_return_if_fail(HINOKO_IS_FW_ISO_IR_SINGLE(self));
+	g_return_if_fail(timestamps != NULL);
+	g_return_if_fail(count != NULL);
+
+	priv = hinoko_fw_iso_ir_single_get_instance_private(self);
+
+	g_return_if_fail(priv->ev != NULL);
+
+	*timestamps = priv->timestamps;
+	*count = priv->timestamp_count;
+}
+
+/**
+ * hinoko_fw_iso_ir_single_get_loss_counters:
+ * @self: A [class@FwIsoIrSingle].
+ * @channel: The isochronous channel, up to 63.
+ * @lost: (out): The number of packets lost.
+ * @duplicated: (out): The number of packets received for the same isochronous cycle as the
+ *		previous packet.
+ * @reordered: (out): The number of packets received after the packet for newer isochronous
+ *	       cycle.
+ *
+ * Retrieve the counters of detection enabled by
+ * [property@FwIsoIrSingle:detect-packet-loss] for the channel since the context starts.
+ *
+ * Since: 1.1
+ */
+void hinoko_fw_iso_ir_single_get_loss_counters(HinokoFwIsoIrSingle *self, guint channel,
+					       guint *lost, guint *duplicated, guint *reordered)
+{
+	HinokoFwIsoIrSinglePrivate *priv;
+
+	g_return_if_fail(HINOKO_IS_FW_ISO_IR_SINGLE(self));
+	g_return_if_fail(channel <= IEEE1394_MAX_CHANNEL);
+	g_return_if_fail(lost != NULL);
+	g_return_if_fail(duplicated != NULL);
+	g_return_if_fail(reordered != NULL);
+
+	priv = hinoko_fw_iso_ir_single_get_instance_private(self);
+
+	fw_iso_ir_loss_detector_get_counters(&priv->loss, channel, lost, duplicated, reordered);
+}
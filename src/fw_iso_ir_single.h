@@ -30,6 +30,21 @@ struct _HinokoFwIsoIrSingleClass {
 	void (*interrupted)(HinokoFwIsoIrSingle *self, guint sec, guint cycle,
 			    const guint8 *header, guint header_length,
 			    guint count);
+
+	/**
+	 * HinokoFwIsoIrSingleClass::packets_lost:
+	 * @self: A [class@FwIsoIrSingle].
+	 * @channel: The isochronous channel in which packets are lost.
+	 * @sec: The sec part of isochronous cycle for the packet after the loss, up to 7.
+	 * @cycle: The cycle part of isochronous cycle for the packet after the loss, up to 7999.
+	 * @count: The number of lost packets.
+	 *
+	 * Class closure for the [signal@FwIsoIrSingle::packets-lost] signal.
+	 *
+	 * Since: 1.1
+	 */
+	void (*packets_lost)(HinokoFwIsoIrSingle *self, guint channel, guint sec, guint cycle,
+			     guint count);
 };
 
 HinokoFwIsoIrSingle *hinoko_fw_iso_ir_single_new(void);
@@ -48,9 +63,20 @@ gboolean hinoko_fw_iso_ir_single_start(HinokoFwIsoIrSingle *self, const guint16
 				       guint32 sync_code, HinokoFwIsoCtxMatchFlag tags,
 				       GError **error);
 
+gboolean hinoko_fw_iso_ir_single_start_at(HinokoFwIsoIrSingle *self, gint clock_id,
+					  gint64 deadline_ns, guint32 sync_code,
+					  HinokoFwIsoCtxMatchFlag tags, guint16 cycle_match[2],
+					  GError **error);
+
 void hinoko_fw_iso_ir_single_get_payload(HinokoFwIsoIrSingle *self, guint index,
 					 const guint8 **payload, guint *length);
 
+void hinoko_fw_iso_ir_single_get_timestamps(HinokoFwIsoIrSingle *self, const gint64 **timestamps,
+					    guint *count);
+
+void hinoko_fw_iso_ir_single_get_loss_counters(HinokoFwIsoIrSingle *self, guint channel,
+					       guint *lost, guint *duplicated, guint *reordered);
+
 G_END_DECLS
 
 #endif
@@ -8,10 +8,55 @@
  * [class@FwIsoIt] transmits isochronous packets for single channel by IT context in 1394 OHCI.
  * The content of packet is split to two parts; context header and context payload in a manner of
  * Linux FireWire subsystem.
+ *
+ * Instead of registering packet for each isochronous cycle in order, the application can submit
+ * packet keyed by isochronous cycle to the scheduler started by
+ * [method@FwIsoIt.start_scheduler]. The scheduler fills isochronous cycles without packet by skip
+ * descriptor.
  */
+
+// The slot of scheduler to hold packet for the isochronous cycle. The header and payload follows.
+struct fw_iso_it_sched_slot {
+	gboolean occupied;
+	HinokoFwIsoCtxMatchFlag tags;
+	guint sync_code;
+	guint payload_length;
+	guint8 data[];
+};
+
+struct fw_iso_it_scheduler {
+	gboolean enabled;
+
+	// The ring of slots. The head slot is for the next isochronous cycle to register.
+	guint8 *slots;
+	guint slot_size;
+	guint slot_count;
+	guint head;
+
+	// The isochronous cycle in the range of 128 seconds.
+	guint next_cycle;
+
+	guint lead_cycles;
+	guint cycles_per_irq;
+	guint queued_cycles;
+	guint accumulated_cycles;
+
+	guint late_packets;
+};
+
 typedef struct {
 	struct fw_iso_ctx_state state;
 	guint offset;
+
+	struct fw_iso_it_scheduler sched;
+
+	guint low_watermark;
+	guint high_watermark;
+
+	guint underrun_margin;
+	gboolean stop_on_underrun;
+	guint underruns;
+	guint near_misses;
 } HinokoFwIsoItPrivate;
 
 static void fw_iso_ctx_iface_init(HinokoFwIsoCtxInterface *iface);
@@ -20,24 +65,103 @@ G_DEFINE_TYPE_WITH_CODE(HinokoFwIsoIt, hinoko_fw_iso_it, G_TYPE_OBJECT,
 			G_ADD_PRIVATE(HinokoFwIsoIt)
 			G_IMPLEMENT_INTERFACE(HINOKO_TYPE_FW_ISO_CTX, fw_iso_ctx_iface_init))
 
+enum fw_iso_it_prop_type {
+	FW_ISO_IT_PROP_TYPE_LATE_PACKETS = FW_ISO_CTX_PROP_TYPE_COUNT,
+	FW_ISO_IT_PROP_TYPE_QUEUED_PACKETS,
+	FW_ISO_IT_PROP_TYPE_LOW_WATERMARK,
+	FW_ISO_IT_PROP_TYPE_HIGH_WATERMARK,
+	FW_ISO_IT_PROP_TYPE_UNDERRUN_MARGIN,
+	FW_ISO_IT_PROP_TYPE_STOP_ON_UNDERRUN,
+	FW_ISO_IT_PROP_TYPE_UNDERRUNS,
+	FW_ISO_IT_PROP_TYPE_NEAR_MISSES,
+	FW_ISO_IT_PROP_TYPE_COUNT,
+};
+
 enum fw_iso_it_sig_type {
 	FW_ISO_IT_SIG_TYPE_IRQ = 1,
+	FW_ISO_IT_SIG_TYPE_REFILL,
+	FW_ISO_IT_SIG_TYPE_LOW_HEADROOM,
 	FW_ISO_IT_SIG_TYPE_COUNT,
 };
 static guint fw_iso_it_sigs[FW_ISO_IT_SIG_TYPE_COUNT] = { 0 };
 
+// The packets registered and not sent yet, computed with the number of timestamps delivered by
+// interrupt event for packets already sent.
+static guint fw_iso_it_queued_packets(const HinokoFwIsoItPrivate *priv)
+{
+	return (guint)(priv->state.registered_total - priv->state.completed_total);
+}
+
 static void fw_iso_it_get_property(GObject *obj, guint id, GValue *val, GParamSpec *spec)
 {
 	HinokoFwIsoIt *self = HINOKO_FW_ISO_IT(obj);
 	HinokoFwIsoItPrivate *priv = hinoko_fw_iso_it_get_instance_private(self);
 
-	fw_iso_ctx_state_get_property(&priv->state, obj, id, val, spec);
+	switch (id) {
+	case FW_ISO_IT_PROP_TYPE_LATE_PACKETS:
+		g_value_set_uint(val, priv->sched.late_packets);
+		break;
+	case FW_ISO_IT_PROP_TYPE_QUEUED_PACKETS:
+		g_value_set_uint(val, fw_iso_it_queued_packets(priv));
+		break;
+	case FW_ISO_IT_PROP_TYPE_LOW_WATERMARK:
+		g_value_set_uint(val, priv->low_watermark);
+		break;
+	case FW_ISO_IT_PROP_TYPE_HIGH_WATERMARK:
+		g_value_set_uint(val, priv->high_watermark);
+		break;
+	case FW_ISO_IT_PROP_TYPE_UNDERRUN_MARGIN:
+		g_value_set_uint(val, priv->underrun_margin);
+		break;
+	case FW_ISO_IT_PROP_TYPE_STOP_ON_UNDERRUN:
+		g_value_set_boolean(val, priv->stop_on_underrun);
+		break;
+	case FW_ISO_IT_PROP_TYPE_UNDERRUNS:
+		g_value_set_uint(val, priv->underruns);
+		break;
+	case FW_ISO_IT_PROP_TYPE_NEAR_MISSES:
+		g_value_set_uint(val, priv->near_misses);
+		break;
+	default:
+		fw_iso_ctx_state_get_property(&priv->state, obj, id, val, spec);
+		break;
+	}
+}
+
+static void fw_iso_it_set_property(GObject *obj, guint id, const GValue *val,
+				   GParamSpec *spec)
+{
+	HinokoFwIsoIt *self = HINOKO_FW_ISO_IT(obj);
+	HinokoFwIsoItPrivate *priv = hinoko_fw_iso_it_get_instance_private(self);
+
+	switch (id) {
+	case FW_ISO_IT_PROP_TYPE_LOW_WATERMARK:
+		priv->low_watermark = g_value_get_uint(val);
+		break;
+	case FW_ISO_IT_PROP_TYPE_HIGH_WATERMARK:
+		priv->high_watermark = g_value_get_uint(val);
+		break;
+	case FW_ISO_IT_PROP_TYPE_UNDERRUN_MARGIN:
+		priv->underrun_margin = g_value_get_uint(val);
+		break;
+	case FW_ISO_IT_PROP_TYPE_STOP_ON_UNDERRUN:
+		priv->stop_on_underrun = g_value_get_boolean(val);
+		break;
+	default:
+		fw_iso_ctx_state_set_property(&priv->state, obj, id, val, spec);
+		break;
+	}
 }
 
 static void fw_iso_it_finalize(GObject *obj)
 {
+	HinokoFwIsoIt *self = HINOKO_FW_ISO_IT(obj);
+	HinokoFwIsoItPrivate *priv = hinoko_fw_iso_it_get_instance_private(self);
+
 	hinoko_fw_iso_ctx_release(HINOKO_FW_ISO_CTX(obj));
 
+	g_free(priv->sched.slots);
+
 	G_OBJECT_CLASS(hinoko_fw_iso_it_parent_class)->finalize(obj);
 }
 
@@ -46,10 +170,133 @@ static void hinoko_fw_iso_it_class_init(HinokoFwIsoItClass *klass)
 	GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
 
 	gobject_class->get_property = fw_iso_it_get_property;
+	gobject_class->set_property = fw_iso_it_set_property;
 	gobject_class->finalize = fw_iso_it_finalize;
 
 	fw_iso_ctx_class_override_properties(gobject_class);
 
+	fw_iso_it_sigs[FW_ISO_IT_SIG_TYPE_LOW_HEADROOM] = fw_iso_ctx_class_lookup_low_headroom();
+
+	/**
+	 * HinokoFwIsoIt:late-packets:
+	 *
+	 * The number of packets rejected by [method@FwIsoIt.schedule_packet] since they were
+	 * scheduled to isochronous cycle already processed. The value is reset by
+	 * [method@FwIsoIt.start_scheduler].
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_IT_PROP_TYPE_LATE_PACKETS,
+		g_param_spec_uint("late-packets", "late-packets",
+				  "The number of packets scheduled to isochronous cycle already "
+				  "processed",
+				  0, G_MAXUINT, 0,
+				  G_PARAM_READABLE));
+
+	/**
+	 * HinokoFwIsoIt:queued-packets:
+	 *
+	 * The number of packets registered and not sent yet. The value is computed with the
+	 * timestamps of sent packets delivered by interrupt event, thus it is updated when
+	 * [signal@FwIsoIt::interrupted] is emitted.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_IT_PROP_TYPE_QUEUED_PACKETS,
+		g_param_spec_uint("queued-packets", "queued-packets",
+				  "The number of packets registered and not sent yet",
+				  0, G_MAXUINT, 0,
+				  G_PARAM_READABLE));
+
+	/**
+	 * HinokoFwIsoIt:low-watermark:
+	 *
+	 * The number of packets registered and not sent yet, below which
+	 * [signal@FwIsoIt::refill] is emitted after processing interrupt event. Zero disables the
+	 * signal.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_IT_PROP_TYPE_LOW_WATERMARK,
+		g_param_spec_uint("low-watermark", "low-watermark",
+				  "The number of queued packets to request refill",
+				  0, G_MAXUINT, 0,
+				  G_PARAM_READWRITE));
+
+	/**
+	 * HinokoFwIsoIt:high-watermark:
+	 *
+	 * The number of packets registered and not sent yet, up to which [signal@FwIsoIt::refill]
+	 * requests to register packets.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_IT_PROP_TYPE_HIGH_WATERMARK,
+		g_param_spec_uint("high-watermark", "high-watermark",
+				  "The number of queued packets to be filled by refill",
+				  0, G_MAXUINT, 0,
+				  G_PARAM_READWRITE));
+
+	/**
+	 * HinokoFwIsoIt:underrun-margin:
+	 *
+	 * The number of packets registered and not sent yet, below which skip packets are
+	 * registered to keep the context alive after processing interrupt event. The last skip
+	 * packet schedules hardware interrupt. Zero disables the injection of skip packets. The
+	 * injection is not done while the scheduler started by [method@FwIsoIt.start_scheduler]
+	 * works, since it keeps queued packets by itself.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_IT_PROP_TYPE_UNDERRUN_MARGIN,
+		g_param_spec_uint("underrun-margin", "underrun-margin",
+				  "The number of queued packets to inject skip packets",
+				  0, G_MAXUINT, 0,
+				  G_PARAM_READWRITE));
+
+	/**
+	 * HinokoFwIsoIt:stop-on-underrun:
+	 *
+	 * Whether to stop the context with [error@FwIsoCtxError.UNDERRUN] when no packet is left
+	 * to transmit and [property@FwIsoIt:underrun-margin] is zero. When disabled, the underrun
+	 * is just counted in [property@FwIsoIt:underruns].
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_IT_PROP_TYPE_STOP_ON_UNDERRUN,
+		g_param_spec_boolean("stop-on-underrun", "stop-on-underrun",
+				     "Whether to stop the context at underrun",
+				     FALSE,
+				     G_PARAM_READWRITE));
+
+	/**
+	 * HinokoFwIsoIt:underruns:
+	 *
+	 * The number of interrupt events at which no packet is left to transmit since the context
+	 * starts.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_IT_PROP_TYPE_UNDERRUNS,
+		g_param_spec_uint("underruns", "underruns",
+				  "The number of underruns",
+				  0, G_MAXUINT, 0,
+				  G_PARAM_READABLE));
+
+	/**
+	 * HinokoFwIsoIt:near-misses:
+	 *
+	 * The number of interrupt events at which the packets left to transmit are less than
+	 * [property@FwIsoIt:underrun-margin] since the context starts.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_IT_PROP_TYPE_NEAR_MISSES,
+		g_param_spec_uint("near-misses", "near-misses",
+				  "The number of near-misses of underrun",
+				  0, G_MAXUINT, 0,
+				  G_PARAM_READABLE));
+
 	/**
 	 * HinokoFwIsoIt::interrupted:
 	 * @self: A [class@FwIsoIt].
@@ -79,6 +326,38 @@ static void hinoko_fw_iso_it_class_init(HinokoFwIsoItClass *klass)
 			G_TYPE_NONE,
 			5, G_TYPE_UINT, G_TYPE_UINT, G_TYPE_POINTER,
 			G_TYPE_UINT, G_TYPE_UINT);
+
+	// Collect arguments of the signal without GValue in the path of interrupt event.
+	g_signal_set_va_marshaller(fw_iso_it_sigs[FW_ISO_IT_SIG_TYPE_IRQ],
+				   G_OBJECT_CLASS_TYPE(klass),
+				   hinoko_sigs_marshal_VOID__UINT_UINT_POINTER_UINT_UINTv);
+
+	/**
+	 * HinokoFwIsoIt::refill:
+	 * @self: A [class@FwIsoIt].
+	 * @count: The number of packets to register up to [property@FwIsoIt:high-watermark].
+	 *
+	 * Emitted after [signal@FwIsoIt::interrupted] when the number of packets registered and not
+	 * sent yet falls below [property@FwIsoIt:low-watermark]. The handler of signal is expected
+	 * to call [method@FwIsoIt.register_packet] for @count times, then the registered packets are
+	 * queued to hardware in the same interrupt event. The application does not need to estimate
+	 * the number of packets to register in each interrupt event.
+	 *
+	 * Since: 1.1
+	 */
+	fw_iso_it_sigs[FW_ISO_IT_SIG_TYPE_REFILL] =
+		g_signal_new("refill",
+			G_OBJECT_CLASS_TYPE(klass),
+			G_SIGNAL_RUN_LAST,
+			G_STRUCT_OFFSET(HinokoFwIsoItClass, refill),
+			NULL, NULL,
+			g_cclosure_marshal_VOID__UINT,
+			G_TYPE_NONE,
+			1, G_TYPE_UINT);
+
+	g_signal_set_va_marshaller(fw_iso_it_sigs[FW_ISO_IT_SIG_TYPE_REFILL],
+				   G_OBJECT_CLASS_TYPE(klass),
+				   g_cclosure_marshal_VOID__UINTv);
 }
 
 static void hinoko_fw_iso_it_init(HinokoFwIsoIt *self)
@@ -101,9 +380,11 @@ static void fw_iso_it_stop(HinokoFwIsoCtx *inst)
 	running = priv->state.running;
 
 	fw_iso_ctx_state_stop(&priv->state);
+	priv->sched.enabled = FALSE;
 
 	if (priv->state.running != running)
-		g_signal_emit_by_name(G_OBJECT(inst), STOPPED_SIGNAL_NAME, NULL);
+		g_signal_emit_by_name(G_OBJECT(inst), STOPPED_SIGNAL_NAME,
+				      priv->state.stop_error);
 }
 
 void fw_iso_it_unmap_buffer(HinokoFwIsoCtx *inst)
@@ -116,6 +397,40 @@ void fw_iso_it_unmap_buffer(HinokoFwIsoCtx *inst)
 	priv = hinoko_fw_iso_it_get_instance_private(self);
 
 	fw_iso_ctx_state_unmap_buffer(&priv->state);
+
+	g_free(priv->sched.slots);
+	priv->sched.slots = NULL;
+	priv->sched.slot_count = 0;
+}
+
+gboolean fw_iso_it_recycle(HinokoFwIsoIt *self)
+{
+	HinokoFwIsoItPrivate *priv;
+
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_IT(self), FALSE);
+	priv = hinoko_fw_iso_it_get_instance_private(self);
+
+	priv->offset = 0;
+	priv->sched.enabled = FALSE;
+
+	return fw_iso_ctx_state_recycle(&priv->state);
+}
+
+struct fw_iso_ctx_state *fw_iso_it_prepare_start(HinokoFwIsoIt *self)
+{
+	HinokoFwIsoItPrivate *priv = hinoko_fw_iso_it_get_instance_private(self);
+
+	priv->underruns = 0;
+	priv->near_misses = 0;
+
+	return &priv->state;
+}
+
+struct fw_iso_ctx_state *fw_iso_it_get_state(HinokoFwIsoIt *self)
+{
+	HinokoFwIsoItPrivate *priv = hinoko_fw_iso_it_get_instance_private(self);
+
+	return &priv->state;
 }
 
 static void fw_iso_it_release(HinokoFwIsoCtx *inst)
@@ -155,6 +470,108 @@ static gboolean fw_iso_it_flush_completions(HinokoFwIsoCtx *inst, GError **error
 	return fw_iso_ctx_state_flush_completions(&priv->state, error);
 }
 
+static void fw_iso_it_write_payload(HinokoFwIsoItPrivate *priv, const guint8 *payload,
+				    guint payload_length)
+{
+	const guint8 *frames;
+	guint frame_size;
+
+	fw_iso_ctx_state_read_frame(&priv->state, priv->offset, payload_length, &frames,
+				    &frame_size);
+	memcpy((void *)frames, payload, frame_size);
+	priv->offset += frame_size;
+
+	if (frame_size != payload_length) {
+		guint rest = payload_length - frame_size;
+
+		payload += frame_size;
+		fw_iso_ctx_state_read_frame(&priv->state, 0, rest, &frames, &frame_size);
+		memcpy((void *)frames, payload, frame_size);
+
+		priv->offset = frame_size;
+	}
+}
+
+static inline struct fw_iso_it_sched_slot *fw_iso_it_sched_slot(struct fw_iso_it_scheduler *sched,
+								guint index)
+{
+	return (struct fw_iso_it_sched_slot *)(sched->slots + index * sched->slot_size);
+}
+
+// Register chunks for isochronous cycles up to the lead time. The arguments of packet in the slot
+// are already validated when scheduled, and the number of chunks is within the room of
+// registration since the lead time is up to the number of chunks per buffer.
+static void fw_iso_it_scheduler_fill(HinokoFwIsoItPrivate *priv)
+{
+	struct fw_iso_it_scheduler *sched = &priv->sched;
+	guint header_size = priv->state.header_size;
+
+	while (sched->queued_cycles < sched->lead_cycles) {
+		struct fw_iso_it_sched_slot *slot = fw_iso_it_sched_slot(sched, sched->head);
+		gboolean schedule_interrupt;
+
+		schedule_interrupt = ++sched->accumulated_cycles % sched->cycles_per_irq == 0;
+		if (sched->accumulated_cycles >= G_MAXINT)
+			sched->accumulated_cycles %= sched->cycles_per_irq;
+
+		if (slot->occupied) {
+			fw_iso_ctx_state_register_chunk_it(&priv->state, FALSE, slot->tags,
+							   slot->sync_code, slot->data,
+							   header_size, slot->payload_length,
+							   schedule_interrupt);
+			fw_iso_it_write_payload(priv, slot->data + header_size,
+						slot->payload_length);
+			slot->occupied = FALSE;
+		} else {
+			fw_iso_ctx_state_register_chunk_it(&priv->state, TRUE, 0, 0, NULL, 0, 0,
+							   schedule_interrupt);
+		}
+
+		sched->head = (sched->head + 1) % sched->slot_count;
+		sched->next_cycle = (sched->next_cycle + 1) % IEEE1394_CYCLES_PER_ROUND;
+		++sched->queued_cycles;
+	}
+}
+
+// The number of packets queued and not sent yet is the difference between the count of registered
+// chunks and the count of completed chunks, both accumulated since the context starts.
+static gboolean fw_iso_it_check_underrun(HinokoFwIsoItPrivate *priv, GError **error)
+{
+	guint queued = fw_iso_it_queued_packets(priv);
+	guint margin;
+	guint count;
+
+	if (queued == 0)
+		++priv->underruns;
+	else if (queued < priv->underrun_margin)
+		++priv->near_misses;
+
+	// The scheduler keeps packets queued by itself.
+	if (priv->sched.enabled)
+		return TRUE;
+
+	margin = MIN(priv->underrun_margin, priv->state.chunks_per_buffer);
+	if (margin == 0) {
+		if (queued > 0 || !priv->stop_on_underrun)
+			return TRUE;
+
+		g_set_error(error, HINOKO_FW_ISO_CTX_ERROR, HINOKO_FW_ISO_CTX_ERROR_UNDERRUN,
+			    "No packet is queued to transmit (underruns: %u, near-misses: %u)",
+			    priv->underruns, priv->near_misses);
+		return FALSE;
+	}
+
+	// The room of registration is enough since the number of packets queued and not sent yet
+	// is less than the number of chunks per buffer. The last one schedules hardware interrupt
+	// to check again.
+	for (count = queued; count < margin; ++count) {
+		fw_iso_ctx_state_register_chunk_it(&priv->state, TRUE, 0, 0, NULL, 0, 0,
+						   count + 1 == margin);
+	}
+
+	return TRUE;
+}
+
 gboolean fw_iso_it_handle_event(HinokoFwIsoCtx *inst, const union fw_cdev_event *event,
 				GError **error)
 {
@@ -178,10 +595,33 @@ gboolean fw_iso_it_handle_event(HinokoFwIsoCtx *inst, const union fw_cdev_event
 	cycle = ohci1394_isoc_desc_tstamp_to_cycle(ev->cycle);
 	pkt_count = ev->header_length / 4;
 
+	if (fw_iso_ctx_state_complete_chunks(&priv->state, pkt_count))
+		g_signal_emit(inst, fw_iso_it_sigs[FW_ISO_IT_SIG_TYPE_LOW_HEADROOM], 0,
+			      priv->state.headroom);
+
+	if (priv->sched.enabled)
+		priv->sched.queued_cycles -= MIN(pkt_count, priv->sched.queued_cycles);
+
 	g_signal_emit(inst, fw_iso_it_sigs[FW_ISO_IT_SIG_TYPE_IRQ], 0, sec, cycle, ev->header,
 		      ev->header_length, pkt_count);
 
-	return fw_iso_ctx_state_queue_chunks(&priv->state, error);
+	if (priv->low_watermark > 0) {
+		guint queued = fw_iso_it_queued_packets(priv);
+
+		if (queued < priv->low_watermark && queued < priv->high_watermark) {
+			g_signal_emit(inst, fw_iso_it_sigs[FW_ISO_IT_SIG_TYPE_REFILL], 0,
+				      priv->high_watermark - queued);
+		}
+	}
+
+	// The handler of signal can schedule packets before filling isochronous cycles.
+	if (priv->sched.enabled)
+		fw_iso_it_scheduler_fill(priv);
+
+	if (!fw_iso_it_check_underrun(priv, error))
+		return FALSE;
+
+	return fw_iso_ctx_state_queue_chunks_by_policy(&priv->state, TRUE, error);
 }
 
 gboolean fw_iso_it_create_source(HinokoFwIsoCtx *inst, GSource **source, GError **error)
@@ -273,7 +713,7 @@ gboolean hinoko_fw_iso_it_map_buffer(HinokoFwIsoIt *self, guint maximum_bytes_pe
 	priv = hinoko_fw_iso_it_get_instance_private(self);
 
 	return fw_iso_ctx_state_map_buffer(&priv->state, maximum_bytes_per_payload,
-					   payloads_per_buffer, error);
+					   payloads_per_buffer, 0, error);
 }
 
 /**
@@ -293,17 +733,46 @@ gboolean hinoko_fw_iso_it_map_buffer(HinokoFwIsoIt *self, guint maximum_bytes_pe
  */
 gboolean hinoko_fw_iso_it_start(HinokoFwIsoIt *self, const guint16 *cycle_match, GError **error)
 {
-	HinokoFwIsoItPrivate *priv;
-
 	g_return_val_if_fail(HINOKO_IS_FW_ISO_IT(self), FALSE);
 	g_return_val_if_fail(cycle_match == NULL ||
 			     cycle_match[0] <= OHCI1394_IT_contextControl_cycleMatch_MAX_SEC ||
 			     cycle_match[1] <= OHCI1394_IT_contextControl_cycleMatch_MAX_CYCLE,
 			     FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
-	priv = hinoko_fw_iso_it_get_instance_private(self);
 
-	return fw_iso_ctx_state_start(&priv->state, cycle_match, 0, 0, error);
+	return fw_iso_ctx_state_start(fw_iso_it_prepare_start(self), cycle_match, 0, 0, error);
+}
+
+/**
+ * hinoko_fw_iso_it_start_at:
+ * @self: A [class@FwIsoIt].
+ * @clock_id: The numeric ID of clock source for the deadline. Either CLOCK_MONOTONIC(1) or
+ *	      CLOCK_MONOTONIC_RAW(4) is available.
+ * @deadline_ns: The time in nanoseconds of the clock source to start the context.
+ * @cycle_match: (array fixed-size=2) (out caller-allocates): The isochronous cycle chosen to start
+ *		 packet processing. The first element is the second part of isochronous cycle, up
+ *		 to 3. The second element is the cycle part of isochronous cycle, up to 7999.
+ * @error: A [struct@GLib.Error].
+ *
+ * Start IT context at the deadline instead of the isochronous cycle. The deadline is converted to
+ * the isochronous cycle which begins at the deadline or just after it, by the pair of cycle time
+ * and system time sampled at once. The isochronous cycle should be within 4 seconds from the
+ * current one due to the two bits of second part for cycle match, otherwise
+ * [error@FwIsoCtxError.OUT_OF_WINDOW] is reported. The deadline in the past is reported as well.
+ *
+ * Returns: TRUE if the overall operation finishes successful, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_it_start_at(HinokoFwIsoIt *self, gint clock_id, gint64 deadline_ns,
+				   guint16 cycle_match[2], GError **error)
+{
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_IT(self), FALSE);
+	g_return_val_if_fail(cycle_match != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	return fw_iso_ctx_state_start_at(fw_iso_it_prepare_start(self), clock_id, deadline_ns, 0, 0,
+					 cycle_match, error);
 }
 
 /**
@@ -324,7 +793,9 @@ gboolean hinoko_fw_iso_it_start(HinokoFwIsoIt *self, const guint16 *cycle_match,
  * Register packet data with header and payload for IT context. The content of given header and
  * payload is appended into data field of isochronous packet to be sent. The caller can schedule
  * hardware interrupt to generate interrupt event. In detail, please refer to documentation about
- * [signal@FwIsoIt::interrupted].
+ * [signal@FwIsoIt::interrupted]. While the context is running, the packet is queued to hardware
+ * according to [property@FwIsoCtx:queue-policy]. The call is not available while the scheduler
+ * started by [method@FwIsoIt.start_scheduler] works.
  *
  * Returns: TRUE if the overall operation finishes successful, otherwise FALSE.
  *
@@ -337,8 +808,6 @@ gboolean hinoko_fw_iso_it_register_packet(HinokoFwIsoIt *self, HinokoFwIsoCtxMat
 					  gboolean schedule_interrupt, GError **error)
 {
 	HinokoFwIsoItPrivate *priv;
-	const guint8 *frames;
-	guint frame_size;
 	gboolean skip;
 
 	g_return_val_if_fail(HINOKO_IS_FW_ISO_IT(self), FALSE);
@@ -350,6 +819,7 @@ gboolean hinoko_fw_iso_it_register_packet(HinokoFwIsoIt *self, HinokoFwIsoCtxMat
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
 	priv = hinoko_fw_iso_it_get_instance_private(self);
+	g_return_val_if_fail(!priv->sched.enabled, FALSE);
 
 	skip = FALSE;
 	if (header_length == 0 && payload_length == 0)
@@ -360,20 +830,209 @@ gboolean hinoko_fw_iso_it_register_packet(HinokoFwIsoIt *self, HinokoFwIsoCtxMat
 					     schedule_interrupt, error))
 		return FALSE;
 
-	fw_iso_ctx_state_read_frame(&priv->state, priv->offset, payload_length, &frames,
-				    &frame_size);
-	memcpy((void *)frames, payload, frame_size);
-	priv->offset += frame_size;
+	fw_iso_it_write_payload(priv, payload, payload_length);
 
-	if (frame_size != payload_length) {
-		guint rest = payload_length - frame_size;
+	return fw_iso_ctx_state_queue_chunks_by_policy(&priv->state, FALSE, error);
+}
 
-		payload += frame_size;
-		fw_iso_ctx_state_read_frame(&priv->state, 0, rest, &frames, &frame_size);
-		memcpy((void *)frames, payload, frame_size);
+/**
+ * hinoko_fw_iso_it_start_scheduler:
+ * @self: A [class@FwIsoIt].
+ * @start_cycle: (array fixed-size=2) (element-type guint16) (in): The isochronous cycle to start
+ *		 packet processing. The first element should be the second part of isochronous
+ *		 cycle, up to 127. The second element should be the cycle part of isochronous
+ *		 cycle, up to 7999.
+ * @lead_cycles: The number of isochronous cycles to keep queued to hardware ahead, up to the value
+ *		 of [property@FwIsoCtx:chunks-per-buffer].
+ * @cycles_per_irq: The number of isochronous cycles per hardware interrupt, up to @lead_cycles.
+ * @error: A [struct@GLib.Error].
+ *
+ * Start IT context with scheduler of packets. The scheduler keeps the chunks queued to hardware
+ * for @lead_cycles isochronous cycles ahead, each of which transmits the packet given by
+ * [method@FwIsoIt.schedule_packet] for the cycle or is skipped when no packet is given. The
+ * first chunk is processed at @start_cycle, thus the value should be later than the current
+ * isochronous cycle retrieved by [method@FwIsoCtx.read_cycle_time]. The call of
+ * [method@FwIsoIt.register_packet] is rejected while the scheduler works.
+ *
+ * Returns: TRUE if the overall operation finishes successful, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_it_start_scheduler(HinokoFwIsoIt *self, const guint16 *start_cycle,
+					  guint lead_cycles, guint cycles_per_irq, GError **error)
+{
+	HinokoFwIsoItPrivate *priv;
+	struct fw_iso_it_scheduler *sched;
+	guint16 cycle_match[2];
+	guint slot_size;
 
-		priv->offset = frame_size;
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_IT(self), FALSE);
+	g_return_val_if_fail(start_cycle != NULL, FALSE);
+	g_return_val_if_fail(start_cycle[0] <= IEEE1394_CYCLE_TIME_MAX_SEC, FALSE);
+	g_return_val_if_fail(start_cycle[1] <= OHCI1394_IT_contextControl_cycleMatch_MAX_CYCLE,
+			     FALSE);
+	g_return_val_if_fail(lead_cycles > 0, FALSE);
+	g_return_val_if_fail(cycles_per_irq > 0 && cycles_per_irq <= lead_cycles, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	priv = hinoko_fw_iso_it_get_instance_private(self);
+	sched = &priv->sched;
+
+	if (priv->state.fd < 0) {
+		generate_fw_iso_ctx_error_coded(error, HINOKO_FW_ISO_CTX_ERROR_NOT_ALLOCATED);
+		return FALSE;
+	}
+
+	if (priv->state.addr == NULL) {
+		generate_fw_iso_ctx_error_coded(error, HINOKO_FW_ISO_CTX_ERROR_NOT_MAPPED);
+		return FALSE;
+	}
+
+	g_return_val_if_fail(!priv->state.running, FALSE);
+	g_return_val_if_fail(priv->state.registered_chunk_count == 0, FALSE);
+	g_return_val_if_fail(lead_cycles <= priv->state.chunks_per_buffer, FALSE);
+
+	slot_size = sizeof(struct fw_iso_it_sched_slot) + priv->state.header_size +
+		    priv->state.bytes_per_chunk;
+	slot_size = (slot_size + sizeof(gpointer) - 1) & ~(sizeof(gpointer) - 1);
+
+	if (sched->slots == NULL || sched->slot_size != slot_size ||
+	    sched->slot_count != priv->state.chunks_per_buffer) {
+		g_free(sched->slots);
+		sched->slot_size = slot_size;
+		sched->slot_count = priv->state.chunks_per_buffer;
+		sched->slots = g_malloc0(sched->slot_size * sched->slot_count);
+	} else {
+		memset(sched->slots, 0, sched->slot_size * sched->slot_count);
+	}
+
+	sched->head = 0;
+	sched->next_cycle = start_cycle[0] * IEEE1394_CYCLES_PER_SEC + start_cycle[1];
+	sched->lead_cycles = lead_cycles;
+	sched->cycles_per_irq = cycles_per_irq;
+	sched->queued_cycles = 0;
+	sched->accumulated_cycles = 0;
+	sched->late_packets = 0;
+
+	priv->underruns = 0;
+	priv->near_misses = 0;
+
+	fw_iso_it_scheduler_fill(priv);
+
+	// The field of cycle match has the lower two bits of second.
+	cycle_match[0] = start_cycle[0] % (OHCI1394_IT_contextControl_cycleMatch_MAX_SEC + 1);
+	cycle_match[1] = start_cycle[1];
+
+	if (!fw_iso_ctx_state_start(&priv->state, cycle_match, 0, 0, error))
+		return FALSE;
+
+	sched->enabled = TRUE;
+
+	return TRUE;
+}
+
+/**
+ * hinoko_fw_iso_it_schedule_packet:
+ * @self: A [class@FwIsoIt].
+ * @cycle: (array fixed-size=2) (element-type guint16) (in): The isochronous cycle to transmit the
+ *	   packet. The first element should be the second part of isochronous cycle, up to 127.
+ *	   The second element should be the cycle part of isochronous cycle, up to 7999.
+ * @tags: The value of tag field for isochronous packet to register.
+ * @sync_code: The value of sync field in isochronous packet header for packet processing, up to 15.
+ * @header: (array length=header_length) (nullable): The header of IT context for isochronous
+ *	    packet. The length of header should be the same as the size of header indicated in
+ *	    allocation if it's not null.
+ * @header_length: The number of bytes for the @header.
+ * @payload: (array length=payload_length)(nullable): The payload of IT context for isochronous
+ *	     packet.
+ * @payload_length: The number of bytes for the @payload.
+ * @error: A [struct@GLib.Error].
+ *
+ * Schedule packet to transmit at the isochronous cycle by the scheduler started by
+ * [method@FwIsoIt.start_scheduler]. The content of header and payload is copied, thus the caller
+ * can reuse the buffer after return. The packet scheduled before to the same isochronous cycle is
+ * replaced.
+ *
+ * The packet should be scheduled before the isochronous cycle is queued to hardware, that is,
+ * earlier than the lead time of scheduler. The late packet is rejected with
+ * [error@FwIsoCtxError.PACKET_LATE] and counted in [property@FwIsoIt:late-packets]. The packet
+ * scheduled beyond the number of chunks per buffer from the isochronous cycle queued next is
+ * rejected with [error@FwIsoCtxError.PACKET_EARLY].
+ *
+ * Returns: TRUE if the overall operation finishes successful, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_it_schedule_packet(HinokoFwIsoIt *self, const guint16 *cycle,
+					  HinokoFwIsoCtxMatchFlag tags, guint sync_code,
+					  const guint8 *header, guint header_length,
+					  const guint8 *payload, guint payload_length,
+					  GError **error)
+{
+	HinokoFwIsoItPrivate *priv;
+	struct fw_iso_it_scheduler *sched;
+	struct fw_iso_it_sched_slot *slot;
+	guint target;
+	guint distance;
+
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_IT(self), FALSE);
+	g_return_val_if_fail(cycle != NULL, FALSE);
+	g_return_val_if_fail(cycle[0] <= IEEE1394_CYCLE_TIME_MAX_SEC, FALSE);
+	g_return_val_if_fail(cycle[1] <= OHCI1394_IT_contextControl_cycleMatch_MAX_CYCLE, FALSE);
+	g_return_val_if_fail(tags == 0 ||
+			     tags == HINOKO_FW_ISO_CTX_MATCH_FLAG_TAG0 ||
+			     tags == HINOKO_FW_ISO_CTX_MATCH_FLAG_TAG1 ||
+			     tags == HINOKO_FW_ISO_CTX_MATCH_FLAG_TAG2 ||
+			     tags == HINOKO_FW_ISO_CTX_MATCH_FLAG_TAG3, FALSE);
+	g_return_val_if_fail(sync_code <= IEEE1394_MAX_SYNC_CODE, FALSE);
+	g_return_val_if_fail((header != NULL && header_length > 0) ||
+			     (header == NULL && header_length == 0), FALSE);
+	g_return_val_if_fail((payload != NULL && payload_length > 0) ||
+			     (payload == NULL && payload_length == 0), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	priv = hinoko_fw_iso_it_get_instance_private(self);
+	sched = &priv->sched;
+
+	g_return_val_if_fail(sched->enabled, FALSE);
+
+	if (header_length > 0 || payload_length > 0) {
+		g_return_val_if_fail(header_length == priv->state.header_size, FALSE);
+		g_return_val_if_fail(payload_length <= priv->state.bytes_per_chunk, FALSE);
+	}
+
+	target = cycle[0] * IEEE1394_CYCLES_PER_SEC + cycle[1];
+	distance = (target + IEEE1394_CYCLES_PER_ROUND - sched->next_cycle) %
+		   IEEE1394_CYCLES_PER_ROUND;
+
+	// The isochronous cycle in the latter half of the round is regarded as past.
+	if (distance >= IEEE1394_CYCLES_PER_ROUND / 2) {
+		++sched->late_packets;
+		generate_fw_iso_ctx_error_coded(error, HINOKO_FW_ISO_CTX_ERROR_PACKET_LATE);
+		return FALSE;
+	}
+
+	if (distance >= sched->slot_count) {
+		generate_fw_iso_ctx_error_coded(error, HINOKO_FW_ISO_CTX_ERROR_PACKET_EARLY);
+		return FALSE;
 	}
 
+	slot = fw_iso_it_sched_slot(sched, (sched->head + distance) % sched->slot_count);
+
+	// The empty packet is equivalent to skip.
+	if (header_length == 0 && payload_length == 0) {
+		slot->occupied = FALSE;
+		return TRUE;
+	}
+
+	slot->tags = tags;
+	slot->sync_code = sync_code;
+	slot->payload_length = payload_length;
+	if (header_length > 0)
+		memcpy(slot->data, header, header_length);
+	if (payload_length > 0)
+		memcpy(slot->data + header_length, payload, payload_length);
+	slot->occupied = TRUE;
+
 	return TRUE;
 }
@@ -28,6 +28,17 @@ struct _HinokoFwIsoItClass {
 	void (*interrupted)(HinokoFwIsoIt *self, guint sec, guint cycle,
 			    const guint8 *tstamp, guint tstamp_length,
 			    guint count);
+
+	/**
+	 * HinokoFwIsoItClass::refill:
+	 * @self: A [class@FwIsoIt].
+	 * @count: The number of packets to register up to high watermark.
+	 *
+	 * Class closure for the [signal@FwIsoIt::refill] signal.
+	 *
+	 * Since: 1.1
+	 */
+	void (*refill)(HinokoFwIsoIt *self, guint count);
 };
 
 HinokoFwIsoIt *hinoko_fw_iso_it_new(void);
@@ -40,12 +51,24 @@ gboolean hinoko_fw_iso_it_map_buffer(HinokoFwIsoIt *self, guint maximum_bytes_pe
 
 gboolean hinoko_fw_iso_it_start(HinokoFwIsoIt *self, const guint16 *cycle_match, GError **error);
 
+gboolean hinoko_fw_iso_it_start_at(HinokoFwIsoIt *self, gint clock_id, gint64 deadline_ns,
+				   guint16 cycle_match[2], GError **error);
+
 gboolean hinoko_fw_iso_it_register_packet(HinokoFwIsoIt *self, HinokoFwIsoCtxMatchFlag tags,
 					  guint sync_code,
 					  const guint8 *header, guint header_length,
 					  const guint8 *payload, guint payload_length,
 					  gboolean schedule_interrupt, GError **error);
 
+gboolean hinoko_fw_iso_it_start_scheduler(HinokoFwIsoIt *self, const guint16 *start_cycle,
+					  guint lead_cycles, guint cycles_per_irq, GError **error);
+
+gboolean hinoko_fw_iso_it_schedule_packet(HinokoFwIsoIt *self, const guint16 *cycle,
+					  HinokoFwIsoCtxMatchFlag tags, guint sync_code,
+					  const guint8 *header, guint header_length,
+					  const guint8 *payload, guint payload_length,
+					  GError **error);
+
 G_END_DECLS
 
 #endif
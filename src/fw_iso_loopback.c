@@ -0,0 +1,938 @@
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#include "fw_iso_ctx_private.h"
+
+#include <sys/timerfd.h>
+#include <time.h>
+
+/**
+ * HinokoFwIsoLoopback:
+ * A software loopback between isochronous contexts.
+ *
+ * [class@FwIsoLoopback] connects [class@FwIsoIt] to [class@FwIsoIrSingle] and
+ * [class@FwIsoIrMultiple] in memory, without 1394 OHCI hardware. The contexts are allocated
+ * offline by the attach methods, then the application can map buffer, register chunks, and start
+ * them as usual.
+ *
+ * At each isochronous cycle of the simulated 8 kHz clock, each running IT context transmits the
+ * packet for the chunk queued first, and each running IR context listening to the channel
+ * receives it when the tag of packet is included in the tags given at starting. The isochronous
+ * packet header is built with the header, the tag, and the sync code of chunk, and no packet is
+ * transmitted for the chunk to skip. The chunk of IR context flagged to wait for sync
+ * (FW_CDEV_ISO_SYNC) discards packets till the sy field of packet matches the sync code given at
+ * starting, as the wait bit of descriptor in 1394 OHCI. The registration methods of IR contexts
+ * never flag the chunk, thus the sync code given at starting takes no effect as well as in the
+ * hardware. The interrupt events are generated for the chunks scheduled
+ * for interrupt in the same layout as Linux FireWire subsystem, then handled by the same handler
+ * as the one for hardware, thus the signals of context are emitted as well.
+ *
+ * The clock is driven by the source created by [method@FwIsoLoopback.create_source] at the pace
+ * of CLOCK_MONOTONIC, or by [method@FwIsoLoopback.advance] as fast as possible. The signals of
+ * contexts are emitted in the thread in which the clock is driven. The cycle time read from the
+ * attached contexts is always derived from CLOCK_MONOTONIC, while the reference timestamp in it
+ * is of the clock given by the caller.
+ */
+
+// The chunk queued to the context and not completed yet.
+struct loopback_chunk {
+	guint32 control;
+	guint offset;
+};
+
+struct loopback_port {
+	HinokoFwIsoCtx *ctx;
+	struct fw_iso_ctx_state *state;
+	fw_iso_ctx_handle_event_t handle_event;
+	gulong handler_id;
+	guint channel;
+	guint64 channels;
+	gboolean started;
+
+	// The ring of chunks in the order of queueing. For IT context, the header of chunk is kept
+	// in the slot of the same index.
+	struct loopback_chunk *chunks;
+	guint8 *headers;
+	guint capacity;
+	guint head;
+	guint count;
+	guint64 queued_bytes;
+
+	// For IT and IR single, the number of bytes accumulated in the header of event.
+	guint header_length;
+
+	// For IR multiple, the position in the chunk queued first, the offset of buffer just after
+	// the last packet, and whether any chunk scheduled for interrupt is filled.
+	guint write_offset;
+	guint completed;
+	gboolean interrupt;
+};
+
+// The packet transmitted at the isochronous cycle. The data consists of the header of chunk
+// followed by the payload in the buffer of IT context.
+struct loopback_packet {
+	guint32 iso_header;
+	guint32 tstamp;
+	const guint8 *header;
+	guint header_length;
+	const guint8 *payload;
+	guint payload_length;
+};
+
+typedef struct {
+	GPtrArray *ports;
+	guint cycles_per_wakeup;
+	guint64 cycles;
+	guint64 simulated_cycles;
+	guint64 delivered_packets;
+	guint64 dropped_packets;
+
+	// The header of chunk is copied since the handlers of signal can reallocate the ring.
+	guint8 header[G_MAXUINT8 + 1];
+	GByteArray *frame;
+} HinokoFwIsoLoopbackPrivate;
+
+G_DEFINE_TYPE_WITH_PRIVATE(HinokoFwIsoLoopback, hinoko_fw_iso_loopback, G_TYPE_OBJECT)
+
+typedef struct {
+	GSource src;
+	gpointer tag;
+	int fd;
+	HinokoFwIsoLoopback *self;
+} FwIsoLoopbackSource;
+
+#define IEEE1394_TCODE_STREAM_DATA		0xa
+#define IEEE1394_ISO_HEADER_TCODE_SHIFT		4
+
+#define DEFAULT_CYCLES_PER_WAKEUP		8
+
+enum fw_iso_loopback_prop_type {
+	FW_ISO_LOOPBACK_PROP_TYPE_CYCLES_PER_WAKEUP = 1,
+	FW_ISO_LOOPBACK_PROP_TYPE_SIMULATED_CYCLES,
+	FW_ISO_LOOPBACK_PROP_TYPE_DELIVERED_PACKETS,
+	FW_ISO_LOOPBACK_PROP_TYPE_DROPPED_PACKETS,
+	FW_ISO_LOOPBACK_PROP_TYPE_COUNT,
+};
+
+static void fw_iso_loopback_get_property(GObject *obj, guint id, GValue *val, GParamSpec *spec)
+{
+	HinokoFwIsoLoopback *self = HINOKO_FW_ISO_LOOPBACK(obj);
+	HinokoFwIsoLoopbackPrivate *priv = hinoko_fw_iso_loopback_get_instance_private(self);
+
+	switch (id) {
+	case FW_ISO_LOOPBACK_PROP_TYPE_CYCLES_PER_WAKEUP:
+		g_value_set_uint(val, priv->cycles_per_wakeup);
+		break;
+	case FW_ISO_LOOPBACK_PROP_TYPE_SIMULATED_CYCLES:
+		g_value_set_uint64(val, priv->simulated_cycles);
+		break;
+	case FW_ISO_LOOPBACK_PROP_TYPE_DELIVERED_PACKETS:
+		g_value_set_uint64(val, priv->delivered_packets);
+		break;
+	case FW_ISO_LOOPBACK_PROP_TYPE_DROPPED_PACKETS:
+		g_value_set_uint64(val, priv->dropped_packets);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, id, spec);
+		break;
+	}
+}
+
+static void fw_iso_loopback_set_property(GObject *obj, guint id, const GValue *val,
+					 GParamSpec *spec)
+{
+	HinokoFwIsoLoopback *self = HINOKO_FW_ISO_LOOPBACK(obj);
+	HinokoFwIsoLoopbackPrivate *priv = hinoko_fw_iso_loopback_get_instance_private(self);
+
+	switch (id) {
+	case FW_ISO_LOOPBACK_PROP_TYPE_CYCLES_PER_WAKEUP:
+		priv->cycles_per_wakeup = g_value_get_uint(val);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, id, spec);
+		break;
+	}
+}
+
+static void free_port(gpointer data)
+{
+	struct loopback_port *port = data;
+
+	g_signal_handler_disconnect(port->ctx, port->handler_id);
+
+	// The context can be attached to the other loopback after released.
+	if (port->state->queue_offline_data == port) {
+		port->state->queue_offline = NULL;
+		port->state->queue_offline_data = NULL;
+	}
+
+	g_object_unref(port->ctx);
+	g_free(port->chunks);
+	g_free(port->headers);
+	g_free(port);
+}
+
+static void fw_iso_loopback_finalize(GObject *obj)
+{
+	HinokoFwIsoLoopback *self = HINOKO_FW_ISO_LOOPBACK(obj);
+	HinokoFwIsoLoopbackPrivate *priv = hinoko_fw_iso_loopback_get_instance_private(self);
+
+	g_ptr_array_unref(priv->ports);
+	g_byte_array_unref(priv->frame);
+
+	G_OBJECT_CLASS(hinoko_fw_iso_loopback_parent_class)->finalize(obj);
+}
+
+static void hinoko_fw_iso_loopback_class_init(HinokoFwIsoLoopbackClass *klass)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+
+	gobject_class->get_property = fw_iso_loopback_get_property;
+	gobject_class->set_property = fw_iso_loopback_set_property;
+	gobject_class->finalize = fw_iso_loopback_finalize;
+
+	/**
+	 * HinokoFwIsoLoopback:cycles-per-wakeup:
+	 *
+	 * The number of isochronous cycles between wakeups of the source created by
+	 * [method@FwIsoLoopback.create_source]. The cycles elapsed since the last wakeup are
+	 * simulated at once, like the interval of hardware interrupt. The value is applied at
+	 * creating the source.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_LOOPBACK_PROP_TYPE_CYCLES_PER_WAKEUP,
+		g_param_spec_uint("cycles-per-wakeup", "cycles-per-wakeup",
+				  "The number of isochronous cycles between wakeups",
+				  1, IEEE1394_CYCLES_PER_SEC, DEFAULT_CYCLES_PER_WAKEUP,
+				  G_PARAM_READWRITE));
+
+	/**
+	 * HinokoFwIsoLoopback:simulated-cycles:
+	 *
+	 * The number of isochronous cycles simulated so far.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_LOOPBACK_PROP_TYPE_SIMULATED_CYCLES,
+		g_param_spec_uint64("simulated-cycles", "simulated-cycles",
+				    "The number of isochronous cycles simulated so far",
+				    0, G_MAXUINT64, 0,
+				    G_PARAM_READABLE));
+
+	/**
+	 * HinokoFwIsoLoopback:delivered-packets:
+	 *
+	 * The number of packets received by IR contexts. The packet received by several contexts
+	 * is counted for each of them.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_LOOPBACK_PROP_TYPE_DELIVERED_PACKETS,
+		g_param_spec_uint64("delivered-packets", "delivered-packets",
+				    "The number of packets received by IR contexts",
+				    0, G_MAXUINT64, 0,
+				    G_PARAM_READABLE));
+
+	/**
+	 * HinokoFwIsoLoopback:dropped-packets:
+	 *
+	 * The number of packets not received by IR contexts listening to the channel, due to no
+	 * chunk queued to store them.
+	 *
+	 * Since: 1.1
+	 */
+	g_object_class_install_property(gobject_class, FW_ISO_LOOPBACK_PROP_TYPE_DROPPED_PACKETS,
+		g_param_spec_uint64("dropped-packets", "dropped-packets",
+				    "The number of packets dropped due to no queued chunk",
+				    0, G_MAXUINT64, 0,
+				    G_PARAM_READABLE));
+}
+
+static void hinoko_fw_iso_loopback_init(HinokoFwIsoLoopback *self)
+{
+	HinokoFwIsoLoopbackPrivate *priv = hinoko_fw_iso_loopback_get_instance_private(self);
+
+	priv->ports = g_ptr_array_new_with_free_func(free_port);
+	priv->cycles_per_wakeup = DEFAULT_CYCLES_PER_WAKEUP;
+	priv->frame = g_byte_array_new();
+}
+
+/**
+ * hinoko_fw_iso_loopback_new:
+ *
+ * Instantiate [class@FwIsoLoopback] object and return the instance.
+ *
+ * Returns: an instance of [class@FwIsoLoopback].
+ *
+ * Since: 1.1
+ */
+HinokoFwIsoLoopback *hinoko_fw_iso_loopback_new(void)
+{
+	return g_object_new(HINOKO_TYPE_FW_ISO_LOOPBACK, NULL);
+}
+
+static void reset_port(struct loopback_port *port)
+{
+	port->started = FALSE;
+	port->head = 0;
+	port->count = 0;
+	port->queued_bytes = 0;
+	port->header_length = 0;
+	port->write_offset = 0;
+	port->completed = 0;
+	port->interrupt = FALSE;
+}
+
+// The ring is sized to the number of chunks in buffer at first, and expanded when the application
+// queues chunks beyond it.
+static void expand_port(struct loopback_port *port, guint header_size)
+{
+	guint capacity = MAX(port->capacity * 2, port->state->chunks_per_buffer);
+	struct loopback_chunk *chunks = g_new(struct loopback_chunk, capacity);
+	guint8 *headers = NULL;
+	guint i;
+
+	if (header_size > 0)
+		headers = g_malloc(capacity * header_size);
+
+	for (i = 0; i < port->count; ++i) {
+		guint index = (port->head + i) % port->capacity;
+
+		chunks[i] = port->chunks[index];
+		if (headers != NULL)
+			memcpy(headers + i * header_size, port->headers + index * header_size,
+			       header_size);
+	}
+
+	g_free(port->chunks);
+	g_free(port->headers);
+	port->chunks = chunks;
+	port->headers = headers;
+	port->capacity = capacity;
+	port->head = 0;
+}
+
+static struct loopback_chunk pop_chunk(struct loopback_port *port)
+{
+	struct loopback_chunk chunk = port->chunks[port->head];
+
+	port->head = (port->head + 1) % port->capacity;
+	--port->count;
+	port->queued_bytes -= fw_cdev_iso_packet_control_to_payload_length(chunk.control);
+
+	return chunk;
+}
+
+static void queue_chunks(struct fw_iso_ctx_state *state, const guint8 *packets, guint size,
+			 guint buf_offset, gpointer user_data)
+{
+	struct loopback_port *port = user_data;
+	guint bytes_per_buffer = state->bytes_per_chunk * state->chunks_per_buffer;
+	guint header_size = 0;
+	guint pos = 0;
+
+	// The header of chunk follows the descriptor just for IT context.
+	if (state->mode == HINOKO_FW_ISO_CTX_MODE_IT)
+		header_size = state->header_size;
+
+	while (pos < size) {
+		const struct fw_cdev_iso_packet *datum =
+			(const struct fw_cdev_iso_packet *)(packets + pos);
+		guint payload_length = fw_cdev_iso_packet_control_to_payload_length(datum->control);
+		guint header_length = 0;
+		guint index;
+
+		if (port->count == port->capacity)
+			expand_port(port, header_size);
+
+		index = (port->head + port->count) % port->capacity;
+		port->chunks[index].control = datum->control;
+		port->chunks[index].offset = buf_offset;
+		++port->count;
+		port->queued_bytes += payload_length;
+
+		if (header_size > 0) {
+			header_length = fw_cdev_iso_packet_control_to_header_length(datum->control);
+			memcpy(port->headers + index * header_size, datum->header, header_length);
+		}
+
+		pos += sizeof(*datum) + header_length;
+		buf_offset = (buf_offset + payload_length) % bytes_per_buffer;
+	}
+}
+
+static void handle_stopped(HinokoFwIsoCtx *ctx, const GError *error, gpointer user_data)
+{
+	reset_port(user_data);
+}
+
+static guint max_header_length(const struct fw_iso_ctx_state *state)
+{
+	return state->event_buf_length - sizeof(struct fw_cdev_event_iso_interrupt);
+}
+
+static void emit_iso_interrupt(struct loopback_port *port, guint32 tstamp)
+{
+	struct fw_cdev_event_iso_interrupt *ev =
+		(struct fw_cdev_event_iso_interrupt *)port->state->event_buf;
+
+	ev->closure = 0;
+	ev->type = FW_CDEV_EVENT_ISO_INTERRUPT;
+	ev->cycle = tstamp;
+	ev->header_length = port->header_length;
+	port->header_length = 0;
+
+	fw_iso_ctx_state_dispatch_event(port->state, port->ctx, port->handle_event,
+					(const union fw_cdev_event *)ev,
+					sizeof(*ev) + ev->header_length);
+}
+
+static void emit_iso_interrupt_mc(struct loopback_port *port)
+{
+	struct fw_cdev_event_iso_interrupt_mc *ev =
+		(struct fw_cdev_event_iso_interrupt_mc *)port->state->event_buf;
+
+	ev->closure = 0;
+	ev->type = FW_CDEV_EVENT_ISO_INTERRUPT_MULTICHANNEL;
+	ev->completed = port->completed;
+	port->interrupt = FALSE;
+
+	fw_iso_ctx_state_dispatch_event(port->state, port->ctx, port->handle_event,
+					(const union fw_cdev_event *)ev, sizeof(*ev));
+}
+
+static void copy_packet_data(const struct loopback_packet *pkt, guint pos, guint8 *dst,
+			     guint length)
+{
+	if (pos < pkt->header_length) {
+		guint count = MIN(length, pkt->header_length - pos);
+
+		memcpy(dst, pkt->header + pos, count);
+		dst += count;
+		pos += count;
+		length -= count;
+	}
+
+	if (length > 0)
+		memcpy(dst, pkt->payload + pos - pkt->header_length, length);
+}
+
+// The chunk flagged to wait for sync discards packets till the sy field of packet matches the sync
+// code given at starting.
+static gboolean wait_for_sync(const struct loopback_port *port, const struct loopback_packet *pkt)
+{
+	const struct loopback_chunk *chunk = port->chunks + port->head;
+
+	return (chunk->control & FW_CDEV_ISO_SYNC) &&
+	       ieee1394_iso_header_to_sync_code(pkt->iso_header) != port->state->start_sync_code;
+}
+
+// The context header consists of the isochronous packet header, the timestamp, and the leading
+// quadlets of data in big endian, then the rest of data is in the chunk of buffer.
+static gboolean receive_ir_single(struct loopback_port *port, const struct loopback_packet *pkt)
+{
+	struct fw_iso_ctx_state *state = port->state;
+	struct fw_cdev_event_iso_interrupt *ev =
+		(struct fw_cdev_event_iso_interrupt *)state->event_buf;
+	guint data_length = pkt->header_length + pkt->payload_length;
+	struct loopback_chunk chunk;
+	guint32 *header;
+	guint pos = 0;
+	guint length;
+
+	if (port->count == 0 || wait_for_sync(port, pkt))
+		return FALSE;
+	chunk = pop_chunk(port);
+
+	header = ev->header + port->header_length / 4;
+	header[0] = GUINT32_TO_BE(pkt->iso_header);
+	if (state->header_size >= 8)
+		header[1] = GUINT32_TO_BE(pkt->tstamp);
+	if (state->header_size > 8) {
+		guint8 *dst = (guint8 *)(header + 2);
+
+		pos = MIN(data_length, state->header_size - 8);
+		copy_packet_data(pkt, 0, dst, pos);
+		memset(dst + pos, 0, state->header_size - 8 - pos);
+	}
+	port->header_length += state->header_size;
+
+	length = fw_cdev_iso_packet_control_to_payload_length(chunk.control);
+	length = MIN(data_length - pos, length);
+	copy_packet_data(pkt, pos, state->addr + chunk.offset, length);
+
+	// Linux FireWire subsystem also generates the event when the header fills one page.
+	if ((chunk.control & FW_CDEV_ISO_INTERRUPT) ||
+	    port->header_length + state->header_size > max_header_length(state))
+		emit_iso_interrupt(port, pkt->tstamp);
+
+	return TRUE;
+}
+
+// In buffer-fill mode, the data padded to quadlet is sandwiched by the isochronous packet header
+// and the timestamp in little endian, and packets are stored across chunks.
+static gboolean receive_ir_multiple(HinokoFwIsoLoopbackPrivate *priv, struct loopback_port *port,
+				    const struct loopback_packet *pkt)
+{
+	struct fw_iso_ctx_state *state = port->state;
+	guint bytes_per_buffer = state->bytes_per_chunk * state->chunks_per_buffer;
+	guint data_length = pkt->header_length + pkt->payload_length;
+	guint length = 4 + ((data_length + 3) & ~3u) + 4;
+	guint8 *frame;
+	guint pos;
+
+	if (port->queued_bytes < port->write_offset + length)
+		return FALSE;
+
+	// The packets are stored across chunks once the sync is detected.
+	if (port->write_offset == 0) {
+		if (wait_for_sync(port, pkt))
+			return FALSE;
+		port->chunks[port->head].control &= ~FW_CDEV_ISO_SYNC;
+	}
+
+	g_byte_array_set_size(priv->frame, length);
+	frame = priv->frame->data;
+	*(guint32 *)frame = GUINT32_TO_LE(pkt->iso_header);
+	copy_packet_data(pkt, 0, frame + 4, data_length);
+	memset(frame + 4 + data_length, 0, length - 8 - data_length);
+	*(guint32 *)(frame + length - 4) = GUINT32_TO_LE(pkt->tstamp);
+
+	for (pos = 0; pos < length;) {
+		const struct loopback_chunk *chunk = port->chunks + port->head;
+		guint chunk_length = fw_cdev_iso_packet_control_to_payload_length(chunk->control);
+		guint count = MIN(length - pos, chunk_length - port->write_offset);
+
+		memcpy(state->addr + chunk->offset + port->write_offset, frame + pos, count);
+		pos += count;
+		port->write_offset += count;
+		port->completed = (chunk->offset + port->write_offset) % bytes_per_buffer;
+
+		if (port->write_offset == chunk_length) {
+			if (chunk->control & FW_CDEV_ISO_INTERRUPT)
+				port->interrupt = TRUE;
+			pop_chunk(port);
+			port->write_offset = 0;
+		}
+	}
+
+	if (port->interrupt)
+		emit_iso_interrupt_mc(port);
+
+	return TRUE;
+}
+
+static void deliver_packet(HinokoFwIsoLoopbackPrivate *priv, guint channel,
+			   const struct loopback_packet *pkt)
+{
+	guint64 channel_flag = G_GUINT64_CONSTANT(1) << channel;
+	guint tag_flag = 1 << ieee1394_iso_header_to_tag(pkt->iso_header);
+	guint i;
+
+	for (i = 0; i < priv->ports->len; ++i) {
+		struct loopback_port *port = g_ptr_array_index(priv->ports, i);
+		struct fw_iso_ctx_state *state = port->state;
+		gboolean received;
+
+		if (state->mode == HINOKO_FW_ISO_CTX_MODE_IT || !state->running || !port->started)
+			continue;
+
+		if (!(port->channels & channel_flag))
+			continue;
+
+		if (state->start_tags != 0 && !(state->start_tags & tag_flag))
+			continue;
+
+		if (state->mode == HINOKO_FW_ISO_CTX_MODE_IR_SINGLE)
+			received = receive_ir_single(port, pkt);
+		else
+			received = receive_ir_multiple(priv, port, pkt);
+
+		if (received)
+			++priv->delivered_packets;
+		else
+			++priv->dropped_packets;
+	}
+}
+
+static void transmit_packet(HinokoFwIsoLoopbackPrivate *priv, struct loopback_port *port,
+			    guint32 tstamp)
+{
+	struct fw_iso_ctx_state *state = port->state;
+	struct fw_cdev_event_iso_interrupt *ev;
+	struct loopback_chunk chunk;
+	guint header_length;
+
+	// Nothing is transmitted till the application queues chunks.
+	if (port->count == 0)
+		return;
+
+	chunk = port->chunks[port->head];
+	header_length = fw_cdev_iso_packet_control_to_header_length(chunk.control);
+	if (header_length > 0)
+		memcpy(priv->header, port->headers + port->head * state->header_size,
+		       header_length);
+	pop_chunk(port);
+
+	if (!(chunk.control & FW_CDEV_ISO_SKIP)) {
+		struct loopback_packet pkt = {
+			.tstamp = tstamp,
+			.header = priv->header,
+			.header_length = header_length,
+			.payload = state->addr + chunk.offset,
+			.payload_length =
+				fw_cdev_iso_packet_control_to_payload_length(chunk.control),
+		};
+
+		pkt.iso_header =
+			((pkt.header_length + pkt.payload_length) <<
+			 IEEE1394_ISO_HEADER_DATA_LENGTH_SHIFT) |
+			(fw_cdev_iso_packet_control_to_tag(chunk.control) <<
+			 IEEE1394_ISO_HEADER_TAG_SHIFT) |
+			(port->channel << IEEE1394_ISO_HEADER_CHANNEL_SHIFT) |
+			(IEEE1394_TCODE_STREAM_DATA << IEEE1394_ISO_HEADER_TCODE_SHIFT) |
+			(fw_cdev_iso_packet_control_to_sync_code(chunk.control) <<
+			 IEEE1394_ISO_HEADER_SY_SHIFT);
+
+		deliver_packet(priv, port->channel, &pkt);
+
+		// The handler of signal for IR context can stop the IT context.
+		if (!state->running)
+			return;
+	}
+
+	// The context header has the timestamp of each handled packet in big endian.
+	ev = (struct fw_cdev_event_iso_interrupt *)state->event_buf;
+	ev->header[port->header_length / 4] = GUINT32_TO_BE(tstamp);
+	port->header_length += 4;
+
+	if ((chunk.control & FW_CDEV_ISO_INTERRUPT) ||
+	    port->header_length + 4 > max_header_length(state))
+		emit_iso_interrupt(port, tstamp);
+}
+
+static void simulate_cycle(HinokoFwIsoLoopbackPrivate *priv)
+{
+	guint cycles = priv->cycles % IEEE1394_CYCLES_PER_ROUND;
+	gint cycles_in_window = cycles % OHCI1394_cycleMatch_CYCLES_PER_WINDOW;
+	guint32 tstamp;
+	guint i;
+
+	// The timestamp of isochronous descriptor has the lower three bits of second.
+	tstamp = (((cycles / IEEE1394_CYCLES_PER_SEC) << OHCI1394_ISOC_DESC_timeStamp_SEC_SHIFT) &
+		  OHCI1394_ISOC_DESC_timeStamp_SEC_MASK) | (cycles % IEEE1394_CYCLES_PER_SEC);
+
+	// The cycle match has the lower two bits of second.
+	for (i = 0; i < priv->ports->len; ++i) {
+		struct loopback_port *port = g_ptr_array_index(priv->ports, i);
+		gint start_cycle = port->state->start_cycle;
+
+		if (port->state->running && !port->started &&
+		    (start_cycle < 0 || start_cycle == cycles_in_window))
+			port->started = TRUE;
+	}
+
+	for (i = 0; i < priv->ports->len; ++i) {
+		struct loopback_port *port = g_ptr_array_index(priv->ports, i);
+
+		if (port->state->mode == HINOKO_FW_ISO_CTX_MODE_IT && port->state->running &&
+		    port->started)
+			transmit_packet(priv, port, tstamp);
+	}
+
+	++priv->cycles;
+	++priv->simulated_cycles;
+}
+
+static gboolean attach_ctx(HinokoFwIsoLoopback *self, HinokoFwIsoCtx *ctx, guint channel,
+			   guint header_size, const guint8 *channels, guint channels_length,
+			   GError **error)
+{
+	HinokoFwIsoLoopbackPrivate *priv = hinoko_fw_iso_loopback_get_instance_private(self);
+	fw_iso_ctx_handle_event_t handle_event;
+	struct fw_iso_ctx_state *state;
+	struct loopback_port *port;
+	gboolean result;
+
+	state = fw_iso_ctx_get_state(ctx, &handle_event);
+
+	if (state->fd >= 0) {
+		generate_fw_iso_ctx_error_coded(error, HINOKO_FW_ISO_CTX_ERROR_ALLOCATED);
+		return FALSE;
+	}
+
+	// The path is not used for the offline context.
+	state->offline = TRUE;
+
+	if (HINOKO_IS_FW_ISO_IT(ctx)) {
+		result = hinoko_fw_iso_it_allocate(HINOKO_FW_ISO_IT(ctx), "loopback",
+						   HINOKO_FW_SCODE_S400, channel, header_size,
+						   error);
+	} else if (HINOKO_IS_FW_ISO_IR_SINGLE(ctx)) {
+		result = hinoko_fw_iso_ir_single_allocate(HINOKO_FW_ISO_IR_SINGLE(ctx), "loopback",
+							  channel, header_size, error);
+	} else {
+		result = hinoko_fw_iso_ir_multiple_allocate(HINOKO_FW_ISO_IR_MULTIPLE(ctx),
+							    "loopback", channels, channels_length,
+							    error);
+	}
+
+	if (!result) {
+		state->offline = FALSE;
+		return FALSE;
+	}
+
+	port = g_new0(struct loopback_port, 1);
+	port->ctx = g_object_ref(ctx);
+	port->state = state;
+	port->handle_event = handle_event;
+	port->channel = channel;
+
+	if (channels != NULL) {
+		guint i;
+
+		for (i = 0; i < channels_length; ++i)
+			port->channels |= G_GUINT64_CONSTANT(1) << channels[i];
+	} else {
+		port->channels = G_GUINT64_CONSTANT(1) << channel;
+	}
+
+	port->handler_id = g_signal_connect(ctx, STOPPED_SIGNAL_NAME, G_CALLBACK(handle_stopped),
+					    port);
+	state->queue_offline_data = port;
+	state->queue_offline = queue_chunks;
+
+	g_ptr_array_add(priv->ports, port);
+
+	return TRUE;
+}
+
+/**
+ * hinoko_fw_iso_loopback_attach_it:
+ * @self: A [class@FwIsoLoopback].
+ * @ctx: A [class@FwIsoIt] not allocated yet.
+ * @channel: An isochronous channel to transfer, up to 63.
+ * @header_size: The number of bytes for header of IT context.
+ * @error: A [struct@GLib.Error]. Error can be generated with domain of Hinoko.FwIsoCtxError.
+ *
+ * Allocate the IT context offline and attach it to the loopback, instead of
+ * [method@FwIsoIt.allocate]. The packets transmitted by the context are delivered to the IR
+ * contexts attached to the loopback.
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_loopback_attach_it(HinokoFwIsoLoopback *self, HinokoFwIsoIt *ctx,
+					  guint channel, guint header_size, GError **error)
+{
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_LOOPBACK(self), FALSE);
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_IT(ctx), FALSE);
+	g_return_val_if_fail(channel <= IEEE1394_MAX_CHANNEL, FALSE);
+	g_return_val_if_fail(header_size <= G_MAXUINT8, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	return attach_ctx(self, HINOKO_FW_ISO_CTX(ctx), channel, header_size, NULL, 0, error);
+}
+
+/**
+ * hinoko_fw_iso_loopback_attach_ir_single:
+ * @self: A [class@FwIsoLoopback].
+ * @ctx: A [class@FwIsoIrSingle] not allocated yet.
+ * @channel: An isochronous channel to listen, up to 63.
+ * @header_size: The number of bytes for header of IR context, greater than 4 at least.
+ * @error: A [struct@GLib.Error]. Error can be generated with domain of Hinoko.FwIsoCtxError.
+ *
+ * Allocate the IR context offline and attach it to the loopback, instead of
+ * [method@FwIsoIrSingle.allocate]. The context receives the packets transmitted by the IT
+ * contexts attached to the loopback.
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_loopback_attach_ir_single(HinokoFwIsoLoopback *self,
+						 HinokoFwIsoIrSingle *ctx, guint channel,
+						 guint header_size, GError **error)
+{
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_LOOPBACK(self), FALSE);
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_IR_SINGLE(ctx), FALSE);
+	g_return_val_if_fail(channel <= IEEE1394_MAX_CHANNEL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	return attach_ctx(self, HINOKO_FW_ISO_CTX(ctx), channel, header_size, NULL, 0, error);
+}
+
+/**
+ * hinoko_fw_iso_loopback_attach_ir_multiple:
+ * @self: A [class@FwIsoLoopback].
+ * @ctx: A [class@FwIsoIrMultiple] not allocated yet.
+ * @channels: (array length=channels_length) (element-type guint8): an array for channels to listen
+ *	      to.
+ * @channels_length: The length of channels.
+ * @error: A [struct@GLib.Error]. Error can be generated with domain of Hinoko.FwIsoCtxError.
+ *
+ * Allocate the IR context offline and attach it to the loopback, instead of
+ * [method@FwIsoIrMultiple.allocate]. The context receives the packets transmitted by the IT
+ * contexts attached to the loopback.
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_loopback_attach_ir_multiple(HinokoFwIsoLoopback *self,
+						   HinokoFwIsoIrMultiple *ctx,
+						   const guint8 *channels, guint channels_length,
+						   GError **error)
+{
+	guint i;
+
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_LOOPBACK(self), FALSE);
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_IR_MULTIPLE(ctx), FALSE);
+	g_return_val_if_fail(channels != NULL, FALSE);
+	g_return_val_if_fail(channels_length > 0, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	for (i = 0; i < channels_length; ++i)
+		g_return_val_if_fail(channels[i] <= IEEE1394_MAX_CHANNEL, FALSE);
+
+	return attach_ctx(self, HINOKO_FW_ISO_CTX(ctx), 0, 0, channels, channels_length, error);
+}
+
+/**
+ * hinoko_fw_iso_loopback_advance:
+ * @self: A [class@FwIsoLoopback].
+ * @cycles: The number of isochronous cycles to simulate.
+ *
+ * Simulate the given number of isochronous cycles as fast as possible in the thread of caller.
+ * The signals of contexts are emitted within the call. The simulated clock is independent of the
+ * cycle time read from the contexts, thus it is not expected to start them at the cycle computed
+ * from the system time.
+ *
+ * Since: 1.1
+ */
+void hinoko_fw_iso_loopback_advance(HinokoFwIsoLoopback *self, guint cycles)
+{
+	HinokoFwIsoLoopbackPrivate *priv;
+
+	g_return_if_fail(HINOKO_IS_FW_ISO_LOOPBACK(self));
+	priv = hinoko_fw_iso_loopback_get_instance_private(self);
+
+	while (cycles-- > 0)
+		simulate_cycle(priv);
+}
+
+static gint64 monotonic_cycles(void)
+{
+	struct timespec ts;
+
+	clock_gettime(FW_ISO_CTX_OFFLINE_CLOCK_ID, &ts);
+
+	return (ts.tv_sec * G_GINT64_CONSTANT(1000000000) + ts.tv_nsec) / IEEE1394_NSEC_PER_CYCLE;
+}
+
+static gboolean check_src(GSource *source)
+{
+	FwIsoLoopbackSource *src = (FwIsoLoopbackSource *)source;
+	GIOCondition condition;
+
+	condition = g_source_query_unix_fd(source, src->tag);
+	return !!(condition & (G_IO_IN | G_IO_ERR));
+}
+
+static gboolean dispatch_src(GSource *source, GSourceFunc cb, gpointer user_data)
+{
+	FwIsoLoopbackSource *src = (FwIsoLoopbackSource *)source;
+	HinokoFwIsoLoopbackPrivate *priv = hinoko_fw_iso_loopback_get_instance_private(src->self);
+	GIOCondition condition;
+	guint64 expirations;
+	guint64 cycles;
+
+	condition = g_source_query_unix_fd(source, src->tag);
+	if (condition & G_IO_ERR)
+		return G_SOURCE_REMOVE;
+
+	if (read(src->fd, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN)
+		return G_SOURCE_REMOVE;
+
+	// The cycles elapsed since the last wakeup are simulated at once, like the isochronous
+	// cycles handled by 1394 OHCI hardware between interrupts.
+	cycles = monotonic_cycles();
+	while (priv->cycles < cycles)
+		simulate_cycle(priv);
+
+	return G_SOURCE_CONTINUE;
+}
+
+static void finalize_src(GSource *source)
+{
+	FwIsoLoopbackSource *src = (FwIsoLoopbackSource *)source;
+
+	close(src->fd);
+	g_object_unref(src->self);
+}
+
+/**
+ * hinoko_fw_iso_loopback_create_source:
+ * @self: A [class@FwIsoLoopback].
+ * @source: (out): A [struct@GLib.Source].
+ * @error: A [struct@GLib.Error].
+ *
+ * Create [struct@GLib.Source] for [struct@GLib.MainContext] to drive the simulated clock at the
+ * pace of CLOCK_MONOTONIC. The isochronous cycle of simulated clock is the same as the one in the
+ * cycle time read from the attached contexts, thus the contexts can be started at the cycle
+ * computed from the system time.
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_loopback_create_source(HinokoFwIsoLoopback *self, GSource **source,
+					      GError **error)
+{
+	static GSourceFuncs funcs = {
+		.check		= check_src,
+		.dispatch	= dispatch_src,
+		.finalize	= finalize_src,
+	};
+	HinokoFwIsoLoopbackPrivate *priv;
+	FwIsoLoopbackSource *src;
+	struct itimerspec its = {0};
+	gint64 interval_ns;
+	int fd;
+
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_LOOPBACK(self), FALSE);
+	g_return_val_if_fail(source != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+	priv = hinoko_fw_iso_loopback_get_instance_private(self);
+
+	fd = timerfd_create(FW_ISO_CTX_OFFLINE_CLOCK_ID, TFD_CLOEXEC | TFD_NONBLOCK);
+	if (fd < 0) {
+		generate_syscall_error(error, errno, "timerfd_create(%d)",
+				       FW_ISO_CTX_OFFLINE_CLOCK_ID);
+		return FALSE;
+	}
+
+	interval_ns = priv->cycles_per_wakeup * IEEE1394_NSEC_PER_CYCLE;
+	its.it_interval.tv_sec = interval_ns / G_GINT64_CONSTANT(1000000000);
+	its.it_interval.tv_nsec = interval_ns % G_GINT64_CONSTANT(1000000000);
+	its.it_value = its.it_interval;
+	if (timerfd_settime(fd, 0, &its, NULL) < 0) {
+		generate_syscall_error(error, errno, "timerfd_settime(%d)", fd);
+		close(fd);
+		return FALSE;
+	}
+
+	// The simulated clock begins at the current isochronous cycle.
+	priv->cycles = monotonic_cycles();
+
+	*source = g_source_new(&funcs, sizeof(FwIsoLoopbackSource));
+
+	g_source_set_name(*source, "HinokoFwIsoLoopback");
+
+	src = (FwIsoLoopbackSource *)(*source);
+	src->tag = g_source_add_unix_fd(*source, fd, G_IO_IN);
+	src->fd = fd;
+	src->self = g_object_ref(self);
+
+	return TRUE;
+}
@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#ifndef __ORG_KERNEL_HINOKO_FW_ISO_LOOPBACK_H__
+#define __ORG_KERNEL_HINOKO_FW_ISO_LOOPBACK_H__
+
+#include <hinoko.h>
+
+G_BEGIN_DECLS
+
+#define HINOKO_TYPE_FW_ISO_LOOPBACK	(hinoko_fw_iso_loopback_get_type())
+
+G_DECLARE_DERIVABLE_TYPE(HinokoFwIsoLoopback, hinoko_fw_iso_loopback, HINOKO, FW_ISO_LOOPBACK,
+			 GObject);
+
+struct _HinokoFwIsoLoopbackClass {
+	GObjectClass parent_class;
+};
+
+HinokoFwIsoLoopback *hinoko_fw_iso_loopback_new(void);
+
+gboolean hinoko_fw_iso_loopback_attach_it(HinokoFwIsoLoopback *self, HinokoFwIsoIt *ctx,
+					  guint channel, guint header_size, GError **error);
+
+gboolean hinoko_fw_iso_loopback_attach_ir_single(HinokoFwIsoLoopback *self,
+						 HinokoFwIsoIrSingle *ctx, guint channel,
+						 guint header_size, GError **error);
+
+gboolean hinoko_fw_iso_loopback_attach_ir_multiple(HinokoFwIsoLoopback *self,
+						   HinokoFwIsoIrMultiple *ctx,
+						   const guint8 *channels, guint channels_length,
+						   GError **error);
+
+void hinoko_fw_iso_loopback_advance(HinokoFwIsoLoopback *self, guint cycles);
+
+gboolean hinoko_fw_iso_loopback_create_source(HinokoFwIsoLoopback *self, GSource **source,
+					      GError **error);
+
+G_END_DECLS
+
+#endif
@@ -240,6 +240,507 @@ gboolean hinoko_fw_iso_resource_allocate_wait(HinokoFwIsoResource *self,
 	return fw_iso_resource_waiter_wait(&w, self, error);
 }
 
+/**
+ * hinoko_fw_iso_resource_allocate_async:
+ * @self: A [iface@FwIsoResource].
+ * @channel_candidates: (array length=channel_candidates_count): The array with elements for
+ *			numeric number for isochronous channel to be allocated.
+ * @channel_candidates_count: The number of channel candidates.
+ * @bandwidth: The amount of bandwidth to be allocated.
+ * @cancellable: (nullable): A [class@Gio.Cancellable].
+ * @callback: (scope async): A [callback@Gio.AsyncReadyCallback] to call when the request is
+ *	      satisfied.
+ * @user_data: (closure): The data to pass to callback function.
+ *
+ * Initiate allocation of isochronous resource and complete the returned task when
+ * [signal@FwIsoResource::allocated] signal is emitted. The task is dispatched by the thread-default
+ * [struct@GLib.MainContext] at the call, while the signal is emitted by [struct@GLib.Source]
+ * retrieved by [method@FwIsoResource.create_source]. The cancellation just stops waiting for the
+ * signal, thus the allocated resource is left as is when the request has already reached the bus
+ * manager. Call [method@FwIsoResource.allocate_finish] in the callback to get the result.
+ *
+ * The task is completed by the next emission of the signal, therefore one request is expected to
+ * be outstanding in the instance at the same time.
+ *
+ * Since: 1.1
+ */
+void hinoko_fw_iso_resource_allocate_async(HinokoFwIsoResource *self,
+					   const guint8 *channel_candidates,
+					   gsize channel_candidates_count, guint bandwidth,
+					   GCancellable *cancellable, GAsyncReadyCallback callback,
+					   gpointer user_data)
+{
+	GTask *task;
+	GError *error = NULL;
+
+	g_return_if_fail(HINOKO_IS_FW_ISO_RESOURCE(self));
+	g_return_if_fail(channel_candidates != NULL);
+	g_return_if_fail(channel_candidates_count > 0);
+	g_return_if_fail(bandwidth > 0);
+	g_return_if_fail(cancellable == NULL || G_IS_CANCELLABLE(cancellable));
+
+	task = fw_iso_resource_task_new(self, ALLOCATED_SIGNAL_NAME, cancellable, callback,
+					user_data, hinoko_fw_iso_resource_allocate_async);
+	if (task == NULL)
+		return;
+
+	if (!hinoko_fw_iso_resource_allocate(self, channel_candidates, channel_candidates_count,
+					     bandwidth, &error))
+		fw_iso_resource_task_abort(task, error);
+}
+
+/**
+ * hinoko_fw_iso_resource_allocate_finish:
+ * @self: A [iface@FwIsoResource].
+ * @result: A [iface@Gio.AsyncResult] passed to the callback function.
+ * @channel: (out): The allocated channel number.
+ * @bandwidth: (out): The allocated amount of bandwidth.
+ * @error: A [struct@GLib.Error]. Error can be generated with domain of [error@FwIsoResourceError],
+ *	   [error@Gio.IOErrorEnum] for cancellation, as well as domain depending on each
+ *	   implementation.
+ *
+ * Finish the request initiated by [method@FwIsoResource.allocate_async].
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_resource_allocate_finish(HinokoFwIsoResource *self, GAsyncResult *result,
+						guint *channel, guint *bandwidth, GError **error)
+{
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_RESOURCE(self), FALSE);
+	g_return_val_if_fail(channel != NULL, FALSE);
+	g_return_val_if_fail(bandwidth != NULL, FALSE);
+
+	return fw_iso_resource_task_finish(self, result, hinoko_fw_iso_resource_allocate_async,
+					   channel, bandwidth, error);
+}
+
+#define RETRY_INITIAL_BACKOFF_MS	10
+
+struct retry_data {
+	HinokoFwIsoResource *self;
+	guint bandwidth;
+	HinokoFwIsoResourceChannelOrder order;
+	guint max_attempts;
+	guint max_backoff_ms;
+	guint attempt_timeout_ms;
+
+	guint8 candidates[64];
+	gint64 failed_at[64];
+	gsize candidate_count;
+
+	gsize round[64];
+	gsize cursor;
+
+	guint attempts;
+	guint backoff_ms;
+	gboolean in_flight;
+	gboolean bus_reset;
+	gboolean timed_out;
+
+	gulong generation_handler_id;
+	GSource *timer_src;
+	GSource *cancel_src;
+	GSource *attempt_src;
+	GCancellable *attempt_cancellable;
+
+	guint channel;
+	guint allocated_bandwidth;
+};
+
+static void build_round(struct retry_data *d)
+{
+	gsize i;
+	gsize j;
+
+	for (i = 0; i < d->candidate_count; ++i)
+		d->round[i] = i;
+
+	switch (d->order) {
+	case HINOKO_FW_ISO_RESOURCE_CHANNEL_ORDER_RANDOM:
+		for (i = d->candidate_count - 1; i > 0; --i) {
+			gsize tmp;
+
+			j = g_random_int_range(0, i + 1);
+			tmp = d->round[i];
+			d->round[i] = d->round[j];
+			d->round[j] = tmp;
+		}
+		break;
+	case HINOKO_FW_ISO_RESOURCE_CHANNEL_ORDER_LEAST_RECENTLY_FAILED:
+		// Stable insertion sort. The candidate which has never failed comes first.
+		for (i = 1; i < d->candidate_count; ++i) {
+			gsize index = d->round[i];
+
+			for (j = i; j > 0 && d->failed_at[d->round[j - 1]] > d->failed_at[index]; --j)
+				d->round[j] = d->round[j - 1];
+			d->round[j] = index;
+		}
+		break;
+	case HINOKO_FW_ISO_RESOURCE_CHANNEL_ORDER_ORDERED:
+	default:
+		break;
+	}
+
+	d->cursor = 0;
+}
+
+static void complete_retry(GTask *task, GError *error)
+{
+	struct retry_data *d = g_task_get_task_data(task);
+
+	if (d->generation_handler_id > 0) {
+		g_signal_handler_disconnect(d->self, d->generation_handler_id);
+		d->generation_handler_id = 0;
+	}
+
+	if (d->timer_src != NULL) {
+		g_source_destroy(d->timer_src);
+		g_source_unref(d->timer_src);
+		d->timer_src = NULL;
+	}
+
+	if (d->cancel_src != NULL) {
+		g_source_destroy(d->cancel_src);
+		g_source_unref(d->cancel_src);
+		d->cancel_src = NULL;
+	}
+
+	g_clear_object(&d->attempt_cancellable);
+
+	if (error != NULL)
+		g_task_return_error(task, error);
+	else
+		g_task_return_boolean(task, TRUE);
+
+	// Release the reference owned by the pending request.
+	g_object_unref(task);
+}
+
+static void handle_attempt_result(GObject *source, GAsyncResult *result, gpointer user_data);
+
+static gboolean handle_attempt_expired(gpointer user_data)
+{
+	GTask *task = G_TASK(user_data);
+	struct retry_data *d = g_task_get_task_data(task);
+
+	// The source is destroyed by returning G_SOURCE_REMOVE.
+	g_source_unref(d->attempt_src);
+	d->attempt_src = NULL;
+
+	// The request in flight is completed with the cancellation. The request itself is still
+	// outstanding in the bus manager, thus no further request is issued.
+	d->timed_out = TRUE;
+	g_cancellable_cancel(d->attempt_cancellable);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void attempt_allocation(GTask *task)
+{
+	struct retry_data *d = g_task_get_task_data(task);
+	guint8 channel = d->candidates[d->round[d->cursor]];
+
+	++d->attempts;
+	d->in_flight = TRUE;
+	d->bus_reset = FALSE;
+	d->timed_out = FALSE;
+
+	g_clear_object(&d->attempt_cancellable);
+	d->attempt_cancellable = g_cancellable_new();
+
+	// The event can be delayed, for example when bus reset occurs before the request reaches
+	// the bus manager, thus each attempt is bound by timeout.
+	d->attempt_src = g_timeout_source_new(d->attempt_timeout_ms);
+	g_task_attach_source(task, d->attempt_src, handle_attempt_expired);
+
+	hinoko_fw_iso_resource_allocate_async(d->self, &channel, 1, d->bandwidth,
+					      d->attempt_cancellable, handle_attempt_result, task);
+}
+
+static gboolean handle_backoff_expired(gpointer user_data)
+{
+	GTask *task = G_TASK(user_data);
+	struct retry_data *d = g_task_get_task_data(task);
+
+	// The source is destroyed by returning G_SOURCE_REMOVE.
+	g_source_unref(d->timer_src);
+	d->timer_src = NULL;
+
+	build_round(d);
+	attempt_allocation(task);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void schedule_backoff(GTask *task)
+{
+	struct retry_data *d = g_task_get_task_data(task);
+
+	d->timer_src = g_timeout_source_new(d->backoff_ms);
+	g_task_attach_source(task, d->timer_src, handle_backoff_expired);
+
+	d->backoff_ms = MIN(d->backoff_ms * 2, d->max_backoff_ms);
+}
+
+static void handle_generation_notify(GObject *obj, GParamSpec *spec, gpointer user_data)
+{
+	GTask *task = G_TASK(user_data);
+	struct retry_data *d = g_task_get_task_data(task);
+
+	// Retry at once with the new generation of bus.
+	d->backoff_ms = MIN(RETRY_INITIAL_BACKOFF_MS, d->max_backoff_ms);
+
+	if (d->in_flight) {
+		d->bus_reset = TRUE;
+	} else if (d->timer_src != NULL) {
+		g_source_destroy(d->timer_src);
+		g_source_unref(d->timer_src);
+		d->timer_src = NULL;
+
+		build_round(d);
+		attempt_allocation(task);
+	}
+}
+
+static gboolean handle_retry_cancel(GCancellable *cancellable, gpointer user_data)
+{
+	GTask *task = G_TASK(user_data);
+	struct retry_data *d = g_task_get_task_data(task);
+
+	// The source is destroyed by returning G_SOURCE_REMOVE.
+	g_source_unref(d->cancel_src);
+	d->cancel_src = NULL;
+
+	// The request in flight is completed with the cancellation.
+	if (d->in_flight) {
+		g_cancellable_cancel(d->attempt_cancellable);
+	} else {
+		GError *error = NULL;
+
+		g_cancellable_set_error_if_cancelled(cancellable, &error);
+		complete_retry(task, error);
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
+static void handle_attempt_result(GObject *source, GAsyncResult *result, gpointer user_data)
+{
+	GTask *task = G_TASK(user_data);
+	struct retry_data *d = g_task_get_task_data(task);
+	GError *error = NULL;
+
+	d->in_flight = FALSE;
+
+	if (d->attempt_src != NULL) {
+		g_source_destroy(d->attempt_src);
+		g_source_unref(d->attempt_src);
+		d->attempt_src = NULL;
+	}
+
+	if (hinoko_fw_iso_resource_allocate_finish(d->self, result, &d->channel,
+						   &d->allocated_bandwidth, &error)) {
+		complete_retry(task, NULL);
+		return;
+	}
+
+	if (g_cancellable_is_cancelled(g_task_get_cancellable(task))) {
+		g_clear_error(&error);
+		g_cancellable_set_error_if_cancelled(g_task_get_cancellable(task), &error);
+		complete_retry(task, error);
+		return;
+	}
+
+	// The event of the expired request can arrive later and is not distinguishable from the
+	// event of the next request, since any event completes the task of the next request. Stop
+	// here, so that the event is not taken for the wrong request.
+	if (d->timed_out) {
+		g_clear_error(&error);
+		generate_fw_iso_resource_error_coded(&error, HINOKO_FW_ISO_RESOURCE_ERROR_TIMEOUT);
+		g_prefix_error(&error, "%u attempts: ", d->attempts);
+		complete_retry(task, error);
+		return;
+	}
+
+	// The failure of system call and cancellation are not retried.
+	if (!g_error_matches(error, HINOKO_FW_ISO_RESOURCE_ERROR,
+			     HINOKO_FW_ISO_RESOURCE_ERROR_EVENT)) {
+		complete_retry(task, error);
+		return;
+	}
+
+	if (d->attempts >= d->max_attempts) {
+		g_prefix_error(&error, "%u attempts: ", d->attempts);
+		complete_retry(task, error);
+		return;
+	}
+
+	d->failed_at[d->round[d->cursor]] = g_get_monotonic_time();
+	g_error_free(error);
+
+	if (d->bus_reset) {
+		// The bus reset occurs in flight. Start the new round at once.
+		build_round(d);
+		attempt_allocation(task);
+	} else if (++d->cursor < d->candidate_count) {
+		attempt_allocation(task);
+	} else {
+		schedule_backoff(task);
+	}
+}
+
+/**
+ * hinoko_fw_iso_resource_allocate_retry_async:
+ * @self: A [iface@FwIsoResource].
+ * @channel_candidates: (array length=channel_candidates_count): The array with elements for
+ *			numeric number for isochronous channel to be allocated.
+ * @channel_candidates_count: The number of channel candidates.
+ * @bandwidth: The amount of bandwidth to be allocated.
+ * @order: The strategy to iterate the channel candidates.
+ * @max_attempts: The maximum number of allocation requests.
+ * @max_backoff_ms: The maximum interval between rounds of the channel candidates.
+ * @attempt_timeout_ms: The timeout to wait for the event of each request.
+ * @cancellable: (nullable): A [class@Gio.Cancellable].
+ * @callback: (scope async): A [callback@Gio.AsyncReadyCallback] to call when the request is
+ *	      satisfied.
+ * @user_data: (closure): The data to pass to callback function.
+ *
+ * Initiate allocation of isochronous resource and retry it when the allocation fails in the event.
+ * Each request includes one of the channel candidates, which are iterated by the given strategy.
+ * When all of the candidates fail in a round, the next round begins after backoff interval, which
+ * starts at 10 milliseconds and is doubled up to the given maximum. When
+ * [property@FwIsoResource:generation] is changed by bus reset, the next round begins at once
+ * without the backoff. The failure of system call is not retried. Call
+ * [method@FwIsoResource.allocate_retry_finish] in the callback to get the result.
+ *
+ * Each request is bound by the given timeout, since the event can be delayed at bus reset. One
+ * request is outstanding at the same time, and the next request is issued after the event of the
+ * previous one arrives. When the timeout expires, the operation fails with TIMEOUT without any
+ * further request, since the event of the expired request can arrive later and can not be
+ * distinguished from the event of the next request. The resource can be allocated in the end by
+ * the expired request, as well as the cancellation of [method@FwIsoResource.allocate_async].
+ *
+ * Since: 1.1
+ */
+void hinoko_fw_iso_resource_allocate_retry_async(HinokoFwIsoResource *self,
+						 const guint8 *channel_candidates,
+						 gsize channel_candidates_count, guint bandwidth,
+						 HinokoFwIsoResourceChannelOrder order,
+						 guint max_attempts, guint max_backoff_ms,
+						 guint attempt_timeout_ms,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback, gpointer user_data)
+{
+	struct retry_data *d;
+	GTask *task;
+	gsize i;
+
+	g_return_if_fail(HINOKO_IS_FW_ISO_RESOURCE(self));
+	g_return_if_fail(channel_candidates != NULL);
+	g_return_if_fail(channel_candidates_count > 0);
+	g_return_if_fail(bandwidth > 0);
+	g_return_if_fail(max_attempts > 0);
+	g_return_if_fail(attempt_timeout_ms > 0);
+	g_return_if_fail(cancellable == NULL || G_IS_CANCELLABLE(cancellable));
+
+	for (i = 0; i < channel_candidates_count; ++i)
+		g_return_if_fail(channel_candidates[i] < 64);
+
+	task = g_task_new(self, cancellable, callback, user_data);
+	g_task_set_source_tag(task, hinoko_fw_iso_resource_allocate_retry_async);
+	// The result of request should be delivered even if cancelled after the event arrives.
+	g_task_set_check_cancellable(task, FALSE);
+
+	if (g_task_return_error_if_cancelled(task)) {
+		g_object_unref(task);
+		return;
+	}
+
+	d = g_new0(struct retry_data, 1);
+	g_task_set_task_data(task, d, g_free);
+
+	d->self = self;
+	d->bandwidth = bandwidth;
+	d->order = order;
+	d->max_attempts = max_attempts;
+	d->max_backoff_ms = max_backoff_ms;
+	d->attempt_timeout_ms = attempt_timeout_ms;
+	d->backoff_ms = MIN(RETRY_INITIAL_BACKOFF_MS, max_backoff_ms);
+
+	for (i = 0; i < channel_candidates_count; ++i) {
+		guint8 channel = channel_candidates[i];
+		gsize j;
+
+		for (j = 0; j < d->candidate_count; ++j) {
+			if (d->candidates[j] == channel)
+				break;
+		}
+		if (j == d->candidate_count)
+			d->candidates[d->candidate_count++] = channel;
+	}
+
+	d->generation_handler_id = g_signal_connect(self, "notify::" GENERATION_PROP_NAME,
+						    G_CALLBACK(handle_generation_notify), task);
+
+	if (cancellable != NULL) {
+		d->cancel_src = g_cancellable_source_new(cancellable);
+		g_task_attach_source(task, d->cancel_src, (GSourceFunc)handle_retry_cancel);
+	}
+
+	build_round(d);
+	attempt_allocation(task);
+}
+
+/**
+ * hinoko_fw_iso_resource_allocate_retry_finish:
+ * @self: A [iface@FwIsoResource].
+ * @result: A [iface@Gio.AsyncResult] passed to the callback function.
+ * @channel: (out): The allocated channel number.
+ * @bandwidth: (out): The allocated amount of bandwidth.
+ * @error: A [struct@GLib.Error]. Error can be generated with domain of [error@FwIsoResourceError],
+ *	   [error@Gio.IOErrorEnum] for cancellation, as well as domain depending on each
+ *	   implementation. When the maximum number of attempts is exceeded, the error in the last
+ *	   event is reported. When the event of any request does not arrive within the timeout,
+ *	   TIMEOUT code is reported.
+ *
+ * Finish the request initiated by [method@FwIsoResource.allocate_retry_async].
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_resource_allocate_retry_finish(HinokoFwIsoResource *self,
+						      GAsyncResult *result, guint *channel,
+						      guint *bandwidth, GError **error)
+{
+	struct retry_data *d;
+	GTask *task;
+
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_RESOURCE(self), FALSE);
+	g_return_val_if_fail(g_task_is_valid(result, self), FALSE);
+	g_return_val_if_fail(channel != NULL, FALSE);
+	g_return_val_if_fail(bandwidth != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	task = G_TASK(result);
+	g_return_val_if_fail(g_task_get_source_tag(task) ==
+			     hinoko_fw_iso_resource_allocate_retry_async, FALSE);
+
+	if (!g_task_propagate_boolean(task, error))
+		return FALSE;
+
+	d = g_task_get_task_data(task);
+	*channel = d->channel;
+	*bandwidth = d->allocated_bandwidth;
+
+	return TRUE;
+}
+
+// The initial value of BANDWIDTH_AVAILABLE register of isochronous resource manager.
+#define BANDWIDTH_AVAILABLE_MAX		4915
+
 /**
  * hinoko_fw_iso_resource_calculate_bandwidth:
  * @bytes_per_payload: The number of bytes in payload of isochronous packet.
@@ -270,3 +771,201 @@ guint hinoko_fw_iso_resource_calculate_bandwidth(guint bytes_per_payload,
 
 	return s400_bytes;
 }
+
+/**
+ * hinoko_fw_iso_resource_calculate_payload:
+ * @bandwidth: The amount of bandwidth in allocation unit.
+ * @scode: The speed of transmission.
+ *
+ * Calculate the maximum number of bytes in payload of isochronous packet which is transmitted
+ * within the given amount of bandwidth. This is the inverse of
+ * [func@FwIsoResource.calculate_bandwidth].
+ *
+ * Returns: The maximum number of bytes in payload, which is aligned to quadlet.
+ *
+ * Since: 1.1
+ */
+guint hinoko_fw_iso_resource_calculate_payload(guint bandwidth, HinokoFwScode scode)
+{
+	guint bytes_per_packet;
+
+	// The inverse of conversion in hinoko_fw_iso_resource_calculate_bandwidth().
+	if (scode <= HINOKO_FW_SCODE_S400) {
+		bytes_per_packet = bandwidth / (1 << (HINOKO_FW_SCODE_S400 - scode));
+	} else {
+		guint shift = scode - HINOKO_FW_SCODE_S400;
+
+		if (bandwidth >= (G_MAXUINT >> shift))
+			bytes_per_packet = G_MAXUINT;
+		else
+			bytes_per_packet = ((bandwidth + 1) << shift) - 1;
+	}
+
+	bytes_per_packet = bytes_per_packet / 4 * 4;
+	if (bytes_per_packet <= 3 * 4)
+		return 0;
+
+	return bytes_per_packet - 3 * 4;
+}
+
+/**
+ * hinoko_fw_iso_resource_plan_bandwidth:
+ * @bytes_per_payloads: (array length=count): The array with elements for the number of bytes in
+ *			payload of isochronous packet for each stream.
+ * @scodes: (array length=count): The array with elements for the speed of transmission for each
+ *	    stream.
+ * @packets_per_cycles: (array length=count): The array with elements for the number of packets
+ *			transmitted per isochronous cycle for each stream.
+ * @count: The number of streams.
+ * @available: The amount of available bandwidth. The initial value of BANDWIDTH_AVAILABLE register
+ *	       of isochronous resource manager is 4915.
+ * @bandwidths: (array length=count) (out caller-allocates): The array to store the amount of
+ *		bandwidth to be allocated for each stream.
+ * @total: (out): The total amount of bandwidth to be allocated for the streams.
+ *
+ * Calculate the amount of bandwidth to be allocated for each stream and check whether all of the
+ * streams are admitted within the available bandwidth, before initiating any allocation.
+ *
+ * Returns: TRUE if all of the streams are admitted, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_resource_plan_bandwidth(const guint *bytes_per_payloads,
+					       const HinokoFwScode *scodes,
+					       const guint *packets_per_cycles, gsize count,
+					       guint available, guint *bandwidths, guint *total)
+{
+	guint64 sum = 0;
+	gsize i;
+
+	g_return_val_if_fail(bytes_per_payloads != NULL, FALSE);
+	g_return_val_if_fail(scodes != NULL, FALSE);
+	g_return_val_if_fail(packets_per_cycles != NULL, FALSE);
+	g_return_val_if_fail(count > 0, FALSE);
+	g_return_val_if_fail(bandwidths != NULL, FALSE);
+	g_return_val_if_fail(total != NULL, FALSE);
+
+	for (i = 0; i < count; ++i) {
+		guint64 bandwidth =
+			(guint64)hinoko_fw_iso_resource_calculate_bandwidth(bytes_per_payloads[i],
+									    scodes[i]) *
+			packets_per_cycles[i];
+
+		bandwidths[i] = (guint)MIN(bandwidth, G_MAXUINT);
+		sum += bandwidths[i];
+	}
+
+	*total = (guint)MIN(sum, G_MAXUINT);
+
+	return sum <= available;
+}
+
+/**
+ * hinoko_fw_iso_resource_plan_packing:
+ * @bytes_per_payloads: (array length=count): The array with elements for the number of bytes in
+ *			payload of isochronous packet for each stream.
+ * @scodes: (array length=count): The array with elements for the speed of transmission for each
+ *	    stream.
+ * @packets_per_cycles: (array length=count): The array with elements for the number of packets
+ *			transmitted per isochronous cycle for each stream.
+ * @count: The number of streams.
+ * @available: The amount of available bandwidth, up to 4915 as the initial value of
+ *	       BANDWIDTH_AVAILABLE register of isochronous resource manager.
+ * @admitted: (array length=count) (out caller-allocates): The array to store whether to admit each
+ *	      stream.
+ * @total: (out): The total amount of bandwidth to be allocated for the admitted streams.
+ *
+ * Choose the combination of streams admitted within the available bandwidth so that the total
+ * payload carried by the admitted streams is maximized. The combination wastes the least amount
+ * of bandwidth for the overhead of packet header, quadlet alignment and the speed of
+ * transmission. When several combinations carry the same payload, the one consuming less
+ * bandwidth is chosen.
+ *
+ * Returns: The number of admitted streams.
+ *
+ * Since: 1.1
+ */
+guint hinoko_fw_iso_resource_plan_packing(const guint *bytes_per_payloads,
+					  const HinokoFwScode *scodes,
+					  const guint *packets_per_cycles, gsize count,
+					  guint available, gboolean *admitted, guint *total)
+{
+	guint *bandwidths;
+	guint64 *values;
+	guint8 *keeps;
+	guint64 stride;
+	guint capacity;
+	guint required;
+	guint best;
+	guint admitted_count;
+	gsize i;
+	guint c;
+
+	g_return_val_if_fail(bytes_per_payloads != NULL, 0);
+	g_return_val_if_fail(scodes != NULL, 0);
+	g_return_val_if_fail(packets_per_cycles != NULL, 0);
+	g_return_val_if_fail(count > 0, 0);
+	g_return_val_if_fail(available <= BANDWIDTH_AVAILABLE_MAX, 0);
+	g_return_val_if_fail(admitted != NULL, 0);
+	g_return_val_if_fail(total != NULL, 0);
+
+	bandwidths = g_new0(guint, count);
+
+	if (hinoko_fw_iso_resource_plan_bandwidth(bytes_per_payloads, scodes, packets_per_cycles,
+						  count, available, bandwidths, &required)) {
+		for (i = 0; i < count; ++i)
+			admitted[i] = TRUE;
+		*total = required;
+		g_free(bandwidths);
+		return count;
+	}
+
+	// 0/1 knapsack over the amount of bandwidth, with the payload carried per cycle as value.
+	// The capacity is bounded by the maximum of available bandwidth.
+	capacity = MIN(available, required);
+	stride = (guint64)capacity + 1;
+	values = g_new0(guint64, stride);
+	keeps = g_malloc0_n(count, stride);
+
+	for (i = 0; i < count; ++i) {
+		guint64 value = (guint64)bytes_per_payloads[i] * packets_per_cycles[i];
+		guint weight = bandwidths[i];
+
+		if (weight == 0 || weight > capacity)
+			continue;
+
+		for (c = capacity; c >= weight; --c) {
+			if (values[c - weight] + value > values[c]) {
+				values[c] = values[c - weight] + value;
+				keeps[i * stride + c] = 1;
+			}
+		}
+	}
+
+	// The smallest amount of bandwidth to carry the maximum payload.
+	best = 0;
+	for (c = 1; c <= capacity; ++c) {
+		if (values[c] > values[best])
+			best = c;
+	}
+
+	*total = 0;
+	admitted_count = 0;
+	c = best;
+	for (i = count; i > 0; --i) {
+		if (keeps[(i - 1) * stride + c]) {
+			admitted[i - 1] = TRUE;
+			c -= bandwidths[i - 1];
+			*total += bandwidths[i - 1];
+			++admitted_count;
+		} else {
+			admitted[i - 1] = FALSE;
+		}
+	}
+
+	g_free(keeps);
+	g_free(values);
+	g_free(bandwidths);
+
+	return admitted_count;
+}
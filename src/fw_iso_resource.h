@@ -116,9 +116,43 @@ gboolean hinoko_fw_iso_resource_allocate_wait(HinokoFwIsoResource *self,
 				              gsize channel_candidates_count, guint bandwidth,
 					      guint timeout_ms, GError **error);
 
+void hinoko_fw_iso_resource_allocate_async(HinokoFwIsoResource *self,
+					   const guint8 *channel_candidates,
+					   gsize channel_candidates_count, guint bandwidth,
+					   GCancellable *cancellable, GAsyncReadyCallback callback,
+					   gpointer user_data);
+
+gboolean hinoko_fw_iso_resource_allocate_finish(HinokoFwIsoResource *self, GAsyncResult *result,
+						guint *channel, guint *bandwidth, GError **error);
+
+void hinoko_fw_iso_resource_allocate_retry_async(HinokoFwIsoResource *self,
+						 const guint8 *channel_candidates,
+						 gsize channel_candidates_count, guint bandwidth,
+						 HinokoFwIsoResourceChannelOrder order,
+						 guint max_attempts, guint max_backoff_ms,
+						 guint attempt_timeout_ms,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback, gpointer user_data);
+
+gboolean hinoko_fw_iso_resource_allocate_retry_finish(HinokoFwIsoResource *self,
+						      GAsyncResult *result, guint *channel,
+						      guint *bandwidth, GError **error);
+
 guint hinoko_fw_iso_resource_calculate_bandwidth(guint bytes_per_payload,
 						 HinokoFwScode scode);
 
+guint hinoko_fw_iso_resource_calculate_payload(guint bandwidth, HinokoFwScode scode);
+
+gboolean hinoko_fw_iso_resource_plan_bandwidth(const guint *bytes_per_payloads,
+					       const HinokoFwScode *scodes,
+					       const guint *packets_per_cycles, gsize count,
+					       guint available, guint *bandwidths, guint *total);
+
+guint hinoko_fw_iso_resource_plan_packing(const guint *bytes_per_payloads,
+					  const HinokoFwScode *scodes,
+					  const guint *packets_per_cycles, gsize count,
+					  guint available, gboolean *admitted, guint *total);
+
 G_END_DECLS
 
 #endif
@@ -438,3 +438,228 @@ gboolean hinoko_fw_iso_resource_auto_deallocate_wait(HinokoFwIsoResourceAuto *se
 
 	return fw_iso_resource_waiter_wait(&w, HINOKO_FW_ISO_RESOURCE(self), error);
 }
+
+/**
+ * hinoko_fw_iso_resource_auto_deallocate_async:
+ * @self: A [class@FwIsoResourceAuto].
+ * @cancellable: (nullable): A [class@Gio.Cancellable].
+ * @callback: (scope async): A [callback@Gio.AsyncReadyCallback] to call when the request is
+ *	      satisfied.
+ * @user_data: (closure): The data to pass to callback function.
+ *
+ * Initiate deallocation of isochronous resource and complete the returned task when
+ * [signal@FwIsoResource::deallocated] signal is emitted. Call
+ * [method@FwIsoResourceAuto.deallocate_finish] in the callback to get the result.
+ *
+ * Since: 1.1
+ */
+void hinoko_fw_iso_resource_auto_deallocate_async(HinokoFwIsoResourceAuto *self,
+						  GCancellable *cancellable,
+						  GAsyncReadyCallback callback, gpointer user_data)
+{
+	GTask *task;
+	GError *error = NULL;
+
+	g_return_if_fail(HINOKO_IS_FW_ISO_RESOURCE_AUTO(self));
+	g_return_if_fail(cancellable == NULL || G_IS_CANCELLABLE(cancellable));
+
+	task = fw_iso_resource_task_new(HINOKO_FW_ISO_RESOURCE(self), DEALLOCATED_SIGNAL_NAME,
+					cancellable, callback, user_data,
+					hinoko_fw_iso_resource_auto_deallocate_async);
+	if (task == NULL)
+		return;
+
+	if (!hinoko_fw_iso_resource_auto_deallocate(self, &error))
+		fw_iso_resource_task_abort(task, error);
+}
+
+/**
+ * hinoko_fw_iso_resource_auto_deallocate_finish:
+ * @self: A [class@FwIsoResourceAuto].
+ * @result: A [iface@Gio.AsyncResult] passed to the callback function.
+ * @error: A [struct@GLib.Error]. Error can be generated with domains of [error@FwIsoResourceError],
+ *	   [error@FwIsoResourceAutoError], and [error@Gio.IOErrorEnum] for cancellation.
+ *
+ * Finish the request initiated by [method@FwIsoResourceAuto.deallocate_async].
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_resource_auto_deallocate_finish(HinokoFwIsoResourceAuto *self,
+						       GAsyncResult *result, GError **error)
+{
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_RESOURCE_AUTO(self), FALSE);
+
+	return fw_iso_resource_task_finish(HINOKO_FW_ISO_RESOURCE(self), result,
+					   hinoko_fw_iso_resource_auto_deallocate_async, NULL, NULL,
+					   error);
+}
+
+static gboolean deallocate_batch(HinokoFwIsoResourceAuto *const *resources, gsize count,
+				 const gboolean *targets, guint timeout_ms, GError **error)
+{
+	struct fw_iso_resource_batch batch;
+	gboolean result;
+	gsize i;
+
+	fw_iso_resource_batch_init(&batch, count, timeout_ms);
+
+	for (i = 0; i < count; ++i) {
+		HinokoFwIsoResource *inst = HINOKO_FW_ISO_RESOURCE(resources[i]);
+		GError *local_error = NULL;
+
+		// The request out of target is regarded as done.
+		if (targets != NULL && !targets[i]) {
+			fw_iso_resource_batch_complete(&batch, i, 0, 0, NULL);
+			continue;
+		}
+
+		fw_iso_resource_batch_connect(&batch, i, inst, DEALLOCATED_SIGNAL_NAME);
+
+		if (!hinoko_fw_iso_resource_auto_deallocate(resources[i], &local_error)) {
+			fw_iso_resource_batch_complete(&batch, i, 0, 0, local_error);
+			g_error_free(local_error);
+		}
+	}
+
+	result = fw_iso_resource_batch_wait(&batch, error);
+
+	for (i = 0; i < count; ++i)
+		fw_iso_resource_batch_disconnect(&batch, i, HINOKO_FW_ISO_RESOURCE(resources[i]));
+	fw_iso_resource_batch_clear(&batch);
+
+	return result;
+}
+
+/**
+ * hinoko_fw_iso_resource_auto_allocate_batch_wait:
+ * @resources: (array length=count): The array with elements for [class@FwIsoResourceAuto] which
+ *	       is already opened.
+ * @count: The number of elements in the arrays.
+ * @channel_masks: (array length=count): The array with elements for bit mask of channel candidates
+ *		   for each instance. The least significant bit expresses channel 0.
+ * @bandwidths: (array length=count): The array with elements for the amount of bandwidth to be
+ *		allocated for each instance.
+ * @timeout_ms: The timeout to wait for all of allocated events.
+ * @error: A [struct@GLib.Error]. Error can be generated with domains of [error@FwIsoResourceError],
+ *	   and [error@FwIsoResourceAutoError].
+ *
+ * Initiate allocation of isochronous resource for each instance back to back, then wait for all of
+ * [signal@FwIsoResource::allocated] signals. When any of the allocations fails, the isochronous
+ * resources allocated for the other instances are deallocated, then the first failure is
+ * reported. The instances of which event does not arrive within the timeout are out of the
+ * rollback, thus [property@FwIsoResourceAuto:is-allocated] property should be checked for them.
+ * The allocated channel and bandwidth are available in properties of each instance.
+ *
+ * Returns: TRUE if all of the allocations finish successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_resource_auto_allocate_batch_wait(HinokoFwIsoResourceAuto *const *resources,
+							 gsize count, const guint64 *channel_masks,
+							 const guint *bandwidths, guint timeout_ms,
+							 GError **error)
+{
+	struct fw_iso_resource_batch batch;
+	gboolean *allocated;
+	gboolean result;
+	gsize i;
+
+	g_return_val_if_fail(resources != NULL, FALSE);
+	g_return_val_if_fail(count > 0, FALSE);
+	g_return_val_if_fail(channel_masks != NULL, FALSE);
+	g_return_val_if_fail(bandwidths != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	for (i = 0; i < count; ++i) {
+		g_return_val_if_fail(HINOKO_IS_FW_ISO_RESOURCE_AUTO(resources[i]), FALSE);
+		g_return_val_if_fail(channel_masks[i] > 0, FALSE);
+		g_return_val_if_fail(bandwidths[i] > 0, FALSE);
+	}
+
+	fw_iso_resource_batch_init(&batch, count, timeout_ms);
+
+	// Issue all of requests back to back, then wait for their events at once.
+	for (i = 0; i < count; ++i) {
+		HinokoFwIsoResource *inst = HINOKO_FW_ISO_RESOURCE(resources[i]);
+		guint8 channel_candidates[64];
+		gsize channel_candidates_count = 0;
+		GError *local_error = NULL;
+		guint channel;
+
+		for (channel = 0; channel < 64; ++channel) {
+			if (channel_masks[i] & (1ull << channel))
+				channel_candidates[channel_candidates_count++] = channel;
+		}
+
+		fw_iso_resource_batch_connect(&batch, i, inst, ALLOCATED_SIGNAL_NAME);
+
+		if (!hinoko_fw_iso_resource_allocate(inst, channel_candidates,
+						     channel_candidates_count, bandwidths[i],
+						     &local_error)) {
+			fw_iso_resource_batch_complete(&batch, i, 0, 0, local_error);
+			g_error_free(local_error);
+		}
+	}
+
+	result = fw_iso_resource_batch_wait(&batch, error);
+
+	for (i = 0; i < count; ++i)
+		fw_iso_resource_batch_disconnect(&batch, i, HINOKO_FW_ISO_RESOURCE(resources[i]));
+
+	if (!result) {
+		GError *local_error = NULL;
+
+		allocated = g_new0(gboolean, count);
+
+		g_mutex_lock(&batch.mutex);
+		for (i = 0; i < count; ++i) {
+			const struct fw_iso_resource_batch_entry *entry = batch.entries + i;
+			allocated[i] = entry->handled && entry->error == NULL;
+		}
+		g_mutex_unlock(&batch.mutex);
+
+		(void)deallocate_batch(resources, count, allocated, timeout_ms, &local_error);
+		g_clear_error(&local_error);
+
+		g_free(allocated);
+	}
+
+	fw_iso_resource_batch_clear(&batch);
+
+	return result;
+}
+
+/**
+ * hinoko_fw_iso_resource_auto_deallocate_batch_wait:
+ * @resources: (array length=count): The array with elements for [class@FwIsoResourceAuto] which
+ *	       is associated to allocated isochronous resource.
+ * @count: The number of elements in the array.
+ * @timeout_ms: The timeout to wait for all of deallocated events.
+ * @error: A [struct@GLib.Error]. Error can be generated with domains of [error@FwIsoResourceError],
+ *	   and [error@FwIsoResourceAutoError].
+ *
+ * Initiate deallocation of isochronous resource for each instance back to back, then wait for all
+ * of [signal@FwIsoResource::deallocated] signals. The first failure is reported, while the rest of
+ * instances are processed.
+ *
+ * Returns: TRUE if all of the deallocations finish successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_resource_auto_deallocate_batch_wait(HinokoFwIsoResourceAuto *const *resources,
+							   gsize count, guint timeout_ms,
+							   GError **error)
+{
+	gsize i;
+
+	g_return_val_if_fail(resources != NULL, FALSE);
+	g_return_val_if_fail(count > 0, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	for (i = 0; i < count; ++i)
+		g_return_val_if_fail(HINOKO_IS_FW_ISO_RESOURCE_AUTO(resources[i]), FALSE);
+
+	return deallocate_batch(resources, count, NULL, timeout_ms, error);
+}
@@ -25,6 +25,22 @@ gboolean hinoko_fw_iso_resource_auto_deallocate(HinokoFwIsoResourceAuto *self, G
 gboolean hinoko_fw_iso_resource_auto_deallocate_wait(HinokoFwIsoResourceAuto *self,
 						     guint timeout_ms, GError **error);
 
+void hinoko_fw_iso_resource_auto_deallocate_async(HinokoFwIsoResourceAuto *self,
+						  GCancellable *cancellable,
+						  GAsyncReadyCallback callback, gpointer user_data);
+
+gboolean hinoko_fw_iso_resource_auto_deallocate_finish(HinokoFwIsoResourceAuto *self,
+						       GAsyncResult *result, GError **error);
+
+gboolean hinoko_fw_iso_resource_auto_allocate_batch_wait(HinokoFwIsoResourceAuto *const *resources,
+							 gsize count, const guint64 *channel_masks,
+							 const guint *bandwidths, guint timeout_ms,
+							 GError **error);
+
+gboolean hinoko_fw_iso_resource_auto_deallocate_batch_wait(HinokoFwIsoResourceAuto *const *resources,
+							   gsize count, guint timeout_ms,
+							   GError **error);
+
 G_END_DECLS
 
 #endif
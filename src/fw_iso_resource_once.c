@@ -12,6 +12,10 @@
  */
 typedef struct {
 	struct fw_iso_resource_state state;
+
+	GMutex mutex;
+	struct fw_iso_resource_batch *batch;
+	guint batch_serial;
 } HinokoFwIsoResourceOncePrivate;
 
 static void fw_iso_resource_iface_init(HinokoFwIsoResourceInterface *iface);
@@ -36,6 +40,7 @@ static void fw_iso_resource_once_finalize(GObject *obj)
 		hinoko_fw_iso_resource_once_get_instance_private(self);
 
 	fw_iso_resource_state_release(&priv->state);
+	g_mutex_clear(&priv->mutex);
 
 	G_OBJECT_CLASS(hinoko_fw_iso_resource_once_parent_class)->finalize(obj);
 }
@@ -56,6 +61,7 @@ static void hinoko_fw_iso_resource_once_init(HinokoFwIsoResourceOnce *self)
 		hinoko_fw_iso_resource_once_get_instance_private(self);
 
 	fw_iso_resource_state_init(&priv->state);
+	g_mutex_init(&priv->mutex);
 }
 
 static gboolean fw_iso_resource_once_open(HinokoFwIsoResource *inst, const gchar *path,
@@ -108,6 +114,12 @@ static gboolean fw_iso_resource_once_allocate(HinokoFwIsoResource *inst,
 
 	return TRUE;
 }
+
+// The closure of request in batch consists of the serial number of batch and the index of request.
+#define BATCH_CLOSURE(serial, index)	(((guint64)(serial) << 32) | ((guint64)(index) + 1))
+#define BATCH_CLOSURE_SERIAL(closure)	((guint)((closure) >> 32))
+#define BATCH_CLOSURE_INDEX(closure)	((gsize)((closure) & G_MAXUINT32) - 1)
+
 static void handle_iso_resource_event(HinokoFwIsoResourceOnce *self,
 				      const struct fw_cdev_event_iso_resource *ev)
 {
@@ -118,6 +130,18 @@ static void handle_iso_resource_event(HinokoFwIsoResourceOnce *self,
 
 	parse_iso_resource_event(ev, &channel, &bandwidth, &signal_name, &error);
 
+	if (ev->closure != 0) {
+		HinokoFwIsoResourceOncePrivate *priv =
+			hinoko_fw_iso_resource_once_get_instance_private(self);
+
+		g_mutex_lock(&priv->mutex);
+		if (priv->batch != NULL && BATCH_CLOSURE_SERIAL(ev->closure) == priv->batch_serial) {
+			fw_iso_resource_batch_complete(priv->batch, BATCH_CLOSURE_INDEX(ev->closure),
+						       channel, bandwidth, error);
+		}
+		g_mutex_unlock(&priv->mutex);
+	}
+
 	g_signal_emit_by_name(self, signal_name, channel, bandwidth, error);
 
 	if (error != NULL)
@@ -278,3 +302,275 @@ gboolean hinoko_fw_iso_resource_once_deallocate_wait(HinokoFwIsoResourceOnce *se
 
 	return fw_iso_resource_waiter_wait(&w, HINOKO_FW_ISO_RESOURCE(self), error);
 }
+
+/**
+ * hinoko_fw_iso_resource_once_deallocate_async:
+ * @self: A [class@FwIsoResourceOnce].
+ * @channel: The channel number to be deallocated.
+ * @bandwidth: The amount of bandwidth to be deallocated.
+ * @cancellable: (nullable): A [class@Gio.Cancellable].
+ * @callback: (scope async): A [callback@Gio.AsyncReadyCallback] to call when the request is
+ *	      satisfied.
+ * @user_data: (closure): The data to pass to callback function.
+ *
+ * Initiate deallocation of isochronous resource and complete the returned task when
+ * [signal@FwIsoResource::deallocated] signal is emitted. Call
+ * [method@FwIsoResourceOnce.deallocate_finish] in the callback to get the result.
+ *
+ * Since: 1.1
+ */
+void hinoko_fw_iso_resource_once_deallocate_async(HinokoFwIsoResourceOnce *self, guint channel,
+						  guint bandwidth, GCancellable *cancellable,
+						  GAsyncReadyCallback callback, gpointer user_data)
+{
+	GTask *task;
+	GError *error = NULL;
+
+	g_return_if_fail(HINOKO_IS_FW_ISO_RESOURCE_ONCE(self));
+	g_return_if_fail(channel < 64);
+	g_return_if_fail(bandwidth > 0);
+	g_return_if_fail(cancellable == NULL || G_IS_CANCELLABLE(cancellable));
+
+	task = fw_iso_resource_task_new(HINOKO_FW_ISO_RESOURCE(self), DEALLOCATED_SIGNAL_NAME,
+					cancellable, callback, user_data,
+					hinoko_fw_iso_resource_once_deallocate_async);
+	if (task == NULL)
+		return;
+
+	if (!hinoko_fw_iso_resource_once_deallocate(self, channel, bandwidth, &error))
+		fw_iso_resource_task_abort(task, error);
+}
+
+/**
+ * hinoko_fw_iso_resource_once_deallocate_finish:
+ * @self: A [class@FwIsoResourceOnce].
+ * @result: A [iface@Gio.AsyncResult] passed to the callback function.
+ * @error: A [struct@GLib.Error]. Error can be generated with domain of [error@FwIsoResourceError]
+ *	   and [error@Gio.IOErrorEnum] for cancellation.
+ *
+ * Finish the request initiated by [method@FwIsoResourceOnce.deallocate_async].
+ *
+ * Returns: TRUE if the overall operation finishes successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_resource_once_deallocate_finish(HinokoFwIsoResourceOnce *self,
+						       GAsyncResult *result, GError **error)
+{
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_RESOURCE_ONCE(self), FALSE);
+
+	return fw_iso_resource_task_finish(HINOKO_FW_ISO_RESOURCE(self), result,
+					   hinoko_fw_iso_resource_once_deallocate_async, NULL, NULL,
+					   error);
+}
+
+static gboolean run_batch(HinokoFwIsoResourceOnce *self, unsigned long request,
+			  const char *request_name, const guint64 *channel_masks,
+			  const guint *bandwidths, gsize count, guint timeout_ms,
+			  struct fw_iso_resource_batch *batch, GError **error)
+{
+	HinokoFwIsoResourceOncePrivate *priv =
+		hinoko_fw_iso_resource_once_get_instance_private(self);
+	gboolean result;
+	guint serial;
+	gsize i;
+
+	fw_iso_resource_batch_init(batch, count, timeout_ms);
+
+	g_mutex_lock(&priv->mutex);
+	serial = ++priv->batch_serial;
+	priv->batch = batch;
+	g_mutex_unlock(&priv->mutex);
+
+	// Issue all of requests back to back, then wait for their events at once.
+	for (i = 0; i < count; ++i) {
+		struct fw_cdev_allocate_iso_resource res = {0};
+
+		res.closure = BATCH_CLOSURE(serial, i);
+		res.channels = channel_masks[i];
+		res.bandwidth = bandwidths[i];
+
+		if (ioctl(priv->state.fd, request, &res) < 0) {
+			GError *local_error = NULL;
+
+			generate_syscall_error(&local_error, errno, "ioctl(%s)", request_name);
+			fw_iso_resource_batch_complete(batch, i, 0, 0, local_error);
+			g_error_free(local_error);
+		}
+	}
+
+	result = fw_iso_resource_batch_wait(batch, error);
+
+	// Any event for the batch is not handled anymore.
+	g_mutex_lock(&priv->mutex);
+	priv->batch = NULL;
+	g_mutex_unlock(&priv->mutex);
+
+	return result;
+}
+
+static void rollback_batch(HinokoFwIsoResourceOnce *self, const struct fw_iso_resource_batch *batch,
+			   guint timeout_ms)
+{
+	struct fw_iso_resource_batch rollback;
+	guint64 *channel_masks;
+	guint *bandwidths;
+	gsize count;
+	gsize i;
+
+	channel_masks = g_new0(guint64, batch->count);
+	bandwidths = g_new0(guint, batch->count);
+	count = 0;
+
+	for (i = 0; i < batch->count; ++i) {
+		const struct fw_iso_resource_batch_entry *entry = batch->entries + i;
+
+		if (entry->handled && entry->error == NULL) {
+			channel_masks[count] = 1ull << entry->channel;
+			bandwidths[count] = entry->bandwidth;
+			++count;
+		}
+	}
+
+	if (count > 0) {
+		GError *error = NULL;
+
+		(void)run_batch(self, FW_CDEV_IOC_DEALLOCATE_ISO_RESOURCE_ONCE,
+				"FW_CDEV_IOC_DEALLOCATE_ISO_RESOURCE_ONCE", channel_masks, bandwidths,
+				count, timeout_ms, &rollback, &error);
+		fw_iso_resource_batch_clear(&rollback);
+		g_clear_error(&error);
+	}
+
+	g_free(bandwidths);
+	g_free(channel_masks);
+}
+
+/**
+ * hinoko_fw_iso_resource_once_allocate_batch_wait:
+ * @self: A [class@FwIsoResourceOnce].
+ * @channel_masks: (array length=count): The array with elements for bit mask of channel candidates
+ *		   for each request. The least significant bit expresses channel 0.
+ * @bandwidths: (array length=count): The array with elements for the amount of bandwidth to be
+ *		allocated for each request.
+ * @count: The number of requests.
+ * @channels: (array length=count) (out caller-allocates): The array to store the allocated channel
+ *	      for each request.
+ * @timeout_ms: The timeout to wait for all of allocated events.
+ * @error: A [struct@GLib.Error]. Error can be generated with domain of [error@FwIsoResourceError].
+ *
+ * Initiate allocation of isochronous resource for the given requests back to back, then wait for
+ * all of events. When any of the requests fails, the isochronous resources allocated by the
+ * other requests are deallocated, then the first failure is reported. The requests of which
+ * event does not arrive within the timeout are out of the rollback.
+ *
+ * The [signal@FwIsoResource::allocated] signal is emitted for each request as well.
+ *
+ * Returns: TRUE if all of the requests finish successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_resource_once_allocate_batch_wait(HinokoFwIsoResourceOnce *self,
+							 const guint64 *channel_masks,
+							 const guint *bandwidths, gsize count,
+							 guint *channels, guint timeout_ms,
+							 GError **error)
+{
+	HinokoFwIsoResourceOncePrivate *priv;
+	struct fw_iso_resource_batch batch;
+	gboolean result;
+	gsize i;
+
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_RESOURCE_ONCE(self), FALSE);
+	g_return_val_if_fail(channel_masks != NULL, FALSE);
+	g_return_val_if_fail(bandwidths != NULL, FALSE);
+	g_return_val_if_fail(count > 0, FALSE);
+	g_return_val_if_fail(channels != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	for (i = 0; i < count; ++i) {
+		g_return_val_if_fail(channel_masks[i] > 0, FALSE);
+		g_return_val_if_fail(bandwidths[i] > 0, FALSE);
+	}
+
+	priv = hinoko_fw_iso_resource_once_get_instance_private(self);
+	if (priv->state.fd < 0) {
+		generate_fw_iso_resource_error_coded(error, HINOKO_FW_ISO_RESOURCE_ERROR_NOT_OPENED);
+		return FALSE;
+	}
+
+	result = run_batch(self, FW_CDEV_IOC_ALLOCATE_ISO_RESOURCE_ONCE,
+			   "FW_CDEV_IOC_ALLOCATE_ISO_RESOURCE_ONCE", channel_masks, bandwidths, count,
+			   timeout_ms, &batch, error);
+	if (result) {
+		for (i = 0; i < count; ++i)
+			channels[i] = batch.entries[i].channel;
+	} else {
+		rollback_batch(self, &batch, timeout_ms);
+	}
+
+	fw_iso_resource_batch_clear(&batch);
+
+	return result;
+}
+
+/**
+ * hinoko_fw_iso_resource_once_deallocate_batch_wait:
+ * @self: A [class@FwIsoResourceOnce].
+ * @channels: (array length=count): The array with elements for channel number to be deallocated.
+ * @bandwidths: (array length=count): The array with elements for the amount of bandwidth to be
+ *		deallocated.
+ * @count: The number of requests.
+ * @timeout_ms: The timeout to wait for all of deallocated events.
+ * @error: A [struct@GLib.Error]. Error can be generated with domain of [error@FwIsoResourceError].
+ *
+ * Initiate deallocation of isochronous resource for the given requests back to back, then wait
+ * for all of events. The first failure is reported, while the rest of requests are processed.
+ *
+ * The [signal@FwIsoResource::deallocated] signal is emitted for each request as well.
+ *
+ * Returns: TRUE if all of the requests finish successfully, otherwise FALSE.
+ *
+ * Since: 1.1
+ */
+gboolean hinoko_fw_iso_resource_once_deallocate_batch_wait(HinokoFwIsoResourceOnce *self,
+							   const guint *channels,
+							   const guint *bandwidths, gsize count,
+							   guint timeout_ms, GError **error)
+{
+	HinokoFwIsoResourceOncePrivate *priv;
+	struct fw_iso_resource_batch batch;
+	guint64 *channel_masks;
+	gboolean result;
+	gsize i;
+
+	g_return_val_if_fail(HINOKO_IS_FW_ISO_RESOURCE_ONCE(self), FALSE);
+	g_return_val_if_fail(channels != NULL, FALSE);
+	g_return_val_if_fail(bandwidths != NULL, FALSE);
+	g_return_val_if_fail(count > 0, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	for (i = 0; i < count; ++i) {
+		g_return_val_if_fail(channels[i] < 64, FALSE);
+		g_return_val_if_fail(bandwidths[i] > 0, FALSE);
+	}
+
+	priv = hinoko_fw_iso_resource_once_get_instance_private(self);
+	if (priv->state.fd < 0) {
+		generate_fw_iso_resource_error_coded(error, HINOKO_FW_ISO_RESOURCE_ERROR_NOT_OPENED);
+		return FALSE;
+	}
+
+	channel_masks = g_new0(guint64, count);
+	for (i = 0; i < count; ++i)
+		channel_masks[i] = 1ull << channels[i];
+
+	result = run_batch(self, FW_CDEV_IOC_DEALLOCATE_ISO_RESOURCE_ONCE,
+			   "FW_CDEV_IOC_DEALLOCATE_ISO_RESOURCE_ONCE", channel_masks, bandwidths,
+			   count, timeout_ms, &batch, error);
+
+	fw_iso_resource_batch_clear(&batch);
+	g_free(channel_masks);
+
+	return result;
+}
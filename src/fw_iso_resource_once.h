@@ -24,6 +24,24 @@ gboolean hinoko_fw_iso_resource_once_deallocate_wait(HinokoFwIsoResourceOnce *se
 						     guint bandwidth, guint timeout_ms,
 						     GError **error);
 
+void hinoko_fw_iso_resource_once_deallocate_async(HinokoFwIsoResourceOnce *self, guint channel,
+						  guint bandwidth, GCancellable *cancellable,
+						  GAsyncReadyCallback callback, gpointer user_data);
+
+gboolean hinoko_fw_iso_resource_once_deallocate_finish(HinokoFwIsoResourceOnce *self,
+						       GAsyncResult *result, GError **error);
+
+gboolean hinoko_fw_iso_resource_once_allocate_batch_wait(HinokoFwIsoResourceOnce *self,
+							 const guint64 *channel_masks,
+							 const guint *bandwidths, gsize count,
+							 guint *channels, guint timeout_ms,
+							 GError **error);
+
+gboolean hinoko_fw_iso_resource_once_deallocate_batch_wait(HinokoFwIsoResourceOnce *self,
+							   const guint *channels,
+							   const guint *bandwidths, gsize count,
+							   guint timeout_ms, GError **error);
+
 G_END_DECLS
 
 #endif
@@ -255,6 +255,259 @@ gboolean fw_iso_resource_waiter_wait(struct fw_iso_resource_waiter *w, HinokoFwI
 	return result;
 }
 
+void fw_iso_resource_batch_init(struct fw_iso_resource_batch *b, gsize count, guint timeout_ms)
+{
+	g_mutex_init(&b->mutex);
+	g_cond_init(&b->cond);
+	b->entries = g_new0(struct fw_iso_resource_batch_entry, count);
+	b->count = count;
+	b->handled_count = 0;
+	b->expiration = g_get_monotonic_time() + timeout_ms * G_TIME_SPAN_MILLISECOND;
+}
+
+void fw_iso_resource_batch_clear(struct fw_iso_resource_batch *b)
+{
+	gsize i;
+
+	for (i = 0; i < b->count; ++i)
+		g_clear_error(&b->entries[i].error);
+	g_free(b->entries);
+	b->entries = NULL;
+	b->count = 0;
+
+	g_cond_clear(&b->cond);
+	g_mutex_clear(&b->mutex);
+}
+
+struct batch_slot {
+	struct fw_iso_resource_batch *batch;
+	gsize index;
+};
+
+static void handle_batch_signal(HinokoFwIsoResource *self, guint channel, guint bandwidth,
+				const GError *error, gpointer user_data)
+{
+	struct batch_slot *slot = (struct batch_slot *)user_data;
+
+	fw_iso_resource_batch_complete(slot->batch, slot->index, channel, bandwidth, error);
+}
+
+static void release_batch_slot(gpointer data, GClosure *closure)
+{
+	g_free(data);
+}
+
+void fw_iso_resource_batch_connect(struct fw_iso_resource_batch *b, gsize index,
+				   HinokoFwIsoResource *inst, const char *signal_name)
+{
+	struct batch_slot *slot = g_new0(struct batch_slot, 1);
+
+	slot->batch = b;
+	slot->index = index;
+	b->entries[index].handler_id = g_signal_connect_data(inst, signal_name,
+							     G_CALLBACK(handle_batch_signal), slot,
+							     release_batch_slot, 0);
+}
+
+void fw_iso_resource_batch_disconnect(struct fw_iso_resource_batch *b, gsize index,
+				      HinokoFwIsoResource *inst)
+{
+	struct fw_iso_resource_batch_entry *entry = b->entries + index;
+
+	if (entry->handler_id > 0) {
+		g_signal_handler_disconnect(inst, entry->handler_id);
+		entry->handler_id = 0;
+	}
+}
+
+void fw_iso_resource_batch_complete(struct fw_iso_resource_batch *b, gsize index, guint channel,
+				    guint bandwidth, const GError *error)
+{
+	struct fw_iso_resource_batch_entry *entry;
+
+	g_return_if_fail(index < b->count);
+	entry = b->entries + index;
+
+	g_mutex_lock(&b->mutex);
+	if (!entry->handled) {
+		entry->channel = channel;
+		entry->bandwidth = bandwidth;
+		if (error != NULL)
+			entry->error = g_error_copy(error);
+		entry->handled = TRUE;
+		++b->handled_count;
+		if (b->handled_count == b->count)
+			g_cond_signal(&b->cond);
+	}
+	g_mutex_unlock(&b->mutex);
+}
+
+// Wait for the events of all requests in the batch, then report the first failure in the batch, or
+// timeout when any event does not arrive.
+gboolean fw_iso_resource_batch_wait(struct fw_iso_resource_batch *b, GError **error)
+{
+	gboolean result = TRUE;
+	gsize i;
+
+	g_mutex_lock(&b->mutex);
+	while (b->handled_count < b->count) {
+		if (!g_cond_wait_until(&b->cond, &b->mutex, b->expiration))
+			break;
+	}
+
+	for (i = 0; i < b->count; ++i) {
+		const struct fw_iso_resource_batch_entry *entry = b->entries + i;
+
+		if (entry->handled && entry->error != NULL) {
+			g_propagate_prefixed_error(error, g_error_copy(entry->error),
+						   "request %zu: ", i);
+			result = FALSE;
+			break;
+		}
+	}
+
+	if (result) {
+		for (i = 0; i < b->count; ++i) {
+			if (!b->entries[i].handled) {
+				generate_fw_iso_resource_error_coded(error,
+								     HINOKO_FW_ISO_RESOURCE_ERROR_TIMEOUT);
+				g_prefix_error(error, "request %zu: ", i);
+				result = FALSE;
+				break;
+			}
+		}
+	}
+	g_mutex_unlock(&b->mutex);
+
+	return result;
+}
+
+struct fw_iso_resource_task_data {
+	HinokoFwIsoResource *self;
+	gulong handler_id;
+	GSource *cancel_src;
+	guint channel;
+	guint bandwidth;
+};
+
+static void detach_task(struct fw_iso_resource_task_data *d)
+{
+	if (d->handler_id > 0) {
+		g_signal_handler_disconnect(d->self, d->handler_id);
+		d->handler_id = 0;
+	}
+
+	if (d->cancel_src != NULL) {
+		g_source_destroy(d->cancel_src);
+		g_source_unref(d->cancel_src);
+		d->cancel_src = NULL;
+	}
+}
+
+static void handle_task_signal(HinokoFwIsoResource *self, guint channel, guint bandwidth,
+			       const GError *error, gpointer user_data)
+{
+	GTask *task = G_TASK(user_data);
+	struct fw_iso_resource_task_data *d = g_task_get_task_data(task);
+
+	detach_task(d);
+
+	if (error != NULL) {
+		g_task_return_error(task, g_error_copy(error));
+	} else {
+		d->channel = channel;
+		d->bandwidth = bandwidth;
+		g_task_return_boolean(task, TRUE);
+	}
+
+	// Release the reference owned by the pending request.
+	g_object_unref(task);
+}
+
+static gboolean handle_task_cancel(GCancellable *cancellable, gpointer user_data)
+{
+	GTask *task = G_TASK(user_data);
+	struct fw_iso_resource_task_data *d = g_task_get_task_data(task);
+
+	// The source is destroyed by returning G_SOURCE_REMOVE.
+	g_source_unref(d->cancel_src);
+	d->cancel_src = NULL;
+	detach_task(d);
+
+	g_task_return_error_if_cancelled(task);
+	g_object_unref(task);
+
+	return G_SOURCE_REMOVE;
+}
+
+// The task is completed by the next emission of the signal, or by the cancellable. The request
+// itself is not aborted by the cancellation, thus the resource can be allocated in the end.
+GTask *fw_iso_resource_task_new(HinokoFwIsoResource *self, const char *signal_name,
+				GCancellable *cancellable, GAsyncReadyCallback callback,
+				gpointer user_data, gpointer source_tag)
+{
+	struct fw_iso_resource_task_data *d;
+	GTask *task;
+
+	task = g_task_new(self, cancellable, callback, user_data);
+	g_task_set_source_tag(task, source_tag);
+	// The result of request should be delivered even if cancelled after the event arrives.
+	g_task_set_check_cancellable(task, FALSE);
+
+	if (g_task_return_error_if_cancelled(task)) {
+		g_object_unref(task);
+		return NULL;
+	}
+
+	d = g_new0(struct fw_iso_resource_task_data, 1);
+	d->self = self;
+	g_task_set_task_data(task, d, g_free);
+
+	d->handler_id = g_signal_connect(self, signal_name, G_CALLBACK(handle_task_signal), task);
+
+	if (cancellable != NULL) {
+		d->cancel_src = g_cancellable_source_new(cancellable);
+		g_task_attach_source(task, d->cancel_src, (GSourceFunc)handle_task_cancel);
+	}
+
+	return task;
+}
+
+void fw_iso_resource_task_abort(GTask *task, GError *error)
+{
+	struct fw_iso_resource_task_data *d = g_task_get_task_data(task);
+
+	detach_task(d);
+
+	g_task_return_error(task, error);
+	g_object_unref(task);
+}
+
+gboolean fw_iso_resource_task_finish(HinokoFwIsoResource *self, GAsyncResult *result,
+				     gpointer source_tag, guint *channel, guint *bandwidth,
+				     GError **error)
+{
+	GTask *task;
+	struct fw_iso_resource_task_data *d;
+
+	g_return_val_if_fail(g_task_is_valid(result, self), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	task = G_TASK(result);
+	g_return_val_if_fail(g_task_get_source_tag(task) == source_tag, FALSE);
+
+	if (!g_task_propagate_boolean(task, error))
+		return FALSE;
+
+	d = g_task_get_task_data(task);
+	if (channel != NULL)
+		*channel = d->channel;
+	if (bandwidth != NULL)
+		*bandwidth = d->bandwidth;
+
+	return TRUE;
+}
+
 void parse_iso_resource_event(const struct fw_cdev_event_iso_resource *ev, guint *channel,
 			      guint *bandwidth, const char **signal_name, GError **error)
 {
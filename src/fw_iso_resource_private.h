@@ -78,6 +78,48 @@ void fw_iso_resource_waiter_init(struct fw_iso_resource_waiter *w, HinokoFwIsoRe
 gboolean fw_iso_resource_waiter_wait(struct fw_iso_resource_waiter *w, HinokoFwIsoResource *self,
 				     GError **error);
 
+struct fw_iso_resource_batch_entry {
+	guint channel;
+	guint bandwidth;
+	GError *error;
+	gboolean handled;
+	gulong handler_id;
+};
+
+struct fw_iso_resource_batch {
+	GMutex mutex;
+	GCond cond;
+	struct fw_iso_resource_batch_entry *entries;
+	gsize count;
+	gsize handled_count;
+	guint64 expiration;
+};
+
+void fw_iso_resource_batch_init(struct fw_iso_resource_batch *b, gsize count, guint timeout_ms);
+
+void fw_iso_resource_batch_clear(struct fw_iso_resource_batch *b);
+
+void fw_iso_resource_batch_connect(struct fw_iso_resource_batch *b, gsize index,
+				   HinokoFwIsoResource *inst, const char *signal_name);
+
+void fw_iso_resource_batch_disconnect(struct fw_iso_resource_batch *b, gsize index,
+				      HinokoFwIsoResource *inst);
+
+void fw_iso_resource_batch_complete(struct fw_iso_resource_batch *b, gsize index, guint channel,
+				    guint bandwidth, const GError *error);
+
+gboolean fw_iso_resource_batch_wait(struct fw_iso_resource_batch *b, GError **error);
+
+GTask *fw_iso_resource_task_new(HinokoFwIsoResource *self, const char *signal_name,
+				GCancellable *cancellable, GAsyncReadyCallback callback,
+				gpointer user_data, gpointer source_tag);
+
+void fw_iso_resource_task_abort(GTask *task, GError *error);
+
+gboolean fw_iso_resource_task_finish(HinokoFwIsoResource *self, GAsyncResult *result,
+				     gpointer source_tag, guint *channel, guint *bandwidth,
+				     GError **error);
+
 void parse_iso_resource_event(const struct fw_cdev_event_iso_resource *ev, guint *channel,
 			      guint *bandwidth, const char **signal_name, GError **error);
 
@@ -4,6 +4,7 @@
 
 #include <glib.h>
 #include <glib-object.h>
+#include <gio/gio.h>
 
 #include <linux/firewire-cdev.h>
 #include <linux/firewire-constants.h>
@@ -19,6 +20,13 @@
 #include <fw_iso_ir_single.h>
 #include <fw_iso_ir_multiple.h>
 #include <fw_iso_it.h>
+#include <fw_iso_ctx_pool.h>
+#include <fw_iso_ctx_group.h>
+#include <fw_iso_capture_writer.h>
+#include <fw_iso_capture_reader.h>
+#include <fw_iso_capture_replayer.h>
+#include <fw_iso_event_trace.h>
+#include <fw_iso_loopback.h>
 
 #include <fw_iso_resource.h>
 #include <fw_iso_resource_auto.h>
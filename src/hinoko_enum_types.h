@@ -57,6 +57,43 @@ typedef enum /*< flags >*/
 	HINOKO_FW_ISO_CTX_MATCH_FLAG_TAG3 = FW_CDEV_ISO_CONTEXT_MATCH_TAG3,
 } HinokoFwIsoCtxMatchFlag;
 
+/**
+ * HinokoFwIsoCtxMapFlag:
+ * @HINOKO_FW_ISO_CTX_MAP_FLAG_POPULATE:	Populate and touch the pages of intermediate buffer
+ *						and the arrays in advance.
+ * @HINOKO_FW_ISO_CTX_MAP_FLAG_LOCK:		Lock the pages of intermediate buffer and the
+ *						arrays in physical memory.
+ * @HINOKO_FW_ISO_CTX_MAP_FLAG_HUGE_PAGES:	Back the arrays used to operate the context by
+ *						huge pages of the default size in the system.
+ *						When none is reserved, transparent huge pages
+ *						are used and a debug message is logged.
+ *
+ * A set of flags applied when mapping intermediate buffer of isochronous context.
+ */
+typedef enum /*< flags >*/
+{
+	HINOKO_FW_ISO_CTX_MAP_FLAG_POPULATE	= 0x00000001,
+	HINOKO_FW_ISO_CTX_MAP_FLAG_LOCK		= 0x00000002,
+	HINOKO_FW_ISO_CTX_MAP_FLAG_HUGE_PAGES	= 0x00000004,
+} HinokoFwIsoCtxMapFlag;
+
+/**
+ * HinokoFwIsoCtxQueuePolicy:
+ * @HINOKO_FW_ISO_CTX_QUEUE_POLICY_INTERRUPT:	Queue registered chunks to hardware just after
+ *						processing interrupt event.
+ * @HINOKO_FW_ISO_CTX_QUEUE_POLICY_IMMEDIATE:	Queue registered chunk to hardware every time to
+ *						register it.
+ * @HINOKO_FW_ISO_CTX_QUEUE_POLICY_THRESHOLD:	Queue registered chunks to hardware when the number
+ *						of pending chunks or bytes reaches threshold.
+ *
+ * A set of policy to queue registered chunks to hardware while isochronous context is running.
+ */
+typedef enum {
+	HINOKO_FW_ISO_CTX_QUEUE_POLICY_INTERRUPT,
+	HINOKO_FW_ISO_CTX_QUEUE_POLICY_IMMEDIATE,
+	HINOKO_FW_ISO_CTX_QUEUE_POLICY_THRESHOLD,
+} HinokoFwIsoCtxQueuePolicy;
+
 /**
  * HinokoFwIsoResourceError:
  * @HINOKO_FW_ISO_RESOURCE_ERROR_FAILED:	The system call fails.
@@ -93,6 +130,23 @@ typedef enum {
 	HINOKO_FW_ISO_RESOURCE_AUTO_ERROR_NOT_ALLOCATED,
 } HinokoFwIsoResourceAutoError;
 
+/**
+ * HinokoFwIsoResourceChannelOrder:
+ * @HINOKO_FW_ISO_RESOURCE_CHANNEL_ORDER_ORDERED:		Try channel candidates in the given
+ *								order.
+ * @HINOKO_FW_ISO_RESOURCE_CHANNEL_ORDER_RANDOM:		Try channel candidates in random order.
+ * @HINOKO_FW_ISO_RESOURCE_CHANNEL_ORDER_LEAST_RECENTLY_FAILED:	Try the channel candidate which
+ *								failed least recently at first.
+ *
+ * A set of strategy to iterate channel candidates when retrying allocation of isochronous
+ * resource.
+ */
+typedef enum {
+	HINOKO_FW_ISO_RESOURCE_CHANNEL_ORDER_ORDERED,
+	HINOKO_FW_ISO_RESOURCE_CHANNEL_ORDER_RANDOM,
+	HINOKO_FW_ISO_RESOURCE_CHANNEL_ORDER_LEAST_RECENTLY_FAILED,
+} HinokoFwIsoResourceChannelOrder;
+
 /**
  * HinokoFwIsoCtxError:
  * @HINOKO_FW_ISO_CTX_ERROR_FAILED:		The system call fails.
@@ -106,6 +160,15 @@ typedef enum {
  *						process.
  * @HINOKO_FW_ISO_CTX_ERROR_CHUNK_UNREGISTERED:	No chunk registered before starting.
  * @HINOKO_FW_ISO_CTX_ERROR_NO_ISOC_CHANNEL:	No isochronous channel is available.
+ * @HINOKO_FW_ISO_CTX_ERROR_PACKET_LATE:	The packet is scheduled to isochronous cycle already
+ *						processed.
+ * @HINOKO_FW_ISO_CTX_ERROR_PACKET_EARLY:	The packet is scheduled to isochronous cycle beyond
+ *						the window of scheduler.
+ * @HINOKO_FW_ISO_CTX_ERROR_UNDERRUN:		No packet is queued to IT context to transmit.
+ * @HINOKO_FW_ISO_CTX_ERROR_OUT_OF_WINDOW:	The deadline to start is out of the window for
+ *						cycle match.
+ * @HINOKO_FW_ISO_CTX_ERROR_INVALID_GEOMETRY:	The geometry of buffer is not available for the
+ *						mode of context.
  *
  * A set of error code for operations in [iface@FwIsoCtx].
  */
@@ -117,6 +180,11 @@ typedef enum {
 	HINOKO_FW_ISO_CTX_ERROR_NOT_MAPPED,
 	HINOKO_FW_ISO_CTX_ERROR_CHUNK_UNREGISTERED,
 	HINOKO_FW_ISO_CTX_ERROR_NO_ISOC_CHANNEL,
+	HINOKO_FW_ISO_CTX_ERROR_PACKET_LATE,
+	HINOKO_FW_ISO_CTX_ERROR_PACKET_EARLY,
+	HINOKO_FW_ISO_CTX_ERROR_UNDERRUN,
+	HINOKO_FW_ISO_CTX_ERROR_OUT_OF_WINDOW,
+	HINOKO_FW_ISO_CTX_ERROR_INVALID_GEOMETRY,
 } HinokoFwIsoCtxError;
 
 G_END_DECLS
@@ -0,0 +1,455 @@
+// SPDX-License-Identifier: LGPL-2.1-or-later
+//
+// Check that no memory allocation occurs in the path of interrupt event once isochronous context
+// starts. The character device of Linux FireWire subsystem is emulated by memfd, and the calls of
+// ioctl(2) and read(2) for it are interposed. The calls of allocator in C library are interposed
+// to count allocations.
+
+#define _GNU_SOURCE
+#include <hinoko.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#define EXIT_SKIP	77
+
+#define BYTES_PER_CHUNK		512
+#define CHUNKS_PER_BUFFER	64
+#define PACKETS_PER_IRQ		8
+#define PAYLOAD_LENGTH		24
+#define IRQ_COUNT		4000
+
+#ifdef __GLIBC__
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void *ptr);
+
+static gboolean armed;
+static guint allocation_count;
+
+static void count_allocation(void)
+{
+	if (armed)
+		++allocation_count;
+}
+
+void *malloc(size_t size)
+{
+	count_allocation();
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+	count_allocation();
+	return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	count_allocation();
+	return __libc_realloc(ptr, size);
+}
+
+void *memalign(size_t alignment, size_t size)
+{
+	count_allocation();
+	return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+	count_allocation();
+	return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size)
+{
+	void *mem;
+
+	count_allocation();
+	mem = __libc_memalign(alignment, size);
+	if (mem == NULL)
+		return ENOMEM;
+	*ptr = mem;
+	return 0;
+}
+
+void free(void *ptr)
+{
+	__libc_free(ptr);
+}
+#endif
+
+static int device_fd = -1;
+static struct stat device_stat;
+static HinokoFwIsoCtxMode device_mode;
+static guint32 device_cycle;
+static guint device_completed;
+
+static gboolean is_device(int fd)
+{
+	struct stat st;
+
+	if (device_fd < 0 || fstat(fd, &st) < 0)
+		return FALSE;
+
+	return st.st_dev == device_stat.st_dev && st.st_ino == device_stat.st_ino;
+}
+
+int ioctl(int fd, unsigned long request, ...)
+{
+	va_list ap;
+	void *arg;
+
+	va_start(ap, request);
+	arg = va_arg(ap, void *);
+	va_end(ap);
+
+	if (!is_device(fd))
+		return syscall(SYS_ioctl, fd, request, arg);
+
+	switch (request) {
+	case FW_CDEV_IOC_CREATE_ISO_CONTEXT:
+	{
+		struct fw_cdev_create_iso_context *create = arg;
+
+		device_mode = create->type;
+		create->handle = 1;
+		break;
+	}
+	case FW_CDEV_IOC_GET_CYCLE_TIMER2:
+	{
+		struct fw_cdev_get_cycle_timer2 *cycle_timer = arg;
+
+		cycle_timer->tv_sec = 0;
+		cycle_timer->tv_nsec = 0;
+		cycle_timer->cycle_timer = device_cycle << 12;
+		break;
+	}
+	case FW_CDEV_IOC_GET_INFO:
+	case FW_CDEV_IOC_SET_ISO_CHANNELS:
+	case FW_CDEV_IOC_QUEUE_ISO:
+	case FW_CDEV_IOC_START_ISO:
+	case FW_CDEV_IOC_STOP_ISO:
+	case FW_CDEV_IOC_FLUSH_ISO:
+		break;
+	default:
+		errno = ENOTTY;
+		return -1;
+	}
+
+	return 0;
+}
+
+ssize_t read(int fd, void *buf, size_t count)
+{
+	if (!is_device(fd))
+		return syscall(SYS_read, fd, buf, count);
+
+	device_cycle = (device_cycle + PACKETS_PER_IRQ) % 8000;
+
+	if (device_mode == HINOKO_FW_ISO_CTX_MODE_IR_MULTIPLE) {
+		struct fw_cdev_event_iso_interrupt_mc *ev = buf;
+
+		device_completed = (device_completed + BYTES_PER_CHUNK) %
+				   (BYTES_PER_CHUNK * CHUNKS_PER_BUFFER);
+
+		ev->closure = 0;
+		ev->type = FW_CDEV_EVENT_ISO_INTERRUPT_MULTICHANNEL;
+		ev->completed = device_completed;
+
+		return sizeof(*ev);
+	} else {
+		struct fw_cdev_event_iso_interrupt *ev = buf;
+		unsigned int quadlets_per_packet;
+		int i;
+
+		ev->closure = 0;
+		ev->type = FW_CDEV_EVENT_ISO_INTERRUPT;
+		ev->cycle = device_cycle;
+
+		// The timestamp for IT, or the pair of isochronous packet header and timestamp for
+		// IR.
+		quadlets_per_packet = device_mode == HINOKO_FW_ISO_CTX_MODE_IT ? 1 : 2;
+		ev->header_length = PACKETS_PER_IRQ * quadlets_per_packet * 4;
+
+		for (i = 0; i < PACKETS_PER_IRQ; ++i) {
+			if (quadlets_per_packet == 1) {
+				ev->header[i] = device_cycle;
+			} else {
+				ev->header[i * 2] = GUINT32_TO_BE(PAYLOAD_LENGTH << 16);
+				ev->header[i * 2 + 1] = device_cycle;
+			}
+		}
+
+		return sizeof(*ev) + ev->header_length;
+	}
+}
+
+static void handle_it_interrupted(HinokoFwIsoIt *self, guint sec, guint cycle,
+				  const guint8 *tstamp, guint tstamp_length, guint count,
+				  gpointer user_data)
+{
+	static const guint8 header[8];
+	static const guint8 payload[PAYLOAD_LENGTH];
+	GError **error = user_data;
+	int i;
+
+	for (i = 0; i < count && *error == NULL; ++i) {
+		hinoko_fw_iso_it_register_packet(self, HINOKO_FW_ISO_CTX_MATCH_FLAG_TAG1, 0,
+						 header, sizeof(header), payload, sizeof(payload),
+						 i == count - 1, error);
+	}
+}
+
+static void handle_ir_single_interrupted(HinokoFwIsoIrSingle *self, guint sec, guint cycle,
+					 const guint8 *header, guint header_length, guint count,
+					 gpointer user_data)
+{
+	GError **error = user_data;
+	int i;
+
+	for (i = 0; i < count; ++i) {
+		const guint8 *payload;
+		guint length;
+
+		hinoko_fw_iso_ir_single_get_payload(self, i, &payload, &length);
+	}
+
+	for (i = 0; i < count && *error == NULL; ++i)
+		hinoko_fw_iso_ir_single_register_packet(self, i == count - 1, error);
+}
+
+static void handle_ir_multiple_interrupted(HinokoFwIsoIrMultiple *self, guint count,
+					   gpointer user_data)
+{
+	int i;
+
+	for (i = 0; i < count; ++i) {
+		const guint8 *payload;
+		guint length;
+
+		hinoko_fw_iso_ir_multiple_get_payload(self, i, &payload, &length);
+	}
+}
+
+static gboolean run(HinokoFwIsoCtx *ctx, const char *label, GError **error)
+{
+	GSource *source;
+	gboolean result = TRUE;
+	int i;
+
+	if (!hinoko_fw_iso_ctx_create_source(ctx, &source, error))
+		return FALSE;
+
+	device_cycle = 0;
+	device_completed = 0;
+
+	if (HINOKO_IS_FW_ISO_IT(ctx)) {
+		static const guint8 header[8];
+		static const guint8 payload[PAYLOAD_LENGTH];
+
+		for (i = 0; i < CHUNKS_PER_BUFFER; ++i) {
+			if (!hinoko_fw_iso_it_register_packet(HINOKO_FW_ISO_IT(ctx),
+					HINOKO_FW_ISO_CTX_MATCH_FLAG_TAG1, 0,
+					header, sizeof(header), payload, sizeof(payload),
+					i % PACKETS_PER_IRQ == PACKETS_PER_IRQ - 1, error))
+				goto end;
+		}
+		g_signal_connect(ctx, "interrupted", G_CALLBACK(handle_it_interrupted), error);
+
+		if (!hinoko_fw_iso_it_start(HINOKO_FW_ISO_IT(ctx), NULL, error))
+			goto end;
+	} else if (HINOKO_IS_FW_ISO_IR_SINGLE(ctx)) {
+		for (i = 0; i < CHUNKS_PER_BUFFER; ++i) {
+			if (!hinoko_fw_iso_ir_single_register_packet(HINOKO_FW_ISO_IR_SINGLE(ctx),
+					i % PACKETS_PER_IRQ == PACKETS_PER_IRQ - 1, error))
+				goto end;
+		}
+		g_signal_connect(ctx, "interrupted", G_CALLBACK(handle_ir_single_interrupted),
+				 error);
+
+		if (!hinoko_fw_iso_ir_single_start(HINOKO_FW_ISO_IR_SINGLE(ctx), NULL, 0, 0, error))
+			goto end;
+	} else {
+		g_signal_connect(ctx, "interrupted", G_CALLBACK(handle_ir_multiple_interrupted),
+				 error);
+
+		if (!hinoko_fw_iso_ir_multiple_start(HINOKO_FW_ISO_IR_MULTIPLE(ctx), NULL, 0, 0,
+						     PACKETS_PER_IRQ, error))
+			goto end;
+	}
+
+#ifdef __GLIBC__
+	allocation_count = 0;
+	armed = TRUE;
+#endif
+
+	// Dispatch the source directly so that the main loop does not count.
+	for (i = 0; i < IRQ_COUNT; ++i) {
+		if (source->source_funcs->dispatch(source, NULL, NULL) == G_SOURCE_REMOVE)
+			break;
+		if (*error != NULL)
+			break;
+	}
+
+#ifdef __GLIBC__
+	armed = FALSE;
+
+	if (allocation_count > 0) {
+		printf("%s: %u allocations in %d interrupts\n", label, allocation_count, i);
+		result = FALSE;
+	}
+#endif
+
+	if (i < IRQ_COUNT) {
+		printf("%s: dispatch stops at %d interrupts\n", label, i);
+		result = FALSE;
+	}
+
+	hinoko_fw_iso_ctx_stop(ctx);
+end:
+	g_source_unref(source);
+
+	if (*error != NULL)
+		return FALSE;
+
+	return result;
+}
+
+// Enable the optional processing in the path of interrupt event.
+static void enable_features(HinokoFwIsoCtx *ctx)
+{
+	g_object_set(ctx, "queue-policy", HINOKO_FW_ISO_CTX_QUEUE_POLICY_THRESHOLD,
+		     "queue-threshold-chunks", PACKETS_PER_IRQ / 2, NULL);
+
+	if (!HINOKO_IS_FW_ISO_IT(ctx))
+		g_object_set(ctx, "detect-packet-loss", TRUE, "timestamp-packets", TRUE, NULL);
+}
+
+static void report_error(GError **error)
+{
+	if (*error != NULL) {
+		printf("%s\n", (*error)->message);
+		g_clear_error(error);
+	}
+}
+
+static gboolean test_it(const char *path, gboolean features)
+{
+	HinokoFwIsoIt *it = hinoko_fw_iso_it_new();
+	GError *error = NULL;
+	gboolean result = TRUE;
+
+	if (features)
+		enable_features(HINOKO_FW_ISO_CTX(it));
+
+	if (!hinoko_fw_iso_it_allocate(it, path, HINOKO_FW_SCODE_S400, 1, 8, &error) ||
+	    !hinoko_fw_iso_it_map_buffer(it, BYTES_PER_CHUNK, CHUNKS_PER_BUFFER, &error) ||
+	    !run(HINOKO_FW_ISO_CTX(it), features ? "IT with features" : "IT", &error))
+		result = FALSE;
+	g_object_unref(it);
+	report_error(&error);
+
+	return result;
+}
+
+static gboolean test_ir_single(const char *path, gboolean features)
+{
+	HinokoFwIsoIrSingle *ir_single = hinoko_fw_iso_ir_single_new();
+	GError *error = NULL;
+	gboolean result = TRUE;
+
+	if (features)
+		enable_features(HINOKO_FW_ISO_CTX(ir_single));
+
+	if (!hinoko_fw_iso_ir_single_allocate(ir_single, path, 1, 8, &error) ||
+	    !hinoko_fw_iso_ir_single_map_buffer(ir_single, BYTES_PER_CHUNK, CHUNKS_PER_BUFFER,
+						&error) ||
+	    !run(HINOKO_FW_ISO_CTX(ir_single), features ? "IR single with features" : "IR single",
+		 &error))
+		result = FALSE;
+	g_object_unref(ir_single);
+	report_error(&error);
+
+	return result;
+}
+
+static gboolean test_ir_multiple(const char *path, gboolean features)
+{
+	const guint8 channels[] = { 1, 2 };
+	HinokoFwIsoIrMultiple *ir_multiple = hinoko_fw_iso_ir_multiple_new();
+	GError *error = NULL;
+	gboolean result = TRUE;
+
+	if (features)
+		enable_features(HINOKO_FW_ISO_CTX(ir_multiple));
+
+	if (!hinoko_fw_iso_ir_multiple_allocate(ir_multiple, path, channels,
+						G_N_ELEMENTS(channels), &error) ||
+	    !hinoko_fw_iso_ir_multiple_map_buffer(ir_multiple, BYTES_PER_CHUNK,
+						  CHUNKS_PER_BUFFER, &error) ||
+	    !run(HINOKO_FW_ISO_CTX(ir_multiple),
+		 features ? "IR multiple with features" : "IR multiple", &error))
+		result = FALSE;
+	g_object_unref(ir_multiple);
+	report_error(&error);
+
+	return result;
+}
+
+int main(void)
+{
+	char path[32];
+	guint8 *buf;
+	gboolean result = TRUE;
+	int features;
+	int i;
+
+#ifndef __GLIBC__
+	return EXIT_SKIP;
+#endif
+
+	device_fd = memfd_create("fw-iso-ctx", 0);
+	if (device_fd < 0)
+		return EXIT_SKIP;
+	if (ftruncate(device_fd, BYTES_PER_CHUNK * CHUNKS_PER_BUFFER) < 0 ||
+	    fstat(device_fd, &device_stat) < 0)
+		return EXIT_FAILURE;
+	snprintf(path, sizeof(path), "/proc/self/fd/%d", device_fd);
+
+	// Fill isochronous packets for buffer-fill mode; isochronous header in little endian,
+	// payload, and timestamp.
+	buf = mmap(NULL, BYTES_PER_CHUNK * CHUNKS_PER_BUFFER, PROT_READ | PROT_WRITE, MAP_SHARED,
+		   device_fd, 0);
+	if (buf == MAP_FAILED)
+		return EXIT_FAILURE;
+	for (i = 0; i < BYTES_PER_CHUNK * CHUNKS_PER_BUFFER; i += PAYLOAD_LENGTH + 8)
+		*(guint32 *)(buf + i) = GUINT32_TO_LE(PAYLOAD_LENGTH << 16);
+	munmap(buf, BYTES_PER_CHUNK * CHUNKS_PER_BUFFER);
+
+	// Loss detection, timestamp conversion, and queue policy by threshold are enabled in the
+	// second iteration.
+	for (features = 0; features < 2; ++features) {
+		if (!test_it(path, features))
+			result = FALSE;
+		if (!test_ir_single(path, features))
+			result = FALSE;
+		if (!test_ir_multiple(path, features))
+			result = FALSE;
+	}
+
+	close(device_fd);
+
+	return result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
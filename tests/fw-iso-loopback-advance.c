@@ -0,0 +1,287 @@
+// SPDX-License-Identifier: LGPL-2.1-or-later
+//
+// Check the packets transferred from IT context to IR single and IR multiple contexts in the
+// software loopback driven by hinoko_fw_iso_loopback_advance(). The payload, the isochronous
+// packet header, and the timestamp of each received packet are compared to the transmitted one.
+
+#include <hinoko.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHANNEL			5
+#define SYNC_CODE		3
+#define IT_HEADER_SIZE		8
+#define PAYLOAD_LENGTH		16
+#define DATA_LENGTH		(IT_HEADER_SIZE + PAYLOAD_LENGTH)
+#define PACKET_COUNT		32
+#define PACKETS_PER_IRQ		8
+
+#define IR_SINGLE_HEADER_SIZE	8
+
+// The packet in buffer-fill mode has the isochronous packet header and the timestamp.
+#define IR_MULTIPLE_FRAME_SIZE	(4 + DATA_LENGTH + 4)
+#define IR_MULTIPLE_CHUNK_SIZE	(IR_MULTIPLE_FRAME_SIZE * 4)
+#define IR_MULTIPLE_CHUNKS	16
+#define IR_MULTIPLE_CHUNKS_PER_IRQ	2
+
+#define TCODE_STREAM_DATA	0xa
+
+struct test_data {
+	const char *label;
+	guint received;
+	gboolean failed;
+};
+
+static void fill_packet(guint index, guint8 *header, guint8 *payload)
+{
+	int i;
+
+	for (i = 0; i < IT_HEADER_SIZE; ++i)
+		header[i] = 0x80 | (index + i);
+	for (i = 0; i < PAYLOAD_LENGTH; ++i)
+		payload[i] = index * PAYLOAD_LENGTH + i;
+}
+
+static guint32 expected_iso_header(void)
+{
+	return (DATA_LENGTH << 16) | (CHANNEL << 8) | (TCODE_STREAM_DATA << 4) | SYNC_CODE;
+}
+
+// The simulated clock begins at zero, thus the packet is transmitted at the cycle of its index.
+static guint32 expected_tstamp(guint index)
+{
+	return ((index / 8000) % 8) << 13 | (index % 8000);
+}
+
+static void check_data(struct test_data *data, guint index, const guint8 *frame)
+{
+	guint8 header[IT_HEADER_SIZE];
+	guint8 payload[PAYLOAD_LENGTH];
+
+	fill_packet(index, header, payload);
+
+	if (memcmp(frame, header, sizeof(header)) ||
+	    memcmp(frame + sizeof(header), payload, sizeof(payload))) {
+		printf("%s: unexpected data at packet %u\n", data->label, index);
+		data->failed = TRUE;
+	}
+}
+
+static void check_header(struct test_data *data, guint index, guint32 iso_header,
+			 guint32 tstamp)
+{
+	if (iso_header != expected_iso_header()) {
+		printf("%s: unexpected isochronous packet header %08x at packet %u\n", data->label,
+		       iso_header, index);
+		data->failed = TRUE;
+	}
+
+	if (tstamp != expected_tstamp(index)) {
+		printf("%s: unexpected timestamp %08x at packet %u\n", data->label, tstamp, index);
+		data->failed = TRUE;
+	}
+}
+
+static void handle_ir_single_interrupted(HinokoFwIsoIrSingle *self, guint sec, guint cycle,
+					 const guint8 *header, guint header_length, guint count,
+					 gpointer user_data)
+{
+	struct test_data *data = user_data;
+	const guint32 *quadlets = (const guint32 *)header;
+	guint i;
+
+	if (header_length != count * IR_SINGLE_HEADER_SIZE) {
+		printf("%s: unexpected length of header %u for %u packets\n", data->label,
+		       header_length, count);
+		data->failed = TRUE;
+		return;
+	}
+
+	for (i = 0; i < count; ++i) {
+		guint index = data->received + i;
+		const guint8 *payload;
+		guint length;
+
+		// The context header has the isochronous packet header and the timestamp in big
+		// endian.
+		check_header(data, index, GUINT32_FROM_BE(quadlets[i * 2]),
+			     GUINT32_FROM_BE(quadlets[i * 2 + 1]));
+
+		hinoko_fw_iso_ir_single_get_payload(self, i, &payload, &length);
+		if (length != DATA_LENGTH) {
+			printf("%s: unexpected length of payload %u at packet %u\n", data->label,
+			       length, index);
+			data->failed = TRUE;
+			continue;
+		}
+		check_data(data, index, payload);
+	}
+
+	data->received += count;
+
+	// The interrupt event has the timestamp of the last packet.
+	if (sec * 8000 + cycle != (data->received - 1) % (8 * 8000)) {
+		printf("%s: unexpected cycle %u-%u of interrupt\n", data->label, sec, cycle);
+		data->failed = TRUE;
+	}
+}
+
+static void handle_ir_multiple_interrupted(HinokoFwIsoIrMultiple *self, guint count,
+					   gpointer user_data)
+{
+	struct test_data *data = user_data;
+	guint i;
+
+	for (i = 0; i < count; ++i) {
+		guint index = data->received + i;
+		const guint8 *frame;
+		guint length;
+
+		hinoko_fw_iso_ir_multiple_get_payload(self, i, &frame, &length);
+		if (length != IR_MULTIPLE_FRAME_SIZE) {
+			printf("%s: unexpected length of frame %u at packet %u\n", data->label,
+			       length, index);
+			data->failed = TRUE;
+			continue;
+		}
+
+		// The data is sandwiched by the isochronous packet header and the timestamp in
+		// little endian.
+		check_header(data, index, GUINT32_FROM_LE(*(const guint32 *)frame),
+			     GUINT32_FROM_LE(*(const guint32 *)(frame + length - 4)));
+		check_data(data, index, frame + 4);
+	}
+
+	data->received += count;
+}
+
+static gboolean setup_it(HinokoFwIsoLoopback *loopback, HinokoFwIsoIt *it, GError **error)
+{
+	guint i;
+
+	if (!hinoko_fw_iso_loopback_attach_it(loopback, it, CHANNEL, IT_HEADER_SIZE, error) ||
+	    !hinoko_fw_iso_it_map_buffer(it, PAYLOAD_LENGTH, PACKET_COUNT, error))
+		return FALSE;
+
+	for (i = 0; i < PACKET_COUNT; ++i) {
+		guint8 header[IT_HEADER_SIZE];
+		guint8 payload[PAYLOAD_LENGTH];
+
+		fill_packet(i, header, payload);
+		if (!hinoko_fw_iso_it_register_packet(it, 0, SYNC_CODE, header, sizeof(header),
+						      payload, sizeof(payload),
+						      i % PACKETS_PER_IRQ == PACKETS_PER_IRQ - 1,
+						      error))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean setup_ir_single(HinokoFwIsoLoopback *loopback, HinokoFwIsoIrSingle *ir_single,
+				GError **error)
+{
+	guint i;
+
+	if (!hinoko_fw_iso_loopback_attach_ir_single(loopback, ir_single, CHANNEL,
+						     IR_SINGLE_HEADER_SIZE, error) ||
+	    !hinoko_fw_iso_ir_single_map_buffer(ir_single, DATA_LENGTH, PACKET_COUNT, error))
+		return FALSE;
+
+	for (i = 0; i < PACKET_COUNT; ++i) {
+		if (!hinoko_fw_iso_ir_single_register_packet(ir_single,
+					i % PACKETS_PER_IRQ == PACKETS_PER_IRQ - 1, error))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean setup_ir_multiple(HinokoFwIsoLoopback *loopback,
+				  HinokoFwIsoIrMultiple *ir_multiple, GError **error)
+{
+	const guint8 channels[] = { CHANNEL };
+
+	return hinoko_fw_iso_loopback_attach_ir_multiple(loopback, ir_multiple, channels,
+							 G_N_ELEMENTS(channels), error) &&
+	       hinoko_fw_iso_ir_multiple_map_buffer(ir_multiple, IR_MULTIPLE_CHUNK_SIZE,
+						    IR_MULTIPLE_CHUNKS, error);
+}
+
+static gboolean check_received(const struct test_data *data)
+{
+	if (data->failed)
+		return FALSE;
+
+	if (data->received != PACKET_COUNT) {
+		printf("%s: %u packets received, while %u expected\n", data->label,
+		       data->received, PACKET_COUNT);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+int main(void)
+{
+	HinokoFwIsoLoopback *loopback = hinoko_fw_iso_loopback_new();
+	HinokoFwIsoIt *it = hinoko_fw_iso_it_new();
+	HinokoFwIsoIrSingle *ir_single = hinoko_fw_iso_ir_single_new();
+	HinokoFwIsoIrMultiple *ir_multiple = hinoko_fw_iso_ir_multiple_new();
+	struct test_data ir_single_data = { .label = "IR single" };
+	struct test_data ir_multiple_data = { .label = "IR multiple" };
+	guint64 delivered_packets;
+	guint64 dropped_packets;
+	GError *error = NULL;
+	gboolean result = FALSE;
+
+	if (!setup_it(loopback, it, &error) ||
+	    !setup_ir_single(loopback, ir_single, &error) ||
+	    !setup_ir_multiple(loopback, ir_multiple, &error))
+		goto end;
+
+	g_signal_connect(ir_single, "interrupted", G_CALLBACK(handle_ir_single_interrupted),
+			 &ir_single_data);
+	g_signal_connect(ir_multiple, "interrupted", G_CALLBACK(handle_ir_multiple_interrupted),
+			 &ir_multiple_data);
+
+	// The IR contexts are started in advance so that the first packet is received.
+	if (!hinoko_fw_iso_ir_single_start(ir_single, NULL, 0, 0, &error) ||
+	    !hinoko_fw_iso_ir_multiple_start(ir_multiple, NULL, 0, 0, IR_MULTIPLE_CHUNKS_PER_IRQ,
+					     &error) ||
+	    !hinoko_fw_iso_it_start(it, NULL, &error))
+		goto end;
+
+	hinoko_fw_iso_loopback_advance(loopback, PACKET_COUNT);
+
+	g_object_get(loopback, "delivered-packets", &delivered_packets,
+		     "dropped-packets", &dropped_packets, NULL);
+
+	result = check_received(&ir_single_data);
+	if (!check_received(&ir_multiple_data))
+		result = FALSE;
+
+	if (delivered_packets != PACKET_COUNT * 2 || dropped_packets != 0) {
+		printf("%" G_GUINT64_FORMAT " packets delivered and %" G_GUINT64_FORMAT
+		       " dropped\n", delivered_packets, dropped_packets);
+		result = FALSE;
+	}
+end:
+	if (error != NULL) {
+		printf("%s\n", error->message);
+		g_clear_error(&error);
+	}
+
+	hinoko_fw_iso_ctx_stop(HINOKO_FW_ISO_CTX(it));
+	hinoko_fw_iso_ctx_stop(HINOKO_FW_ISO_CTX(ir_single));
+	hinoko_fw_iso_ctx_stop(HINOKO_FW_ISO_CTX(ir_multiple));
+
+	g_object_unref(loopback);
+	g_object_unref(it);
+	g_object_unref(ir_single);
+	g_object_unref(ir_multiple);
+
+	return result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
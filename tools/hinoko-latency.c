@@ -0,0 +1,520 @@
+// SPDX-License-Identifier: LGPL-2.1-or-later
+//
+// Measure the round-trip latency of isochronous packets transmitted by IT context and received by
+// IR context in the same machine, for a sweep of the number of chunks per buffer and the interval
+// of interrupts. Each packet carries the sequence number and the isochronous cycle at which it is
+// registered, then the IR context reports the isochronous cycle at which it is transmitted. The
+// isochronous cycle at which it is handled is read from the cycle time register.
+//
+// For each packet the following values are computed in isochronous cycles:
+//  - latency: from registration to handling of reception.
+//  - slack: from registration to transmission, the margin against underrun.
+
+#include <hinoko.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/utsname.h>
+
+// The sequence number and the isochronous cycle of registration in big endian.
+#define IT_HEADER_SIZE		8
+// The isochronous packet header, the timestamp, and the above header in big endian.
+#define IR_HEADER_SIZE		(8 + IT_HEADER_SIZE)
+
+#define CYCLES_PER_SEC		8000
+// The timestamp of isochronous descriptor has the lower three bits of second.
+#define CYCLES_PER_ROUND	(8 * CYCLES_PER_SEC)
+
+#define TSTAMP_SEC_SHIFT	13
+#define TSTAMP_SEC_MASK		0x0000e000
+#define TSTAMP_CYCLE_MASK	0x00001fff
+
+static gchar *device_path = "/dev/fw0";
+static gboolean use_loopback;
+static gint channel = 1;
+static gint payload_length = 64;
+static gint duration = 2;
+static gchar *chunks_per_buffer_list = "32,64,128,256";
+static gchar *cycles_per_irq_list = "8,16,32";
+static gchar *output_path;
+
+static const GOptionEntry entries[] = {
+	{ "device", 'd', 0, G_OPTION_ARG_STRING, &device_path,
+	  "The path to Linux FireWire character device (default: /dev/fw0)", "PATH" },
+	{ "loopback", 'l', 0, G_OPTION_ARG_NONE, &use_loopback,
+	  "Use software loopback instead of the device", NULL },
+	{ "channel", 'c', 0, G_OPTION_ARG_INT, &channel,
+	  "The isochronous channel (default: 1)", "CHANNEL" },
+	{ "payload", 'p', 0, G_OPTION_ARG_INT, &payload_length,
+	  "The number of bytes in payload of packet following the header (default: 64)", "BYTES" },
+	{ "duration", 't', 0, G_OPTION_ARG_INT, &duration,
+	  "The number of seconds for each geometry (default: 2)", "SECONDS" },
+	{ "chunks-per-buffer", 'b', 0, G_OPTION_ARG_STRING, &chunks_per_buffer_list,
+	  "The comma-separated numbers of chunks per buffer (default: 32,64,128,256)", "LIST" },
+	{ "cycles-per-irq", 'i', 0, G_OPTION_ARG_STRING, &cycles_per_irq_list,
+	  "The comma-separated numbers of cycles per interrupt (default: 8,16,32)", "LIST" },
+	{ "output", 'o', 0, G_OPTION_ARG_FILENAME, &output_path,
+	  "The path to write report (default: standard output)", "PATH" },
+	{ NULL },
+};
+
+struct measurement {
+	HinokoFwIsoIt *it;
+	HinokoFwIsoIrSingle *ir;
+	HinokoFwIsoLoopback *loopback;
+	GMainLoop *loop;
+	GError *error;
+
+	guint chunks_per_buffer;
+	guint cycles_per_irq;
+	guint8 *payload;
+
+	guint32 next_seq;
+	guint32 expected_seq;
+	guint it_registered;
+	guint ir_registered;
+
+	guint64 received;
+	guint64 lost;
+	GArray *latencies;
+	GArray *slacks;
+};
+
+static gboolean read_cycles(HinokoFwIsoCtx *ctx, guint *cycles, GError **error)
+{
+	HinawaCycleTime cycle_time = {0};
+	HinawaCycleTime *ptr = &cycle_time;
+	guint16 fields[3];
+
+	if (!hinoko_fw_iso_ctx_read_cycle_time(ctx, CLOCK_MONOTONIC, &ptr, error))
+		return FALSE;
+
+	hinawa_cycle_time_get_fields(&cycle_time, fields);
+	*cycles = (fields[0] * CYCLES_PER_SEC + fields[1]) % CYCLES_PER_ROUND;
+
+	return TRUE;
+}
+
+static guint distance(guint begin, guint end)
+{
+	return (end + CYCLES_PER_ROUND - begin) % CYCLES_PER_ROUND;
+}
+
+static gboolean register_it_packets(struct measurement *m, guint count, GError **error)
+{
+	guint cycles;
+	guint i;
+
+	if (!read_cycles(HINOKO_FW_ISO_CTX(m->it), &cycles, error))
+		return FALSE;
+
+	for (i = 0; i < count; ++i) {
+		guint32 header[2] = {
+			GUINT32_TO_BE(m->next_seq),
+			GUINT32_TO_BE(cycles),
+		};
+		gboolean schedule_interrupt = ++m->it_registered % m->cycles_per_irq == 0;
+
+		if (!hinoko_fw_iso_it_register_packet(m->it, HINOKO_FW_ISO_CTX_MATCH_FLAG_TAG1, 0,
+						      (const guint8 *)header, sizeof(header),
+						      m->payload, payload_length,
+						      schedule_interrupt, error))
+			return FALSE;
+
+		++m->next_seq;
+	}
+
+	return TRUE;
+}
+
+static gboolean register_ir_packets(struct measurement *m, guint count, GError **error)
+{
+	guint i;
+
+	for (i = 0; i < count; ++i) {
+		gboolean schedule_interrupt = ++m->ir_registered % m->cycles_per_irq == 0;
+
+		if (!hinoko_fw_iso_ir_single_register_packet(m->ir, schedule_interrupt, error))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void handle_it_interrupted(HinokoFwIsoIt *self, guint sec, guint cycle,
+				  const guint8 *tstamp, guint tstamp_length, guint count,
+				  gpointer user_data)
+{
+	struct measurement *m = user_data;
+
+	// Keep the same number of packets queued as the chunks in buffer.
+	if (m->error == NULL && !register_it_packets(m, count, &m->error))
+		g_main_loop_quit(m->loop);
+}
+
+static void handle_ir_interrupted(HinokoFwIsoIrSingle *self, guint sec, guint cycle,
+				  const guint8 *header, guint header_length, guint count,
+				  gpointer user_data)
+{
+	struct measurement *m = user_data;
+	const guint32 *quadlets = (const guint32 *)header;
+	guint handled;
+	guint i;
+
+	if (m->error != NULL)
+		return;
+
+	if (!read_cycles(HINOKO_FW_ISO_CTX(self), &handled, &m->error)) {
+		g_main_loop_quit(m->loop);
+		return;
+	}
+
+	for (i = 0; i < count; ++i) {
+		const guint32 *fields = quadlets + i * IR_HEADER_SIZE / 4;
+		guint32 tstamp = GUINT32_FROM_BE(fields[1]);
+		guint32 seq = GUINT32_FROM_BE(fields[2]);
+		guint registered = GUINT32_FROM_BE(fields[3]);
+		guint transmitted;
+		guint latency;
+		guint slack;
+
+		if (seq > m->expected_seq)
+			m->lost += seq - m->expected_seq;
+		m->expected_seq = seq + 1;
+		++m->received;
+
+		// The packets queued before starting are for warm-up.
+		if (seq < m->chunks_per_buffer)
+			continue;
+
+		transmitted = ((tstamp & TSTAMP_SEC_MASK) >> TSTAMP_SEC_SHIFT) * CYCLES_PER_SEC +
+			      (tstamp & TSTAMP_CYCLE_MASK);
+		latency = distance(registered, handled);
+		slack = distance(registered, transmitted);
+		g_array_append_val(m->latencies, latency);
+		g_array_append_val(m->slacks, slack);
+	}
+
+	if (!register_ir_packets(m, count, &m->error))
+		g_main_loop_quit(m->loop);
+}
+
+static void handle_stopped(HinokoFwIsoCtx *self, const GError *error, gpointer user_data)
+{
+	struct measurement *m = user_data;
+
+	if (error != NULL && m->error == NULL)
+		m->error = g_error_copy(error);
+	g_main_loop_quit(m->loop);
+}
+
+static gboolean handle_timeout(gpointer user_data)
+{
+	struct measurement *m = user_data;
+
+	g_main_loop_quit(m->loop);
+
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean prepare(struct measurement *m, GError **error)
+{
+	if (use_loopback) {
+		m->loopback = hinoko_fw_iso_loopback_new();
+		if (!hinoko_fw_iso_loopback_attach_it(m->loopback, m->it, channel, IT_HEADER_SIZE,
+						      error) ||
+		    !hinoko_fw_iso_loopback_attach_ir_single(m->loopback, m->ir, channel,
+							     IR_HEADER_SIZE, error))
+			return FALSE;
+	} else {
+		if (!hinoko_fw_iso_it_allocate(m->it, device_path, HINOKO_FW_SCODE_S400, channel,
+					       IT_HEADER_SIZE, error) ||
+		    !hinoko_fw_iso_ir_single_allocate(m->ir, device_path, channel,
+						      IR_HEADER_SIZE, error))
+			return FALSE;
+	}
+
+	// The header of IT context is delivered in the header of IR context.
+	return hinoko_fw_iso_it_map_buffer(m->it, payload_length, m->chunks_per_buffer, error) &&
+	       hinoko_fw_iso_ir_single_map_buffer(m->ir, payload_length, m->chunks_per_buffer,
+						  error);
+}
+
+static gboolean attach_source(GObject *obj, GMainContext *ctx, GPtrArray *sources,
+			      GError **error)
+{
+	GSource *source;
+	gboolean result;
+
+	if (HINOKO_IS_FW_ISO_LOOPBACK(obj))
+		result = hinoko_fw_iso_loopback_create_source(HINOKO_FW_ISO_LOOPBACK(obj), &source,
+							      error);
+	else
+		result = hinoko_fw_iso_ctx_create_source(HINOKO_FW_ISO_CTX(obj), &source, error);
+
+	if (!result)
+		return FALSE;
+
+	g_source_attach(source, ctx);
+	g_ptr_array_add(sources, source);
+
+	return TRUE;
+}
+
+static gboolean measure(struct measurement *m, GError **error)
+{
+	GMainContext *ctx = g_main_context_new();
+	GPtrArray *sources = g_ptr_array_new();
+	GSource *timeout;
+	gboolean result = FALSE;
+	guint i;
+
+	m->loop = g_main_loop_new(ctx, FALSE);
+
+	if (!prepare(m, error))
+		goto end;
+
+	g_signal_connect(m->it, "interrupted", G_CALLBACK(handle_it_interrupted), m);
+	g_signal_connect(m->ir, "interrupted", G_CALLBACK(handle_ir_interrupted), m);
+	g_signal_connect(m->it, "stopped", G_CALLBACK(handle_stopped), m);
+	g_signal_connect(m->ir, "stopped", G_CALLBACK(handle_stopped), m);
+
+	if (!attach_source(G_OBJECT(m->it), ctx, sources, error) ||
+	    !attach_source(G_OBJECT(m->ir), ctx, sources, error))
+		goto end;
+	if (m->loopback != NULL && !attach_source(G_OBJECT(m->loopback), ctx, sources, error))
+		goto end;
+
+	if (!register_ir_packets(m, m->chunks_per_buffer, error) ||
+	    !hinoko_fw_iso_ir_single_start(m->ir, NULL, 0,
+					   HINOKO_FW_ISO_CTX_MATCH_FLAG_TAG0 |
+					   HINOKO_FW_ISO_CTX_MATCH_FLAG_TAG1 |
+					   HINOKO_FW_ISO_CTX_MATCH_FLAG_TAG2 |
+					   HINOKO_FW_ISO_CTX_MATCH_FLAG_TAG3, error))
+		goto end;
+
+	if (!register_it_packets(m, m->chunks_per_buffer, error) ||
+	    !hinoko_fw_iso_it_start(m->it, NULL, error))
+		goto end;
+
+	timeout = g_timeout_source_new_seconds(duration);
+	g_source_set_callback(timeout, handle_timeout, m, NULL);
+	g_source_attach(timeout, ctx);
+	g_ptr_array_add(sources, timeout);
+
+	g_main_loop_run(m->loop);
+
+	if (m->error != NULL) {
+		g_propagate_error(error, m->error);
+		m->error = NULL;
+	} else {
+		result = TRUE;
+	}
+end:
+	hinoko_fw_iso_ctx_stop(HINOKO_FW_ISO_CTX(m->it));
+	hinoko_fw_iso_ctx_stop(HINOKO_FW_ISO_CTX(m->ir));
+
+	for (i = 0; i < sources->len; ++i) {
+		GSource *source = g_ptr_array_index(sources, i);
+
+		g_source_destroy(source);
+		g_source_unref(source);
+	}
+	g_ptr_array_unref(sources);
+
+	hinoko_fw_iso_ctx_unmap_buffer(HINOKO_FW_ISO_CTX(m->it));
+	hinoko_fw_iso_ctx_unmap_buffer(HINOKO_FW_ISO_CTX(m->ir));
+	hinoko_fw_iso_ctx_release(HINOKO_FW_ISO_CTX(m->it));
+	hinoko_fw_iso_ctx_release(HINOKO_FW_ISO_CTX(m->ir));
+
+	g_main_loop_unref(m->loop);
+	g_main_context_unref(ctx);
+
+	return result;
+}
+
+static gint compare_uint(gconstpointer a, gconstpointer b)
+{
+	guint lhs = *(const guint *)a;
+	guint rhs = *(const guint *)b;
+
+	return (lhs > rhs) - (lhs < rhs);
+}
+
+static guint percentile(const GArray *samples, guint rank)
+{
+	return g_array_index(samples, guint, (samples->len - 1) * rank / 100);
+}
+
+static double average(const GArray *samples)
+{
+	guint64 total = 0;
+	guint i;
+
+	for (i = 0; i < samples->len; ++i)
+		total += g_array_index(samples, guint, i);
+
+	return (double)total / samples->len;
+}
+
+static void print_distribution(FILE *output, GArray *samples)
+{
+	if (samples->len == 0) {
+		fprintf(output, "\t-\t-\t-\t-\t-\t-");
+		return;
+	}
+
+	g_array_sort(samples, compare_uint);
+	fprintf(output, "\t%u\t%u\t%u\t%u\t%u\t%.2f",
+		g_array_index(samples, guint, 0), percentile(samples, 50),
+		percentile(samples, 90), percentile(samples, 99),
+		g_array_index(samples, guint, samples->len - 1), average(samples));
+}
+
+static void print_preamble(FILE *output)
+{
+	struct utsname name;
+	time_t now = time(NULL);
+	char date[64];
+
+	strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&now));
+
+	fprintf(output, "# hinoko-latency report\n");
+	fprintf(output, "# date: %s\n", date);
+	fprintf(output, "# hinoko: %s\n", PACKAGE_VERSION);
+	if (uname(&name) == 0) {
+		fprintf(output, "# host: %s\n", name.nodename);
+		fprintf(output, "# kernel: %s %s %s\n", name.sysname, name.release, name.version);
+		fprintf(output, "# machine: %s\n", name.machine);
+	}
+	fprintf(output, "# backend: %s\n", use_loopback ? "loopback" : device_path);
+	fprintf(output, "# channel: %d\n", channel);
+	fprintf(output, "# bytes per packet: %d\n", IT_HEADER_SIZE + payload_length);
+	fprintf(output, "# seconds per geometry: %d\n", duration);
+	fprintf(output, "# unit: isochronous cycle (125 usec)\n");
+	fprintf(output, "chunks-per-buffer\tcycles-per-irq\treceived\tlost\t"
+		"latency-min\tlatency-p50\tlatency-p90\tlatency-p99\tlatency-max\tlatency-avg\t"
+		"slack-min\tslack-p50\tslack-p90\tslack-p99\tslack-max\tslack-avg\n");
+}
+
+static gboolean parse_list(const char *list, const char *name, GArray *values, GError **error)
+{
+	gchar **tokens = g_strsplit(list, ",", -1);
+	gboolean result = TRUE;
+	int i;
+
+	for (i = 0; tokens[i] != NULL; ++i) {
+		guint64 value;
+
+		if (!g_ascii_string_to_unsigned(g_strstrip(tokens[i]), 10, 1, G_MAXUINT16, &value,
+						error)) {
+			g_prefix_error(error, "%s: ", name);
+			result = FALSE;
+			break;
+		}
+		g_array_append_val(values, value);
+	}
+
+	g_strfreev(tokens);
+
+	return result;
+}
+
+int main(int argc, char **argv)
+{
+	GOptionContext *context;
+	GArray *chunks_per_buffer = g_array_new(FALSE, FALSE, sizeof(guint64));
+	GArray *cycles_per_irq = g_array_new(FALSE, FALSE, sizeof(guint64));
+	FILE *output = stdout;
+	GError *error = NULL;
+	int status = EXIT_FAILURE;
+	guint i;
+	guint j;
+
+	context = g_option_context_new("- measure round-trip latency of isochronous packets");
+	g_option_context_add_main_entries(context, entries, NULL);
+	if (!g_option_context_parse(context, &argc, &argv, &error))
+		goto end;
+
+	if (channel < 0 || channel > 63 || payload_length < 4 || payload_length % 4 > 0 ||
+	    duration <= 0) {
+		g_set_error_literal(&error, G_OPTION_ERROR, G_OPTION_ERROR_BAD_VALUE,
+				    "The channel should be up to 63, the payload should be quadlet "
+				    "aligned and not empty, and the duration should be positive");
+		goto end;
+	}
+
+	if (!parse_list(chunks_per_buffer_list, "chunks-per-buffer", chunks_per_buffer, &error) ||
+	    !parse_list(cycles_per_irq_list, "cycles-per-irq", cycles_per_irq, &error))
+		goto end;
+
+	if (output_path != NULL) {
+		output = fopen(output_path, "w");
+		if (output == NULL) {
+			g_set_error(&error, G_FILE_ERROR, g_file_error_from_errno(errno),
+				    "fopen(%s): %s", output_path, strerror(errno));
+			output = stdout;
+			goto end;
+		}
+	}
+
+	print_preamble(output);
+
+	for (i = 0; i < chunks_per_buffer->len; ++i) {
+		for (j = 0; j < cycles_per_irq->len; ++j) {
+			struct measurement m = {
+				.chunks_per_buffer = g_array_index(chunks_per_buffer, guint64, i),
+				.cycles_per_irq = g_array_index(cycles_per_irq, guint64, j),
+			};
+			gboolean result;
+
+			// No interrupt is scheduled for the buffer shorter than the interval.
+			if (m.cycles_per_irq > m.chunks_per_buffer)
+				continue;
+
+			m.it = hinoko_fw_iso_it_new();
+			m.ir = hinoko_fw_iso_ir_single_new();
+			m.payload = g_malloc0(payload_length);
+			m.latencies = g_array_new(FALSE, FALSE, sizeof(guint));
+			m.slacks = g_array_new(FALSE, FALSE, sizeof(guint));
+
+			result = measure(&m, &error);
+			if (result) {
+				fprintf(output, "%u\t%u\t%" G_GUINT64_FORMAT "\t%" G_GUINT64_FORMAT,
+					m.chunks_per_buffer, m.cycles_per_irq, m.received, m.lost);
+				print_distribution(output, m.latencies);
+				print_distribution(output, m.slacks);
+				fprintf(output, "\n");
+				fflush(output);
+			}
+
+			g_array_unref(m.latencies);
+			g_array_unref(m.slacks);
+			g_free(m.payload);
+			g_object_unref(m.it);
+			g_object_unref(m.ir);
+			g_clear_object(&m.loopback);
+
+			if (!result)
+				goto end;
+		}
+	}
+
+	status = EXIT_SUCCESS;
+end:
+	if (error != NULL) {
+		g_printerr("%s\n", error->message);
+		g_clear_error(&error);
+	}
+
+	if (output != stdout)
+		fclose(output);
+	g_array_unref(chunks_per_buffer);
+	g_array_unref(cycles_per_irq);
+	g_option_context_free(context);
+
+	return status;
+}